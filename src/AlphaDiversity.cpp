@@ -0,0 +1,50 @@
+#include "AlphaDiversity.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace miint {
+
+void AlphaDiversity::Add(double count) {
+	if (!(count >= 0)) {
+		throw std::runtime_error("Counts must be non-negative, found " + std::to_string(count));
+	}
+	if (count == 0) {
+		return;
+	}
+	total += count;
+	sum_c_log_c += count * std::log(count);
+	sum_c2 += count * count;
+	observed++;
+	if (count == 1) {
+		singletons++;
+	} else if (count == 2) {
+		doubletons++;
+	}
+}
+
+void AlphaDiversity::Merge(const AlphaDiversity &other) {
+	total += other.total;
+	sum_c_log_c += other.sum_c_log_c;
+	sum_c2 += other.sum_c2;
+	observed += other.observed;
+	singletons += other.singletons;
+	doubletons += other.doubletons;
+}
+
+double AlphaDiversity::Shannon() const {
+	// Clamp the rounding error of a single feature, whose entropy is exactly 0
+	return observed == 1 ? 0.0 : std::log(total) - sum_c_log_c / total;
+}
+
+double AlphaDiversity::Simpson() const {
+	return 1.0 - sum_c2 / (total * total);
+}
+
+double AlphaDiversity::Chao1() const {
+	auto f1 = static_cast<double>(singletons);
+	auto f2 = static_cast<double>(doubletons);
+	return static_cast<double>(observed) + f1 * (f1 - 1) / (2 * (f2 + 1));
+}
+
+} // namespace miint
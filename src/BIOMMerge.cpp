@@ -0,0 +1,640 @@
+#include "BIOMMerge.hpp"
+#include "BIOMReader.hpp"
+#include "HDF5Chunks.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <hdf5.h>
+#include <zlib.h>
+
+namespace miint {
+
+namespace {
+
+// Elements per HDF5 chunk and gzip level, as COPY FORMAT BIOM writes them
+constexpr hsize_t CHUNK_SIZE = 65536;
+constexpr unsigned DEFLATE_LEVEL = 4;
+
+// hdf5_lock() is taken around each HDF5 call or batch of calls only; the ID union, sorting and deflating are
+// done without it, so scans of other BIOM files can proceed in between
+using HDF5Guard = std::lock_guard<std::recursive_mutex>;
+
+// Closes an HDF5 object when it goes out of scope
+class H5Object {
+public:
+	H5Object(hid_t id_p, herr_t (*close_p)(hid_t)) : id(id_p), close(close_p) {
+	}
+	~H5Object() {
+		if (id >= 0) {
+			HDF5Guard guard(hdf5_lock());
+			close(id);
+		}
+	}
+	H5Object(const H5Object &) = delete;
+	H5Object &operator=(const H5Object &) = delete;
+
+	hid_t get() const {
+		return id;
+	}
+
+private:
+	hid_t id;
+	herr_t (*close)(hid_t);
+};
+
+void check(herr_t status, const char *what) {
+	if (status < 0) {
+		throw std::runtime_error(std::string("Failed to write BIOM ") + what);
+	}
+}
+
+hid_t check_id(hid_t id, const char *what) {
+	if (id < 0) {
+		throw std::runtime_error(std::string("Failed to create BIOM ") + what);
+	}
+	return id;
+}
+
+std::string current_timestamp() {
+	auto now = std::chrono::system_clock::now();
+	auto time_t_now = std::chrono::system_clock::to_time_t(now);
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
+	std::ostringstream oss;
+	oss << std::put_time(std::gmtime(&time_t_now), "%Y-%m-%dT%H:%M:%S");
+	oss << "." << std::setfill('0') << std::setw(6) << (ms.count() * 1000);
+	return oss.str();
+}
+
+void write_string_attribute(hid_t loc, const char *name, const std::string &value) {
+	// Fixed-length strings cannot be empty, so an empty value is stored as a single NUL
+	H5Object type(H5Tcopy(H5T_C_S1), H5Tclose);
+	check(H5Tset_size(type.get(), std::max<size_t>(value.size(), 1)), name);
+	H5Object space(H5Screate(H5S_SCALAR), H5Sclose);
+	H5Object attr(check_id(H5Acreate2(loc, name, type.get(), space.get(), H5P_DEFAULT, H5P_DEFAULT), name),
+	              H5Aclose);
+	std::string stored = value.empty() ? std::string(1, '\0') : value;
+	check(H5Awrite(attr.get(), type.get(), stored.data()), name);
+}
+
+void write_int_attribute(hid_t loc, const char *name, hid_t type, const void *values, hsize_t n) {
+	H5Object space(n == 0 ? H5Screate(H5S_SCALAR) : H5Screate_simple(1, &n, nullptr), H5Sclose);
+	H5Object attr(check_id(H5Acreate2(loc, name, type, space.get(), H5P_DEFAULT, H5P_DEFAULT), name), H5Aclose);
+	check(H5Awrite(attr.get(), type, values), name);
+}
+
+void write_root_attributes(hid_t file, const BIOMMergeSummary &summary, const BIOMMergeOptions &options) {
+	write_string_attribute(file, "creation-date", current_timestamp());
+	write_string_attribute(file, "format-url", "http://biom-format.org");
+	int version[2] = {2, 1};
+	write_int_attribute(file, "format-version", H5T_NATIVE_INT, version, 2);
+	write_string_attribute(file, "generated-by", options.generated_by);
+	write_string_attribute(file, "id", options.id);
+	int64_t nnz = static_cast<int64_t>(summary.nnz);
+	write_int_attribute(file, "nnz", H5T_NATIVE_INT64, &nnz, 0);
+	int64_t shape[2] = {static_cast<int64_t>(summary.n_features), static_cast<int64_t>(summary.n_samples)};
+	write_int_attribute(file, "shape", H5T_NATIVE_INT64, shape, 2);
+	write_string_attribute(file, "type", "");
+}
+
+// Create a 1-D dataset of n elements, chunked and deflated when compressing
+hid_t create_dataset(hid_t group, const char *name, hid_t type, hsize_t n, bool use_compression) {
+	H5Object space(H5Screate_simple(1, &n, nullptr), H5Sclose);
+	H5Object plist(H5Pcreate(H5P_DATASET_CREATE), H5Pclose);
+	if (use_compression && n > 0) {
+		hsize_t chunk = std::min(n, CHUNK_SIZE);
+		check(H5Pset_chunk(plist.get(), 1, &chunk), name);
+		check(H5Pset_deflate(plist.get(), DEFLATE_LEVEL), name);
+	}
+	return check_id(H5Dcreate2(group, name, type, space.get(), H5P_DEFAULT, plist.get(), H5P_DEFAULT), name);
+}
+
+// Write count elements at offset of a 1-D dataset
+void write_range(hid_t dataset, hid_t mem_type, hsize_t offset, hsize_t count, const void *data) {
+	if (count == 0) {
+		return;
+	}
+	H5Object file_space(H5Dget_space(dataset), H5Sclose);
+	H5Object mem_space(H5Screate_simple(1, &count, nullptr), H5Sclose);
+	check(H5Sselect_hyperslab(file_space.get(), H5S_SELECT_SET, &offset, nullptr, &count, nullptr), "dataset range");
+	check(H5Dwrite(dataset, mem_type, mem_space.get(), file_space.get(), H5P_DEFAULT, data), "dataset range");
+}
+
+// Writes the elements of a 1-D dataset in order. With compression, each chunk is deflated here, away from the
+// HDF5 lock, and stored as is with H5Dwrite_chunk; the dataset carries the deflate filter, so readers see what
+// HDF5 would have written itself.
+template <typename T>
+class DatasetWriter {
+public:
+	DatasetWriter(hid_t dataset_p, hid_t mem_type_p, hsize_t size_p, bool use_compression)
+	    : dataset(dataset_p), mem_type(mem_type_p), size(size_p),
+	      chunk_size(use_compression && size_p > 0 ? std::min(size_p, CHUNK_SIZE) : 0) {
+	}
+
+	void append(const T *values, hsize_t n) {
+		if (chunk_size == 0) {
+			HDF5Guard guard(hdf5_lock());
+			write_range(dataset, mem_type, written, n, values);
+			written += n;
+			return;
+		}
+		while (n > 0) {
+			hsize_t take = std::min<hsize_t>(n, chunk_size - pending.size());
+			pending.insert(pending.end(), values, values + take);
+			values += take;
+			n -= take;
+			written += take;
+			if (pending.size() == chunk_size) {
+				flush();
+			}
+		}
+	}
+
+	void finish() {
+		if (written != size) {
+			throw std::runtime_error("Failed to write BIOM dataset: " + std::to_string(written) + " of " +
+			                         std::to_string(size) + " elements");
+		}
+		if (!pending.empty()) {
+			// The edge chunk is stored at full size, padded with zeros
+			pending.resize(chunk_size, T());
+			flush();
+		}
+	}
+
+private:
+	void flush() {
+		uLong source_bytes = pending.size() * sizeof(T);
+		uLongf compressed_bytes = compressBound(source_bytes);
+		compressed.resize(compressed_bytes);
+		if (compress2(compressed.data(), &compressed_bytes, reinterpret_cast<const Bytef *>(pending.data()),
+		              source_bytes, DEFLATE_LEVEL) != Z_OK) {
+			throw std::runtime_error("Failed to compress BIOM dataset chunk");
+		}
+		{
+			HDF5Guard guard(hdf5_lock());
+			check(H5Dwrite_chunk(dataset, H5P_DEFAULT, 0, &chunk_offset, compressed_bytes, compressed.data()),
+			      "dataset chunk");
+		}
+		chunk_offset += chunk_size;
+		pending.clear();
+	}
+
+	hid_t dataset;
+	hid_t mem_type;
+	hsize_t size;
+	hsize_t chunk_size;
+	hsize_t written = 0;
+	hsize_t chunk_offset = 0;
+	std::vector<T> pending;
+	std::vector<Bytef> compressed;
+};
+
+void write_ids(hid_t group, const std::vector<std::string> &ids, bool use_compression) {
+	H5Object type(H5Tcopy(H5T_C_S1), H5Tclose);
+	check(H5Tset_size(type.get(), H5T_VARIABLE), "ids");
+	H5Object dataset(create_dataset(group, "ids", type.get(), ids.size(), use_compression), H5Dclose);
+	std::vector<const char *> c_strs(ids.size());
+	for (size_t i = 0; i < ids.size(); i++) {
+		c_strs[i] = ids[i].c_str();
+	}
+	write_range(dataset.get(), type.get(), 0, ids.size(), c_strs.data());
+}
+
+// The datasets of one compressed matrix of the output
+struct MatrixDatasets {
+	std::unique_ptr<H5Object> group;
+	std::unique_ptr<H5Object> indptr;
+	std::unique_ptr<H5Object> indices;
+	std::unique_ptr<H5Object> data;
+
+	MatrixDatasets(hid_t axis_group, uint64_t n_major, uint64_t nnz, bool use_compression) {
+		group = std::make_unique<H5Object>(
+		    check_id(H5Gcreate2(axis_group, "matrix", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), "matrix"), H5Gclose);
+		auto g = group->get();
+		indptr = std::make_unique<H5Object>(create_dataset(g, "indptr", H5T_STD_I32LE, n_major + 1, use_compression),
+		                                    H5Dclose);
+		indices =
+		    std::make_unique<H5Object>(create_dataset(g, "indices", H5T_STD_I32LE, nnz, use_compression), H5Dclose);
+		data = std::make_unique<H5Object>(create_dataset(g, "data", H5T_IEEE_F64LE, nnz, use_compression), H5Dclose);
+	}
+};
+
+// An input file, with its feature indices mapped to the merged ones
+struct MergeInput {
+	std::string path;
+	std::unique_ptr<BIOMReader> reader;
+	std::vector<int32_t> indptr;
+	std::vector<uint32_t> remap;
+	// The remap is increasing, so columns stay sorted without re-sorting
+	bool order_preserving = true;
+	size_t sample_offset = 0;
+	// Entries of each of its features, counted while copying sample/matrix
+	std::vector<uint64_t> feature_counts;
+	// observation/matrix pointers; empty when the file has none
+	std::vector<int32_t> obs_indptr;
+	// Its features in merged order, and the first of them not yet copied to observation/matrix
+	std::vector<uint32_t> by_merged;
+	size_t next_feature = 0;
+
+	~MergeInput() {
+		HDF5Guard guard(hdf5_lock());
+		reader.reset();
+	}
+};
+
+// Read entries [begin, end) of one of the input's matrices, holding the HDF5 lock only while fetching them
+void read_entries(const MergeInput &input, BIOMAxis axis, uint64_t begin, uint64_t end, BIOMRawEntries &raw,
+                  BIOMEntries &entries) {
+	{
+		HDF5Guard guard(hdf5_lock());
+		input.reader->read_entries_raw(axis, begin, end, raw);
+	}
+	input.reader->decode_entries(raw, entries);
+}
+
+// Read the input's sample/matrix a run of whole columns at a time, no more than block_entries entries per run
+// unless a single column is larger, and call fn(first_column, end_column, entries) for each run
+template <typename Fn>
+void for_each_column_run(const MergeInput &input, uint64_t block_entries, BIOMRawEntries &raw, BIOMEntries &entries,
+                         Fn fn) {
+	size_t n_columns = input.indptr.size() - 1;
+	size_t first = 0;
+	while (first < n_columns) {
+		size_t end = first + 1;
+		while (end < n_columns &&
+		       static_cast<uint64_t>(input.indptr[end + 1] - input.indptr[first]) <= block_entries) {
+			end++;
+		}
+		read_entries(input, BIOMAxis::SAMPLE, input.indptr[first], input.indptr[end], raw, entries);
+		size_t n_local = input.remap.size();
+		for (auto index : entries.indices) {
+			if (index < 0 || static_cast<size_t>(index) >= n_local) {
+				throw std::runtime_error("Corrupt BIOM file '" + input.path + "': feature index " +
+				                         std::to_string(index) + " is out of range");
+			}
+		}
+		fn(first, end, entries);
+		first = end;
+	}
+}
+
+// The sorted union of the inputs' feature IDs, filling in each input's remap
+std::vector<std::string> merge_feature_ids(std::vector<MergeInput> &inputs) {
+	std::vector<std::vector<std::string>> ids(inputs.size());
+	std::vector<std::vector<uint32_t>> order(inputs.size());
+	for (size_t f = 0; f < inputs.size(); f++) {
+		{
+			HDF5Guard guard(hdf5_lock());
+			ids[f] = inputs[f].reader->read_feature_ids();
+		}
+		auto &file_ids = ids[f];
+		order[f].resize(file_ids.size());
+		for (uint32_t i = 0; i < file_ids.size(); i++) {
+			order[f][i] = i;
+		}
+		std::sort(order[f].begin(), order[f].end(),
+		          [&](uint32_t a, uint32_t b) { return file_ids[a] < file_ids[b]; });
+		for (size_t i = 1; i < order[f].size(); i++) {
+			if (file_ids[order[f][i]] == file_ids[order[f][i - 1]]) {
+				throw std::runtime_error("Feature '" + file_ids[order[f][i]] + "' appears more than once in '" +
+				                         inputs[f].path + "'");
+			}
+		}
+		inputs[f].remap.resize(file_ids.size());
+	}
+
+	// k-way merge of the sorted lists; ties take the same merged index
+	using Head = std::pair<std::string_view, size_t>;
+	std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+	std::vector<size_t> cursor(inputs.size(), 0);
+	for (size_t f = 0; f < inputs.size(); f++) {
+		if (!order[f].empty()) {
+			heads.emplace(ids[f][order[f][0]], f);
+		}
+	}
+	std::vector<std::string> merged;
+	while (!heads.empty()) {
+		auto head = heads.top();
+		heads.pop();
+		size_t f = head.second;
+		if (merged.empty() || merged.back() != head.first) {
+			merged.emplace_back(head.first);
+		}
+		inputs[f].remap[order[f][cursor[f]]] = static_cast<uint32_t>(merged.size() - 1);
+		if (++cursor[f] < order[f].size()) {
+			heads.emplace(ids[f][order[f][cursor[f]]], f);
+		}
+	}
+
+	for (size_t f = 0; f < inputs.size(); f++) {
+		inputs[f].order_preserving = std::is_sorted(inputs[f].remap.begin(), inputs[f].remap.end());
+		inputs[f].by_merged = std::move(order[f]);
+	}
+	return merged;
+}
+
+// The inputs' sample IDs in order, which must be distinct
+std::vector<std::string> concatenate_sample_ids(std::vector<MergeInput> &inputs) {
+	std::vector<std::vector<std::string>> ids(inputs.size());
+	size_t total = 0;
+	for (size_t f = 0; f < inputs.size(); f++) {
+		{
+			HDF5Guard guard(hdf5_lock());
+			ids[f] = inputs[f].reader->read_sample_ids();
+		}
+		if (ids[f].size() + 1 != inputs[f].indptr.size()) {
+			throw std::runtime_error("Corrupt BIOM file '" + inputs[f].path + "': " + std::string(SAMPLE_INDPTR) +
+			                         " does not match " + std::string(SAMPLE_IDS));
+		}
+		inputs[f].sample_offset = total;
+		total += ids[f].size();
+	}
+
+	// Reserved up front so the views in seen stay valid
+	std::vector<std::string> merged;
+	merged.reserve(total);
+	std::unordered_map<std::string_view, size_t> seen;
+	for (size_t f = 0; f < inputs.size(); f++) {
+		for (auto &id : ids[f]) {
+			merged.push_back(std::move(id));
+			auto inserted = seen.emplace(merged.back(), f);
+			if (!inserted.second) {
+				throw std::runtime_error("Sample '" + merged.back() + "' is in both '" +
+				                         inputs[inserted.first->second].path + "' and '" + inputs[f].path + "'");
+			}
+		}
+	}
+	return merged;
+}
+
+// Add the entries of features [g_first, g_end) of an input without observation/matrix to a block of the output's
+// observation/matrix, by scanning its sample/matrix in sample order; next holds each feature's next position
+void scan_observations(const MergeInput &input, uint64_t block_entries, BIOMRawEntries &raw, BIOMEntries &entries,
+                       size_t g_first, size_t g_end, std::vector<uint64_t> &next, std::vector<int32_t> &block_indices,
+                       std::vector<double> &block_data) {
+	for_each_column_run(input, block_entries, raw, entries, [&](size_t first, size_t end, BIOMEntries &run) {
+		uint64_t base = input.indptr[first];
+		for (size_t c = first; c < end; c++) {
+			auto sample = static_cast<int32_t>(input.sample_offset + c);
+			for (uint64_t e = input.indptr[c] - base; e < input.indptr[c + 1] - base; e++) {
+				size_t g = input.remap[run.indices[e]];
+				if (g >= g_first && g < g_end) {
+					auto p = next[g - g_first]++;
+					block_indices[p] = sample;
+					block_data[p] = run.data[e];
+				}
+			}
+		}
+	});
+}
+
+BIOMMergeSummary merge_into(hid_t file, std::vector<MergeInput> &inputs, const BIOMMergeOptions &options) {
+	auto feature_ids = merge_feature_ids(inputs);
+	auto sample_ids = concatenate_sample_ids(inputs);
+
+	BIOMMergeSummary summary;
+	summary.n_features = feature_ids.size();
+	summary.n_samples = sample_ids.size();
+	for (const auto &input : inputs) {
+		summary.nnz += static_cast<uint64_t>(input.indptr.back());
+	}
+	constexpr uint64_t int32_max = std::numeric_limits<int32_t>::max();
+	if (summary.n_features > int32_max || summary.n_samples > int32_max || summary.nnz > int32_max) {
+		throw std::runtime_error("Merged table exceeds the int32 limits of BIOM: " +
+		                         std::to_string(summary.n_features) + " features, " +
+		                         std::to_string(summary.n_samples) + " samples, " + std::to_string(summary.nnz) +
+		                         " entries");
+	}
+	uint64_t block_entries = std::max<uint64_t>(options.block_entries, 1);
+	bool use_compression = options.use_compression;
+
+	// The layout of the output, written as one batch
+	std::unique_lock<std::recursive_mutex> layout_guard(hdf5_lock());
+	write_root_attributes(file, summary, options);
+	H5Object obs_group(check_id(H5Gcreate2(file, "observation", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), "group"),
+	                   H5Gclose);
+	H5Object sample_group(check_id(H5Gcreate2(file, "sample", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), "group"),
+	                      H5Gclose);
+	for (auto group : {obs_group.get(), sample_group.get()}) {
+		for (auto name : {"metadata", "group-metadata"}) {
+			H5Object empty(check_id(H5Gcreate2(group, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), name), H5Gclose);
+		}
+	}
+	write_ids(obs_group.get(), feature_ids, use_compression);
+	write_ids(sample_group.get(), sample_ids, use_compression);
+	MatrixDatasets sample_matrix(sample_group.get(), summary.n_samples, summary.nnz, use_compression);
+	MatrixDatasets obs_matrix(obs_group.get(), summary.n_features, summary.nnz, use_compression);
+	layout_guard.unlock();
+	feature_ids = {};
+	sample_ids = {};
+
+	// sample/matrix: each input's columns in turn, counting the entries of every feature on the way
+	DatasetWriter<int32_t> sample_indices(sample_matrix.indices->get(), H5T_NATIVE_INT32, summary.nnz,
+	                                      use_compression);
+	DatasetWriter<double> sample_data(sample_matrix.data->get(), H5T_NATIVE_DOUBLE, summary.nnz, use_compression);
+	BIOMRawEntries raw;
+	BIOMEntries entries;
+	std::vector<uint64_t> feature_counts(summary.n_features, 0);
+	std::vector<int32_t> sample_indptr(summary.n_samples + 1, 0);
+	std::vector<std::pair<int32_t, double>> column;
+	uint64_t position = 0;
+	for (auto &input : inputs) {
+		input.feature_counts.assign(input.remap.size(), 0);
+		for_each_column_run(input, block_entries, raw, entries, [&](size_t first, size_t end, BIOMEntries &run) {
+			uint64_t base = input.indptr[first];
+			for (size_t c = first; c < end; c++) {
+				uint64_t begin = input.indptr[c] - base;
+				uint64_t stop = input.indptr[c + 1] - base;
+				for (uint64_t e = begin; e < stop; e++) {
+					input.feature_counts[run.indices[e]]++;
+					run.indices[e] = static_cast<int32_t>(input.remap[run.indices[e]]);
+				}
+				if (!input.order_preserving) {
+					column.clear();
+					for (uint64_t e = begin; e < stop; e++) {
+						column.emplace_back(run.indices[e], run.data[e]);
+					}
+					std::sort(column.begin(), column.end(),
+					          [](const auto &a, const auto &b) { return a.first < b.first; });
+					for (uint64_t e = begin; e < stop; e++) {
+						run.indices[e] = column[e - begin].first;
+						run.data[e] = column[e - begin].second;
+					}
+				}
+				sample_indptr[input.sample_offset + c + 1] = static_cast<int32_t>(position + stop);
+			}
+			sample_indices.append(run.indices.data(), run.size());
+			sample_data.append(run.data.data(), run.size());
+			position += run.size();
+		});
+	}
+	sample_indices.finish();
+	sample_data.finish();
+	DatasetWriter<int32_t> sample_pointers(sample_matrix.indptr->get(), H5T_NATIVE_INT32, sample_indptr.size(),
+	                                       use_compression);
+	sample_pointers.append(sample_indptr.data(), sample_indptr.size());
+	sample_pointers.finish();
+	sample_indptr = {};
+
+	for (auto &input : inputs) {
+		for (size_t l = 0; l < input.remap.size(); l++) {
+			feature_counts[input.remap[l]] += input.feature_counts[l];
+		}
+		{
+			HDF5Guard guard(hdf5_lock());
+			if (!input.reader->has_observation_matrix()) {
+				continue;
+			}
+			input.obs_indptr = input.reader->read_indptr(BIOMAxis::OBSERVATION);
+		}
+		bool consistent = input.obs_indptr.size() == input.remap.size() + 1;
+		for (size_t l = 0; consistent && l < input.remap.size(); l++) {
+			auto row_size = static_cast<uint64_t>(input.obs_indptr[l + 1] - input.obs_indptr[l]);
+			consistent = row_size == input.feature_counts[l];
+		}
+		if (!consistent) {
+			throw std::runtime_error("Corrupt BIOM file '" + input.path + "': " + std::string(OBS_INDPTR) +
+			                         " does not match " + std::string(SAMPLE_INDICES));
+		}
+		input.feature_counts = {};
+	}
+
+	// observation/matrix: a block of features at a time. A feature's samples are its rows in the inputs'
+	// observation/matrix concatenated in input order, each offset by the input's first sample; as the inputs hold
+	// consecutive samples, they come out sorted. Every row is read once: the rows an input contributes to a block
+	// follow those of the previous block in merged order, and are read as runs of consecutive rows (one run per
+	// block when the input's feature IDs are sorted). Inputs without observation/matrix are instead scanned in
+	// full for every block.
+	std::vector<int32_t> obs_indptr(summary.n_features + 1, 0);
+	for (size_t g = 0; g < summary.n_features; g++) {
+		obs_indptr[g + 1] = static_cast<int32_t>(obs_indptr[g] + feature_counts[g]);
+	}
+	feature_counts = {};
+	DatasetWriter<int32_t> obs_pointers(obs_matrix.indptr->get(), H5T_NATIVE_INT32, obs_indptr.size(),
+	                                    use_compression);
+	obs_pointers.append(obs_indptr.data(), obs_indptr.size());
+	obs_pointers.finish();
+	DatasetWriter<int32_t> obs_indices(obs_matrix.indices->get(), H5T_NATIVE_INT32, summary.nnz, use_compression);
+	DatasetWriter<double> obs_data(obs_matrix.data->get(), H5T_NATIVE_DOUBLE, summary.nnz, use_compression);
+
+	std::vector<int32_t> block_indices;
+	std::vector<double> block_data;
+	std::vector<uint64_t> next;
+	size_t g_first = 0;
+	while (g_first < summary.n_features) {
+		size_t g_end = g_first + 1;
+		while (g_end < summary.n_features &&
+		       static_cast<uint64_t>(obs_indptr[g_end + 1] - obs_indptr[g_first]) <= block_entries) {
+			g_end++;
+		}
+		uint64_t block_base = obs_indptr[g_first];
+		uint64_t block_size = obs_indptr[g_end] - block_base;
+		block_indices.resize(block_size);
+		block_data.resize(block_size);
+		next.resize(g_end - g_first);
+		for (size_t g = g_first; g < g_end; g++) {
+			next[g - g_first] = obs_indptr[g] - block_base;
+		}
+		for (auto &input : inputs) {
+			if (input.obs_indptr.empty()) {
+				if (block_size > 0) {
+					scan_observations(input, block_entries, raw, entries, g_first, g_end, next, block_indices,
+					                  block_data);
+				}
+				continue;
+			}
+			auto n_local_samples = static_cast<int32_t>(input.indptr.size() - 1);
+			size_t first = input.next_feature;
+			size_t last = first;
+			while (last < input.by_merged.size() && input.remap[input.by_merged[last]] < g_end) {
+				last++;
+			}
+			input.next_feature = last;
+			while (first < last) {
+				size_t run_end = first + 1;
+				while (run_end < last && input.by_merged[run_end] == input.by_merged[run_end - 1] + 1) {
+					run_end++;
+				}
+				uint32_t row_begin = input.by_merged[first];
+				uint32_t row_end = input.by_merged[run_end - 1] + 1;
+				uint64_t base = input.obs_indptr[row_begin];
+				read_entries(input, BIOMAxis::OBSERVATION, base, input.obs_indptr[row_end], raw, entries);
+				for (uint32_t row = row_begin; row < row_end; row++) {
+					auto &p = next[input.remap[row] - g_first];
+					for (uint64_t e = input.obs_indptr[row] - base; e < input.obs_indptr[row + 1] - base; e++) {
+						auto sample = entries.indices[e];
+						if (sample < 0 || sample >= n_local_samples) {
+							throw std::runtime_error("Corrupt BIOM file '" + input.path + "': sample index " +
+							                         std::to_string(sample) + " is out of range");
+						}
+						block_indices[p] = static_cast<int32_t>(input.sample_offset + sample);
+						block_data[p] = entries.data[e];
+						p++;
+					}
+				}
+				first = run_end;
+			}
+		}
+		obs_indices.append(block_indices.data(), block_size);
+		obs_data.append(block_data.data(), block_size);
+		g_first = g_end;
+	}
+	obs_indices.finish();
+	obs_data.finish();
+	return summary;
+}
+
+} // namespace
+
+BIOMMergeSummary biom_merge(const std::vector<std::string> &inputs, const std::string &output,
+                            const BIOMMergeOptions &options) {
+	if (inputs.empty()) {
+		throw std::runtime_error("No BIOM files to merge");
+	}
+	std::vector<MergeInput> merge_inputs(inputs.size());
+	hid_t file;
+	{
+		HDF5Guard guard(hdf5_lock());
+		for (size_t f = 0; f < inputs.size(); f++) {
+			auto &input = merge_inputs[f];
+			input.path = inputs[f];
+			input.reader = std::make_unique<BIOMReader>(inputs[f]);
+			input.indptr = input.reader->read_indptr(BIOMAxis::SAMPLE);
+		}
+		file = H5Fcreate(output.c_str(), H5F_ACC_EXCL, H5P_DEFAULT, H5P_DEFAULT);
+	}
+	if (file < 0) {
+		throw std::runtime_error("Cannot create '" + output + "'; it may already exist");
+	}
+	BIOMMergeSummary summary;
+	try {
+		summary = merge_into(file, merge_inputs, options);
+	} catch (...) {
+		HDF5Guard guard(hdf5_lock());
+		H5Fclose(file);
+		std::remove(output.c_str());
+		throw;
+	}
+	herr_t closed;
+	{
+		HDF5Guard guard(hdf5_lock());
+		closed = H5Fclose(file);
+	}
+	if (closed < 0) {
+		std::remove(output.c_str());
+		throw std::runtime_error("Failed to write '" + output + "'");
+	}
+	return summary;
+}
+
+} // namespace miint
@@ -63,6 +63,21 @@ BIOMReader::BIOMReader(const std::string &path) {
 		ds_samp_ids = ds_samp_ids_id;
 		ds_obs_ids = ds_obs_ids_id;
 
+		indices_layout = HDF5ChunkLayout::inspect(ds_indices);
+		data_layout = HDF5ChunkLayout::inspect(ds_data);
+
+		// Walk the path one link at a time, as H5Lexists fails on missing intermediate groups
+		if (H5Lexists(file_id, "/observation", H5P_DEFAULT) > 0 &&
+		    H5Lexists(file_id, "/observation/matrix", H5P_DEFAULT) > 0 &&
+		    H5Lexists(file_id, OBS_INDPTR, H5P_DEFAULT) > 0 && H5Lexists(file_id, OBS_INDICES, H5P_DEFAULT) > 0 &&
+		    H5Lexists(file_id, OBS_DATA, H5P_DEFAULT) > 0) {
+			ds_obs_indptr = H5Dopen2(file_id, OBS_INDPTR, H5P_DEFAULT);
+			ds_obs_indices = H5Dopen2(file_id, OBS_INDICES, H5P_DEFAULT);
+			ds_obs_data = H5Dopen2(file_id, OBS_DATA, H5P_DEFAULT);
+			obs_indices_layout = HDF5ChunkLayout::inspect(ds_obs_indices);
+			obs_data_layout = HDF5ChunkLayout::inspect(ds_obs_data);
+		}
+
 	} catch (const std::exception &e) {
 		// Clean up any open handles
 		if (ds_obs_ids_id >= 0) {
@@ -105,6 +120,15 @@ BIOMReader::~BIOMReader() {
 	if (ds_obs_ids >= 0) {
 		H5Dclose(ds_obs_ids);
 	}
+	if (ds_obs_indptr >= 0) {
+		H5Dclose(ds_obs_indptr);
+	}
+	if (ds_obs_indices >= 0) {
+		H5Dclose(ds_obs_indices);
+	}
+	if (ds_obs_data >= 0) {
+		H5Dclose(ds_obs_data);
+	}
 	if (file_handle >= 0) {
 		H5Fclose(file_handle);
 	}
@@ -114,6 +138,114 @@ BIOMTable BIOMReader::read() const {
 	return BIOMTable(ds_indices, ds_indptr, ds_data, ds_obs_ids, ds_samp_ids);
 }
 
+// Read elements [begin, begin + count) of a 1-D dataset as mem_type, converting from the stored type
+static void read_dataset_range(hid_t ds_id, hid_t mem_type, uint64_t begin, uint64_t count, void *out) {
+	if (count == 0) {
+		return;
+	}
+	hid_t file_space = H5Dget_space(ds_id);
+	if (file_space < 0) {
+		throw std::runtime_error("Failed to access dataspace");
+	}
+	hsize_t dims[1];
+	H5Sget_simple_extent_dims(file_space, dims, nullptr);
+	if (begin + count > dims[0]) {
+		H5Sclose(file_space);
+		throw std::runtime_error("BIOM dataset range [" + std::to_string(begin) + ", " + std::to_string(begin + count) +
+		                         ") exceeds its " + std::to_string(dims[0]) + " elements");
+	}
+	hsize_t start[1] = {begin};
+	hsize_t length[1] = {count};
+	hid_t mem_space = H5Screate_simple(1, length, nullptr);
+	herr_t status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, nullptr, length, nullptr);
+	if (status >= 0) {
+		status = H5Dread(ds_id, mem_type, mem_space, file_space, H5P_DEFAULT, out);
+	}
+	H5Sclose(mem_space);
+	H5Sclose(file_space);
+	if (status < 0) {
+		throw std::runtime_error("Failed to read BIOM dataset range");
+	}
+}
+
+std::vector<std::string> BIOMReader::read_sample_ids() const {
+	return BIOMTable::load_dataset_1D_str(ds_samp_ids);
+}
+
+std::vector<std::string> BIOMReader::read_feature_ids() const {
+	return BIOMTable::load_dataset_1D_str(ds_obs_ids);
+}
+
+bool BIOMReader::has_observation_matrix() const {
+	return ds_obs_indptr >= 0 && ds_obs_indices >= 0 && ds_obs_data >= 0;
+}
+
+BIOMReader::Matrix BIOMReader::matrix(BIOMAxis axis) const {
+	if (axis == BIOMAxis::SAMPLE) {
+		return {ds_indices, ds_indptr, ds_data, indices_layout, data_layout, SAMPLE_INDPTR, SAMPLE_INDICES};
+	}
+	if (!has_observation_matrix()) {
+		throw std::runtime_error("BIOM file has no " + std::string(OBS_INDPTR));
+	}
+	return {ds_obs_indices, ds_obs_indptr, ds_obs_data, obs_indices_layout, obs_data_layout, OBS_INDPTR, OBS_INDICES};
+}
+
+std::vector<int32_t> BIOMReader::read_indptr(BIOMAxis axis) const {
+	auto m = matrix(axis);
+	auto indptr = BIOMTable::load_dataset_1D<int32_t>(m.indptr, H5T_NATIVE_INT32);
+	hid_t space = H5Dget_space(m.indices);
+	hsize_t dims[1] = {0};
+	H5Sget_simple_extent_dims(space, dims, nullptr);
+	H5Sclose(space);
+
+	if (indptr.empty() || indptr.front() != 0 || static_cast<hsize_t>(indptr.back()) != dims[0]) {
+		throw std::runtime_error("Corrupt BIOM file: " + std::string(m.indptr_name) + " does not span " +
+		                         std::string(m.indices_name));
+	}
+	for (size_t i = 1; i < indptr.size(); i++) {
+		if (indptr[i] < indptr[i - 1]) {
+			throw std::runtime_error("Corrupt BIOM file: " + std::string(m.indptr_name) + " is not sorted");
+		}
+	}
+	return indptr;
+}
+
+void BIOMReader::read_entries(BIOMAxis axis, uint64_t begin, uint64_t end, BIOMEntries &out) const {
+	auto m = matrix(axis);
+	out.indices.resize(end - begin);
+	out.data.resize(end - begin);
+	read_dataset_range(m.indices, H5T_NATIVE_INT32, begin, end - begin, out.indices.data());
+	read_dataset_range(m.data, H5T_NATIVE_DOUBLE, begin, end - begin, out.data.data());
+}
+
+void BIOMReader::read_entries_raw(BIOMAxis axis, uint64_t begin, uint64_t end, BIOMRawEntries &out) const {
+	auto m = matrix(axis);
+	out.axis = axis;
+	out.begin = begin;
+	out.end = end;
+	out.direct = m.indices_layout.direct && m.data_layout.direct;
+	if (!out.direct) {
+		read_entries(axis, begin, end, out.decoded);
+		return;
+	}
+	hdf5_read_raw_range(m.indices, m.indices_layout, begin, end, out.indices);
+	hdf5_read_raw_range(m.data, m.data_layout, begin, end, out.data);
+}
+
+void BIOMReader::decode_entries(BIOMRawEntries &raw, BIOMEntries &out) const {
+	if (!raw.direct) {
+		std::swap(out.indices, raw.decoded.indices);
+		std::swap(out.data, raw.decoded.data);
+		return;
+	}
+	// Only the cached layouts are used here, no HDF5 calls
+	bool sample = raw.axis == BIOMAxis::SAMPLE;
+	out.indices.resize(raw.end - raw.begin);
+	out.data.resize(raw.end - raw.begin);
+	hdf5_decode_range(sample ? indices_layout : obs_indices_layout, raw.indices, out.indices.data());
+	hdf5_decode_range(sample ? data_layout : obs_data_layout, raw.data, out.data.data());
+}
+
 bool BIOMReader::IsBIOM(const std::string &path) {
 	const char *target = "format-version";
 
@@ -6,11 +6,12 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <string>
+#include <limits>
+#include <stdexcept>
 
 namespace miint {
 
-BIOMTable::BIOMTable()
-    : coo_feature_indices({}), coo_sample_indices({}), coo_values({}), feature_ids_ordered({}), sample_ids_ordered({}) {
+BIOMTable::BIOMTable() : csc({}, {}, {0}), feature_ids_ordered({}), sample_ids_ordered({}) {
 }
 
 BIOMTable::BIOMTable(hid_t ds_indices, hid_t ds_indptr, hid_t ds_data, hid_t ds_obs_ids, hid_t ds_samp_ids) {
@@ -18,35 +19,43 @@ BIOMTable::BIOMTable(hid_t ds_indices, hid_t ds_indptr, hid_t ds_data, hid_t ds_
 	// https://github.com/biocore/unifrac-binaries/blob/main/src/biom.cpp
 	feature_ids_ordered = load_dataset_1D_str(ds_obs_ids);
 	sample_ids_ordered = load_dataset_1D_str(ds_samp_ids);
-	std::vector<int32_t> indptr = load_dataset_1D<int32_t>(ds_indptr, H5T_NATIVE_INT32);
-	std::vector<int32_t> indices = load_dataset_1D<int32_t>(ds_indices, H5T_NATIVE_INT32);
-	coo_values = load_dataset_1D<double>(ds_data, H5T_NATIVE_DOUBLE);
-
-	InitCOOFromCSC(indptr, indices);
+	// sample/matrix is kept as stored: BIOM files are already in canonical form (sorted within each column, no
+	// duplicates, no zeros)
+	csc.indptr = load_dataset_1D<int32_t>(ds_indptr, H5T_NATIVE_INT32);
+	csc.indices = load_dataset_1D<int32_t>(ds_indices, H5T_NATIVE_INT32);
+	csc.data = load_dataset_1D<double>(ds_data, H5T_NATIVE_DOUBLE);
+	if (csc.indptr.empty()) {
+		csc.indptr.push_back(0);
+	}
 }
 BIOMTable::BIOMTable(const std::vector<std::string> &feature_ids, const std::vector<std::string> &sample_ids,
-                     const std::vector<double> &values)
-    : coo_values(values) {
-	InitCOOFromCOO(feature_ids, sample_ids);
+                     const std::vector<double> &values) {
+	InitCSCFromCOO(feature_ids, sample_ids, values);
 }
 
-BIOMTable::BIOMTable(const std::vector<size_t> &feature_indices, const std::vector<size_t> &sample_indices,
-                     const std::vector<double> &values, std::vector<std::string> feature_ids_ordered_param,
-                     std::vector<std::string> sample_ids_ordered_param)
-    : coo_feature_indices(feature_indices), coo_sample_indices(sample_indices), coo_values(values),
-      feature_ids_ordered(std::move(feature_ids_ordered_param)),
+template <typename Index>
+BIOMTable::BIOMTable(std::vector<Index> feature_indices, std::vector<Index> sample_indices,
+                     std::vector<double> values, std::vector<std::string> feature_ids_ordered_param,
+                     std::vector<std::string> sample_ids_ordered_param, size_t n_threads)
+    : feature_ids_ordered(std::move(feature_ids_ordered_param)),
       sample_ids_ordered(std::move(sample_ids_ordered_param)) {
 	// Compress COO (sort by row/column, deduplicate, remove zeros)
-	compress_coo();
+	compress_coo(feature_indices, sample_indices, values, n_threads);
 }
 
-void BIOMTable::InitCOOFromCOO(const std::vector<std::string> &feature_ids,
-                               const std::vector<std::string> &sample_ids) {
+template BIOMTable::BIOMTable(std::vector<size_t>, std::vector<size_t>, std::vector<double>,
+                              std::vector<std::string>, std::vector<std::string>, size_t);
+template BIOMTable::BIOMTable(std::vector<uint32_t>, std::vector<uint32_t>, std::vector<double>,
+                              std::vector<std::string>, std::vector<std::string>, size_t);
+
+void BIOMTable::InitCSCFromCOO(const std::vector<std::string> &feature_ids,
+                               const std::vector<std::string> &sample_ids, const std::vector<double> &values) {
 	feature_ids_ordered = unique_ids_in_order(feature_ids);
 	sample_ids_ordered = unique_ids_in_order(sample_ids);
-	coo_feature_indices = ids_to_indices(feature_ids, feature_ids_ordered);
-	coo_sample_indices = ids_to_indices(sample_ids, sample_ids_ordered);
-	compress_coo();
+	auto feature_indices = ids_to_indices(feature_ids, feature_ids_ordered);
+	auto sample_indices = ids_to_indices(sample_ids, sample_ids_ordered);
+	auto coo_values = values;
+	compress_coo(feature_indices, sample_indices, coo_values);
 }
 
 std::vector<size_t> ids_to_indices(const std::vector<std::string> &ids, const std::vector<std::string> &ordered) {
@@ -95,49 +104,21 @@ std::vector<std::string> unique_ids_in_order(const std::vector<std::string> &ids
 	return unique_ordered_ids;
 }
 
-void BIOMTable::InitCOOFromCSC(const std::vector<int32_t> &indptr, const std::vector<int32_t> &indices) {
-	auto nnz = coo_values.size();
-	auto n_cols = indptr.size() - 1;
-
-	coo_feature_indices.reserve(nnz);
-	coo_sample_indices.reserve(nnz);
-
-	for (size_t col = 0; col < n_cols; col++) {
-		auto start = indptr[col];
-		auto end = indptr[col + 1];
-
-		for (auto offset = start; offset < end; offset++) {
-			auto index = indices[offset];
-
-			coo_sample_indices.push_back(col);
-			coo_feature_indices.push_back(index);
-		}
-	}
-
-	// Skip compress_coo() since BIOM files are already in canonical form
-	// (sorted by row then column, no duplicates, no zeros)
+std::vector<size_t> BIOMTable::COOFeatureIndices() const {
+	return std::vector<size_t>(csc.indices.begin(), csc.indices.end());
 }
 
-std::vector<std::string> BIOMTable::indices_to_ids(const std::vector<size_t> &indices,
-                                                   const std::vector<std::string> &names) {
-	std::vector<std::string> result;
-	result.reserve(indices.size());
-	for (auto index : indices) {
-		result.push_back(names[index]);
+std::vector<size_t> BIOMTable::COOSampleIndices() const {
+	std::vector<size_t> sample_indices;
+	sample_indices.reserve(csc.data.size());
+	for (size_t col = 0; col + 1 < csc.indptr.size(); col++) {
+		sample_indices.insert(sample_indices.end(), csc.indptr[col + 1] - csc.indptr[col], col);
 	}
-
-	return result;
+	return sample_indices;
 }
 
-const std::vector<size_t> &BIOMTable::COOFeatureIndices() const {
-	return coo_feature_indices;
-}
-
-const std::vector<size_t> &BIOMTable::COOSampleIndices() const {
-	return coo_sample_indices;
-}
 const std::vector<double> &BIOMTable::COOValues() const {
-	return coo_values;
+	return csc.data;
 }
 
 std::vector<std::string> BIOMTable::load_dataset_1D_str(hid_t ds_id) {
@@ -258,12 +239,13 @@ std::vector<T> BIOMTable::load_dataset_1D(hid_t ds_id, hid_t exp_dtype) {
 	return data;
 }
 
-uint32_t BIOMTable::nnz() const {
-	auto values_size = coo_values.size();
-	auto sids_size = coo_sample_indices.size();
-	auto fids_size = coo_feature_indices.size();
+template std::vector<int32_t> BIOMTable::load_dataset_1D<int32_t>(hid_t ds_id, hid_t exp_dtype);
+template std::vector<double> BIOMTable::load_dataset_1D<double>(hid_t ds_id, hid_t exp_dtype);
 
-	if (values_size != sids_size || values_size != fids_size) {
+uint32_t BIOMTable::nnz() const {
+	auto values_size = csc.data.size();
+	if (values_size != csc.indices.size() || csc.indptr.empty() ||
+	    static_cast<size_t>(csc.indptr.back()) != values_size) {
 		throw std::runtime_error("Invalid data size on BIOM load");
 	}
 
@@ -327,137 +309,183 @@ void apply_permutation(std::vector<size_t> &rows, std::vector<size_t> &cols, std
 	}
 }
 
-void BIOMTable::compress_coo() {
-	auto n = coo_sample_indices.size();
+template <typename Index>
+std::vector<size_t> counting_sort_by_key(std::vector<Index> &keys, std::vector<Index> &others,
+                                         std::vector<double> &values, size_t n_keys, size_t n_threads) {
+	auto n = keys.size();
+	if (others.size() != n || values.size() != n) {
+		throw std::invalid_argument("Cannot sort: keys, others and values differ in length");
+	}
 	if (n == 0) {
-		return;
+		return std::vector<size_t>(n_keys + 1, 0);
+	}
+
+	// Every slice keeps its own histogram, so only split when those stay small next to the input
+	constexpr size_t MIN_SLICE_SIZE = 16384;
+	size_t n_slices = std::min({n_threads, n / std::max<size_t>(n_keys, 1), n / MIN_SLICE_SIZE});
+	n_slices = std::max<size_t>(n_slices, 1);
+	size_t slice_size = (n + n_slices - 1) / n_slices;
+
+	std::vector<std::vector<size_t>> positions(n_slices);
+	run_parallel(n_slices, n_threads, [&](size_t slice) {
+		auto &count = positions[slice];
+		count.assign(n_keys, 0);
+		auto end = std::min(n, (slice + 1) * slice_size);
+		for (size_t i = slice * slice_size; i < end; i++) {
+			if (keys[i] >= n_keys) {
+				throw std::out_of_range("Cannot sort: index " + std::to_string(keys[i]) + " is out of range");
+			}
+			count[keys[i]]++;
+		}
+	});
+
+	// Turn the counts into write positions: all of a key's entries from slice 0, then slice 1, ...
+	// which keeps the sort stable
+	std::vector<size_t> boundaries(n_keys + 1);
+	size_t position = 0;
+	for (size_t key = 0; key < n_keys; key++) {
+		boundaries[key] = position;
+		for (auto &count : positions) {
+			auto key_count = count[key];
+			count[key] = position;
+			position += key_count;
+		}
 	}
+	boundaries[n_keys] = position;
+
+	std::vector<Index> sorted_keys(n);
+	std::vector<Index> sorted_others(n);
+	std::vector<double> sorted_values(n);
+	run_parallel(n_slices, n_threads, [&](size_t slice) {
+		auto &next = positions[slice];
+		auto end = std::min(n, (slice + 1) * slice_size);
+		for (size_t i = slice * slice_size; i < end; i++) {
+			auto target = next[keys[i]]++;
+			sorted_keys[target] = keys[i];
+			sorted_others[target] = others[i];
+			sorted_values[target] = values[i];
+		}
+	});
 
-	// Sort by (sample, feature) for efficient duplicate merging and optimal CSC conversion
-	sort_by_row_then_column(coo_sample_indices, coo_feature_indices, coo_values);
+	keys = std::move(sorted_keys);
+	others = std::move(sorted_others);
+	values = std::move(sorted_values);
+	return boundaries;
+}
 
-	std::vector<size_t> coo_sample_indices_compressed;
-	std::vector<size_t> coo_feature_indices_compressed;
-	std::vector<double> coo_values_compressed;
+template std::vector<size_t> counting_sort_by_key(std::vector<size_t> &keys, std::vector<size_t> &others,
+                                                  std::vector<double> &values, size_t n_keys, size_t n_threads);
+template std::vector<size_t> counting_sort_by_key(std::vector<uint32_t> &keys, std::vector<uint32_t> &others,
+                                                  std::vector<double> &values, size_t n_keys, size_t n_threads);
 
-	coo_sample_indices_compressed.reserve(n);
-	coo_feature_indices_compressed.reserve(n);
-	coo_values_compressed.reserve(n);
+template <typename Index>
+void BIOMTable::compress_coo(std::vector<Index> &feature_indices, std::vector<Index> &sample_indices,
+                             std::vector<double> &values, size_t n_threads) {
+	auto n = sample_indices.size();
 
-	size_t last_row = coo_sample_indices[0];
-	size_t last_col = coo_feature_indices[0];
-	double accum_value = coo_values[0];
+	// Sort by (sample, feature) for efficient duplicate merging: a stable counting sort by feature followed by
+	// one by sample, each linear in the number of entries. The second one's boundaries delimit the columns.
+	counting_sort_by_key(feature_indices, sample_indices, values, NumFeatures(), n_threads);
+	auto boundaries = counting_sort_by_key(sample_indices, feature_indices, values, NumSamples(), n_threads);
+	std::vector<Index>().swap(sample_indices);
 
 	// Epsilon for zero comparison (accounts for floating-point rounding errors)
 	constexpr double EPSILON = 1e-10;
 
-	for (size_t i = 1; i < n; i++) {
-		size_t current_row = coo_sample_indices[i];
-		size_t current_col = coo_feature_indices[i];
-		double current_value = coo_values[i];
-
-		if (current_row == last_row && current_col == last_col) {
+	csc.indices.clear();
+	csc.data.clear();
+	csc.indices.reserve(n);
+	csc.data.reserve(n);
+	csc.indptr.assign(NumSamples() + 1, 0);
+	for (size_t col = 0; col < NumSamples(); col++) {
+		size_t i = boundaries[col];
+		while (i < boundaries[col + 1]) {
 			// Merge duplicate (feature, sample) pairs by summing values
-			accum_value += current_value;
-		} else {
+			auto feature = feature_indices[i];
+			double accum_value = 0;
+			for (; i < boundaries[col + 1] && feature_indices[i] == feature; i++) {
+				accum_value += values[i];
+			}
 			// Only keep non-zero values (sparse matrix format)
 			if (accum_value > EPSILON) {
-				coo_sample_indices_compressed.push_back(last_row);
-				coo_feature_indices_compressed.push_back(last_col);
-				coo_values_compressed.push_back(accum_value);
+				csc.indices.push_back(static_cast<int32_t>(feature));
+				csc.data.push_back(accum_value);
 			}
-
-			last_row = current_row;
-			last_col = current_col;
-			accum_value = current_value;
 		}
+		if (csc.data.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+			throw std::runtime_error("Too many entries for a BIOM table (>2.1B), exceeds int32_t limit");
+		}
+		csc.indptr[col + 1] = static_cast<int32_t>(csc.data.size());
 	}
-
-	// Handle final accumulated value
-	if (accum_value > EPSILON) {
-		coo_sample_indices_compressed.push_back(last_row);
-		coo_feature_indices_compressed.push_back(last_col);
-		coo_values_compressed.push_back(accum_value);
-	}
-
-	coo_sample_indices = std::move(coo_sample_indices_compressed);
-	coo_feature_indices = std::move(coo_feature_indices_compressed);
-	coo_values = std::move(coo_values_compressed);
-}
-
-SparseMatrix BIOMTable::ToCSR() const {
-	// CSR: features are rows (major axis), samples are columns (minor axis)
-	// Sort by (feature, sample) and build row pointers
-	return ConvertCOOToCompressed(true);
+	csc.indices.shrink_to_fit();
+	csc.data.shrink_to_fit();
 }
 
-SparseMatrix BIOMTable::ToCSC() const {
-	// CSC: samples are columns (major axis), features are rows (minor axis)
-	// Sort by (sample, feature) and build column pointers
-	// Note: COO is already sorted by (sample, feature) after compress_coo()
-	return ConvertCOOToCompressed(false);
-}
-
-SparseMatrix BIOMTable::ConvertCOOToCompressed(bool by_row) const {
-	// Convert COO to compressed format (CSR or CSC)
-	// by_row=true:  CSR (features=rows=major, samples=cols=minor)
-	// by_row=false: CSC (samples=cols=major, features=rows=minor)
-
-	auto n_major = by_row ? NumFeatures() : NumSamples();
-	auto n_values = coo_values.size();
-
+SparseMatrix BIOMTable::ToCSR(size_t n_threads) const {
+	// CSR: features are rows (major axis), samples are columns (minor axis). A counting sort of the entries by
+	// feature; scattering the columns in order keeps each row's samples ascending.
+	auto n_features = NumFeatures();
+	auto n_samples = NumSamples();
+	auto n_values = csc.data.size();
 	if (n_values == 0) {
 		return SparseMatrix({}, {}, {0});
 	}
 
-	// Create index array for sorting
-	std::vector<size_t> sort_indices(n_values);
-	std::iota(sort_indices.begin(), sort_indices.end(), 0);
-
-	// Sort by (major_axis, minor_axis)
-	if (by_row) {
-		// CSR: sort by (feature, sample) - need to re-sort since compress_coo sorts by (sample, feature)
-		std::ranges::sort(sort_indices, [&](size_t i, size_t j) {
-			return std::tie(coo_feature_indices[i], coo_sample_indices[i]) <
-			       std::tie(coo_feature_indices[j], coo_sample_indices[j]);
-		});
-	}
-	// else: CSC doesn't need sorting - compress_coo already sorted by (sample, feature)
-
-	// Build compressed arrays
-	std::vector<double> data;
-	std::vector<int32_t> minor_indices; // column indices for CSR, row indices for CSC
-	std::vector<int32_t> indptr;        // row pointers for CSR, column pointers for CSC
-
-	data.reserve(n_values);
-	minor_indices.reserve(n_values);
-	indptr.reserve(n_major + 1);
-
-	indptr.push_back(0);
-
-	size_t current_major = 0;
-	for (size_t i = 0; i < n_values; i++) {
-		auto idx = sort_indices[i];
-		auto major_axis = by_row ? coo_feature_indices[idx] : coo_sample_indices[idx];
-		auto minor_axis = by_row ? coo_sample_indices[idx] : coo_feature_indices[idx];
-		auto value = coo_values[idx];
-
-		// Add indptr entries for any empty major axis positions
-		while (current_major < major_axis) {
-			indptr.push_back(static_cast<int32_t>(data.size()));
-			current_major++;
+	// Every slice of columns keeps its own histogram, so only split when those stay small next to the input
+	constexpr size_t MIN_SLICE_SIZE = 16384;
+	size_t n_slices = std::min({n_threads, n_values / std::max<size_t>(n_features, 1), n_values / MIN_SLICE_SIZE,
+	                            n_samples});
+	n_slices = std::max<size_t>(n_slices, 1);
+	// Slices hold contiguous columns with about the same number of entries
+	std::vector<size_t> slice_cols(n_slices + 1, n_samples);
+	slice_cols[0] = 0;
+	for (size_t slice = 1, col = 0; slice < n_slices; slice++) {
+		auto target = n_values * slice / n_slices;
+		while (col < n_samples && static_cast<size_t>(csc.indptr[col]) < target) {
+			col++;
 		}
-
-		data.push_back(value);
-		minor_indices.push_back(static_cast<int32_t>(minor_axis));
+		slice_cols[slice] = col;
 	}
 
-	// Add final indptr entries for any trailing empty major axis positions
-	while (current_major < n_major) {
-		indptr.push_back(static_cast<int32_t>(data.size()));
-		current_major++;
+	std::vector<std::vector<size_t>> positions(n_slices);
+	run_parallel(n_slices, n_threads, [&](size_t slice) {
+		auto &count = positions[slice];
+		count.assign(n_features, 0);
+		for (auto i = csc.indptr[slice_cols[slice]]; i < csc.indptr[slice_cols[slice + 1]]; i++) {
+			if (csc.indices[i] < 0 || static_cast<size_t>(csc.indices[i]) >= n_features) {
+				throw std::out_of_range("Cannot transpose: index " + std::to_string(csc.indices[i]) +
+				                        " is out of range");
+			}
+			count[csc.indices[i]]++;
+		}
+	});
+
+	// Turn the counts into write positions: all of a feature's entries from slice 0, then slice 1, ...
+	std::vector<int32_t> indptr(n_features + 1);
+	size_t position = 0;
+	for (size_t feature = 0; feature < n_features; feature++) {
+		indptr[feature] = static_cast<int32_t>(position);
+		for (auto &count : positions) {
+			auto feature_count = count[feature];
+			count[feature] = position;
+			position += feature_count;
+		}
 	}
+	indptr[n_features] = static_cast<int32_t>(position);
+
+	std::vector<int32_t> indices(n_values);
+	std::vector<double> data(n_values);
+	run_parallel(n_slices, n_threads, [&](size_t slice) {
+		auto &next = positions[slice];
+		for (auto col = slice_cols[slice]; col < slice_cols[slice + 1]; col++) {
+			for (auto i = csc.indptr[col]; i < csc.indptr[col + 1]; i++) {
+				auto target = next[csc.indices[i]]++;
+				indices[target] = static_cast<int32_t>(col);
+				data[target] = csc.data[i];
+			}
+		}
+	});
 
-	return SparseMatrix(std::move(data), std::move(minor_indices), std::move(indptr));
+	return SparseMatrix(std::move(data), std::move(indices), std::move(indptr));
 }
 } // namespace miint
@@ -0,0 +1,82 @@
+#include "BetaDiversity.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace miint {
+
+BetaMetric parse_beta_metric(const std::string &name) {
+	if (name == "braycurtis") {
+		return BetaMetric::BRAY_CURTIS;
+	}
+	if (name == "jaccard") {
+		return BetaMetric::JACCARD;
+	}
+	throw std::runtime_error("Unknown beta diversity metric '" + name + "', expected 'braycurtis' or 'jaccard'");
+}
+
+BetaDiversity::BetaDiversity(const uint64_t *indptr, const uint32_t *features, const double *values,
+                             size_t n_samples, size_t n_features, BetaMetric metric)
+    : indptr(indptr), features(features), values(values), n_samples(n_samples), metric(metric) {
+	uint64_t nnz = indptr[n_samples];
+
+	// Transpose by counting sort; walking the rows in order leaves the samples of each column sorted
+	column_indptr.assign(n_features + 1, 0);
+	for (uint64_t e = 0; e < nnz; e++) {
+		column_indptr[features[e] + 1]++;
+	}
+	for (size_t k = 0; k < n_features; k++) {
+		column_indptr[k + 1] += column_indptr[k];
+	}
+	column_samples.resize(nnz);
+	column_values.resize(nnz);
+	column_position.resize(nnz);
+	totals.assign(n_samples, 0);
+	std::vector<uint64_t> next(column_indptr.begin(), column_indptr.end() - 1);
+	for (size_t i = 0; i < n_samples; i++) {
+		for (uint64_t e = indptr[i]; e < indptr[i + 1]; e++) {
+			if (values[e] < 0) {
+				throw std::runtime_error("Beta diversity needs non-negative values");
+			}
+			auto p = next[features[e]]++;
+			column_samples[p] = static_cast<uint32_t>(i);
+			column_values[p] = values[e];
+			column_position[e] = p;
+			totals[i] += metric == BetaMetric::BRAY_CURTIS ? values[e] : (values[e] > 0 ? 1 : 0);
+		}
+	}
+}
+
+void BetaDiversity::row(size_t i, std::vector<double> &scratch, std::vector<double> &out) const {
+	scratch.resize(n_samples, 0);
+	out.resize(n_samples - i - 1);
+
+	// Shared abundance (sum of minima) or number of shared features with every later sample
+	for (uint64_t e = indptr[i]; e < indptr[i + 1]; e++) {
+		double value = values[e];
+		if (value == 0) {
+			continue;
+		}
+		auto column_end = column_indptr[features[e] + 1];
+		if (metric == BetaMetric::BRAY_CURTIS) {
+			for (uint64_t p = column_position[e] + 1; p < column_end; p++) {
+				scratch[column_samples[p]] += std::min(value, column_values[p]);
+			}
+		} else {
+			for (uint64_t p = column_position[e] + 1; p < column_end; p++) {
+				scratch[column_samples[p]] += column_values[p] > 0 ? 1 : 0;
+			}
+		}
+	}
+
+	// Turn the shared terms into distances, clearing the scratch row for the next call
+	double total_i = totals[i];
+	for (size_t j = i + 1; j < n_samples; j++) {
+		double shared = scratch[j];
+		scratch[j] = 0;
+		double denominator = metric == BetaMetric::BRAY_CURTIS ? total_i + totals[j] : total_i + totals[j] - shared;
+		double similarity = metric == BetaMetric::BRAY_CURTIS ? 2 * shared : shared;
+		out[j - i - 1] = denominator > 0 ? 1.0 - similarity / denominator : 0.0;
+	}
+}
+
+} // namespace miint
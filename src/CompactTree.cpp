@@ -0,0 +1,175 @@
+#include "CompactTree.hpp"
+#include "NewickStream.hpp"
+#include <algorithm>
+
+namespace miint {
+
+CompactTree::CompactTree(const NewickTree &tree) {
+	size_t n = tree.num_nodes();
+	root_ = n == 0 ? NO_NODE : tree.root();
+	parent_.resize(n);
+	child_offsets.resize(n + 1, 0);
+	children_.reserve(n == 0 ? 0 : n - 1);
+	branch_length_.resize(n);
+	edge_id_.assign(n, 0);
+	has_edge_id.assign(n, false);
+	name_start.resize(n);
+	name_length.resize(n);
+
+	size_t total_length = 0;
+	for (uint32_t node = 0; node < n; node++) {
+		total_length += tree.name(node).size();
+	}
+	names.reserve(total_length);
+
+	for (uint32_t node = 0; node < n; node++) {
+		parent_[node] = tree.parent(node);
+		const auto &children = tree.children(node);
+		children_.insert(children_.end(), children.begin(), children.end());
+		child_offsets[node + 1] = static_cast<uint32_t>(children_.size());
+		branch_length_[node] = tree.branch_length(node);
+		auto edge_id = tree.edge_id(node);
+		if (edge_id.has_value()) {
+			edge_id_[node] = edge_id.value();
+			has_edge_id[node] = true;
+		}
+		name_start[node] = names.size();
+		name_length[node] = static_cast<uint32_t>(tree.name(node).size());
+		names += tree.name(node);
+	}
+	build_indexes();
+}
+
+CompactTree::CompactTree(std::string_view newick) {
+	NewickStreamParser parser(newick);
+	NewickRow row;
+	while (parser.next(row)) {
+		// A node is returned after its children but before its parent, which comes later in the numbering
+		size_t last = row.parent == NewickStreamParser::NO_PARENT ? row.node : row.parent;
+		if (parent_.size() <= last) {
+			parent_.resize(last + 1, NO_NODE);
+			branch_length_.resize(last + 1);
+			edge_id_.resize(last + 1, 0);
+			has_edge_id.resize(last + 1, false);
+			name_start.resize(last + 1);
+			name_length.resize(last + 1);
+		}
+		if (row.parent == NewickStreamParser::NO_PARENT) {
+			root_ = row.node;
+		}
+		parent_[row.node] = row.parent;
+		branch_length_[row.node] = row.branch_length;
+		if (row.edge_id.has_value()) {
+			edge_id_[row.node] = row.edge_id.value();
+			has_edge_id[row.node] = true;
+		}
+		name_start[row.node] = names.size();
+		name_length[row.node] = static_cast<uint32_t>(row.name.size());
+		names += row.name;
+	}
+	// The arrays grew by doubling
+	parent_.shrink_to_fit();
+	branch_length_.shrink_to_fit();
+	edge_id_.shrink_to_fit();
+	has_edge_id.shrink_to_fit();
+	name_start.shrink_to_fit();
+	name_length.shrink_to_fit();
+	names.shrink_to_fit();
+
+	// Children are numbered in the order they are parsed, so bucketing nodes by parent in index order keeps each
+	// node's children in order
+	size_t n = parent_.size();
+	child_offsets.assign(n + 1, 0);
+	for (uint32_t node = 0; node < n; node++) {
+		if (parent_[node] != NO_NODE) {
+			child_offsets[parent_[node] + 1]++;
+		}
+	}
+	for (size_t node = 0; node < n; node++) {
+		child_offsets[node + 1] += child_offsets[node];
+	}
+	children_.resize(child_offsets[n]);
+	std::vector<uint32_t> next(child_offsets.begin(), child_offsets.end() - 1);
+	for (uint32_t node = 0; node < n; node++) {
+		if (parent_[node] != NO_NODE) {
+			children_[next[parent_[node]]++] = node;
+		}
+	}
+	build_indexes();
+}
+
+void CompactTree::build_indexes() {
+	size_t n = num_nodes();
+	n_tips = 0;
+	for (uint32_t node = 0; node < n; node++) {
+		n_tips += is_tip(node);
+		if (has_edge_id[node]) {
+			auto inserted = edge_index.emplace(edge_id_[node], node);
+			if (!inserted.second) {
+				inserted.first->second = AMBIGUOUS;
+			}
+		}
+	}
+
+	// names is complete, so views into it stay valid
+	name_index.reserve(n);
+	for (uint32_t node = 0; node < n; node++) {
+		auto node_name = name(node);
+		if (node_name.empty()) {
+			continue;
+		}
+		auto inserted = name_index.emplace(node_name, node);
+		if (!inserted.second) {
+			inserted.first->second = AMBIGUOUS;
+		}
+	}
+}
+
+std::vector<uint32_t> CompactTree::preorder() const {
+	std::vector<uint32_t> result;
+	result.reserve(num_nodes());
+	if (root_ == NO_NODE) {
+		return result;
+	}
+	std::vector<uint32_t> stack {root_};
+	while (!stack.empty()) {
+		uint32_t node = stack.back();
+		stack.pop_back();
+		result.push_back(node);
+		// Pushed in reverse so the first child is visited first
+		auto node_children = children(node);
+		stack.insert(stack.end(), node_children.rbegin(), node_children.rend());
+	}
+	return result;
+}
+
+std::vector<uint32_t> CompactTree::postorder() const {
+	// The preorder of the tree with every node's children reversed, read backwards
+	std::vector<uint32_t> result;
+	result.reserve(num_nodes());
+	if (root_ == NO_NODE) {
+		return result;
+	}
+	std::vector<uint32_t> stack {root_};
+	while (!stack.empty()) {
+		uint32_t node = stack.back();
+		stack.pop_back();
+		result.push_back(node);
+		auto node_children = children(node);
+		stack.insert(stack.end(), node_children.begin(), node_children.end());
+	}
+	std::reverse(result.begin(), result.end());
+	return result;
+}
+
+size_t CompactTree::memory_usage() const {
+	size_t n = num_nodes();
+	// parent, child offsets, children and name lengths; branch lengths, edge ids and name starts; the edge id bits
+	size_t arrays = n * (4 * sizeof(uint32_t) + sizeof(double) + sizeof(int64_t) + sizeof(uint64_t)) + n / 8;
+	// Rough per-entry cost of a node-based hash map: the key and value, a next pointer and a bucket
+	size_t name_hash = name_index.size() * (sizeof(std::string_view) + sizeof(uint32_t) + 2 * sizeof(void *));
+	size_t edge_hash = edge_index.size() * (sizeof(int64_t) + sizeof(uint32_t) + 2 * sizeof(void *));
+	return arrays + names.capacity() + name_hash + edge_hash;
+}
+
+} // namespace miint
@@ -0,0 +1,69 @@
+#include "FaithPD.hpp"
+#include <cmath>
+
+namespace miint {
+
+FaithPDTree::FaithPDTree(const NewickTree &tree) {
+	init(tree);
+}
+
+FaithPDTree::FaithPDTree(const CompactTree &tree) {
+	init(tree);
+}
+
+template <typename Tree>
+void FaithPDTree::init(const Tree &tree) {
+	size_t n = tree.num_nodes();
+	parent.resize(n);
+	length.resize(n);
+	size_t n_tips = 0;
+	for (uint32_t node = 0; node < n; node++) {
+		parent[node] = tree.parent(node);
+		double branch_length = tree.branch_length(node);
+		length[node] = std::isnan(branch_length) ? 0.0 : branch_length;
+		n_tips += tree.is_tip(node);
+	}
+	length[tree.root()] = 0.0;
+
+	// tip_index holds views into tip_names, which must not reallocate once filled
+	tip_names.reserve(n_tips);
+	tip_index.reserve(n_tips);
+	for (uint32_t node = 0; node < n; node++) {
+		if (!tree.is_tip(node)) {
+			continue;
+		}
+		tip_names.emplace_back(tree.name(node));
+		auto inserted = tip_index.emplace(tip_names.back(), node);
+		if (!inserted.second) {
+			inserted.first->second = AMBIGUOUS_TIP;
+		}
+	}
+}
+
+double FaithPDTree::pd(const std::vector<uint32_t> &tips, std::vector<uint64_t> &visited) const {
+	double total = 0;
+	// Each walk stops at the first node an earlier walk reached, so every branch is added once
+	for (auto tip : tips) {
+		for (auto node = tip; node != NewickTree::NO_PARENT; node = parent[node]) {
+			uint64_t bit = uint64_t(1) << (node % 64);
+			if (visited[node / 64] & bit) {
+				break;
+			}
+			visited[node / 64] |= bit;
+			total += length[node];
+		}
+	}
+	// Clear the bits set above by walking the same paths, rather than the whole bitmap
+	for (auto tip : tips) {
+		for (auto node = tip; node != NewickTree::NO_PARENT; node = parent[node]) {
+			uint64_t bit = uint64_t(1) << (node % 64);
+			if (!(visited[node / 64] & bit)) {
+				break;
+			}
+			visited[node / 64] &= ~bit;
+		}
+	}
+	return total;
+}
+
+} // namespace miint
@@ -0,0 +1,140 @@
+#include "FastxIndex.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace miint {
+
+// On-disk layout (all integers little-endian):
+//   "MFXI", u32 version, u64 interval, u64 flags (bit 0: compressed), u64 record_count,
+//   u64 uncompressed_size, u64 file_size, u64 entry_count, entry_count x (u64 record, u64 offset,
+//   u64 virtual_offset)
+static constexpr char FASTX_INDEX_MAGIC[4] = {'M', 'F', 'X', 'I'};
+static constexpr uint32_t FASTX_INDEX_VERSION = 1;
+static constexpr size_t FASTX_INDEX_HEADER_SIZE = 4 + 4 + 6 * 8;
+static constexpr size_t FASTX_INDEX_ENTRY_SIZE = 3 * 8;
+
+static void put_u64(std::string &out, uint64_t value) {
+	for (int i = 0; i < 8; i++) {
+		out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+}
+
+static uint64_t get_u64(const std::string &data, size_t &pos) {
+	uint64_t value = 0;
+	for (int i = 0; i < 8; i++) {
+		value |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+	}
+	pos += 8;
+	return value;
+}
+
+FastxIndex::FastxIndex(uint64_t interval_p, bool compressed_p) : interval(interval_p), compressed(compressed_p) {
+	if (interval == 0) {
+		throw std::invalid_argument("FASTX index interval must be greater than 0");
+	}
+}
+
+void FastxIndex::add_block(const std::vector<uint64_t> &record_offsets, uint64_t buffer_length,
+                           uint64_t compressed_start, const std::vector<uint64_t> &bgzf_block_sizes) {
+	// Offsets are ascending, so the compressed start of each block is a running prefix sum
+	size_t block = 0;
+	uint64_t block_start = compressed_start;
+	for (size_t i = 0; i < record_offsets.size(); i++) {
+		uint64_t record = record_count + i;
+		if (record % interval != 0) {
+			continue;
+		}
+		uint64_t offset = record_offsets[i];
+		uint64_t virtual_offset = 0;
+		if (compressed) {
+			size_t target = offset / BGZF_BLOCK_DATA_SIZE;
+			if (target >= bgzf_block_sizes.size()) {
+				throw std::invalid_argument("FASTX index record offset lies beyond the compressed blocks");
+			}
+			for (; block < target; block++) {
+				block_start += bgzf_block_sizes[block];
+			}
+			virtual_offset = (block_start << 16) | (offset % BGZF_BLOCK_DATA_SIZE);
+		}
+		entries.push_back({record, uncompressed_size + offset, virtual_offset});
+	}
+	record_count += record_offsets.size();
+	uncompressed_size += buffer_length;
+}
+
+const FastxIndexEntry &FastxIndex::seek(uint64_t record) const {
+	if (entries.empty()) {
+		throw std::out_of_range("FASTX index has no entries");
+	}
+	auto it = std::upper_bound(entries.begin(), entries.end(), record,
+	                           [](uint64_t value, const FastxIndexEntry &entry) { return value < entry.record; });
+	if (it == entries.begin()) {
+		return entries.front();
+	}
+	return *(it - 1);
+}
+
+std::string FastxIndex::serialize() const {
+	std::string out;
+	out.reserve(FASTX_INDEX_HEADER_SIZE + entries.size() * FASTX_INDEX_ENTRY_SIZE);
+	out.append(FASTX_INDEX_MAGIC, sizeof(FASTX_INDEX_MAGIC));
+	for (int i = 0; i < 4; i++) {
+		out.push_back(static_cast<char>((FASTX_INDEX_VERSION >> (8 * i)) & 0xff));
+	}
+	put_u64(out, interval);
+	put_u64(out, compressed ? 1 : 0);
+	put_u64(out, record_count);
+	put_u64(out, uncompressed_size);
+	put_u64(out, file_size);
+	put_u64(out, entries.size());
+	for (const auto &entry : entries) {
+		put_u64(out, entry.record);
+		put_u64(out, entry.offset);
+		put_u64(out, entry.virtual_offset);
+	}
+	return out;
+}
+
+FastxIndex FastxIndex::deserialize(const std::string &data) {
+	if (data.size() < FASTX_INDEX_HEADER_SIZE || data.compare(0, 4, FASTX_INDEX_MAGIC, 4) != 0) {
+		throw std::runtime_error("Not a FASTX index (bad magic or truncated header)");
+	}
+	uint32_t version = 0;
+	for (int i = 0; i < 4; i++) {
+		version |= static_cast<uint32_t>(static_cast<unsigned char>(data[4 + i])) << (8 * i);
+	}
+	if (version != FASTX_INDEX_VERSION) {
+		throw std::runtime_error("Unsupported FASTX index version " + std::to_string(version));
+	}
+
+	size_t pos = 8;
+	uint64_t interval = get_u64(data, pos);
+	uint64_t flags = get_u64(data, pos);
+	if (interval == 0) {
+		throw std::runtime_error("Invalid FASTX index interval 0");
+	}
+	FastxIndex index(interval, (flags & 1) != 0);
+	index.record_count = get_u64(data, pos);
+	index.uncompressed_size = get_u64(data, pos);
+	index.file_size = get_u64(data, pos);
+	uint64_t entry_count = get_u64(data, pos);
+	if ((data.size() - FASTX_INDEX_HEADER_SIZE) / FASTX_INDEX_ENTRY_SIZE != entry_count ||
+	    (data.size() - FASTX_INDEX_HEADER_SIZE) % FASTX_INDEX_ENTRY_SIZE != 0) {
+		throw std::runtime_error("Truncated FASTX index: expected " + std::to_string(entry_count) + " entries");
+	}
+
+	index.entries.reserve(entry_count);
+	for (uint64_t i = 0; i < entry_count; i++) {
+		FastxIndexEntry entry;
+		entry.record = get_u64(data, pos);
+		entry.offset = get_u64(data, pos);
+		entry.virtual_offset = get_u64(data, pos);
+		if (entry.record >= index.record_count || (i > 0 && entry.record <= index.entries.back().record)) {
+			throw std::runtime_error("Corrupt FASTX index: entries out of order");
+		}
+		index.entries.push_back(entry);
+	}
+	return index;
+}
+
+} // namespace miint
@@ -0,0 +1,268 @@
+#include "HDF5Chunks.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <zlib.h>
+
+namespace miint {
+
+std::recursive_mutex &hdf5_lock() {
+	static std::recursive_mutex lock;
+	return lock;
+}
+
+HDF5ChunkLayout HDF5ChunkLayout::inspect(hid_t ds_id) {
+	HDF5ChunkLayout layout;
+	hid_t dcpl = H5Dget_create_plist(ds_id);
+	hid_t dtype = H5Dget_type(ds_id);
+	bool supported = dcpl >= 0 && dtype >= 0 && H5Pget_layout(dcpl) == H5D_CHUNKED;
+
+	if (supported) {
+		hsize_t chunk_dims[1] = {0};
+		supported = H5Pget_chunk(dcpl, 1, chunk_dims) == 1 && chunk_dims[0] > 0;
+		layout.chunk_elements = chunk_dims[0];
+	}
+
+	if (supported) {
+		// Raw chunks hold the stored bytes, so only types this host can reinterpret directly are decoded here
+		H5T_class_t type_class = H5Tget_class(dtype);
+		layout.element_size = H5Tget_size(dtype);
+		layout.is_float = type_class == H5T_FLOAT;
+		layout.is_signed = type_class == H5T_INTEGER && H5Tget_sign(dtype) == H5T_SGN_2;
+		bool little_endian = H5Tget_order(dtype) == H5T_ORDER_LE && H5Tget_order(H5T_NATIVE_INT32) == H5T_ORDER_LE;
+		if (type_class == H5T_FLOAT) {
+			supported = little_endian && (H5Tequal(dtype, H5T_IEEE_F32LE) > 0 || H5Tequal(dtype, H5T_IEEE_F64LE) > 0);
+		} else if (type_class == H5T_INTEGER) {
+			supported = little_endian && (layout.element_size == 1 || layout.element_size == 2 ||
+			                              layout.element_size == 4 || layout.element_size == 8);
+		} else {
+			supported = false;
+		}
+	}
+
+	if (supported) {
+		int n_filters = H5Pget_nfilters(dcpl);
+		supported = n_filters >= 0;
+		for (int i = 0; supported && i < n_filters; i++) {
+			unsigned flags = 0;
+			size_t n_values = 0;
+			H5Z_filter_t filter = H5Pget_filter2(dcpl, static_cast<unsigned>(i), &flags, &n_values, nullptr, 0,
+			                                     nullptr, nullptr);
+			supported = filter == H5Z_FILTER_DEFLATE || filter == H5Z_FILTER_SHUFFLE || filter == H5Z_FILTER_LZF;
+			layout.filters.push_back(filter);
+		}
+	}
+
+	if (dtype >= 0) {
+		H5Tclose(dtype);
+	}
+	if (dcpl >= 0) {
+		H5Pclose(dcpl);
+	}
+	layout.direct = supported;
+	return layout;
+}
+
+void hdf5_read_raw_range(hid_t ds_id, const HDF5ChunkLayout &layout, uint64_t begin, uint64_t end,
+                         HDF5RawRange &out) {
+	if (!layout.direct) {
+		throw std::runtime_error("Dataset chunks cannot be read directly");
+	}
+	hid_t space = H5Dget_space(ds_id);
+	if (space < 0) {
+		throw std::runtime_error("Failed to access dataspace");
+	}
+	hsize_t dims[1] = {0};
+	H5Sget_simple_extent_dims(space, dims, nullptr);
+	H5Sclose(space);
+	if (end > dims[0]) {
+		throw std::runtime_error("Dataset range [" + std::to_string(begin) + ", " + std::to_string(end) +
+		                         ") exceeds its " + std::to_string(dims[0]) + " elements");
+	}
+
+	out.begin = begin;
+	out.end = end;
+	if (begin >= end) {
+		out.chunks.clear();
+		out.filter_masks.clear();
+		return;
+	}
+
+	out.first_chunk = begin / layout.chunk_elements;
+	uint64_t n_chunks = (end - 1) / layout.chunk_elements - out.first_chunk + 1;
+	out.chunks.resize(n_chunks);
+	out.filter_masks.assign(n_chunks, 0);
+	for (uint64_t i = 0; i < n_chunks; i++) {
+		hsize_t offset[1] = {(out.first_chunk + i) * layout.chunk_elements};
+		hsize_t n_bytes = 0;
+		if (H5Dget_chunk_storage_size(ds_id, offset, &n_bytes) < 0) {
+			throw std::runtime_error("Failed to locate chunk at element " + std::to_string(offset[0]));
+		}
+		// Chunks never written are left empty and decode to the (zero) fill value
+		out.chunks[i].resize(n_bytes);
+		if (n_bytes > 0 &&
+		    H5Dread_chunk(ds_id, H5P_DEFAULT, offset, &out.filter_masks[i], out.chunks[i].data()) < 0) {
+			throw std::runtime_error("Failed to read chunk at element " + std::to_string(offset[0]));
+		}
+	}
+}
+
+size_t lzf_decompress(const char *in, size_t in_size, char *out, size_t out_capacity) {
+	auto ip = reinterpret_cast<const uint8_t *>(in);
+	auto in_end = ip + in_size;
+	size_t op = 0;
+
+	while (ip < in_end) {
+		unsigned ctrl = *ip++;
+		if (ctrl < (1 << 5)) {
+			// Literal run of ctrl + 1 bytes
+			size_t length = ctrl + 1;
+			if (op + length > out_capacity || ip + length > in_end) {
+				throw std::runtime_error("Corrupt LZF data");
+			}
+			std::memcpy(out + op, ip, length);
+			ip += length;
+			op += length;
+		} else {
+			// Back reference of length + 2 bytes, possibly overlapping the bytes it produces
+			size_t length = ctrl >> 5;
+			if (length == 7) {
+				if (ip >= in_end) {
+					throw std::runtime_error("Corrupt LZF data");
+				}
+				length += *ip++;
+			}
+			length += 2;
+			if (ip >= in_end) {
+				throw std::runtime_error("Corrupt LZF data");
+			}
+			size_t distance = ((ctrl & 0x1f) << 8) + *ip++ + 1;
+			if (distance > op || op + length > out_capacity) {
+				throw std::runtime_error("Corrupt LZF data");
+			}
+			for (size_t i = 0; i < length; i++, op++) {
+				out[op] = out[op - distance];
+			}
+		}
+	}
+	return op;
+}
+
+namespace {
+
+// Undo the filter pipeline of one chunk. Returns the decoded bytes, which live in either in or scratch.
+const std::vector<char> &unfilter_chunk(const HDF5ChunkLayout &layout, const std::vector<char> &in, uint32_t mask,
+                                        std::vector<char> &buffer, std::vector<char> &scratch, size_t &size) {
+	size_t chunk_bytes = layout.chunk_elements * layout.element_size;
+	const std::vector<char> *current = &in;
+	size = in.size();
+
+	for (size_t i = layout.filters.size(); i-- > 0;) {
+		if (mask & (1u << i)) {
+			continue; // filter was skipped for this chunk when it was written
+		}
+		std::vector<char> &next = (current == &buffer) ? scratch : buffer;
+		switch (layout.filters[i]) {
+		case H5Z_FILTER_DEFLATE: {
+			next.resize(chunk_bytes);
+			uLongf length = chunk_bytes;
+			if (uncompress(reinterpret_cast<Bytef *>(next.data()), &length,
+			               reinterpret_cast<const Bytef *>(current->data()), size) != Z_OK) {
+				throw std::runtime_error("Failed to inflate chunk");
+			}
+			size = length;
+			break;
+		}
+		case H5Z_FILTER_SHUFFLE: {
+			// Bytes were grouped by their position within the element; interleave them again
+			next.resize(size);
+			size_t n_elements = size / layout.element_size;
+			for (size_t b = 0; b < layout.element_size; b++) {
+				const char *src = current->data() + b * n_elements;
+				for (size_t e = 0; e < n_elements; e++) {
+					next[e * layout.element_size + b] = src[e];
+				}
+			}
+			size_t tail = n_elements * layout.element_size;
+			std::memcpy(next.data() + tail, current->data() + tail, size - tail);
+			break;
+		}
+		case H5Z_FILTER_LZF:
+			next.resize(chunk_bytes);
+			size = lzf_decompress(current->data(), size, next.data(), chunk_bytes);
+			break;
+		default:
+			throw std::runtime_error("Unsupported HDF5 filter " + std::to_string(layout.filters[i]));
+		}
+		current = &next;
+	}
+	return *current;
+}
+
+template <typename S, typename T>
+void convert_elements(const char *in, size_t n, T *out) {
+	for (size_t i = 0; i < n; i++) {
+		S value;
+		std::memcpy(&value, in + i * sizeof(S), sizeof(S));
+		out[i] = static_cast<T>(value);
+	}
+}
+
+template <typename T>
+void convert_elements(const HDF5ChunkLayout &layout, const char *in, size_t n, T *out) {
+	if (layout.is_float) {
+		if (layout.element_size == 8) {
+			convert_elements<double>(in, n, out);
+		} else {
+			convert_elements<float>(in, n, out);
+		}
+		return;
+	}
+	switch (layout.element_size) {
+	case 1:
+		layout.is_signed ? convert_elements<int8_t>(in, n, out) : convert_elements<uint8_t>(in, n, out);
+		break;
+	case 2:
+		layout.is_signed ? convert_elements<int16_t>(in, n, out) : convert_elements<uint16_t>(in, n, out);
+		break;
+	case 4:
+		layout.is_signed ? convert_elements<int32_t>(in, n, out) : convert_elements<uint32_t>(in, n, out);
+		break;
+	default:
+		layout.is_signed ? convert_elements<int64_t>(in, n, out) : convert_elements<uint64_t>(in, n, out);
+		break;
+	}
+}
+
+} // namespace
+
+template <typename T>
+void hdf5_decode_range(const HDF5ChunkLayout &layout, const HDF5RawRange &raw, T *out) {
+	thread_local std::vector<char> buffer;
+	thread_local std::vector<char> scratch;
+
+	for (size_t i = 0; i < raw.chunks.size(); i++) {
+		uint64_t chunk_begin = (raw.first_chunk + i) * layout.chunk_elements;
+		uint64_t lo = std::max(raw.begin, chunk_begin);
+		uint64_t hi = std::min(raw.end, chunk_begin + layout.chunk_elements);
+		if (raw.chunks[i].empty()) {
+			std::fill(out + (lo - raw.begin), out + (hi - raw.begin), T(0));
+			continue;
+		}
+
+		size_t size = 0;
+		const auto &decoded = unfilter_chunk(layout, raw.chunks[i], raw.filter_masks[i], buffer, scratch, size);
+		if (size < (hi - chunk_begin) * layout.element_size) {
+			throw std::runtime_error("Corrupt chunk at element " + std::to_string(chunk_begin) + ": decoded " +
+			                         std::to_string(size) + " bytes");
+		}
+		convert_elements(layout, decoded.data() + (lo - chunk_begin) * layout.element_size, hi - lo,
+		                 out + (lo - raw.begin));
+	}
+}
+
+template void hdf5_decode_range<int32_t>(const HDF5ChunkLayout &layout, const HDF5RawRange &raw, int32_t *out);
+template void hdf5_decode_range<double>(const HDF5ChunkLayout &layout, const HDF5RawRange &raw, double *out);
+
+} // namespace miint
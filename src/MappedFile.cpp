@@ -0,0 +1,50 @@
+#include "MappedFile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace miint {
+
+MappedFile::MappedFile(const std::string &path) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open file: " + path + " - " + std::strerror(errno));
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		throw std::runtime_error("Not a regular file: " + path);
+	}
+	size_ = static_cast<size_t>(st.st_size);
+	// A zero-length mapping is invalid; an empty file is an empty view
+	if (size_ > 0) {
+		data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data_ == MAP_FAILED) {
+			int err = errno;
+			data_ = nullptr;
+			close(fd);
+			throw std::runtime_error("Failed to map file: " + path + " - " + std::strerror(err));
+		}
+		// The file is read front to back, once
+		madvise(data_, size_, MADV_SEQUENTIAL);
+	}
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if (data_ != nullptr) {
+		munmap(data_, size_);
+	}
+}
+
+bool MappedFile::is_mappable(const std::string &path) {
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+} // namespace miint
@@ -0,0 +1,354 @@
+#include "NewickStream.hpp"
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+namespace miint {
+
+// Maximum number of nodes supported (uint32_t limit)
+static constexpr size_t MAX_NODES = static_cast<size_t>(UINT32_MAX);
+
+std::vector<size_t> newick_tree_ends(std::string_view text) {
+	std::vector<size_t> ends;
+	// Whether a tree has started since the last ';': whitespace and comments alone are not a tree
+	bool in_tree = false;
+	size_t pos = 0;
+	while (pos < text.size()) {
+		char c = text[pos];
+		if (c == ';') {
+			ends.push_back(++pos);
+			in_tree = false;
+		} else if (c == '\'' || c == '"') {
+			// A doubled quote inside a label closes and reopens it, which this handles as it is
+			auto close = text.find(c, pos + 1);
+			pos = close == std::string_view::npos ? text.size() : close + 1;
+			in_tree = true;
+		} else if (c == '[') {
+			int depth = 1;
+			for (++pos; pos < text.size() && depth > 0; ++pos) {
+				if (text[pos] == '[') {
+					++depth;
+				} else if (text[pos] == ']') {
+					--depth;
+				}
+			}
+		} else {
+			in_tree |= !std::isspace(static_cast<unsigned char>(c));
+			++pos;
+		}
+	}
+	if (in_tree || ends.empty()) {
+		ends.push_back(text.size());
+	}
+	return ends;
+}
+
+NewickStreamParser::NewickStreamParser(std::string_view input) : input_(input) {
+}
+
+bool NewickStreamParser::next(NewickRow &row) {
+	while (ready_head == ready.size()) {
+		if (state == State::DONE) {
+			return false;
+		}
+		ready.clear();
+		ready_head = 0;
+		step();
+	}
+	row = ready[ready_head++];
+	return true;
+}
+
+void NewickStreamParser::step() {
+	switch (state) {
+	case State::START:
+		skip_whitespace_and_comments();
+		if (pos_ >= input_.size() || input_[pos_] == ';') {
+			// Empty tree (just ";" or whitespace/comments followed by ";")
+			// This is valid - represents an unnamed root with no children
+			if (pos_ >= input_.size()) {
+				throw std::runtime_error("Cannot parse empty Newick string");
+			}
+			++pos_; // consume ';'
+			ready.push_back({0, NO_PARENT, std::string_view(), std::numeric_limits<double>::quiet_NaN(),
+			                 std::nullopt, true});
+			n_nodes = 1;
+			state = State::DONE;
+			return;
+		}
+		state = State::START_NODE;
+		return;
+
+	case State::START_NODE:
+		skip_whitespace_and_comments();
+		if (peek() == '(') {
+			++pos_; // consume '('; its first child starts next
+			open.push_back(pending.size());
+			return;
+		}
+		finish_node(pending.size());
+		state = State::AFTER_NODE;
+		return;
+
+	case State::AFTER_NODE: {
+		if (open.empty()) {
+			// The node just completed is the root
+			NewickRow root = pending.back();
+			pending.pop_back();
+			ready.push_back(root);
+
+			skip_whitespace_and_comments();
+			if (pos_ >= input_.size() || input_[pos_] != ';') {
+				throw std::runtime_error("Missing semicolon at end of Newick string");
+			}
+			++pos_; // consume ';'
+			state = State::DONE;
+			return;
+		}
+
+		skip_whitespace_and_comments();
+		if (peek() == ',') {
+			++pos_; // consume ','
+			state = State::START_NODE;
+			return;
+		}
+		if (peek() != ')') {
+			throw std::runtime_error("Unmatched opening parenthesis in Newick string");
+		}
+		++pos_; // consume ')'
+		size_t children_start = open.back();
+		open.pop_back();
+		finish_node(children_start);
+		return;
+	}
+
+	case State::DONE:
+		return;
+	}
+}
+
+// Parse the label, branch length and edge identifier of a node whose children are pending[children_start, end)
+void NewickStreamParser::finish_node(size_t children_start) {
+	skip_whitespace_and_comments();
+	std::string_view name = parse_label();
+
+	// Parse branch length (optional)
+	double branch_length = std::numeric_limits<double>::quiet_NaN();
+	skip_whitespace_and_comments();
+	if (peek() == ':') {
+		++pos_; // consume ':'
+		branch_length = parse_branch_length();
+	}
+
+	// Parse edge identifier (optional, jplace format)
+	std::optional<int64_t> edge_id;
+	skip_whitespace_and_comments();
+	if (peek() == '{') {
+		edge_id = parse_edge_id();
+	}
+
+	// Check for overflow before creating node
+	if (n_nodes >= MAX_NODES) {
+		throw std::runtime_error("Tree too large: exceeds maximum of " + std::to_string(MAX_NODES) + " nodes");
+	}
+	auto node = static_cast<uint32_t>(n_nodes++);
+
+	// The children's parent is now known
+	bool is_tip = children_start == pending.size();
+	for (size_t i = children_start; i < pending.size(); ++i) {
+		pending[i].parent = node;
+		ready.push_back(pending[i]);
+	}
+	pending.resize(children_start);
+	pending.push_back({node, NO_PARENT, name, branch_length, edge_id, is_tip});
+}
+
+void NewickStreamParser::skip_whitespace_and_comments() {
+	while (pos_ < input_.size()) {
+		char c = input_[pos_];
+		if (std::isspace(static_cast<unsigned char>(c))) {
+			++pos_;
+		} else if (c == '[') {
+			// Skip '[' and everything until matching ']', handling nesting
+			size_t comment_start = pos_++;
+			int depth = 1;
+			while (pos_ < input_.size() && depth > 0) {
+				char d = input_[pos_++];
+				if (d == '[') {
+					++depth;
+				} else if (d == ']') {
+					--depth;
+				}
+			}
+			if (depth > 0) {
+				throw std::runtime_error("Unclosed comment starting at position " + std::to_string(comment_start));
+			}
+		} else {
+			break;
+		}
+	}
+}
+
+// Keep simple whitespace skip for places where comments aren't expected
+void NewickStreamParser::skip_whitespace() {
+	while (pos_ < input_.size() && std::isspace(static_cast<unsigned char>(input_[pos_]))) {
+		++pos_;
+	}
+}
+
+std::string_view NewickStreamParser::parse_label() {
+	char c = peek();
+
+	// Quoted label
+	if (c == '\'' || c == '"') {
+		return parse_quoted_label(c);
+	}
+
+	// Unquoted label - ends at special characters
+	size_t start = pos_;
+	while (pos_ < input_.size()) {
+		c = input_[pos_];
+		if (c == '(' || c == ')' || c == ',' || c == ':' || c == ';' || c == '{' || c == '[' ||
+		    std::isspace(static_cast<unsigned char>(c))) {
+			break;
+		}
+		++pos_;
+	}
+	return input_.substr(start, pos_ - start);
+}
+
+std::string_view NewickStreamParser::parse_quoted_label(char quote_char) {
+	++pos_; // consume opening quote
+
+	// First pass: find end and check if escaping needed
+	size_t start = pos_;
+	bool has_escapes = false;
+	while (pos_ < input_.size()) {
+		if (input_[pos_] == quote_char) {
+			if (pos_ + 1 < input_.size() && input_[pos_ + 1] == quote_char) {
+				// Escaped quote
+				has_escapes = true;
+				pos_ += 2;
+			} else {
+				// End of quoted string
+				break;
+			}
+		} else {
+			++pos_;
+		}
+	}
+
+	if (pos_ >= input_.size()) {
+		throw std::runtime_error("Unclosed quote in Newick label");
+	}
+
+	size_t end = pos_;
+	++pos_; // consume closing quote
+
+	// If no escapes, the label is a view into the input
+	if (!has_escapes) {
+		return input_.substr(start, end - start);
+	}
+
+	// Otherwise, build unescaped string
+	std::string label;
+	label.reserve(end - start);
+	for (size_t i = start; i < end; ++i) {
+		char c = input_[i];
+		label += c;
+		if (c == quote_char) {
+			++i; // skip the second quote
+		}
+	}
+	unescaped.push_back(std::move(label));
+	return unescaped.back();
+}
+
+double NewickStreamParser::parse_branch_length() {
+	skip_whitespace();
+
+	size_t start = pos_;
+	// Find end of token (stop at Newick structural characters)
+	while (pos_ < input_.size()) {
+		char c = input_[pos_];
+		if (c == '(' || c == ')' || c == ',' || c == ';' || c == '{' || c == '[' ||
+		    std::isspace(static_cast<unsigned char>(c))) {
+			break;
+		}
+		++pos_;
+	}
+
+	if (pos_ == start) {
+		throw std::runtime_error("Invalid branch length: expected number after ':'");
+	}
+
+	std::string_view num_str = input_.substr(start, pos_ - start);
+
+	// Use strtod for platform compatibility (std::from_chars for float not available on macOS yet)
+	// Need null-terminated string for strtod
+	std::string num_cstr(num_str);
+	char *endptr;
+	errno = 0;
+	double value = std::strtod(num_cstr.c_str(), &endptr);
+
+	if (errno == ERANGE) {
+		throw std::runtime_error("Invalid branch length: '" + std::string(num_str) + "' (out of range)");
+	}
+	if (endptr == num_cstr.c_str()) {
+		throw std::runtime_error("Invalid branch length: '" + std::string(num_str) + "'");
+	}
+	if (endptr != num_cstr.c_str() + num_cstr.size()) {
+		throw std::runtime_error("Invalid branch length: unexpected characters in '" + std::string(num_str) + "'");
+	}
+
+	return value;
+}
+
+int64_t NewickStreamParser::parse_edge_id() {
+	++pos_; // consume '{'
+
+	skip_whitespace();
+
+	size_t start = pos_;
+	// Find end of token (stop at '}' or other structural chars)
+	while (pos_ < input_.size()) {
+		char c = input_[pos_];
+		if (c == '}' || c == '(' || c == ')' || c == ',' || c == ';' || c == '[' ||
+		    std::isspace(static_cast<unsigned char>(c))) {
+			break;
+		}
+		++pos_;
+	}
+
+	if (pos_ == start) {
+		throw std::runtime_error("Invalid edge identifier: expected integer");
+	}
+
+	std::string_view num_str = input_.substr(start, pos_ - start);
+	int64_t value;
+
+	auto [ptr, ec] = std::from_chars(num_str.data(), num_str.data() + num_str.size(), value);
+
+	if (ec != std::errc()) {
+		throw std::runtime_error("Invalid edge identifier: '" + std::string(num_str) + "'");
+	}
+	if (ptr != num_str.data() + num_str.size()) {
+		throw std::runtime_error("Invalid edge identifier: unexpected characters in '" + std::string(num_str) +
+		                         "'");
+	}
+
+	skip_whitespace();
+
+	if (pos_ >= input_.size() || input_[pos_] != '}') {
+		throw std::runtime_error("Unclosed brace in edge identifier");
+	}
+	++pos_; // consume '}'
+
+	return value;
+}
+
+} // namespace miint
@@ -1,10 +1,10 @@
 #include "NewickTree.hpp"
+#include "NewickStream.hpp"
+#include "Parallel.hpp"
 #include <algorithm>
 #include <array>
-#include <cerrno>
-#include <charconv>
 #include <cmath>
-#include <cstdlib>
+#include <functional>
 #include <stdexcept>
 #include <stack>
 
@@ -13,333 +13,74 @@ namespace miint {
 // Maximum number of nodes supported (uint32_t limit)
 static constexpr size_t MAX_NODES = static_cast<size_t>(UINT32_MAX);
 
-// ============================================================================
-// Parser implementation
-// ============================================================================
-
-class NewickParser {
-public:
-	explicit NewickParser(std::string_view input) : input_(input), pos_(0) {
-	}
-
-	NewickTree parse() {
-		skip_whitespace_and_comments();
-
-		if (pos_ >= input_.size() || input_[pos_] == ';') {
-			// Empty tree (just ";" or whitespace/comments followed by ";")
-			// This is valid - represents an unnamed root with no children
-			NewickTree tree;
-			tree.root_ = 0;
-			tree.nodes_.emplace_back("", std::numeric_limits<double>::quiet_NaN(), std::nullopt);
-			if (pos_ < input_.size() && input_[pos_] == ';') {
-				return tree;
-			}
-			throw std::runtime_error("Cannot parse empty Newick string");
-		}
-
-		NewickTree tree;
-		tree.root_ = parse_node(tree);
-
-		skip_whitespace_and_comments();
-
-		if (pos_ >= input_.size() || input_[pos_] != ';') {
-			throw std::runtime_error("Missing semicolon at end of Newick string");
-		}
-
-		return tree;
-	}
-
-private:
-	std::string_view input_;
-	size_t pos_;
-
-	char peek() const {
-		return pos_ < input_.size() ? input_[pos_] : '\0';
-	}
-
-	char consume() {
-		return pos_ < input_.size() ? input_[pos_++] : '\0';
-	}
-
-	void skip_whitespace_and_comments() {
-		while (pos_ < input_.size()) {
-			char c = input_[pos_];
-			if (std::isspace(static_cast<unsigned char>(c))) {
-				++pos_;
-			} else if (c == '[') {
-				skip_comment();
-			} else {
-				break;
-			}
-		}
-	}
-
-	void skip_comment() {
-		// Skip '[' and everything until matching ']', handling nesting
-		size_t comment_start = pos_;
-		consume(); // consume '['
-		int depth = 1;
-		while (pos_ < input_.size() && depth > 0) {
-			char c = input_[pos_++];
-			if (c == '[') {
-				++depth;
-			} else if (c == ']') {
-				--depth;
-			}
-		}
-		if (depth > 0) {
-			throw std::runtime_error("Unclosed comment starting at position " + std::to_string(comment_start));
-		}
-	}
-
-	// Keep simple whitespace skip for places where comments aren't expected
-	void skip_whitespace() {
-		while (pos_ < input_.size() && std::isspace(static_cast<unsigned char>(input_[pos_]))) {
-			++pos_;
-		}
-	}
-
-	uint32_t parse_node(NewickTree &tree) {
-		skip_whitespace_and_comments();
-
-		std::vector<uint32_t> children;
-
-		// Check for children (subtree)
-		if (peek() == '(') {
-			consume(); // consume '('
-			children = parse_children(tree);
+namespace {
 
-			skip_whitespace_and_comments();
-			if (peek() != ')') {
-				throw std::runtime_error("Unmatched opening parenthesis in Newick string");
-			}
-			consume(); // consume ')'
-		}
-
-		skip_whitespace_and_comments();
+// Placements are validated and hashed in chunks of this many, one chunk per parallel task
+constexpr size_t PLACEMENT_CHUNK = size_t(1) << 16;
 
-		// Parse node label
-		std::string name = parse_label();
-
-		// Parse branch length (optional)
-		double branch_length = std::numeric_limits<double>::quiet_NaN();
-		skip_whitespace_and_comments();
-		if (peek() == ':') {
-			consume(); // consume ':'
-			branch_length = parse_branch_length();
-		}
-
-		// Parse edge identifier (optional, jplace format)
-		std::optional<int64_t> edge_id;
-		skip_whitespace_and_comments();
-		if (peek() == '{') {
-			edge_id = parse_edge_id();
-		}
-
-		// Check for overflow before creating node
-		if (tree.nodes_.size() >= MAX_NODES) {
-			throw std::runtime_error("Tree too large: exceeds maximum of " + std::to_string(MAX_NODES) + " nodes");
-		}
-
-		// Create node
-		uint32_t node_idx = static_cast<uint32_t>(tree.nodes_.size());
-		tree.nodes_.emplace_back(std::move(name), branch_length, edge_id);
-
-		// Set up parent-child relationships
-		for (auto child : children) {
-			tree.nodes_[child].parent = node_idx;
-			tree.nodes_[node_idx].children.push_back(child);
-		}
+// Indices [0, keys.size()) grouped by key with a counting sort, keeping index order within a group: the indices
+// with key k are indices[offsets[k], offsets[k + 1])
+struct IndexGroups {
+	std::vector<size_t> offsets;
+	std::vector<size_t> indices;
+};
 
-		return node_idx;
+IndexGroups group_indices(const std::vector<uint32_t> &keys, size_t n_keys) {
+	IndexGroups groups;
+	groups.offsets.assign(n_keys + 1, 0);
+	for (auto key : keys) {
+		groups.offsets[key + 1]++;
 	}
-
-	std::vector<uint32_t> parse_children(NewickTree &tree) {
-		std::vector<uint32_t> children;
-
-		while (true) {
-			skip_whitespace_and_comments();
-			children.push_back(parse_node(tree));
-
-			skip_whitespace_and_comments();
-			if (peek() == ',') {
-				consume(); // consume ','
-			} else {
-				break;
-			}
-		}
-
-		return children;
+	for (size_t k = 0; k < n_keys; k++) {
+		groups.offsets[k + 1] += groups.offsets[k];
 	}
-
-	std::string parse_label() {
-		skip_whitespace_and_comments();
-
-		char c = peek();
-
-		// Quoted label
-		if (c == '\'' || c == '"') {
-			return parse_quoted_label(c);
-		}
-
-		// Unquoted label - ends at special characters
-		// Use substr for O(1) extraction instead of character-by-character O(n²)
-		size_t start = pos_;
-		while (pos_ < input_.size()) {
-			c = input_[pos_];
-			if (c == '(' || c == ')' || c == ',' || c == ':' || c == ';' || c == '{' || c == '[' ||
-			    std::isspace(static_cast<unsigned char>(c))) {
-				break;
-			}
-			++pos_;
-		}
-
-		return std::string(input_.substr(start, pos_ - start));
+	groups.indices.resize(keys.size());
+	std::vector<size_t> next(groups.offsets.begin(), groups.offsets.end() - 1);
+	for (size_t i = 0; i < keys.size(); i++) {
+		groups.indices[next[keys[i]]++] = i;
 	}
+	return groups;
+}
 
-	std::string parse_quoted_label(char quote_char) {
-		consume(); // consume opening quote
-
-		// First pass: find end and check if escaping needed
-		size_t start = pos_;
-		bool has_escapes = false;
-		size_t label_len = 0;
-
-		while (pos_ < input_.size()) {
-			char c = input_[pos_];
-			if (c == quote_char) {
-				if (pos_ + 1 < input_.size() && input_[pos_ + 1] == quote_char) {
-					// Escaped quote
-					has_escapes = true;
-					pos_ += 2;
-					label_len += 1; // Only one quote in output
-				} else {
-					// End of quoted string
-					break;
-				}
-			} else {
-				++pos_;
-				++label_len;
-			}
-		}
-
-		if (pos_ >= input_.size()) {
-			throw std::runtime_error("Unclosed quote in Newick label");
-		}
-
-		size_t end = pos_;
-		consume(); // consume closing quote
-
-		// If no escapes, just return substring
-		if (!has_escapes) {
-			return std::string(input_.substr(start, end - start));
-		}
-
-		// Otherwise, build unescaped string
-		std::string label;
-		label.reserve(label_len);
-		for (size_t i = start; i < end; ++i) {
-			char c = input_[i];
-			if (c == quote_char && i + 1 < end && input_[i + 1] == quote_char) {
-				label += quote_char;
-				++i; // skip the second quote
-			} else {
-				label += c;
-			}
-		}
-
-		return label;
-	}
-
-	double parse_branch_length() {
-		skip_whitespace();
-
-		size_t start = pos_;
-		// Find end of token (stop at Newick structural characters)
-		while (pos_ < input_.size()) {
-			char c = input_[pos_];
-			if (c == '(' || c == ')' || c == ',' || c == ';' || c == '{' || c == '[' ||
-			    std::isspace(static_cast<unsigned char>(c))) {
-				break;
-			}
-			++pos_;
-		}
-
-		if (pos_ == start) {
-			throw std::runtime_error("Invalid branch length: expected number after ':'");
-		}
-
-		std::string_view num_str = input_.substr(start, pos_ - start);
-
-		// Use strtod for platform compatibility (std::from_chars for float not available on macOS yet)
-		// Need null-terminated string for strtod
-		std::string num_cstr(num_str);
-		char *endptr;
-		errno = 0;
-		double value = std::strtod(num_cstr.c_str(), &endptr);
-
-		if (errno == ERANGE) {
-			throw std::runtime_error("Invalid branch length: '" + std::string(num_str) + "' (out of range)");
-		}
-		if (endptr == num_cstr.c_str()) {
-			throw std::runtime_error("Invalid branch length: '" + std::string(num_str) + "'");
-		}
-		if (endptr != num_cstr.c_str() + num_cstr.size()) {
-			throw std::runtime_error("Invalid branch length: unexpected characters in '" + std::string(num_str) + "'");
-		}
-
-		return value;
+// Whether p should replace existing as the placement of their fragment: higher like_weight_ratio, then lower
+// pendant_length. Using epsilon comparison for floating-point like_weight_ratio.
+bool better_placement(const Placement &p, const Placement &existing) {
+	constexpr double EPSILON = 1e-9;
+	double diff = p.like_weight_ratio - existing.like_weight_ratio;
+	if (diff > EPSILON) {
+		return true;
 	}
+	return std::abs(diff) <= EPSILON && p.pendant_length < existing.pendant_length;
+}
 
-	int64_t parse_edge_id() {
-		if (consume() != '{') {
-			throw std::runtime_error("Expected '{' for edge identifier");
-		}
-
-		skip_whitespace();
-
-		size_t start = pos_;
-		// Find end of token (stop at '}' or other structural chars)
-		while (pos_ < input_.size()) {
-			char c = input_[pos_];
-			if (c == '}' || c == '(' || c == ')' || c == ',' || c == ';' || c == '[' ||
-			    std::isspace(static_cast<unsigned char>(c))) {
-				break;
-			}
-			++pos_;
-		}
-
-		if (pos_ == start) {
-			throw std::runtime_error("Invalid edge identifier: expected integer");
-		}
-
-		std::string_view num_str = input_.substr(start, pos_ - start);
-		int64_t value;
-
-		auto [ptr, ec] = std::from_chars(num_str.data(), num_str.data() + num_str.size(), value);
-
-		if (ec != std::errc()) {
-			throw std::runtime_error("Invalid edge identifier: '" + std::string(num_str) + "'");
-		}
-		if (ptr != num_str.data() + num_str.size()) {
-			throw std::runtime_error("Invalid edge identifier: unexpected characters in '" + std::string(num_str) +
-			                         "'");
-		}
+} // namespace
 
-		skip_whitespace();
+// ============================================================================
+// Parsing
+// ============================================================================
 
-		if (pos_ >= input_.size() || input_[pos_] != '}') {
-			throw std::runtime_error("Unclosed brace in edge identifier");
+NewickTree NewickTree::parse(std::string_view newick) {
+	NewickStreamParser parser(newick);
+	NewickTree tree;
+	NewickRow row;
+	while (parser.next(row)) {
+		// A node is returned after its children but before its parent, which comes later in the numbering
+		size_t last = row.parent == NewickStreamParser::NO_PARENT ? row.node : row.parent;
+		if (tree.nodes_.size() <= last) {
+			tree.nodes_.resize(last + 1);
+		}
+		auto &node = tree.nodes_[row.node];
+		node.name = std::string(row.name);
+		node.branch_length = row.branch_length;
+		node.edge_id = row.edge_id;
+		if (row.parent == NewickStreamParser::NO_PARENT) {
+			tree.root_ = row.node;
+		} else {
+			node.parent = row.parent;
+			tree.nodes_[row.parent].children.push_back(row.node);
 		}
-		consume(); // consume '}'
-
-		return value;
 	}
-};
-
-NewickTree NewickTree::parse(std::string_view newick) {
-	NewickParser parser(newick);
-	return parser.parse();
+	return tree;
 }
 
 // ============================================================================
@@ -730,25 +471,33 @@ uint32_t NewickTree::find_lca(uint32_t a, uint32_t b) const {
 		throw std::out_of_range("Invalid node index: " + std::to_string(b));
 	}
 
-	// Collect ancestors of a (including a itself)
-	std::vector<bool> is_ancestor_of_a(nodes_.size(), false);
-	uint32_t current = a;
-	while (current != NO_PARENT) {
-		is_ancestor_of_a[current] = true;
-		current = nodes_[current].parent;
-	}
-
-	// Find first ancestor of b that is also ancestor of a
-	current = b;
-	while (current != NO_PARENT) {
-		if (is_ancestor_of_a[current]) {
-			return current;
+	// Lift the deeper node to the depth of the other, then both together until they meet; no allocation, so
+	// repeated calls stay cheap. For many queries on one tree, TreeLCA answers in constant time.
+	auto depth = [&](uint32_t node) {
+		size_t d = 0;
+		for (uint32_t current = nodes_[node].parent; current != NO_PARENT; current = nodes_[current].parent) {
+			d++;
 		}
-		current = nodes_[current].parent;
+		return d;
+	};
+	size_t depth_a = depth(a);
+	size_t depth_b = depth(b);
+	for (; depth_a > depth_b; depth_a--) {
+		a = nodes_[a].parent;
+	}
+	for (; depth_b > depth_a; depth_b--) {
+		b = nodes_[b].parent;
+	}
+	while (a != b) {
+		a = nodes_[a].parent;
+		b = nodes_[b].parent;
 	}
 
-	// Should not happen in a valid tree
-	throw std::runtime_error("Nodes have no common ancestor - tree may be disconnected");
+	// Nodes in different components meet at NO_PARENT
+	if (a == NO_PARENT) {
+		throw std::runtime_error("Nodes have no common ancestor - tree may be disconnected");
+	}
+	return a;
 }
 
 double NewickTree::pairwise_distance(uint32_t a, uint32_t b) const {
@@ -786,142 +535,194 @@ double NewickTree::pairwise_distance(uint32_t a, uint32_t b) const {
 // Phylogenetic placement
 // ============================================================================
 
-void NewickTree::insert_fully_resolved(const std::vector<Placement> &placements) {
+void NewickTree::insert_fully_resolved(const std::vector<Placement> &placements, size_t n_threads) {
 	if (placements.empty()) {
 		return;
 	}
+	size_t n_placements = placements.size();
+	size_t n_chunks = (n_placements + PLACEMENT_CHUNK - 1) / PLACEMENT_CHUNK;
 
 	// Step 1: Build edge_id -> node_id index
 	auto edge_index = build_edge_index();
 
 	// Step 2: Validate ALL placements upfront before any processing
-	// This ensures we catch and report all invalid data, not just the "winning" placements
-	for (const auto &p : placements) {
-		if (edge_index.find(p.edge_id) == edge_index.end()) {
-			throw std::runtime_error("Unknown edge_id " + std::to_string(p.edge_id) + " for fragment '" +
-			                         p.fragment_id + "'");
-		}
-		if (p.distal_length < 0) {
-			throw std::runtime_error("Negative distal_length " + std::to_string(p.distal_length) + " for fragment '" +
-			                         p.fragment_id + "'");
-		}
-		if (p.pendant_length < 0) {
-			throw std::runtime_error("Negative pendant_length " + std::to_string(p.pendant_length) + " for fragment '" +
-			                         p.fragment_id + "'");
+	// This ensures we catch and report all invalid data, not just the "winning" placements.
+	// Chunks are validated in parallel, each stopping at its first error; the earliest error in input order is
+	// reported, as a sequential scan would.
+	std::vector<uint32_t> edge_node_of(n_placements);
+	std::vector<std::string> chunk_error(n_chunks);
+	run_parallel(n_chunks, n_threads, [&](size_t chunk) {
+		size_t end = std::min(n_placements, (chunk + 1) * PLACEMENT_CHUNK);
+		for (size_t i = chunk * PLACEMENT_CHUNK; i < end; i++) {
+			const auto &p = placements[i];
+			auto it = edge_index.find(p.edge_id);
+			if (it == edge_index.end()) {
+				chunk_error[chunk] =
+				    "Unknown edge_id " + std::to_string(p.edge_id) + " for fragment '" + p.fragment_id + "'";
+				return;
+			}
+			if (p.distal_length < 0) {
+				chunk_error[chunk] = "Negative distal_length " + std::to_string(p.distal_length) + " for fragment '" +
+				                     p.fragment_id + "'";
+				return;
+			}
+			if (p.pendant_length < 0) {
+				chunk_error[chunk] = "Negative pendant_length " + std::to_string(p.pendant_length) +
+				                     " for fragment '" + p.fragment_id + "'";
+				return;
+			}
+			// Validate distal_length against edge length
+			double edge_length = nodes_[it->second].branch_length;
+			if (!std::isnan(edge_length) && p.distal_length > edge_length) {
+				chunk_error[chunk] = "distal_length " + std::to_string(p.distal_length) + " exceeds edge length " +
+				                     std::to_string(edge_length) + " for fragment '" + p.fragment_id + "'";
+				return;
+			}
+			edge_node_of[i] = it->second;
 		}
-		// Validate distal_length against edge length
-		uint32_t edge_node = edge_index.at(p.edge_id);
-		double edge_length = nodes_[edge_node].branch_length;
-		if (!std::isnan(edge_length) && p.distal_length > edge_length) {
-			throw std::runtime_error("distal_length " + std::to_string(p.distal_length) + " exceeds edge length " +
-			                         std::to_string(edge_length) + " for fragment '" + p.fragment_id + "'");
+	});
+	for (const auto &error : chunk_error) {
+		if (!error.empty()) {
+			throw std::runtime_error(error);
 		}
 	}
 
 	// Step 3: Deduplicate placements by fragment_id
-	// Keep the one with highest like_weight_ratio, then lowest pendant_length
-	// Note: Using epsilon comparison for floating-point like_weight_ratio
-	constexpr double EPSILON = 1e-9;
-	std::unordered_map<std::string, const Placement *> best_placement;
-	for (const auto &p : placements) {
-		auto it = best_placement.find(p.fragment_id);
-		if (it == best_placement.end()) {
-			best_placement[p.fragment_id] = &p;
-		} else {
-			const Placement *existing = it->second;
-			double diff = p.like_weight_ratio - existing->like_weight_ratio;
-			// Prefer higher like_weight_ratio (with epsilon tolerance)
-			if (diff > EPSILON) {
-				it->second = &p;
-			} else if (std::abs(diff) <= EPSILON) {
-				// Tiebreaker: prefer lower pendant_length
-				if (p.pendant_length < existing->pendant_length) {
-					it->second = &p;
-				}
+	// Keep the one with highest like_weight_ratio, then lowest pendant_length, then the first seen.
+	// Placements are bucketed by a hash of their fragment_id so that every copy of a fragment lands in the same
+	// bucket, and buckets are deduplicated in parallel, each in input order.
+	size_t n_buckets = n_chunks;
+	std::vector<uint32_t> bucket_of(n_placements);
+	run_parallel(n_chunks, n_threads, [&](size_t chunk) {
+		size_t end = std::min(n_placements, (chunk + 1) * PLACEMENT_CHUNK);
+		for (size_t i = chunk * PLACEMENT_CHUNK; i < end; i++) {
+			bucket_of[i] = static_cast<uint32_t>(std::hash<std::string> {}(placements[i].fragment_id) % n_buckets);
+		}
+	});
+	auto by_bucket = group_indices(bucket_of, n_buckets);
+
+	std::vector<uint8_t> is_best(n_placements, 0);
+	run_parallel(n_buckets, n_threads, [&](size_t bucket) {
+		std::unordered_map<std::string_view, size_t> best_placement;
+		best_placement.reserve(by_bucket.offsets[bucket + 1] - by_bucket.offsets[bucket]);
+		for (size_t j = by_bucket.offsets[bucket]; j < by_bucket.offsets[bucket + 1]; j++) {
+			size_t i = by_bucket.indices[j];
+			auto inserted = best_placement.emplace(placements[i].fragment_id, i);
+			if (!inserted.second && better_placement(placements[i], placements[inserted.first->second])) {
+				inserted.first->second = i;
 			}
 		}
-	}
+		for (const auto &[fragment_id, i] : best_placement) {
+			is_best[i] = 1;
+		}
+	});
 
 	// Step 4: Check node limit before any allocation
 	// Each unique placement creates 2 nodes: internal + fragment
-	size_t new_nodes_needed = best_placement.size() * 2;
+	size_t n_best = static_cast<size_t>(std::count(is_best.begin(), is_best.end(), 1));
+	size_t new_nodes_needed = n_best * 2;
 	if (nodes_.size() + new_nodes_needed > MAX_NODES) {
 		throw std::runtime_error("Too many placements: would create " + std::to_string(new_nodes_needed) +
 		                         " new nodes, exceeding maximum of " + std::to_string(MAX_NODES) + " total nodes");
 	}
 
-	// Step 5: Group placements by edge_id
-	std::unordered_map<int64_t, std::vector<const Placement *>> by_edge;
-	for (const auto &[frag_id, p] : best_placement) {
-		by_edge[p->edge_id].push_back(p);
-	}
-
-	// Step 6: Sort each edge's placements by distal_length descending
-	for (auto &[edge_id, edge_placements] : by_edge) {
-		std::sort(edge_placements.begin(), edge_placements.end(),
-		          [](const Placement *a, const Placement *b) { return a->distal_length > b->distal_length; });
-	}
-
-	// Step 7: Reserve space for new nodes (2 per placement: internal + fragment)
-	nodes_.reserve(nodes_.size() + best_placement.size() * 2);
-
-	// Step 8: Process each edge
-	for (const auto &[edge_id, edge_placements] : by_edge) {
-		uint32_t edge_node = edge_index.at(edge_id);
-		double original_length = nodes_[edge_node].branch_length;
-
-		// Get original parent
-		uint32_t original_parent = nodes_[edge_node].parent;
-		// Note: If original_parent == NO_PARENT, we're inserting on the root's edge.
-		// In this case, current_parent starts as NO_PARENT, and the first new internal
-		// node will become the new root (handled at line ~760 below).
-
-		// Remove edge_node from its parent
-		if (original_parent != NO_PARENT) {
-			remove_child(original_parent, edge_node);
-			nodes_[edge_node].parent = NO_PARENT;
-		}
+	// Step 5: Group the kept placements by the node below their edge, in input order
+	size_t n_original = nodes_.size();
+	std::vector<uint32_t> kept_edge_node;
+	std::vector<size_t> kept;
+	kept_edge_node.reserve(n_best);
+	kept.reserve(n_best);
+	for (size_t i = 0; i < n_placements; i++) {
+		if (is_best[i]) {
+			kept_edge_node.push_back(edge_node_of[i]);
+			kept.push_back(i);
+		}
+	}
+	auto by_edge = group_indices(kept_edge_node, n_original);
+	for (auto &j : by_edge.indices) {
+		j = kept[j];
+	}
+	std::vector<uint32_t> edge_nodes;
+	for (uint32_t node = 0; node < n_original; node++) {
+		if (by_edge.offsets[node + 1] > by_edge.offsets[node]) {
+			edge_nodes.push_back(node);
+		}
+	}
+
+	// Step 6: Sort each edge's placements by distal_length descending, then build its chain of new nodes.
+	// The placements of an edge are by_edge.indices[offsets[edge_node], offsets[edge_node + 1]); their nodes take
+	// the same range, doubled, after the original nodes, so edges are independent and are processed in parallel.
+	// Each chain is: original_parent -> new_internal_1 -> new_internal_2 -> ... -> edge_node, with the fragment as
+	// the first child of each new internal node.
+	nodes_.resize(n_original + new_nodes_needed);
+	run_parallel(edge_nodes.size(), n_threads, [&](size_t task) {
+		uint32_t edge_node = edge_nodes[task];
+		auto first = by_edge.indices.begin() + by_edge.offsets[edge_node];
+		auto last = by_edge.indices.begin() + by_edge.offsets[edge_node + 1];
+		// Stable, so placements at the same distal_length keep their input order
+		std::stable_sort(first, last, [&](size_t a, size_t b) {
+			return placements[a].distal_length > placements[b].distal_length;
+		});
 
 		// Insert placements from highest distal_length to lowest
-		// This creates a chain: original_parent -> new_internal_1 -> new_internal_2 -> ... -> edge_node
-		double remaining_length = original_length;
-		uint32_t current_parent = original_parent;
-
-		for (size_t i = 0; i < edge_placements.size(); ++i) {
-			const Placement *p = edge_placements[i];
-
-			// Calculate the branch length from current_parent to new internal node
-			// This is: remaining_length - distal_length
-			double internal_branch_length = remaining_length - p->distal_length;
+		double remaining_length = nodes_[edge_node].branch_length;
+		uint32_t current_parent = nodes_[edge_node].parent;
+		auto node = static_cast<uint32_t>(n_original + 2 * by_edge.offsets[edge_node]);
+		for (auto it = first; it != last; ++it, node += 2) {
+			const Placement &p = placements[*it];
+			uint32_t new_internal = node;
+			uint32_t fragment_node = node + 1;
+
+			// The branch length from current_parent to the new internal node is remaining_length - distal_length
+			double internal_branch_length = remaining_length - p.distal_length;
 			if (std::isnan(remaining_length)) {
 				internal_branch_length = std::numeric_limits<double>::quiet_NaN();
 			}
 
-			// Create new internal node
-			uint32_t new_internal = add_node("", internal_branch_length, std::nullopt);
-
-			// Create fragment node
-			uint32_t fragment_node = add_node(p->fragment_id, p->pendant_length, std::nullopt);
+			auto &internal = nodes_[new_internal];
+			internal.branch_length = internal_branch_length;
+			internal.parent = current_parent;
+			// The next internal node, or edge_node after the last placement
+			uint32_t next = it + 1 == last ? edge_node : node + 2;
+			internal.children = {fragment_node, next};
 
-			// Connect internal node to current parent
-			if (current_parent != NO_PARENT) {
-				set_parent(new_internal, current_parent);
-			} else {
-				// This internal node becomes the new root
-				root_ = new_internal;
-			}
-
-			// Connect fragment to internal
-			set_parent(fragment_node, new_internal);
+			auto &fragment = nodes_[fragment_node];
+			fragment.name = p.fragment_id;
+			fragment.branch_length = p.pendant_length;
+			fragment.parent = new_internal;
 
 			// Update for next iteration
 			current_parent = new_internal;
-			remaining_length = p->distal_length;
+			remaining_length = p.distal_length;
 		}
 
-		// Finally, connect edge_node to the last internal node
+		// Finally, hang edge_node below the last internal node
 		nodes_[edge_node].branch_length = remaining_length;
-		set_parent(edge_node, current_parent);
+		nodes_[edge_node].parent = current_parent;
+	});
+
+	// Step 7: Put each chain in place of its edge_node among the original parent's children, so the order of
+	// siblings is kept. Each such parent's children are rewritten in one pass, however many of them have
+	// placements. If the edge is the root's, the first new internal node becomes the root.
+	auto first_internal = [&](uint32_t edge_node) {
+		return static_cast<uint32_t>(n_original + 2 * by_edge.offsets[edge_node]);
+	};
+	std::vector<uint8_t> rewritten(n_original, 0);
+	for (auto edge_node : edge_nodes) {
+		uint32_t original_parent = nodes_[first_internal(edge_node)].parent;
+		if (original_parent == NO_PARENT) {
+			root_ = first_internal(edge_node);
+			continue;
+		}
+		if (rewritten[original_parent]) {
+			continue;
+		}
+		rewritten[original_parent] = 1;
+		for (auto &child : nodes_[original_parent].children) {
+			if (by_edge.offsets[child + 1] > by_edge.offsets[child]) {
+				child = first_internal(child);
+			}
+		}
 	}
 }
 
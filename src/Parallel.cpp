@@ -0,0 +1,171 @@
+#include "Parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace miint {
+
+namespace {
+
+// run_parallel calls and WorkerPool::run calls in progress across the process
+std::atomic<size_t> active_calls {0};
+
+struct ActiveCall {
+	size_t calls;
+	ActiveCall() : calls(++active_calls) {
+	}
+	~ActiveCall() {
+		--active_calls;
+	}
+};
+
+} // namespace
+
+void run_parallel(size_t n_tasks, size_t n_threads, const std::function<void(size_t)> &task) {
+	ActiveCall call;
+	n_threads = std::max<size_t>(1, std::min(n_threads / call.calls, n_tasks));
+	if (n_threads == 1) {
+		for (size_t i = 0; i < n_tasks; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	std::atomic<size_t> next_task {0};
+	std::mutex error_lock;
+	std::exception_ptr error;
+	auto worker = [&]() {
+		while (true) {
+			auto i = next_task.fetch_add(1);
+			if (i >= n_tasks) {
+				return;
+			}
+			try {
+				task(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> guard(error_lock);
+				if (!error) {
+					error = std::current_exception();
+				}
+				// Stop handing out further tasks
+				next_task = n_tasks;
+				return;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(n_threads - 1);
+	for (size_t t = 1; t < n_threads; t++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+WorkerPool::WorkerPool(size_t n_threads) {
+	n_threads = std::max<size_t>(1, n_threads);
+	try {
+		workers_.reserve(n_threads - 1);
+		for (size_t t = 1; t < n_threads; t++) {
+			workers_.emplace_back([this, t]() { work(t - 1); });
+		}
+	} catch (...) {
+		stop();
+		throw;
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	stop();
+}
+
+void WorkerPool::stop() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		stop_ = true;
+	}
+	start_.notify_all();
+	for (auto &worker : workers_) {
+		worker.join();
+	}
+	workers_.clear();
+}
+
+void WorkerPool::run(size_t n_tasks, const std::function<void(size_t)> &task) {
+	ActiveCall call;
+	size_t n_active = std::max<size_t>(1, std::min(size() / call.calls, n_tasks)) - 1;
+	if (n_active == 0) {
+		for (size_t i = 0; i < n_tasks; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	std::unique_lock<std::mutex> guard(lock_);
+	task_ = &task;
+	n_tasks_ = n_tasks;
+	n_active_ = n_active;
+	next_task_ = 0;
+	finished_ = 0;
+	error_ = nullptr;
+	generation_++;
+	start_.notify_all();
+	drain(guard);
+	done_.wait(guard, [&]() { return finished_ == n_active_; });
+	task_ = nullptr;
+	if (error_) {
+		auto error = error_;
+		error_ = nullptr;
+		guard.unlock();
+		std::rethrow_exception(error);
+	}
+}
+
+void WorkerPool::work(size_t worker) {
+	size_t seen = 0;
+	std::unique_lock<std::mutex> guard(lock_);
+	while (true) {
+		start_.wait(guard, [&]() { return stop_ || generation_ != seen; });
+		if (stop_) {
+			return;
+		}
+		seen = generation_;
+		// Workers beyond the run's share of threads sit it out
+		if (worker >= n_active_) {
+			continue;
+		}
+		drain(guard);
+		if (++finished_ == n_active_) {
+			done_.notify_one();
+		}
+	}
+}
+
+void WorkerPool::drain(std::unique_lock<std::mutex> &guard) {
+	while (next_task_ < n_tasks_) {
+		size_t i = next_task_++;
+		guard.unlock();
+		try {
+			(*task_)(i);
+			guard.lock();
+		} catch (...) {
+			guard.lock();
+			if (!error_) {
+				error_ = std::current_exception();
+			}
+			// Stop handing out further tasks
+			next_task_ = n_tasks_;
+		}
+	}
+}
+
+} // namespace miint
@@ -0,0 +1,170 @@
+#include "Rarefaction.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace miint {
+
+uint64_t RarefactionRandom::next_interval(uint64_t max) {
+	if (max == 0) {
+		return 0;
+	}
+	// Draw from the smallest power-of-two range covering max and reject values above it
+	uint64_t mask = max;
+	mask |= mask >> 1;
+	mask |= mask >> 2;
+	mask |= mask >> 4;
+	mask |= mask >> 8;
+	mask |= mask >> 16;
+	mask |= mask >> 32;
+	uint64_t value;
+	while ((value = engine() & mask) > max) {
+	}
+	return value;
+}
+
+uint64_t rarefaction_seed(uint64_t seed, const std::string &sample_id) {
+	// FNV-1a of the ID, mixed with the seed by a splitmix64 finalizer
+	uint64_t hash = 14695981039346656037ULL;
+	for (unsigned char c : sample_id) {
+		hash = (hash ^ c) * 1099511628211ULL;
+	}
+	uint64_t z = seed + 0x9e3779b97f4a7c15ULL * (hash | 1);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+namespace {
+
+double log_factorial(int64_t k) {
+	static const auto table = [] {
+		std::array<double, 126> values {};
+		for (size_t i = 1; i < values.size(); i++) {
+			values[i] = values[i - 1] + std::log(static_cast<double>(i));
+		}
+		return values;
+	}();
+	if (k < static_cast<int64_t>(table.size())) {
+		return table[k];
+	}
+	// Stirling series, accurate to double precision beyond the table
+	double x = static_cast<double>(k);
+	return (x + 0.5) * std::log(x) - x + 0.9189385332046727 + (1.0 / x) * (1.0 / 12 - 1.0 / (360 * x * x));
+}
+
+// Draw the items one at a time; used when the smaller of sample and its complement is tiny
+int64_t hypergeometric_urn(RarefactionRandom &random, int64_t good, int64_t bad, int64_t sample) {
+	int64_t total = good + bad;
+	int64_t computed_sample = sample > total / 2 ? total - sample : sample;
+	int64_t remaining_total = total;
+	int64_t remaining_good = good;
+	while (computed_sample > 0 && remaining_good > 0 && remaining_total > remaining_good) {
+		--remaining_total;
+		if (static_cast<int64_t>(random.next_interval(remaining_total)) < remaining_good) {
+			--remaining_good;
+		}
+		--computed_sample;
+	}
+	if (remaining_total == remaining_good) {
+		remaining_good -= computed_sample;
+	}
+	return sample > total / 2 ? remaining_good : good - remaining_good;
+}
+
+// Ratio-of-uniforms rejection sampler (Stadlober 1989, "HRUA"), constant expected time in the sample size
+int64_t hypergeometric_hrua(RarefactionRandom &random, int64_t good, int64_t bad, int64_t sample) {
+	constexpr double D1 = 1.7155277699214135;
+	constexpr double D2 = 0.8989161620588988;
+
+	int64_t total = good + bad;
+	int64_t computed_sample = std::min(sample, total - sample);
+	int64_t min_good_bad = std::min(good, bad);
+	int64_t max_good_bad = std::max(good, bad);
+
+	double p = static_cast<double>(min_good_bad) / total;
+	double q = static_cast<double>(max_good_bad) / total;
+	double mu = computed_sample * p;
+	double a = mu + 0.5;
+	double var = static_cast<double>(total - computed_sample) * computed_sample * p * q / (total - 1);
+	double c = std::sqrt(var + 0.5);
+	double h = D1 * c + D2;
+	auto m = static_cast<int64_t>(
+	    std::floor(static_cast<double>(computed_sample + 1) * (min_good_bad + 1) / (static_cast<double>(total) + 2)));
+	double g = log_factorial(m) + log_factorial(min_good_bad - m) + log_factorial(computed_sample - m) +
+	           log_factorial(max_good_bad - computed_sample + m);
+	double b = std::min(static_cast<double>(std::min(computed_sample, min_good_bad) + 1), std::floor(a + 16 * c));
+
+	int64_t k;
+	while (true) {
+		double u = random.next_double();
+		double v = random.next_double();
+		double x = a + h * (v - 0.5) / u;
+		if (x < 0.0 || x >= b) {
+			continue;
+		}
+		k = static_cast<int64_t>(std::floor(x));
+		double t = g - (log_factorial(k) + log_factorial(min_good_bad - k) + log_factorial(computed_sample - k) +
+		                log_factorial(max_good_bad - computed_sample + k));
+		if (u * (4.0 - u) - 3.0 <= t) {
+			break; // quick acceptance
+		}
+		if (u * (u - t) >= 1) {
+			continue; // quick rejection
+		}
+		if (2.0 * std::log(u) <= t) {
+			break;
+		}
+	}
+
+	if (good > bad) {
+		k = computed_sample - k;
+	}
+	if (computed_sample < sample) {
+		k = good - k;
+	}
+	return k;
+}
+
+} // namespace
+
+uint64_t random_hypergeometric(RarefactionRandom &random, uint64_t good, uint64_t bad, uint64_t sample) {
+	if (sample == 0 || good == 0) {
+		return 0;
+	}
+	if (bad == 0) {
+		return sample;
+	}
+	auto g = static_cast<int64_t>(good);
+	auto b = static_cast<int64_t>(bad);
+	auto s = static_cast<int64_t>(sample);
+	if (s >= 10 && s <= g + b - 10) {
+		return static_cast<uint64_t>(hypergeometric_hrua(random, g, b, s));
+	}
+	return static_cast<uint64_t>(hypergeometric_urn(random, g, b, s));
+}
+
+void rarefy(const std::vector<uint64_t> &counts, uint64_t depth, RarefactionRandom &random,
+            std::vector<uint64_t> &out) {
+	uint64_t total = 0;
+	for (auto count : counts) {
+		total += count;
+	}
+	if (total < depth) {
+		throw std::runtime_error("Cannot rarefy " + std::to_string(total) + " items to a depth of " +
+		                         std::to_string(depth));
+	}
+
+	// The draws of the first j counts leave a hypergeometric draw from count j against the counts after it
+	out.assign(counts.size(), 0);
+	uint64_t remaining = total;
+	uint64_t to_draw = depth;
+	for (size_t j = 0; j < counts.size() && to_draw > 0; j++) {
+		remaining -= counts[j];
+		out[j] = random_hypergeometric(random, counts[j], remaining, to_draw);
+		to_draw -= out[j];
+	}
+}
+
+} // namespace miint
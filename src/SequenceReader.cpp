@@ -1,5 +1,8 @@
 #include <SequenceReader.hpp>
+#include "ZstdSeekable.hpp"
 #include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace miint {
 // Helper function to extract base read ID by stripping /[1-9] suffix and comments
@@ -34,9 +37,105 @@ static void check_ids(const std::string &name1, const std::string &name2) {
 	}
 }
 
-SequenceReader::SequenceReader(const std::string &path1, const std::optional<std::string> &path2) : first_read_(true) {
-	sequence1_reader_ = std::make_unique<SeqStreamIn>(path1.c_str());
+class GzipInput : public SequenceInput {
+public:
+	explicit GzipInput(gzFile file) : file_(file) {
+	}
+	~GzipInput() override {
+		gzclose(file_);
+	}
+	int read(void *buffer, unsigned length) override {
+		return gzread(file_, buffer, length);
+	}
+
+private:
+	gzFile file_;
+};
+
+class ZstdInput : public SequenceInput {
+public:
+	ZstdInput(const std::string &path, size_t n_threads) : reader_(path, n_threads) {
+	}
+	int read(void *buffer, unsigned length) override {
+		return static_cast<int>(reader_.read(static_cast<char *>(buffer), length));
+	}
+
+private:
+	ZstdReader reader_;
+};
+
+using StreamIn = klibpp::KStreamIn<SequenceInput *, int (*)(SequenceInput *, void *, unsigned)>;
+
+static int read_input(SequenceInput *input, void *buffer, unsigned length) {
+	return input->read(buffer, length);
+}
+
+static int close_input(SequenceInput *input) {
+	delete input;
+	return 0;
+}
+
+static std::unique_ptr<StreamIn> make_stream(std::unique_ptr<SequenceInput> input) {
+	return std::make_unique<StreamIn>(input.release(), read_input, close_input);
+}
+
+static bool is_zstd_path(const std::string &path) {
+	return (path.size() > 4 && path.compare(path.size() - 4, 4, ".zst") == 0) || ZstdReader::is_zstd_file(path);
+}
+
+static std::unique_ptr<StreamIn> open_stream(const std::string &path, size_t decode_threads) {
+	if (is_zstd_path(path)) {
+		return make_stream(std::make_unique<ZstdInput>(path, decode_threads));
+	}
+	return make_stream(std::make_unique<GzipInput>(gzopen(path.c_str(), "r")));
+}
 
+// Open path positioned at offset: a byte offset for plain files, a BGZF virtual offset (block start << 16 |
+// offset within the block) for compressed ones. zlib reads the concatenated BGZF members from there on.
+static std::unique_ptr<StreamIn> open_stream_at(const std::string &path, uint64_t offset, bool compressed) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+	uint64_t file_offset = compressed ? (offset >> 16) : offset;
+	if (::lseek(fd, static_cast<off_t>(file_offset), SEEK_SET) < 0) {
+		::close(fd);
+		throw std::runtime_error("Failed to seek to offset " + std::to_string(file_offset) + " in " + path);
+	}
+	gzFile file = gzdopen(fd, "r");
+	if (file == nullptr) {
+		::close(fd);
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+	uint64_t block_offset = compressed ? (offset & 0xffff) : 0;
+	if (block_offset > 0 && gzseek(file, static_cast<z_off_t>(block_offset), SEEK_CUR) < 0) {
+		gzclose(file);
+		throw std::runtime_error("Failed to seek to virtual offset " + std::to_string(offset) + " in " + path);
+	}
+	return make_stream(std::make_unique<GzipInput>(file));
+}
+
+SequenceReader::SequenceReader(const std::string &path1, const std::optional<std::string> &path2,
+                               size_t decode_threads)
+    : first_read_(true) {
+	sequence1_reader_ = open_stream(path1, decode_threads);
+	if (path2.has_value() && path2->length() > 0) {
+		sequence2_reader_.emplace(open_stream(path2.value(), decode_threads));
+	}
+	initialize(path1, path2);
+}
+
+SequenceReader::SequenceReader(const std::string &path1, const std::optional<std::string> &path2,
+                               const SequenceReadRange &range)
+    : first_read_(true), limited_(range.max_records > 0), remaining_records_(range.max_records) {
+	sequence1_reader_ = open_stream_at(path1, range.offset1, range.compressed1);
+	if (path2.has_value() && path2->length() > 0) {
+		sequence2_reader_.emplace(open_stream_at(path2.value(), range.offset2, range.compressed2));
+	}
+	initialize(path1, path2);
+}
+
+void SequenceReader::initialize(const std::string &path1, const std::optional<std::string> &path2) {
 	// Check if first file is empty by attempting to peek at first record
 	buffered_read1_ = sequence1_reader_->read(1);
 	bool is_empty1 = buffered_read1_.empty();
@@ -50,8 +149,6 @@ SequenceReader::SequenceReader(const std::string &path1, const std::optional<std
 
 	paired_ = path2.has_value() && (path2->length() > 0);
 	if (paired_) {
-		sequence2_reader_.emplace(std::make_unique<SeqStreamIn>(path2->c_str()));
-
 		// Check if second file is empty and detect format
 		buffered_read2_ = sequence2_reader_.value()->read(1);
 		bool is_empty2 = buffered_read2_.empty();
@@ -169,10 +266,18 @@ SequenceRecordBatch SequenceReader::read_pe(const int n) {
 }
 
 SequenceRecordBatch SequenceReader::read(const int n) {
-	if (paired_) {
-		return read_pe(n);
-	} else {
-		return read_se(n);
+	int count = n;
+	if (limited_) {
+		if (remaining_records_ == 0) {
+			return SequenceRecordBatch(paired_);
+		}
+		count = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(n), remaining_records_));
+	}
+
+	auto batch = paired_ ? read_pe(count) : read_se(count);
+	if (limited_) {
+		remaining_records_ -= batch.size();
 	}
+	return batch;
 }
 }; // namespace miint
@@ -0,0 +1,67 @@
+#include "TreeLCA.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace miint {
+
+TreeLCA::TreeLCA(std::shared_ptr<const CompactTree> tree_p) : tree_(std::move(tree_p)) {
+	const auto &tree = *tree_;
+	size_t n = tree.num_nodes();
+	if (n == 0) {
+		return;
+	}
+	preorder = tree.preorder();
+	if (preorder.size() != n) {
+		throw std::runtime_error("Tree has nodes that are not reachable from its root");
+	}
+	preorder_number.resize(n);
+	root_distance.resize(n);
+	for (uint32_t i = 0; i < n; i++) {
+		preorder_number[preorder[i]] = i;
+	}
+	// Parents come before their children in preorder
+	for (auto node : preorder) {
+		if (node == tree.root()) {
+			root_distance[node] = 0;
+			continue;
+		}
+		double length = tree.branch_length(node);
+		root_distance[node] = root_distance[tree.parent(node)] + (std::isnan(length) ? 0.0 : length);
+	}
+
+	// Level 0 starts at preorder number 1; entry 0 (the root, which has no parent) is never queried
+	std::vector<uint32_t> level0(n, 0);
+	for (uint32_t i = 1; i < n; i++) {
+		level0[i] = preorder_number[tree.parent(preorder[i])];
+	}
+	levels.push_back(std::move(level0));
+	for (size_t width = 2; width <= n; width *= 2) {
+		const auto &previous = levels.back();
+		std::vector<uint32_t> level(n - width + 1);
+		for (size_t i = 0; i + width <= n; i++) {
+			level[i] = std::min(previous[i], previous[i + width / 2]);
+		}
+		levels.push_back(std::move(level));
+	}
+}
+
+uint32_t TreeLCA::lca(uint32_t a, uint32_t b) const {
+	if (a == b) {
+		return a;
+	}
+	uint32_t first = preorder_number[a];
+	uint32_t last = preorder_number[b];
+	if (first > last) {
+		std::swap(first, last);
+	}
+	// Range (first, last] as two overlapping power-of-two windows
+	uint32_t begin = first + 1;
+	uint32_t length = last - first;
+	unsigned k = std::bit_width(length) - 1;
+	const auto &level = levels[k];
+	return preorder[std::min(level[begin], level[last + 1 - (uint32_t(1) << k)])];
+}
+
+} // namespace miint
@@ -0,0 +1,242 @@
+#include "UniFrac.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace miint {
+
+namespace {
+
+// Branch embeddings applied to the stripes together are held in a batch of up to BATCH_BYTES, at most
+// MAX_BRANCH_BATCH branches; each stripe is then swept once per batch rather than once per branch
+constexpr size_t BATCH_BYTES = 64 << 20;
+constexpr size_t MAX_BRANCH_BATCH = 4096;
+constexpr uint32_t AMBIGUOUS_TIP = UINT32_MAX;
+
+} // namespace
+
+UniFracMetric parse_unifrac_metric(const std::string &name) {
+	if (name == "unweighted") {
+		return UniFracMetric::UNWEIGHTED;
+	}
+	if (name == "weighted_unnormalized") {
+		return UniFracMetric::WEIGHTED_UNNORMALIZED;
+	}
+	if (name == "weighted_normalized") {
+		return UniFracMetric::WEIGHTED_NORMALIZED;
+	}
+	throw std::runtime_error("Unknown UniFrac metric '" + name +
+	                         "', expected 'unweighted', 'weighted_unnormalized' or 'weighted_normalized'");
+}
+
+UniFrac UniFrac::compute(const NewickTree &tree, const std::vector<std::string> &feature_ids,
+                         const SparseCounts &counts, UniFracMetric metric, size_t n_threads) {
+	return compute_tree(tree, feature_ids, counts, metric, n_threads);
+}
+
+UniFrac UniFrac::compute(const CompactTree &tree, const std::vector<std::string> &feature_ids,
+                         const SparseCounts &counts, UniFracMetric metric, size_t n_threads) {
+	return compute_tree(tree, feature_ids, counts, metric, n_threads);
+}
+
+template <typename Tree>
+UniFrac UniFrac::compute_tree(const Tree &tree, const std::vector<std::string> &feature_ids,
+                              const SparseCounts &counts, UniFracMetric metric, size_t n_threads) {
+	UniFrac result;
+	size_t n = counts.n_samples;
+	result.n_samples = n;
+	if (n < 2) {
+		return result;
+	}
+	bool unweighted = metric == UniFracMetric::UNWEIGHTED;
+
+	// The stripes hold n / 2 * n doubles, twice for unweighted UniFrac
+	size_t n_stripes = result.stripe_count();
+	size_t n_matrices = unweighted ? 2 : 1;
+	if (n_stripes > SIZE_MAX / sizeof(double) / n_matrices / n) {
+		throw std::runtime_error("UniFrac of " + std::to_string(n) +
+		                         " samples needs more memory than can be addressed");
+	}
+	std::vector<double> numerator;
+	std::vector<double> denominator;
+	try {
+		numerator.assign(n_stripes * n, 0);
+		denominator.assign(unweighted ? n_stripes * n : 0, 0);
+	} catch (const std::bad_alloc &) {
+		throw std::runtime_error("UniFrac of " + std::to_string(n) + " samples needs " +
+		                         std::to_string(n_stripes * n * n_matrices * sizeof(double) >> 20) +
+		                         "MB for its distances, which could not be allocated");
+	}
+
+	// Tip of each feature
+	std::unordered_map<std::string_view, uint32_t> tip_index;
+	for (uint32_t node = 0; node < tree.num_nodes(); node++) {
+		if (tree.is_tip(node)) {
+			auto inserted = tip_index.emplace(tree.name(node), node);
+			if (!inserted.second) {
+				inserted.first->second = AMBIGUOUS_TIP;
+			}
+		}
+	}
+	std::vector<uint32_t> feature_tip(feature_ids.size());
+	for (size_t k = 0; k < feature_ids.size(); k++) {
+		auto it = tip_index.find(feature_ids[k]);
+		if (it == tip_index.end()) {
+			throw std::runtime_error("Feature '" + feature_ids[k] + "' is not a tip of the tree");
+		}
+		if (it->second == AMBIGUOUS_TIP) {
+			throw std::runtime_error("Feature '" + feature_ids[k] + "' names more than one tip of the tree");
+		}
+		feature_tip[k] = it->second;
+	}
+
+	// Embedding of each tip: presence, or proportion of the sample's counts, by sample
+	uint64_t nnz = counts.indptr[n];
+	std::vector<uint64_t> tip_indptr(tree.num_nodes() + 1, 0);
+	for (uint64_t e = 0; e < nnz; e++) {
+		tip_indptr[feature_tip[counts.features[e]] + 1]++;
+	}
+	for (size_t node = 0; node < tree.num_nodes(); node++) {
+		tip_indptr[node + 1] += tip_indptr[node];
+	}
+	std::vector<std::pair<uint32_t, double>> tip_entries(nnz);
+	{
+		std::vector<uint64_t> next(tip_indptr.begin(), tip_indptr.end() - 1);
+		for (size_t i = 0; i < n; i++) {
+			double total = 0;
+			for (uint64_t e = counts.indptr[i]; e < counts.indptr[i + 1]; e++) {
+				if (counts.values[e] < 0) {
+					throw std::runtime_error("UniFrac needs non-negative counts");
+				}
+				total += counts.values[e];
+			}
+			for (uint64_t e = counts.indptr[i]; e < counts.indptr[i + 1]; e++) {
+				double value = counts.values[e];
+				double embedding = unweighted ? (value > 0 ? 1.0 : 0.0) : (total > 0 ? value / total : 0.0);
+				tip_entries[next[feature_tip[counts.features[e]]]++] = {static_cast<uint32_t>(i), embedding};
+			}
+		}
+	}
+
+	std::vector<double> sample_depth(n, 0); // sum of branch length * embedding, normalizes weighted UniFrac
+
+	// Each batched embedding is stored twice in a row, so sample (i + k) % n is at i + k
+	size_t branch_batch = std::clamp<size_t>(BATCH_BYTES / (2 * n * sizeof(double)), 1, MAX_BRANCH_BATCH);
+	std::vector<double> batch(branch_batch * 2 * n);
+	std::vector<double> batch_lengths;
+	// The same threads apply every batch
+	WorkerPool workers(std::max<size_t>(1, n_threads));
+	size_t n_tasks = std::min(n_stripes, workers.size() * 4);
+	auto apply_batch = [&]() {
+		workers.run(n_tasks, [&](size_t task) {
+			size_t stripe_begin = task * n_stripes / n_tasks;
+			size_t stripe_end = (task + 1) * n_stripes / n_tasks;
+			for (size_t s = stripe_begin; s < stripe_end; s++) {
+				size_t k = s + 1;
+				double *num = numerator.data() + s * n;
+				double *den = unweighted ? denominator.data() + s * n : nullptr;
+				for (size_t b = 0; b < batch_lengths.size(); b++) {
+					const double *e = batch.data() + b * 2 * n;
+					const double *f = e + k;
+					double length = batch_lengths[b];
+					if (unweighted) {
+						for (size_t i = 0; i < n; i++) {
+							num[i] += length * std::abs(e[i] - f[i]);
+							den[i] += length * std::max(e[i], f[i]);
+						}
+					} else {
+						for (size_t i = 0; i < n; i++) {
+							num[i] += length * std::abs(e[i] - f[i]);
+						}
+					}
+				}
+			}
+		});
+		batch_lengths.clear();
+	};
+
+	// Postorder sweep. The stack holds the embeddings of the subtrees completed but not yet merged into their
+	// parent; an empty vector stands for a subtree none of the samples has counts in.
+	std::vector<std::vector<double>> stack;
+	std::vector<std::vector<double>> pool;
+	auto take = [&]() {
+		if (pool.empty()) {
+			return std::vector<double>(n, 0.0);
+		}
+		auto v = std::move(pool.back());
+		pool.pop_back();
+		std::fill(v.begin(), v.end(), 0.0);
+		return v;
+	};
+
+	for (auto node : tree.postorder()) {
+		std::vector<double> embedding;
+		if (tree.is_tip(node)) {
+			if (tip_indptr[node] < tip_indptr[node + 1]) {
+				embedding = take();
+				for (uint64_t p = tip_indptr[node]; p < tip_indptr[node + 1]; p++) {
+					// A feature repeated in a sample adds up
+					auto &value = embedding[tip_entries[p].first];
+					value = unweighted ? 1.0 : value + tip_entries[p].second;
+				}
+			}
+		} else {
+			size_t n_children = tree.children(node).size();
+			for (size_t c = stack.size() - n_children; c < stack.size(); c++) {
+				auto &child = stack[c];
+				if (child.empty()) {
+					continue;
+				}
+				if (embedding.empty()) {
+					embedding = std::move(child);
+					continue;
+				}
+				for (size_t i = 0; i < n; i++) {
+					embedding[i] = unweighted ? std::max(embedding[i], child[i]) : embedding[i] + child[i];
+				}
+				pool.push_back(std::move(child));
+			}
+			stack.resize(stack.size() - n_children);
+		}
+
+		double length = tree.branch_length(node);
+		if (node != tree.root() && !embedding.empty() && length > 0) {
+			auto slot = batch.data() + batch_lengths.size() * 2 * n;
+			std::copy(embedding.begin(), embedding.end(), slot);
+			std::copy(embedding.begin(), embedding.end(), slot + n);
+			batch_lengths.push_back(length);
+			for (size_t i = 0; i < n; i++) {
+				sample_depth[i] += length * embedding[i];
+			}
+			if (batch_lengths.size() == branch_batch) {
+				apply_batch();
+			}
+		}
+		stack.push_back(std::move(embedding));
+	}
+	if (!batch_lengths.empty()) {
+		apply_batch();
+	}
+
+	for (size_t s = 0; s < n_stripes; s++) {
+		for (size_t i = 0; i < n; i++) {
+			double &value = numerator[s * n + i];
+			double norm = 1.0;
+			if (unweighted) {
+				norm = denominator[s * n + i];
+			} else if (metric == UniFracMetric::WEIGHTED_NORMALIZED) {
+				norm = sample_depth[i] + sample_depth[(i + s + 1) % n];
+			}
+			value = norm > 0 ? value / norm : 0.0;
+		}
+	}
+	result.distances = std::move(numerator);
+	return result;
+}
+
+} // namespace miint
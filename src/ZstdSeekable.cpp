@@ -0,0 +1,394 @@
+#include "ZstdSeekable.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+namespace miint {
+
+static constexpr uint32_t ZSTD_FRAME_MAGIC = 0xFD2FB528;
+static constexpr uint8_t SEEK_TABLE_CHECKSUM_FLAG = 0x80;
+static constexpr uint8_t SEEK_TABLE_RESERVED_BITS = 0x7C;
+
+static void put_u32(std::string &out, uint32_t value) {
+	for (int i = 0; i < 4; i++) {
+		out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+}
+
+static uint32_t get_u32(const std::string &data, size_t pos) {
+	uint32_t value = 0;
+	for (int i = 0; i < 4; i++) {
+		value |= static_cast<uint32_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+	}
+	return value;
+}
+
+//===--------------------------------------------------------------------===//
+// ZstdSeekTable
+//===--------------------------------------------------------------------===//
+
+std::string ZstdSeekTable::serialize() const {
+	std::string out;
+	size_t entries_size = frames.size() * 8;
+	out.reserve(FRAME_HEADER_SIZE + entries_size + FOOTER_SIZE);
+	put_u32(out, SKIPPABLE_MAGIC);
+	put_u32(out, static_cast<uint32_t>(entries_size + FOOTER_SIZE));
+	for (const auto &frame : frames) {
+		put_u32(out, frame.compressed);
+		put_u32(out, frame.decompressed);
+	}
+	put_u32(out, static_cast<uint32_t>(frames.size()));
+	out.push_back(0);
+	put_u32(out, SEEKABLE_MAGIC);
+	return out;
+}
+
+size_t ZstdSeekTable::table_size(const std::string &footer) {
+	if (footer.size() != FOOTER_SIZE || get_u32(footer, 5) != SEEKABLE_MAGIC) {
+		return 0;
+	}
+	auto descriptor = static_cast<uint8_t>(footer[4]);
+	if (descriptor & SEEK_TABLE_RESERVED_BITS) {
+		return 0;
+	}
+	size_t entry_size = (descriptor & SEEK_TABLE_CHECKSUM_FLAG) ? 12 : 8;
+	return FRAME_HEADER_SIZE + static_cast<size_t>(get_u32(footer, 0)) * entry_size + FOOTER_SIZE;
+}
+
+ZstdSeekTable ZstdSeekTable::deserialize(const std::string &data) {
+	if (data.size() < FRAME_HEADER_SIZE + FOOTER_SIZE || get_u32(data, 0) != SKIPPABLE_MAGIC ||
+	    get_u32(data, 4) != data.size() - FRAME_HEADER_SIZE) {
+		throw std::runtime_error("Not a zstd seek table (bad magic or frame size)");
+	}
+	auto footer = data.substr(data.size() - FOOTER_SIZE);
+	if (table_size(footer) != data.size()) {
+		throw std::runtime_error("Corrupt zstd seek table: footer does not match the table size");
+	}
+	size_t n_frames = get_u32(footer, 0);
+	size_t entry_size = (static_cast<uint8_t>(footer[4]) & SEEK_TABLE_CHECKSUM_FLAG) ? 12 : 8;
+
+	ZstdSeekTable table;
+	table.frames.reserve(n_frames);
+	for (size_t i = 0; i < n_frames; i++) {
+		size_t pos = FRAME_HEADER_SIZE + i * entry_size;
+		table.frames.push_back({get_u32(data, pos), get_u32(data, pos + 4)});
+	}
+	return table;
+}
+
+uint64_t ZstdSeekTable::compressed_size() const {
+	uint64_t total = 0;
+	for (const auto &frame : frames) {
+		total += frame.compressed;
+	}
+	return total;
+}
+
+uint64_t ZstdSeekTable::decompressed_size() const {
+	uint64_t total = 0;
+	for (const auto &frame : frames) {
+		total += frame.decompressed;
+	}
+	return total;
+}
+
+//===--------------------------------------------------------------------===//
+// Compression
+//===--------------------------------------------------------------------===//
+
+#ifdef HAVE_LIBZSTD
+
+// Contexts are reused by each thread instead of being allocated per frame
+struct ZstdContexts {
+	ZSTD_CCtx *cctx = nullptr;
+	ZSTD_DCtx *dctx = nullptr;
+
+	~ZstdContexts() {
+		ZSTD_freeCCtx(cctx);
+		ZSTD_freeDCtx(dctx);
+	}
+	ZSTD_CCtx *compression() {
+		if (!cctx) {
+			cctx = ZSTD_createCCtx();
+		}
+		return cctx;
+	}
+	ZSTD_DCtx *decompression() {
+		if (!dctx) {
+			dctx = ZSTD_createDCtx();
+		}
+		return dctx;
+	}
+};
+
+static thread_local ZstdContexts zstd_contexts;
+
+bool zstd_available() {
+	return true;
+}
+
+size_t zstd_compress_frames_bound(size_t size) {
+	size_t bound = 0;
+	for (size_t offset = 0; offset < size; offset += ZSTD_MAX_FRAME_SIZE) {
+		bound += ZSTD_compressBound(std::min(size - offset, ZSTD_MAX_FRAME_SIZE));
+	}
+	return bound;
+}
+
+size_t zstd_compress_frames(const char *data, size_t size, char *out, int level, std::vector<ZstdFrameSize> &frames) {
+	auto cctx = zstd_contexts.compression();
+	if (!cctx) {
+		throw std::runtime_error("Failed to allocate a zstd compression context");
+	}
+	size_t written = 0;
+	for (size_t offset = 0; offset < size; offset += ZSTD_MAX_FRAME_SIZE) {
+		size_t chunk = std::min(size - offset, ZSTD_MAX_FRAME_SIZE);
+		size_t result = ZSTD_compressCCtx(cctx, out + written, ZSTD_compressBound(chunk), data + offset, chunk, level);
+		if (ZSTD_isError(result)) {
+			throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(result));
+		}
+		frames.push_back({static_cast<uint32_t>(result), static_cast<uint32_t>(chunk)});
+		written += result;
+	}
+	return written;
+}
+
+#else
+
+bool zstd_available() {
+	return false;
+}
+
+size_t zstd_compress_frames_bound(size_t size) {
+	throw std::runtime_error("zstd support is not available in this build");
+}
+
+size_t zstd_compress_frames(const char *data, size_t size, char *out, int level, std::vector<ZstdFrameSize> &frames) {
+	throw std::runtime_error("zstd support is not available in this build");
+}
+
+#endif
+
+//===--------------------------------------------------------------------===//
+// ZstdReader
+//===--------------------------------------------------------------------===//
+
+bool ZstdReader::is_zstd_file(const std::string &path) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	bool is_zstd = false;
+	if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= 4) {
+		std::string magic(4, '\0');
+		is_zstd = ::pread(fd, &magic[0], 4, 0) == 4 && get_u32(magic, 0) == ZSTD_FRAME_MAGIC;
+	}
+	::close(fd);
+	return is_zstd;
+}
+
+#ifdef HAVE_LIBZSTD
+
+// Read exactly length bytes at offset
+static void pread_fully(int fd, char *buffer, size_t length, uint64_t offset, const std::string &path) {
+	while (length > 0) {
+		ssize_t n = ::pread(fd, buffer, length, static_cast<off_t>(offset));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			throw std::runtime_error("Failed to read " + path + ": unexpected end of file");
+		}
+		buffer += n;
+		length -= static_cast<size_t>(n);
+		offset += static_cast<uint64_t>(n);
+	}
+}
+
+ZstdReader::ZstdReader(const std::string &path, size_t n_threads)
+    : path_(path), n_threads_(std::max<size_t>(1, n_threads)) {
+	fd_ = ::open(path.c_str(), O_RDONLY);
+	if (fd_ < 0) {
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	// A seek table is only trusted when its frames account for every byte before it
+	struct stat st;
+	if (::fstat(fd_, &st) == 0 && S_ISREG(st.st_mode) &&
+	    static_cast<uint64_t>(st.st_size) >= ZstdSeekTable::FRAME_HEADER_SIZE + ZstdSeekTable::FOOTER_SIZE) {
+		uint64_t file_size = static_cast<uint64_t>(st.st_size);
+		std::string footer(ZstdSeekTable::FOOTER_SIZE, '\0');
+		pread_fully(fd_, &footer[0], footer.size(), file_size - footer.size(), path_);
+		size_t table_size = ZstdSeekTable::table_size(footer);
+		if (table_size > 0 && table_size <= file_size) {
+			std::string data(table_size, '\0');
+			pread_fully(fd_, &data[0], table_size, file_size - table_size, path_);
+			try {
+				auto table = ZstdSeekTable::deserialize(data);
+				if (table.compressed_size() + table_size == file_size) {
+					frames_ = std::move(table.frames);
+					seekable_ = true;
+				}
+			} catch (std::runtime_error &) {
+				// Not a seek table after all; the file is streamed
+			}
+		}
+	}
+
+	if (seekable_ && n_threads_ > 1 && frames_.size() > 1) {
+		try {
+			pool_ = std::make_unique<WorkerPool>(n_threads_);
+		} catch (...) {
+			::close(fd_);
+			throw;
+		}
+	}
+	if (!seekable_) {
+		dstream_ = ZSTD_createDStream();
+		if (!dstream_) {
+			::close(fd_);
+			throw std::runtime_error("Failed to allocate a zstd decompression context");
+		}
+		ZSTD_initDStream(static_cast<ZSTD_DStream *>(dstream_));
+		input_.resize(ZSTD_DStreamInSize());
+	}
+}
+
+ZstdReader::~ZstdReader() {
+	if (dstream_) {
+		ZSTD_freeDStream(static_cast<ZSTD_DStream *>(dstream_));
+	}
+	if (fd_ >= 0) {
+		::close(fd_);
+	}
+}
+
+bool ZstdReader::read_batch() {
+	if (next_frame_ >= frames_.size()) {
+		return false;
+	}
+	// Frames are contiguous, so a batch is fetched with a single read and then decoded in parallel
+	size_t count = std::min(frames_.size() - next_frame_, pool_ ? pool_->size() * 2 : 1);
+	std::vector<uint64_t> offsets(count + 1, 0);
+	for (size_t i = 0; i < count; i++) {
+		offsets[i + 1] = offsets[i] + frames_[next_frame_ + i].compressed;
+	}
+	std::string compressed(offsets[count], '\0');
+	pread_fully(fd_, &compressed[0], compressed.size(), next_offset_, path_);
+
+	batch_.resize(count);
+	auto decode = [&](size_t i) {
+		const auto &frame = frames_[next_frame_ + i];
+		auto &out = batch_[i];
+		out.resize(frame.decompressed);
+		auto dctx = zstd_contexts.decompression();
+		if (!dctx) {
+			throw std::runtime_error("Failed to allocate a zstd decompression context");
+		}
+		size_t result =
+		    ZSTD_decompressDCtx(dctx, &out[0], out.size(), compressed.data() + offsets[i], frame.compressed);
+		if (ZSTD_isError(result) || result != frame.decompressed) {
+			throw std::runtime_error("Corrupt zstd frame " + std::to_string(next_frame_ + i) + " in " + path_);
+		}
+	};
+	if (pool_) {
+		pool_->run(count, decode);
+	} else {
+		decode(0);
+	}
+
+	next_frame_ += count;
+	next_offset_ += offsets[count];
+	batch_frame_ = 0;
+	batch_pos_ = 0;
+	return true;
+}
+
+size_t ZstdReader::read_stream(char *buffer, size_t length) {
+	auto dstream = static_cast<ZSTD_DStream *>(dstream_);
+	ZSTD_outBuffer out {buffer, length, 0};
+	while (out.pos == 0) {
+		if (input_pos_ == input_size_ && !input_eof_) {
+			ssize_t n = ::read(fd_, input_.data(), input_.size());
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n < 0) {
+				throw std::runtime_error("Failed to read " + path_);
+			}
+			input_eof_ = n == 0;
+			input_size_ = static_cast<size_t>(n);
+			input_pos_ = 0;
+		}
+		bool input_done = input_eof_ && input_pos_ == input_size_;
+		if (input_done && last_result_ == 0) {
+			// Every frame is complete and flushed
+			break;
+		}
+		ZSTD_inBuffer in {input_.data(), input_size_, input_pos_};
+		size_t result = ZSTD_decompressStream(dstream, &out, &in);
+		if (ZSTD_isError(result)) {
+			throw std::runtime_error("Corrupt zstd data in " + path_ + ": " + ZSTD_getErrorName(result));
+		}
+		input_pos_ = in.pos;
+		last_result_ = result;
+		if (input_done && out.pos == 0) {
+			break;
+		}
+	}
+	if (out.pos == 0 && last_result_ != 0) {
+		throw std::runtime_error("Truncated zstd data in " + path_);
+	}
+	return out.pos;
+}
+
+#else
+
+ZstdReader::ZstdReader(const std::string &path, size_t n_threads) : path_(path), n_threads_(n_threads) {
+	throw std::runtime_error("Cannot read " + path + ": zstd support is not available in this build");
+}
+
+ZstdReader::~ZstdReader() {
+}
+
+bool ZstdReader::read_batch() {
+	return false;
+}
+
+size_t ZstdReader::read_stream(char *buffer, size_t length) {
+	return 0;
+}
+
+#endif
+
+size_t ZstdReader::read(char *buffer, size_t length) {
+	if (!seekable_) {
+		return read_stream(buffer, length);
+	}
+	size_t copied = 0;
+	while (copied < length) {
+		if (batch_frame_ >= batch_.size() && !read_batch()) {
+			break;
+		}
+		const auto &frame = batch_[batch_frame_];
+		size_t n = std::min(length - copied, frame.size() - batch_pos_);
+		std::copy_n(frame.data() + batch_pos_, n, buffer + copied);
+		copied += n;
+		batch_pos_ += n;
+		if (batch_pos_ == frame.size()) {
+			batch_frame_++;
+			batch_pos_ = 0;
+		}
+	}
+	return copied;
+}
+
+} // namespace miint
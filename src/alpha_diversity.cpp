@@ -0,0 +1,97 @@
+#include "alpha_diversity.hpp"
+#include "duckdb/function/aggregate_function.hpp"
+
+namespace duckdb {
+
+struct ShannonMetric {
+	static constexpr const char *NAME = "alpha_shannon";
+	static constexpr bool NULL_IF_EMPTY = true;
+	static double Compute(const miint::AlphaDiversity &state) {
+		return state.Shannon();
+	}
+};
+
+struct SimpsonMetric {
+	static constexpr const char *NAME = "alpha_simpson";
+	static constexpr bool NULL_IF_EMPTY = true;
+	static double Compute(const miint::AlphaDiversity &state) {
+		return state.Simpson();
+	}
+};
+
+struct Chao1Metric {
+	static constexpr const char *NAME = "alpha_chao1";
+	static constexpr bool NULL_IF_EMPTY = true;
+	static double Compute(const miint::AlphaDiversity &state) {
+		return state.Chao1();
+	}
+};
+
+struct ObservedMetric {
+	static constexpr const char *NAME = "alpha_observed";
+	static constexpr bool NULL_IF_EMPTY = false;
+	static int64_t Compute(const miint::AlphaDiversity &state) {
+		return static_cast<int64_t>(state.observed);
+	}
+};
+
+template <class METRIC>
+struct AlphaDiversityOperation {
+	template <class STATE>
+	static void Initialize(STATE &state) {
+		state = STATE();
+	}
+
+	template <class INPUT_TYPE, class STATE, class OP>
+	static void Operation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &unary_input) {
+		if (!(input >= 0)) {
+			throw InvalidInputException("%s: counts must be non-negative, found %s", METRIC::NAME,
+			                            std::to_string(input));
+		}
+		state.Add(input);
+	}
+
+	template <class INPUT_TYPE, class STATE, class OP>
+	static void ConstantOperation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &unary_input,
+	                              idx_t count) {
+		// Each row is one feature, so a repeated count is still added once per row
+		for (idx_t i = 0; i < count; i++) {
+			Operation<INPUT_TYPE, STATE, OP>(state, input, unary_input);
+		}
+	}
+
+	template <class STATE, class OP>
+	static void Combine(const STATE &source, STATE &target, AggregateInputData &aggr_input_data) {
+		target.Merge(source);
+	}
+
+	template <class T, class STATE>
+	static void Finalize(STATE &state, T &target, AggregateFinalizeData &finalize_data) {
+		if (METRIC::NULL_IF_EMPTY && state.Empty()) {
+			finalize_data.ReturnNull();
+			return;
+		}
+		target = METRIC::Compute(state);
+	}
+
+	static bool IgnoreNull() {
+		return true;
+	}
+};
+
+template <class METRIC, class RESULT_TYPE>
+static AggregateFunction GetAlphaDiversityFunction(const LogicalType &return_type) {
+	auto fun = AggregateFunction::UnaryAggregate<miint::AlphaDiversity, double, RESULT_TYPE,
+	                                             AlphaDiversityOperation<METRIC>>(LogicalType::DOUBLE, return_type);
+	fun.name = METRIC::NAME;
+	return fun;
+}
+
+void AlphaDiversityFunctions::Register(ExtensionLoader &loader) {
+	loader.RegisterFunction(GetAlphaDiversityFunction<ShannonMetric, double>(LogicalType::DOUBLE));
+	loader.RegisterFunction(GetAlphaDiversityFunction<SimpsonMetric, double>(LogicalType::DOUBLE));
+	loader.RegisterFunction(GetAlphaDiversityFunction<Chao1Metric, double>(LogicalType::DOUBLE));
+	loader.RegisterFunction(GetAlphaDiversityFunction<ObservedMetric, int64_t>(LogicalType::BIGINT));
+}
+
+} // namespace duckdb
@@ -0,0 +1,449 @@
+#include "bam_writer.hpp"
+#include "Parallel.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/uuid.hpp"
+#include "duckdb/common/serializer/buffered_file_reader.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+#include <htslib-1.22.1/htslib/bgzf.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <queue>
+
+namespace duckdb {
+
+//===--------------------------------------------------------------------===//
+// BAM Serialization
+//===--------------------------------------------------------------------===//
+void SerializeBAMHeader(sam_hdr_t *header, MemoryStream &out) {
+	const char *text = sam_hdr_str(header);
+	size_t text_length = sam_hdr_length(header);
+	if (text_length > UINT32_MAX) {
+		throw IOException("SAM header too long for BAM format");
+	}
+
+	out.WriteData(const_data_ptr_cast("BAM\1"), 4);
+	uint32_t l_text = static_cast<uint32_t>(text_length);
+	out.WriteData(const_data_ptr_cast(&l_text), sizeof(l_text));
+	if (l_text > 0) {
+		out.WriteData(const_data_ptr_cast(text), l_text);
+	}
+
+	int32_t n_ref = sam_hdr_nref(header);
+	out.WriteData(const_data_ptr_cast(&n_ref), sizeof(n_ref));
+	for (int32_t tid = 0; tid < n_ref; tid++) {
+		const char *name = sam_hdr_tid2name(header, tid);
+		int32_t name_length = static_cast<int32_t>(strlen(name)) + 1; // Includes NUL terminator
+		uint32_t ref_length = static_cast<uint32_t>(sam_hdr_tid2len(header, tid));
+		out.WriteData(const_data_ptr_cast(&name_length), sizeof(name_length));
+		out.WriteData(const_data_ptr_cast(name), name_length);
+		out.WriteData(const_data_ptr_cast(&ref_length), sizeof(ref_length));
+	}
+}
+
+void SerializeBAMRecord(const bam1_t *record, MemoryStream &out, const string &read_id) {
+	const bam1_core_t &c = record->core;
+	if (c.l_qname - c.l_extranul > 255) {
+		throw InvalidInputException("Read name is longer than 254 characters and cannot be written to BAM: %s",
+		                            read_id);
+	}
+	if (c.pos > INT32_MAX || c.mpos > INT32_MAX || c.isize < INT32_MIN || c.isize > INT32_MAX) {
+		throw InvalidInputException("Positional data is too large for BAM format for read: %s", read_id);
+	}
+
+	bool long_cigar = c.n_cigar > 0xffff;
+	uint32_t block_length = record->l_data - c.l_extranul + 32;
+	if (long_cigar) {
+		block_length += 16; // "CGBI", 4-byte count and the 8-byte placeholder CIGAR
+	}
+
+	uint32_t fixed[9];
+	fixed[0] = block_length;
+	fixed[1] = static_cast<uint32_t>(c.tid);
+	fixed[2] = static_cast<uint32_t>(c.pos);
+	fixed[3] = static_cast<uint32_t>(c.bin) << 16 | static_cast<uint32_t>(c.qual) << 8 | (c.l_qname - c.l_extranul);
+	fixed[4] = static_cast<uint32_t>(c.flag) << 16 | (long_cigar ? 2 : (c.n_cigar & 0xffff));
+	fixed[5] = static_cast<uint32_t>(c.l_qseq);
+	fixed[6] = static_cast<uint32_t>(c.mtid);
+	fixed[7] = static_cast<uint32_t>(c.mpos);
+	fixed[8] = static_cast<uint32_t>(c.isize);
+	out.WriteData(const_data_ptr_cast(fixed), sizeof(fixed));
+	out.WriteData(record->data, c.l_qname - c.l_extranul);
+
+	if (!long_cigar) {
+		out.WriteData(record->data + c.l_qname, record->l_data - c.l_qname);
+		return;
+	}
+
+	auto cigar = bam_get_cigar(record);
+	hts_pos_t ref_length = bam_cigar2rlen(c.n_cigar, cigar);
+	if (ref_length >= (1 << 28)) {
+		throw InvalidInputException("CIGAR for read %s covers too much reference to be written to BAM", read_id);
+	}
+	uint32_t placeholder[2] = {static_cast<uint32_t>(c.l_qseq) << 4 | BAM_CSOFT_CLIP,
+	                           static_cast<uint32_t>(ref_length) << 4 | BAM_CREF_SKIP};
+	uint32_t cigar_start = static_cast<uint32_t>(reinterpret_cast<const uint8_t *>(cigar) - record->data);
+	uint32_t cigar_end = cigar_start + c.n_cigar * 4;
+	uint32_t n_cigar = c.n_cigar;
+	out.WriteData(const_data_ptr_cast(placeholder), sizeof(placeholder));
+	out.WriteData(record->data + cigar_end, record->l_data - cigar_end);
+	out.WriteData(const_data_ptr_cast("CGBI"), 4);
+	out.WriteData(const_data_ptr_cast(&n_cigar), sizeof(n_cigar));
+	out.WriteData(record->data + cigar_start, c.n_cigar * 4);
+}
+
+//===--------------------------------------------------------------------===//
+// BAMSortLocalState Implementation
+//===--------------------------------------------------------------------===//
+BAMSortLocalState::BAMSortLocalState(idx_t run_size_p) : run_size(run_size_p) {
+}
+
+bool BAMSortLocalState::Append(const bam1_t *record, const string &read_id) {
+	Entry entry;
+	entry.tid_key = static_cast<uint32_t>(record->core.tid);
+	entry.pos = record->core.pos;
+	entry.end = bam_endpos(record);
+	entry.mapped = !(record->core.flag & BAM_FUNMAP);
+	entry.offset = records.GetPosition();
+	SerializeBAMRecord(record, records, read_id);
+	entry.length = static_cast<uint32_t>(records.GetPosition() - entry.offset);
+	entries.push_back(entry);
+	return records.GetPosition() >= run_size;
+}
+
+//===--------------------------------------------------------------------===//
+// Run File Layout
+//===--------------------------------------------------------------------===//
+// Each run is a sequence of (tid_key, mapped, pos, end, length, serialized record) in sorted order
+struct BAMRunEntryHeader {
+	uint32_t tid_key;
+	uint32_t mapped;
+	int64_t pos;
+	int64_t end;
+	uint32_t length;
+	uint32_t padding;
+};
+
+struct BAMRunReader {
+	unique_ptr<BufferedFileReader> reader;
+	BAMRunEntryHeader header;
+	vector<uint8_t> record;
+
+	// Load the next entry; returns false once the run is exhausted
+	bool Next() {
+		if (reader->Finished()) {
+			return false;
+		}
+		reader->ReadData(data_ptr_cast(&header), sizeof(header));
+		record.resize(header.length);
+		reader->ReadData(record.data(), header.length);
+		return true;
+	}
+};
+
+// K-way merge of the runs at paths, calling emit(run) for each entry in sorted order. Entries that compare
+// equal come out in the order of their runs, so merging consecutive groups of runs keeps the sort stable.
+template <class EMIT>
+static void MergeRuns(FileSystem &fs, const string *paths, idx_t n_runs, EMIT &&emit) {
+	vector<BAMRunReader> runs(n_runs);
+	auto later = [&runs](idx_t a, idx_t b) {
+		auto &ha = runs[a].header;
+		auto &hb = runs[b].header;
+		if (ha.tid_key != hb.tid_key) {
+			return ha.tid_key > hb.tid_key;
+		}
+		if (ha.pos != hb.pos) {
+			return ha.pos > hb.pos;
+		}
+		return a > b;
+	};
+	std::priority_queue<idx_t, vector<idx_t>, decltype(later)> heap(later);
+	for (idx_t i = 0; i < n_runs; i++) {
+		runs[i].reader = make_uniq<BufferedFileReader>(fs, paths[i].c_str());
+		if (runs[i].Next()) {
+			heap.push(i);
+		}
+	}
+
+	while (!heap.empty()) {
+		auto i = heap.top();
+		heap.pop();
+		auto &run = runs[i];
+		emit(run);
+		if (run.Next()) {
+			heap.push(i);
+		}
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// BGZF Block Writer (tracks virtual offsets for indexing)
+//===--------------------------------------------------------------------===//
+// Cuts the stream into BGZF blocks as bgzf_write would, and compresses a batch of blocks at a time on a
+// WorkerPool before appending them in order. A block's file address is only known once the blocks before it
+// are compressed, so virtual offsets are taken with Mark() and reported to on_marks after each batch.
+class BGZFBlockWriter {
+public:
+	// Blocks compressed together, per thread
+	static constexpr idx_t BLOCKS_PER_THREAD = 4;
+
+	using MarkCallback = std::function<void(const vector<uint64_t> &offsets)>;
+
+	BGZFBlockWriter(CopyFileHandle &file_p, idx_t n_threads, MarkCallback on_marks_p)
+	    : file(file_p), workers(n_threads), on_marks(std::move(on_marks_p)), block_address(file_p.BytesWritten()),
+	      block_starts({0}), compressed(workers.size() * BLOCKS_PER_THREAD) {
+	}
+
+	// BGZF virtual offset of the next byte to be written, once everything appended has been flushed
+	uint64_t Tell() {
+		D_ASSERT(buffer.GetPosition() == 0);
+		return block_address << 16;
+	}
+
+	void Append(const_data_ptr_t data, idx_t size) {
+		// Start a new block rather than splitting a record that would fit in one (as bgzf_flush_try does)
+		if (OpenBlockSize() + size > BGZF_BLOCK_SIZE) {
+			CloseBlock();
+		}
+		while (size > 0) {
+			idx_t n = MinValue<idx_t>(size, BGZF_BLOCK_SIZE - OpenBlockSize());
+			buffer.WriteData(data, n);
+			data += n;
+			size -= n;
+			if (OpenBlockSize() == BGZF_BLOCK_SIZE) {
+				CloseBlock();
+			}
+		}
+	}
+
+	// Take the virtual offset of the next byte to be written; on_marks receives it after the next batch
+	void Mark() {
+		marks.emplace_back(block_starts.size() - 1, OpenBlockSize());
+	}
+
+	void Flush() {
+		CloseBlock();
+		WriteBlocks();
+	}
+
+private:
+	idx_t OpenBlockSize() {
+		return buffer.GetPosition() - block_starts.back();
+	}
+
+	void CloseBlock() {
+		if (OpenBlockSize() == 0) {
+			return;
+		}
+		block_starts.push_back(buffer.GetPosition());
+		if (block_starts.size() - 1 == compressed.size()) {
+			WriteBlocks();
+		}
+	}
+
+	// Compress and append the closed blocks; the open block is empty
+	void WriteBlocks() {
+		idx_t n_blocks = block_starts.size() - 1;
+		auto data = buffer.GetData();
+		auto level = file.CompressionLevel();
+		workers.run(n_blocks, [&](size_t b) {
+			compressed[b].Rewind();
+			CompressBGZFBlocks(data + block_starts[b], block_starts[b + 1] - block_starts[b], compressed[b], level);
+		});
+
+		vector<uint64_t> addresses(n_blocks + 1);
+		addresses[0] = block_address;
+		for (idx_t b = 0; b < n_blocks; b++) {
+			file.WriteCompressed(compressed[b].GetData(), compressed[b].GetPosition());
+			addresses[b + 1] = addresses[b] + compressed[b].GetPosition();
+		}
+		block_address = addresses[n_blocks];
+
+		if (!marks.empty()) {
+			vector<uint64_t> offsets;
+			offsets.reserve(marks.size());
+			for (auto &mark : marks) {
+				offsets.push_back(addresses[mark.first] << 16 | mark.second);
+			}
+			marks.clear();
+			on_marks(offsets);
+		}
+		buffer.Rewind();
+		block_starts.assign(1, 0);
+	}
+
+	CopyFileHandle &file;
+	miint::WorkerPool workers;
+	MarkCallback on_marks;
+	uint64_t block_address;
+	MemoryStream buffer;                  // blocks not yet written, back to back
+	vector<idx_t> block_starts;           // start of each block in buffer; the last one is open
+	vector<std::pair<idx_t, idx_t>> marks; // (block, offset in block) of each mark not yet reported
+	vector<MemoryStream> compressed;
+};
+
+struct HTSIndexDeleter {
+	void operator()(hts_idx_t *idx) const {
+		if (idx) {
+			hts_idx_destroy(idx);
+		}
+	}
+};
+
+//===--------------------------------------------------------------------===//
+// BAMCoordinateSorter Implementation
+//===--------------------------------------------------------------------===//
+BAMCoordinateSorter::BAMCoordinateSorter(ClientContext &context) : fs(FileSystem::GetFileSystem(context)) {
+	n_threads = static_cast<idx_t>(MaxValue<int32_t>(TaskScheduler::GetScheduler(context).NumberOfThreads(), 1));
+	temp_directory = BufferManager::GetBufferManager(context).GetTemporaryDirectory();
+	if (temp_directory.empty()) {
+		throw InvalidInputException("COPY FORMAT BAM with SORT 'coordinate' spills to disk and requires a temporary "
+		                            "directory (SET temp_directory = '...')");
+	}
+	if (!fs.DirectoryExists(temp_directory)) {
+		fs.CreateDirectory(temp_directory);
+	}
+}
+
+BAMCoordinateSorter::~BAMCoordinateSorter() {
+	// Runs are removed after a successful merge; clean up whatever is left after an error
+	for (auto &path : run_paths) {
+		try {
+			fs.RemoveFile(path);
+		} catch (...) {
+		}
+	}
+}
+
+string BAMCoordinateSorter::NewRunPath() {
+	return fs.JoinPath(temp_directory,
+	                   StringUtil::Format("miint_bam_sort_%s.run", UUID::ToString(UUID::GenerateRandomUUID())));
+}
+
+void BAMCoordinateSorter::Spill(BAMSortLocalState &local_state) {
+	if (local_state.Empty()) {
+		return;
+	}
+
+	auto &entries = local_state.entries;
+	std::stable_sort(entries.begin(), entries.end(),
+	                 [](const BAMSortLocalState::Entry &a, const BAMSortLocalState::Entry &b) {
+		                 return a.tid_key != b.tid_key ? a.tid_key < b.tid_key : a.pos < b.pos;
+	                 });
+
+	string path = NewRunPath();
+	{
+		BufferedFileWriter writer(fs, path, FileFlags::FILE_FLAGS_WRITE | FileFlags::FILE_FLAGS_FILE_CREATE_NEW);
+		auto data = local_state.records.GetData();
+		for (auto &entry : entries) {
+			BAMRunEntryHeader header {entry.tid_key, entry.mapped ? 1u : 0u, entry.pos, entry.end, entry.length, 0};
+			writer.WriteData(const_data_ptr_cast(&header), sizeof(header));
+			writer.WriteData(data + entry.offset, entry.length);
+		}
+		writer.Close();
+	}
+
+	{
+		lock_guard<mutex> glock(lock);
+		run_paths.push_back(path);
+	}
+
+	local_state.records.Rewind();
+	entries.clear();
+}
+
+void BAMCoordinateSorter::Merge(CopyFileHandle &file, sam_hdr_t *header, bool build_index,
+                                const string &index_base_path) {
+	// Merge passes over groups of consecutive runs, until one merge can take them all
+	while (run_paths.size() > BAM_SORT_MERGE_FAN_IN) {
+		idx_t n_groups = (run_paths.size() + BAM_SORT_MERGE_FAN_IN - 1) / BAM_SORT_MERGE_FAN_IN;
+		vector<string> inputs = run_paths;
+		vector<string> merged(n_groups);
+		for (auto &path : merged) {
+			path = NewRunPath();
+		}
+		// Registered up front so they are removed if the pass fails
+		run_paths.insert(run_paths.end(), merged.begin(), merged.end());
+		miint::run_parallel(n_groups, n_threads, [&](size_t g) {
+			idx_t begin = g * BAM_SORT_MERGE_FAN_IN;
+			idx_t n_runs = MinValue<idx_t>(BAM_SORT_MERGE_FAN_IN, inputs.size() - begin);
+			BufferedFileWriter writer(fs, merged[g],
+			                          FileFlags::FILE_FLAGS_WRITE | FileFlags::FILE_FLAGS_FILE_CREATE_NEW);
+			MergeRuns(fs, inputs.data() + begin, n_runs, [&](BAMRunReader &run) {
+				writer.WriteData(const_data_ptr_cast(&run.header), sizeof(run.header));
+				writer.WriteData(run.record.data(), run.record.size());
+			});
+			writer.Close();
+		});
+		for (auto &path : inputs) {
+			fs.RemoveFile(path);
+		}
+		run_paths = std::move(merged);
+	}
+
+	// Records whose end offsets are still to be reported by the writer, for the index
+	vector<BAMRunEntryHeader> unindexed;
+	std::unique_ptr<hts_idx_t, HTSIndexDeleter> index;
+	auto push_index = [&](const vector<uint64_t> &offsets) {
+		for (idx_t i = 0; i < offsets.size(); i++) {
+			auto &entry = unindexed[i];
+			auto tid = static_cast<int32_t>(entry.tid_key);
+			if (hts_idx_push(index.get(), tid, entry.pos, entry.end, offsets[i], entry.mapped) < 0) {
+				throw IOException("Failed to index BAM record at %s:%lld",
+				                  tid < 0 ? string("*") : string(sam_hdr_tid2name(header, tid)), entry.pos + 1);
+			}
+		}
+		unindexed.clear();
+	};
+	BGZFBlockWriter writer(file, n_threads, push_index);
+
+	int index_format = HTS_FMT_BAI;
+	if (build_index) {
+		// Same level selection as sam_idx_init; BAI addresses at most 2^29 bases per reference
+		int32_t n_ref = sam_hdr_nref(header);
+		int64_t max_length = 0;
+		for (int32_t tid = 0; tid < n_ref; tid++) {
+			max_length = MaxValue<int64_t>(max_length, sam_hdr_tid2len(header, tid));
+		}
+		int min_shift = 14;
+		int n_lvls = 5;
+		if (max_length >= (int64_t(1) << 29)) {
+			index_format = HTS_FMT_CSI;
+			n_lvls = 0;
+			for (int64_t s = int64_t(1) << min_shift; max_length + 256 > s; s <<= 3) {
+				n_lvls++;
+			}
+		}
+		index.reset(hts_idx_init(n_ref, index_format, writer.Tell(), min_shift, n_lvls));
+		if (!index) {
+			throw IOException("Failed to initialize BAM index");
+		}
+	}
+
+	MergeRuns(fs, run_paths.data(), run_paths.size(), [&](BAMRunReader &run) {
+		writer.Append(run.record.data(), run.record.size());
+		if (index) {
+			unindexed.push_back(run.header);
+			writer.Mark();
+		}
+	});
+	writer.Flush();
+
+	for (auto &path : run_paths) {
+		fs.RemoveFile(path);
+	}
+	run_paths.clear();
+
+	if (index) {
+		if (hts_idx_finish(index.get(), writer.Tell()) < 0) {
+			throw IOException("Failed to finish BAM index");
+		}
+		if (hts_idx_save_as(index.get(), index_base_path.c_str(), nullptr, index_format) < 0) {
+			throw IOException("Failed to write BAM index for %s", index_base_path);
+		}
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,123 @@
+#include "beta_diversity.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/vector.hpp"
+#include "duckdb/common/vector_size.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include <stdexcept>
+
+namespace duckdb {
+
+unique_ptr<FunctionData> BetaDiversityTableFunction::Bind(ClientContext &context, TableFunctionBindInput &input,
+                                                          vector<LogicalType> &return_types,
+                                                          vector<std::string> &names) {
+	auto data = make_uniq<Data>();
+
+	if (input.inputs[0].IsNull()) {
+		throw BinderException("beta_diversity: table must not be NULL");
+	}
+	data->table_name = input.inputs[0].ToString();
+
+	if (input.inputs[1].IsNull()) {
+		throw BinderException("beta_diversity: metric must not be NULL");
+	}
+	try {
+		data->metric = miint::parse_beta_metric(StringUtil::Lower(input.inputs[1].ToString()));
+	} catch (const std::runtime_error &e) {
+		throw BinderException("beta_diversity: %s", e.what());
+	}
+
+	data->columns = ParseFeatureTableColumns(input.named_parameters);
+	ValidateFeatureTable(context, data->table_name, data->columns);
+
+	names = data->names;
+	return_types = data->types;
+	return std::move(data);
+}
+
+bool BetaDiversityTableFunction::GlobalState::NextRow(size_t &row) {
+	std::lock_guard<std::mutex> guard(lock);
+	// The last sample has no samples after it
+	if (next_row + 1 >= table.SampleCount()) {
+		return false;
+	}
+	row = next_row++;
+	return true;
+}
+
+unique_ptr<GlobalTableFunctionState> BetaDiversityTableFunction::InitGlobal(ClientContext &context,
+                                                                            TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<Data>();
+	auto gstate = make_uniq<GlobalState>();
+	gstate->table = ReadFeatureTable(context, bind_data.table_name, bind_data.columns);
+
+	auto &table = gstate->table;
+	try {
+		gstate->beta = make_uniq<miint::BetaDiversity>(table.indptr.data(), table.features.data(),
+		                                               table.values.data(), table.SampleCount(),
+		                                               table.feature_ids.size(), bind_data.metric);
+	} catch (const std::runtime_error &e) {
+		throw InvalidInputException("beta_diversity: %s", e.what());
+	}
+
+	gstate->max_threads =
+	    static_cast<idx_t>(MaxValue<int32_t>(TaskScheduler::GetScheduler(context).NumberOfThreads(), 1));
+	return std::move(gstate);
+}
+
+unique_ptr<LocalTableFunctionState> BetaDiversityTableFunction::InitLocal(ExecutionContext &context,
+                                                                          TableFunctionInitInput &input,
+                                                                          GlobalTableFunctionState *global_state) {
+	return make_uniq<LocalState>();
+}
+
+void BetaDiversityTableFunction::Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &global_state = data_p.global_state->Cast<GlobalState>();
+	auto &local_state = data_p.local_state->Cast<LocalState>();
+	const auto &sample_ids = global_state.table.sample_ids;
+
+	auto sample_a_data = FlatVector::GetData<string_t>(output.data[0]);
+	auto sample_b_data = FlatVector::GetData<string_t>(output.data[1]);
+	auto distance_data = FlatVector::GetData<double>(output.data[2]);
+
+	idx_t n_rows = 0;
+	while (n_rows < STANDARD_VECTOR_SIZE) {
+		if (local_state.position >= local_state.distances.size()) {
+			if (!global_state.NextRow(local_state.row)) {
+				break;
+			}
+			global_state.beta->row(local_state.row, local_state.scratch, local_state.distances);
+			local_state.position = 0;
+		}
+
+		// Emit as much of the current row as fits
+		auto n = MinValue<idx_t>(STANDARD_VECTOR_SIZE - n_rows, local_state.distances.size() - local_state.position);
+		auto sample_a = StringVector::AddString(output.data[0], sample_ids[local_state.row]);
+		for (idx_t i = 0; i < n; i++) {
+			auto j = local_state.row + 1 + local_state.position + i;
+			sample_a_data[n_rows + i] = sample_a;
+			sample_b_data[n_rows + i] = StringVector::AddString(output.data[1], sample_ids[j]);
+			distance_data[n_rows + i] = local_state.distances[local_state.position + i];
+		}
+		local_state.position += n;
+		n_rows += n;
+	}
+
+	output.SetCardinality(n_rows);
+}
+
+TableFunction BetaDiversityTableFunction::GetFunction() {
+	TableFunction tf("beta_diversity", {LogicalType::VARCHAR, LogicalType::VARCHAR}, Execute, Bind, InitGlobal,
+	                 InitLocal);
+
+	tf.named_parameters["sample_id"] = LogicalType::VARCHAR;
+	tf.named_parameters["feature_id"] = LogicalType::VARCHAR;
+	tf.named_parameters["value"] = LogicalType::VARCHAR;
+
+	return tf;
+}
+
+void BetaDiversityTableFunction::Register(ExtensionLoader &loader) {
+	loader.RegisterFunction(GetFunction());
+}
+
+} // namespace duckdb
@@ -0,0 +1,128 @@
+#include "biom_merge.hpp"
+#include "BIOMReader.hpp"
+#include "table_function_common.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/string_util.hpp"
+
+namespace duckdb {
+
+unique_ptr<FunctionData> BiomMergeTableFunction::Bind(ClientContext &context, TableFunctionBindInput &input,
+                                                      vector<LogicalType> &return_types, vector<std::string> &names) {
+	auto data = make_uniq<Data>();
+	FileSystem &fs = FileSystem::GetFileSystem(context);
+
+	// Handle VARCHAR (single path, potentially a glob) or VARCHAR[] (array of literal paths), as read_biom does
+	if (input.inputs[0].IsNull()) {
+		throw BinderException("biom_merge: paths must not be NULL");
+	}
+	if (input.inputs[0].type().id() == LogicalTypeId::VARCHAR) {
+		data->biom_paths = ExpandGlobPattern(fs, context, input.inputs[0].ToString());
+	} else if (input.inputs[0].type().id() == LogicalTypeId::LIST) {
+		for (const auto &child : ListValue::GetChildren(input.inputs[0])) {
+			data->biom_paths.push_back(child.ToString());
+		}
+		if (data->biom_paths.empty()) {
+			throw InvalidInputException("biom_merge: at least one file path must be provided");
+		}
+	} else {
+		throw InvalidInputException("biom_merge: first argument must be VARCHAR or VARCHAR[]");
+	}
+	for (const auto &path : data->biom_paths) {
+		if (!fs.FileExists(path)) {
+			throw IOException("File not found: " + path);
+		}
+		std::lock_guard<std::recursive_mutex> hdf5_guard(miint::hdf5_lock());
+		if (!miint::BIOMReader::IsBIOM(path)) {
+			throw IOException("File is not a BIOM file: " + path);
+		}
+	}
+
+	if (input.inputs[1].IsNull()) {
+		throw BinderException("biom_merge: output must not be NULL");
+	}
+	data->output_path = input.inputs[1].ToString();
+	// Fail before any work, like COPY FORMAT BIOM
+	if (fs.FileExists(data->output_path)) {
+		throw IOException("biom_merge: Cannot overwrite existing file '%s'. Delete it first or choose a different "
+		                  "path.",
+		                  data->output_path);
+	}
+
+	auto id = input.named_parameters.find("id");
+	if (id != input.named_parameters.end() && !id->second.IsNull()) {
+		data->options.id = id->second.ToString();
+	}
+	auto generated_by = input.named_parameters.find("generated_by");
+	if (generated_by != input.named_parameters.end() && !generated_by->second.IsNull()) {
+		data->options.generated_by = generated_by->second.ToString();
+	}
+	auto compression = input.named_parameters.find("compression");
+	if (compression != input.named_parameters.end() && !compression->second.IsNull()) {
+		string comp_str = StringUtil::Lower(compression->second.ToString());
+		if (comp_str == "gzip" || comp_str == "gz") {
+			data->options.use_compression = true;
+		} else if (comp_str == "none") {
+			data->options.use_compression = false;
+		} else {
+			throw InvalidInputException("biom_merge: compression must be 'gzip', 'gz', or 'none'");
+		}
+	}
+
+	for (const auto &name : data->names) {
+		names.emplace_back(name);
+	}
+	for (const auto &type : data->types) {
+		return_types.emplace_back(type);
+	}
+	return std::move(data);
+}
+
+unique_ptr<GlobalTableFunctionState> BiomMergeTableFunction::InitGlobal(ClientContext &context,
+                                                                        TableFunctionInitInput &input) {
+	auto &data = input.bind_data->Cast<Data>();
+	auto gstate = make_uniq<GlobalState>();
+
+	try {
+		gstate->summary = miint::biom_merge(data.biom_paths, data.output_path, data.options);
+	} catch (const std::exception &e) {
+		throw IOException("biom_merge: failed to merge into '%s': %s", data.output_path, e.what());
+	}
+
+	return std::move(gstate);
+}
+
+void BiomMergeTableFunction::Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &bind_data = data_p.bind_data->Cast<Data>();
+	auto &global_state = data_p.global_state->Cast<GlobalState>();
+
+	if (global_state.done) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	const auto &summary = global_state.summary;
+	output.data[0].SetValue(0, Value(bind_data.output_path));
+	output.data[1].SetValue(0, Value::BIGINT(static_cast<int64_t>(bind_data.biom_paths.size())));
+	output.data[2].SetValue(0, Value::BIGINT(static_cast<int64_t>(summary.n_samples)));
+	output.data[3].SetValue(0, Value::BIGINT(static_cast<int64_t>(summary.n_features)));
+	output.data[4].SetValue(0, Value::BIGINT(static_cast<int64_t>(summary.nnz)));
+
+	output.SetCardinality(1);
+	global_state.done = true;
+}
+
+TableFunction BiomMergeTableFunction::GetFunction() {
+	TableFunction tf("biom_merge", {LogicalType::ANY, LogicalType::VARCHAR}, Execute, Bind, InitGlobal);
+
+	tf.named_parameters["id"] = LogicalType::VARCHAR;
+	tf.named_parameters["generated_by"] = LogicalType::VARCHAR;
+	tf.named_parameters["compression"] = LogicalType::VARCHAR;
+
+	return tf;
+}
+
+void BiomMergeTableFunction::Register(ExtensionLoader &loader) {
+	loader.RegisterFunction(GetFunction());
+}
+
+} // namespace duckdb
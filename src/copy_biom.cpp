@@ -1,14 +1,19 @@
 #include "copy_biom.hpp"
 #include "BIOMTable.hpp"
+#include "HDF5Chunks.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/file_system.hpp"
+#include "duckdb/common/string_map_set.hpp"
+#include "duckdb/common/types/string_heap.hpp"
 #include "duckdb/common/vector_operations/generic_executor.hpp"
 #include "duckdb/function/copy_function.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
 #include "H5Cpp.h"
 #include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <limits>
+#include <zlib.h>
 
 namespace duckdb {
 
@@ -123,20 +128,49 @@ static unique_ptr<FunctionData> BiomCopyBind(ClientContext &context, CopyFunctio
 	return result;
 }
 
+//===--------------------------------------------------------------------===//
+// Partial Table
+//===--------------------------------------------------------------------===//
+// The rows one thread has seen, with IDs replaced by indices into thread-local dictionaries. Sink
+// only touches its own partial; the dictionaries are merged once in Finalize.
+struct BiomCopyPartial {
+	explicit BiomCopyPartial(Allocator &allocator) : heap(allocator) {
+	}
+
+	StringHeap heap; // Owns the dictionary strings
+	string_map_t<uint32_t> feature_map;
+	string_map_t<uint32_t> sample_map;
+	vector<string_t> feature_ids;
+	vector<string_t> sample_ids;
+	vector<uint32_t> feature_indices;
+	vector<uint32_t> sample_indices;
+	vector<double> values;
+};
+
+// Index of id in a thread-local dictionary, adding it (copied into the partial's heap) when new
+static uint32_t LookupOrInsertId(BiomCopyPartial &partial, string_map_t<uint32_t> &map, vector<string_t> &ids,
+                                 const string_t &id, const char *kind) {
+	auto entry = map.find(id);
+	if (entry != map.end()) {
+		return entry->second;
+	}
+	if (ids.size() >= static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+		throw InvalidInputException("COPY FORMAT BIOM: Too many %s (>2.1B), exceeds int32_t limit", kind);
+	}
+	auto owned = partial.heap.AddString(id);
+	auto index = static_cast<uint32_t>(ids.size());
+	ids.push_back(owned);
+	map.emplace(owned, index);
+	return index;
+}
+
 //===--------------------------------------------------------------------===//
 // Global State
 //===--------------------------------------------------------------------===//
 struct BiomCopyGlobalState : public GlobalFunctionData {
 	mutex lock;
-	// Incremental dictionary building for optimal performance
-	unordered_map<string, int32_t> feature_map;
-	unordered_map<string, int32_t> sample_map;
-	vector<string> feature_ids_ordered;
-	vector<string> sample_ids_ordered;
-	// Store integer indices instead of strings
-	vector<size_t> feature_indices;
-	vector<size_t> sample_indices;
-	vector<double> values;
+	// One partial per thread, in the order the threads finished
+	vector<unique_ptr<BiomCopyPartial>> partials;
 };
 
 static unique_ptr<GlobalFunctionData> BiomCopyInitializeGlobal(ClientContext &context, FunctionData &bind_data,
@@ -149,14 +183,12 @@ static unique_ptr<GlobalFunctionData> BiomCopyInitializeGlobal(ClientContext &co
 // Local State
 //===--------------------------------------------------------------------===//
 struct BiomCopyLocalState : public LocalFunctionData {
-	// Store strings locally - dictionary building happens in Combine
-	vector<string> local_feature_ids;
-	vector<string> local_sample_ids;
-	vector<double> local_values;
+	unique_ptr<BiomCopyPartial> partial;
 };
 
 static unique_ptr<LocalFunctionData> BiomCopyInitializeLocal(ExecutionContext &context, FunctionData &bind_data) {
 	auto lstate = make_uniq<BiomCopyLocalState>();
+	lstate->partial = make_uniq<BiomCopyPartial>(Allocator::Get(context.client));
 	return lstate;
 }
 
@@ -166,8 +198,8 @@ static unique_ptr<LocalFunctionData> BiomCopyInitializeLocal(ExecutionContext &c
 static void BiomCopySink(ExecutionContext &context, FunctionData &bind_data, GlobalFunctionData &gstate_p,
                          LocalFunctionData &lstate_p, DataChunk &input) {
 	auto &fdata = bind_data.Cast<BiomCopyBindData>();
-	auto &gstate = gstate_p.Cast<BiomCopyGlobalState>();
 	auto &lstate = lstate_p.Cast<BiomCopyLocalState>();
+	auto &partial = *lstate.partial;
 
 	// Process each row
 	UnifiedVectorFormat feature_data, sample_data, value_data;
@@ -180,6 +212,10 @@ static void BiomCopySink(ExecutionContext &context, FunctionData &bind_data, Glo
 	auto sample_strings = UnifiedVectorFormat::GetData<string_t>(sample_data);
 	auto value_doubles = UnifiedVectorFormat::GetData<double>(value_data);
 
+	partial.feature_indices.reserve(partial.feature_indices.size() + input.size());
+	partial.sample_indices.reserve(partial.sample_indices.size() + input.size());
+	partial.values.reserve(partial.values.size() + input.size());
+
 	for (idx_t row = 0; row < input.size(); row++) {
 		auto feature_idx = feature_data.sel->get_index(row);
 		auto sample_idx = sample_data.sel->get_index(row);
@@ -196,23 +232,23 @@ static void BiomCopySink(ExecutionContext &context, FunctionData &bind_data, Glo
 			throw InvalidInputException("COPY FORMAT BIOM: NULL values not allowed in value column");
 		}
 
-		// Get values
-		string feature_id = feature_strings[feature_idx].GetString();
-		string sample_id = sample_strings[sample_idx].GetString();
-		double value = value_doubles[value_idx];
+		const auto &feature_id = feature_strings[feature_idx];
+		const auto &sample_id = sample_strings[sample_idx];
 
 		// Validate feature_id and sample_id are not empty
-		if (feature_id.empty()) {
+		if (feature_id.GetSize() == 0) {
 			throw InvalidInputException("COPY FORMAT BIOM: empty feature_id not allowed");
 		}
-		if (sample_id.empty()) {
+		if (sample_id.GetSize() == 0) {
 			throw InvalidInputException("COPY FORMAT BIOM: empty sample_id not allowed");
 		}
 
-		// Store in local state (no locking needed - each thread has its own local state)
-		lstate.local_feature_ids.push_back(std::move(feature_id));
-		lstate.local_sample_ids.push_back(std::move(sample_id));
-		lstate.local_values.push_back(value);
+		// Thread-local dictionaries: no locking, and each distinct ID is copied once per thread
+		partial.feature_indices.push_back(
+		    LookupOrInsertId(partial, partial.feature_map, partial.feature_ids, feature_id, "features"));
+		partial.sample_indices.push_back(
+		    LookupOrInsertId(partial, partial.sample_map, partial.sample_ids, sample_id, "samples"));
+		partial.values.push_back(value_doubles[value_idx]);
 	}
 }
 
@@ -224,51 +260,29 @@ static void BiomCopyCombine(ExecutionContext &context, FunctionData &bind_data,
 	auto &gstate = gstate_p.Cast<BiomCopyGlobalState>();
 	auto &lstate = lstate_p.Cast<BiomCopyLocalState>();
 
-	// Convert local strings to indices using global dictionaries
-	// Lock only during dictionary updates and global state append
-	lock_guard<mutex> glock(gstate.lock);
+	if (!lstate.partial || lstate.partial->values.empty()) {
+		return;
+	}
 
-	idx_t n = lstate.local_feature_ids.size();
-	vector<size_t> local_feature_indices;
-	vector<size_t> local_sample_indices;
-	local_feature_indices.reserve(n);
-	local_sample_indices.reserve(n);
-
-	for (idx_t i = 0; i < n; i++) {
-		const auto &feature_id = lstate.local_feature_ids[i];
-		const auto &sample_id = lstate.local_sample_ids[i];
-
-		// Look up or insert feature_id
-		auto feature_it = gstate.feature_map.find(feature_id);
-		int32_t feature_index;
-		if (feature_it == gstate.feature_map.end()) {
-			feature_index = static_cast<int32_t>(gstate.feature_ids_ordered.size());
-			gstate.feature_map[feature_id] = feature_index;
-			gstate.feature_ids_ordered.push_back(feature_id);
-		} else {
-			feature_index = feature_it->second;
-		}
+	// Hand the partial over as a whole; the lock only covers the pointer move
+	lock_guard<mutex> glock(gstate.lock);
+	gstate.partials.push_back(std::move(lstate.partial));
+}
 
-		// Look up or insert sample_id
-		auto sample_it = gstate.sample_map.find(sample_id);
-		int32_t sample_index;
-		if (sample_it == gstate.sample_map.end()) {
-			sample_index = static_cast<int32_t>(gstate.sample_ids_ordered.size());
-			gstate.sample_map[sample_id] = sample_index;
-			gstate.sample_ids_ordered.push_back(sample_id);
+// Add the IDs of one thread-local dictionary to the global one, recording the global index of each
+static void MergeDictionary(const vector<string_t> &local_ids, string_map_t<size_t> &global_map,
+                            vector<string> &global_ids, vector<size_t> &remap) {
+	remap.resize(local_ids.size());
+	for (idx_t i = 0; i < local_ids.size(); i++) {
+		auto entry = global_map.find(local_ids[i]);
+		if (entry == global_map.end()) {
+			remap[i] = global_ids.size();
+			global_map.emplace(local_ids[i], remap[i]);
+			global_ids.push_back(local_ids[i].GetString());
 		} else {
-			sample_index = sample_it->second;
+			remap[i] = entry->second;
 		}
-
-		local_feature_indices.push_back(static_cast<size_t>(feature_index));
-		local_sample_indices.push_back(static_cast<size_t>(sample_index));
 	}
-
-	// Append local indices to global
-	gstate.feature_indices.insert(gstate.feature_indices.end(), local_feature_indices.begin(),
-	                              local_feature_indices.end());
-	gstate.sample_indices.insert(gstate.sample_indices.end(), local_sample_indices.begin(), local_sample_indices.end());
-	gstate.values.insert(gstate.values.end(), lstate.local_values.begin(), lstate.local_values.end());
 }
 
 //===--------------------------------------------------------------------===//
@@ -337,6 +351,11 @@ static void WriteRootAttributes(H5::H5File &file, size_t nnz, size_t n_features,
 	attr_type.write(type_type, type_str);
 }
 
+// Elements per HDF5 chunk, which is also the unit of parallel compression
+static constexpr hsize_t BIOM_CHUNK_SIZE = 65536;
+// gzip compression level 4 (h5py/BIOM default)
+static constexpr int BIOM_DEFLATE_LEVEL = 4;
+
 static void WriteStringDataset(H5::Group &group, const string &name, const std::vector<std::string> &data,
                                bool use_compression) {
 	if (data.empty()) {
@@ -358,9 +377,9 @@ static void WriteStringDataset(H5::Group &group, const string &name, const std::
 	// Create dataset with optional compression
 	H5::DSetCreatPropList plist;
 	if (use_compression && data.size() > 0) {
-		hsize_t chunk_dims[1] = {std::min(data.size(), size_t(65536))};
+		hsize_t chunk_dims[1] = {std::min<hsize_t>(data.size(), BIOM_CHUNK_SIZE)};
 		plist.setChunk(1, chunk_dims);
-		plist.setDeflate(4); // gzip compression level 4 (h5py/BIOM default)
+		plist.setDeflate(BIOM_DEFLATE_LEVEL);
 	}
 
 	H5::DataSet dataset = group.createDataSet(name, datatype, dataspace, plist);
@@ -374,9 +393,54 @@ static void WriteStringDataset(H5::Group &group, const string &name, const std::
 	dataset.write(c_strs.data(), datatype);
 }
 
+// The deflated chunks of a 1-D dataset, in order, as H5Dwrite_chunk stores them
+struct DeflatedChunks {
+	hsize_t chunk_size = 0;
+	vector<vector<Bytef>> chunks;
+};
+
+// Deflate the chunks of a 1-D dataset on n_threads threads. This runs before the HDF5 lock is taken, which
+// is then only held while the finished chunks are stored.
+template <typename T>
+static DeflatedChunks DeflateChunks(const std::vector<T> &data, idx_t n_threads) {
+	DeflatedChunks result;
+	if (data.empty()) {
+		return result;
+	}
+	auto chunk_size = std::min<hsize_t>(data.size(), BIOM_CHUNK_SIZE);
+	result.chunk_size = chunk_size;
+	result.chunks.resize((data.size() + chunk_size - 1) / chunk_size);
+	miint::run_parallel(result.chunks.size(), n_threads, [&](size_t chunk) {
+		idx_t begin = chunk * chunk_size;
+		idx_t count = MinValue<idx_t>(chunk_size, data.size() - begin);
+		const T *source = data.data() + begin;
+		// Edge chunks are stored at full size, padded with zeros
+		vector<T> padded;
+		if (count < chunk_size) {
+			padded.assign(chunk_size, T());
+			std::copy(source, source + count, padded.begin());
+			source = padded.data();
+		}
+
+		uLong source_bytes = chunk_size * sizeof(T);
+		uLongf compressed_bytes = compressBound(source_bytes);
+		auto &buffer = result.chunks[chunk];
+		buffer.resize(compressed_bytes);
+		if (compress2(buffer.data(), &compressed_bytes, reinterpret_cast<const Bytef *>(source), source_bytes,
+		              BIOM_DEFLATE_LEVEL) != Z_OK) {
+			throw IOException("COPY FORMAT BIOM: Failed to compress dataset chunk");
+		}
+		buffer.resize(compressed_bytes);
+	});
+	return result;
+}
+
+// Write a 1-D numeric dataset. With compression its chunks come already deflated by DeflateChunks and are
+// stored with H5Dwrite_chunk; the dataset carries the deflate filter, so readers see exactly what HDF5 would
+// have written itself.
 template <typename T>
 static void WriteNumericDataset(H5::Group &group, const string &name, const std::vector<T> &data,
-                                const H5::DataType &dtype, bool use_compression) {
+                                const H5::DataType &dtype, bool use_compression, const DeflatedChunks &deflated) {
 	if (data.empty()) {
 		// Write empty dataset
 		hsize_t dims[1] = {0};
@@ -388,16 +452,25 @@ static void WriteNumericDataset(H5::Group &group, const string &name, const std:
 	hsize_t dims[1] = {data.size()};
 	H5::DataSpace dataspace(1, dims);
 
-	// Create dataset with optional compression
-	H5::DSetCreatPropList plist;
-	if (use_compression && data.size() > 0) {
-		hsize_t chunk_dims[1] = {std::min(data.size(), size_t(65536))};
-		plist.setChunk(1, chunk_dims);
-		plist.setDeflate(4); // gzip compression level 4 (h5py/BIOM default)
+	if (!use_compression) {
+		H5::DataSet dataset = group.createDataSet(name, dtype, dataspace);
+		dataset.write(data.data(), dtype);
+		return;
 	}
 
+	hsize_t chunk_dims[1] = {deflated.chunk_size};
+	H5::DSetCreatPropList plist;
+	plist.setChunk(1, chunk_dims);
+	plist.setDeflate(BIOM_DEFLATE_LEVEL);
+
 	H5::DataSet dataset = group.createDataSet(name, dtype, dataspace, plist);
-	dataset.write(data.data(), dtype);
+	for (idx_t chunk = 0; chunk < deflated.chunks.size(); chunk++) {
+		auto &buffer = deflated.chunks[chunk];
+		hsize_t offset[1] = {chunk * deflated.chunk_size};
+		if (H5Dwrite_chunk(dataset.getId(), H5P_DEFAULT, 0, offset, buffer.size(), buffer.data()) < 0) {
+			throw IOException("COPY FORMAT BIOM: Failed to write dataset chunk");
+		}
+	}
 }
 
 //===--------------------------------------------------------------------===//
@@ -406,29 +479,80 @@ static void WriteNumericDataset(H5::Group &group, const string &name, const std:
 static void BiomCopyFinalize(ClientContext &context, FunctionData &bind_data, GlobalFunctionData &gstate_p) {
 	auto &fdata = bind_data.Cast<BiomCopyBindData>();
 	auto &gstate = gstate_p.Cast<BiomCopyGlobalState>();
+	auto &partials = gstate.partials;
+	auto n_threads = static_cast<idx_t>(MaxValue<int32_t>(TaskScheduler::GetScheduler(context).NumberOfThreads(), 1));
+
+	vector<string> feature_ids_ordered;
+	vector<string> sample_ids_ordered;
+	// 32-bit indices, as BIOM stores them, halve the memory of the triplets while they are sorted
+	vector<uint32_t> feature_indices;
+	vector<uint32_t> sample_indices;
+	vector<double> values;
+	{
+		// Merge the thread-local dictionaries once, in Combine order, so IDs keep the order in which
+		// they first appeared. The map keys point into the partials' heaps.
+		string_map_t<size_t> feature_map;
+		string_map_t<size_t> sample_map;
+		vector<vector<size_t>> feature_remap(partials.size());
+		vector<vector<size_t>> sample_remap(partials.size());
+		vector<idx_t> row_offsets(partials.size() + 1, 0);
+		for (idx_t p = 0; p < partials.size(); p++) {
+			MergeDictionary(partials[p]->feature_ids, feature_map, feature_ids_ordered, feature_remap[p]);
+			MergeDictionary(partials[p]->sample_ids, sample_map, sample_ids_ordered, sample_remap[p]);
+			row_offsets[p + 1] = row_offsets[p] + partials[p]->values.size();
+		}
+
+		// Validate int32 range
+		if (feature_ids_ordered.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+			throw InvalidInputException("COPY FORMAT BIOM: Too many features (>2.1B), exceeds int32_t limit");
+		}
+		if (sample_ids_ordered.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+			throw InvalidInputException("COPY FORMAT BIOM: Too many samples (>2.1B), exceeds int32_t limit");
+		}
+
+		// Rewrite each partial's local indices to global ones, one partial per task
+		feature_indices.resize(row_offsets.back());
+		sample_indices.resize(row_offsets.back());
+		values.resize(row_offsets.back());
+		miint::run_parallel(partials.size(), n_threads, [&](size_t p) {
+			auto &partial = *partials[p];
+			auto offset = row_offsets[p];
+			for (idx_t i = 0; i < partial.values.size(); i++) {
+				feature_indices[offset + i] = static_cast<uint32_t>(feature_remap[p][partial.feature_indices[i]]);
+				sample_indices[offset + i] = static_cast<uint32_t>(sample_remap[p][partial.sample_indices[i]]);
+				values[offset + i] = partial.values[i];
+			}
+		});
+	}
+	// Release the per-thread strings and triplets before sorting
+	partials.clear();
 
 	// Create BIOMTable using pre-computed integer indices and dictionaries
 	// This skips the expensive string hashing that the old constructor did
-	miint::BIOMTable table(gstate.feature_indices, gstate.sample_indices, gstate.values,
-	                       std::move(gstate.feature_ids_ordered), std::move(gstate.sample_ids_ordered));
+	miint::BIOMTable table(std::move(feature_indices), std::move(sample_indices), std::move(values),
+	                       std::move(feature_ids_ordered), std::move(sample_ids_ordered), n_threads);
 
 	auto n_features = table.NumFeatures();
 	auto n_samples = table.NumSamples();
 	auto nnz = table.nnz();
 
-	// Validate int32 range
-	if (n_features > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
-		throw InvalidInputException("COPY FORMAT BIOM: Too many features (>2.1B), exceeds int32_t limit");
-	}
-	if (n_samples > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
-		throw InvalidInputException("COPY FORMAT BIOM: Too many samples (>2.1B), exceeds int32_t limit");
+	// The table is held as CSC; only the CSR is built
+	auto csr = table.ToCSR(n_threads); // observation/matrix
+	const auto &csc = table.CSC();     // sample/matrix
+
+	// Deflate every matrix dataset up front, so the HDF5 lock is only held to store the chunks
+	DeflatedChunks obs_data, obs_indices, obs_indptr, samp_data, samp_indices, samp_indptr;
+	if (fdata.use_compression) {
+		obs_data = DeflateChunks(csr.data, n_threads);
+		obs_indices = DeflateChunks(csr.indices, n_threads);
+		obs_indptr = DeflateChunks(csr.indptr, n_threads);
+		samp_data = DeflateChunks(csc.data, n_threads);
+		samp_indices = DeflateChunks(csc.indices, n_threads);
+		samp_indptr = DeflateChunks(csc.indptr, n_threads);
 	}
 
-	// Convert to CSR and CSC
-	auto csr = table.ToCSR(); // observation/matrix
-	auto csc = table.ToCSC(); // sample/matrix
-
-	// Create HDF5 file
+	// Create HDF5 file. The HDF5 objects below are all released before the lock
+	lock_guard<std::recursive_mutex> hdf5_guard(miint::hdf5_lock());
 	H5::H5File file(fdata.file_path, H5F_ACC_TRUNC);
 
 	// Write root attributes
@@ -449,17 +573,23 @@ static void BiomCopyFinalize(ClientContext &context, FunctionData &bind_data, Gl
 	WriteStringDataset(obs_group, "ids", table.FeatureIDs(), fdata.use_compression);
 
 	// Write observation/matrix (CSR)
-	WriteNumericDataset(obs_matrix_group, "data", csr.data, H5::PredType::NATIVE_DOUBLE, fdata.use_compression);
-	WriteNumericDataset(obs_matrix_group, "indices", csr.indices, H5::PredType::NATIVE_INT32, fdata.use_compression);
-	WriteNumericDataset(obs_matrix_group, "indptr", csr.indptr, H5::PredType::NATIVE_INT32, fdata.use_compression);
+	WriteNumericDataset(obs_matrix_group, "data", csr.data, H5::PredType::NATIVE_DOUBLE, fdata.use_compression,
+	                    obs_data);
+	WriteNumericDataset(obs_matrix_group, "indices", csr.indices, H5::PredType::NATIVE_INT32, fdata.use_compression,
+	                    obs_indices);
+	WriteNumericDataset(obs_matrix_group, "indptr", csr.indptr, H5::PredType::NATIVE_INT32, fdata.use_compression,
+	                    obs_indptr);
 
 	// Write sample IDs
 	WriteStringDataset(samp_group, "ids", table.SampleIDs(), fdata.use_compression);
 
 	// Write sample/matrix (CSC)
-	WriteNumericDataset(samp_matrix_group, "data", csc.data, H5::PredType::NATIVE_DOUBLE, fdata.use_compression);
-	WriteNumericDataset(samp_matrix_group, "indices", csc.indices, H5::PredType::NATIVE_INT32, fdata.use_compression);
-	WriteNumericDataset(samp_matrix_group, "indptr", csc.indptr, H5::PredType::NATIVE_INT32, fdata.use_compression);
+	WriteNumericDataset(samp_matrix_group, "data", csc.data, H5::PredType::NATIVE_DOUBLE, fdata.use_compression,
+	                    samp_data);
+	WriteNumericDataset(samp_matrix_group, "indices", csc.indices, H5::PredType::NATIVE_INT32, fdata.use_compression,
+	                    samp_indices);
+	WriteNumericDataset(samp_matrix_group, "indptr", csc.indptr, H5::PredType::NATIVE_INT32, fdata.use_compression,
+	                    samp_indptr);
 
 	// Close file
 	file.close();
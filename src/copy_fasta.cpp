@@ -4,7 +4,6 @@
 #include "duckdb/common/file_system.hpp"
 #include "duckdb/common/vector_operations/generic_executor.hpp"
 #include "duckdb/function/copy_function.hpp"
-#include <sstream>
 
 namespace duckdb {
 
@@ -22,6 +21,8 @@ struct FastaCopyBindData : public SequenceCopyBindData {
 		result->include_comment = include_comment;
 		result->compression = compression;
 		result->flush_size = flush_size;
+		result->write_index = write_index;
+		result->index_interval = index_interval;
 		result->file_path = file_path;
 		result->is_paired = is_paired;
 		result->names = names;
@@ -35,7 +36,7 @@ struct FastaCopyBindData : public SequenceCopyBindData {
 		return interleave == other.interleave && id_as_sequence_index == other.id_as_sequence_index &&
 		       include_comment == other.include_comment && compression == other.compression &&
 		       file_path == other.file_path && is_paired == other.is_paired && flush_size == other.flush_size &&
-		       names == other.names;
+		       write_index == other.write_index && index_interval == other.index_interval && names == other.names;
 	}
 };
 
@@ -70,11 +71,14 @@ static unique_ptr<FunctionData> FastaCopyBind(ClientContext &context, CopyFuncti
 			has_interleave_param = true;
 		} else if (!StringUtil::CIEquals(option.first, "id_as_sequence_index") &&
 		           !StringUtil::CIEquals(option.first, "include_comment") &&
-		           !StringUtil::CIEquals(option.first, "compression")) {
+		           !StringUtil::CIEquals(option.first, "compression") &&
+		           !StringUtil::CIEquals(option.first, "index") &&
+		           !StringUtil::CIEquals(option.first, "index_interval")) {
 			throw BinderException("Unknown option for COPY FORMAT FASTA: %s", option.first);
 		}
 	}
 
+	common_params.streaming = IsStreamingCopyTarget(FileSystem::GetFileSystem(context), result->file_path);
 	common_params.ParseFromOptions(input.info.options, result->file_path);
 
 	result->interleave = common_params.interleave;
@@ -82,6 +86,8 @@ static unique_ptr<FunctionData> FastaCopyBind(ClientContext &context, CopyFuncti
 	result->include_comment = common_params.include_comment;
 	result->compression = common_params.compression;
 	result->flush_size = common_params.flush_size;
+	result->write_index = common_params.write_index;
+	result->index_interval = common_params.index_interval;
 
 	// Validate paired-end parameters
 	ValidatePairedEndParameters(result->is_paired, has_interleave_param, result->interleave, result->file_path);
@@ -116,28 +122,30 @@ static unique_ptr<LocalFunctionData> FastaCopyInitializeLocal(ExecutionContext &
 //===--------------------------------------------------------------------===//
 // Sink
 //===--------------------------------------------------------------------===//
-static void WriteFastaRecordToBuffer(MemoryStream &stream, const string &id, const string &seq, const string &comment) {
-	// Pre-calculate total size to avoid reallocations
-	idx_t size = 1 + id.size() + 1 + seq.size() + 1; // > + id + \n + seq + \n
-	if (!comment.empty()) {
-		size += 1 + comment.size(); // space + comment
+static void WriteFastaRecordToBuffer(MemoryStream &stream, const string_t &id, const string_t &seq,
+                                     const string_t &comment) {
+	// Size is known up front, so the record is written in place
+	idx_t id_size = id.GetSize();
+	idx_t seq_size = seq.GetSize();
+	idx_t comment_size = comment.GetSize();
+	idx_t size = 1 + id_size + 1 + seq_size + 1; // > + id + \n + seq + \n
+	if (comment_size > 0) {
+		size += 1 + comment_size; // space + comment
 	}
 
-	// Build record string with pre-reserved capacity
-	string record;
-	record.reserve(size);
-	record += '>';
-	record += id;
-	if (!comment.empty()) {
-		record += ' ';
-		record += comment;
+	auto out = ReserveStreamSpace(stream, size);
+	*out++ = '>';
+	memcpy(out, id.GetData(), id_size);
+	out += id_size;
+	if (comment_size > 0) {
+		*out++ = ' ';
+		memcpy(out, comment.GetData(), comment_size);
+		out += comment_size;
 	}
-	record += '\n';
-	record += seq;
-	record += '\n';
-
-	// Write to stream
-	stream.WriteData(const_data_ptr_cast(record.c_str()), record.size());
+	*out++ = '\n';
+	memcpy(out, seq.GetData(), seq_size);
+	out += seq_size;
+	*out = '\n';
 }
 
 static void FastaCopySink(ExecutionContext &context, FunctionData &bind_data, GlobalFunctionData &gstate_p,
@@ -168,8 +176,10 @@ static void FastaCopySink(ExecutionContext &context, FunctionData &bind_data, Gl
 	auto seq1_strings = UnifiedVectorFormat::GetData<string_t>(seq1_data);
 
 	bool is_paired = fdata.is_paired;
+	const string_t *seq2_strings = nullptr;
 	if (is_paired) {
 		input.data[indices.sequence2_idx].ToUnifiedFormat(input.size(), seq2_data);
+		seq2_strings = UnifiedVectorFormat::GetData<string_t>(seq2_data);
 	}
 
 	// Get references to local buffers
@@ -180,6 +190,7 @@ static void FastaCopySink(ExecutionContext &context, FunctionData &bind_data, Gl
 	}
 
 	// Build all records into local buffer(s) - NO LOCK
+	char id_buffer[SEQUENCE_INDEX_ID_BUFFER_SIZE];
 	for (idx_t row = 0; row < input.size(); row++) {
 		auto row_idx = read_id_data.sel->get_index(row);
 
@@ -188,23 +199,23 @@ static void FastaCopySink(ExecutionContext &context, FunctionData &bind_data, Gl
 			throw InvalidInputException("NULL value in read_id column (row %llu)", row);
 		}
 
-		// Get ID
-		string id;
+		// Get ID (sequence_index is formatted into a stack buffer)
+		string_t id;
 		if (fdata.id_as_sequence_index) {
 			auto seq_idx_data = UnifiedVectorFormat::GetData<int64_t>(sequence_index_data);
 			auto seq_idx_row = sequence_index_data.sel->get_index(row);
-			id = to_string(seq_idx_data[seq_idx_row]);
+			id = FormatSequenceIndexId(seq_idx_data[seq_idx_row], id_buffer);
 		} else {
-			id = read_ids[row_idx].GetString();
+			id = read_ids[row_idx];
 		}
 
 		// Get comment
-		string comment;
+		string_t comment("", 0);
 		if (fdata.include_comment && indices.comment_idx != DConstants::INVALID_INDEX) {
 			auto comment_strings = UnifiedVectorFormat::GetData<string_t>(comment_data);
 			auto comment_row = comment_data.sel->get_index(row);
 			if (comment_data.validity.RowIsValid(comment_row)) {
-				comment = comment_strings[comment_row].GetString();
+				comment = comment_strings[comment_row];
 			}
 		}
 
@@ -213,26 +224,28 @@ static void FastaCopySink(ExecutionContext &context, FunctionData &bind_data, Gl
 		if (!seq1_data.validity.RowIsValid(seq1_row)) {
 			throw InvalidInputException("NULL value in sequence1 column (row %llu)", row);
 		}
-		string seq1 = seq1_strings[seq1_row].GetString();
+		auto &seq1 = seq1_strings[seq1_row];
 
 		// Write R1 record to local buffer
+		lstate.writer_state_r1->MarkRecord();
 		WriteFastaRecordToBuffer(stream_r1, id, seq1, comment);
 		lstate.writer_state_r1->written_anything = true;
 
 		// Handle R2 for paired-end
 		if (is_paired) {
-			auto seq2_strings = UnifiedVectorFormat::GetData<string_t>(seq2_data);
 			auto seq2_row = seq2_data.sel->get_index(row);
 			if (!seq2_data.validity.RowIsValid(seq2_row)) {
 				throw InvalidInputException("NULL value in sequence2 column (row %llu)", row);
 			}
-			string seq2 = seq2_strings[seq2_row].GetString();
+			auto &seq2 = seq2_strings[seq2_row];
 
 			if (fdata.interleave) {
 				// Write R2 to same buffer
+				lstate.writer_state_r1->MarkRecord();
 				WriteFastaRecordToBuffer(stream_r1, id, seq2, comment);
 			} else {
 				// Write R2 to separate buffer
+				lstate.writer_state_r2->MarkRecord();
 				WriteFastaRecordToBuffer(*stream_r2, id, seq2, comment);
 				lstate.writer_state_r2->written_anything = true;
 			}
@@ -240,13 +253,7 @@ static void FastaCopySink(ExecutionContext &context, FunctionData &bind_data, Gl
 	}
 
 	// Check if we need to flush (buffer exceeded threshold)
-	if (lstate.writer_state_r1->stream->GetPosition() >= lstate.writer_state_r1->flush_size) {
-		FlushFormatBuffer(*lstate.writer_state_r1, *gstate.file_r1, gstate.lock);
-	}
-
-	if (stream_r2 && lstate.writer_state_r2->stream->GetPosition() >= lstate.writer_state_r2->flush_size) {
-		FlushFormatBuffer(*lstate.writer_state_r2, *gstate.file_r2, gstate.lock);
-	}
+	SequenceCopyFlushIfFull(fdata, gstate, lstate);
 }
 
 //===--------------------------------------------------------------------===//
@@ -265,7 +272,7 @@ static void FastaCopyCombine(ExecutionContext &context, FunctionData &bind_data,
 //===--------------------------------------------------------------------===//
 static void FastaCopyFinalize(ClientContext &context, FunctionData &bind_data, GlobalFunctionData &gstate_p) {
 	auto &gstate = gstate_p.Cast<FastaCopyGlobalState>();
-	SequenceCopyFinalize(gstate);
+	SequenceCopyFinalize(context, gstate);
 }
 
 //===--------------------------------------------------------------------===//
@@ -279,6 +286,9 @@ CopyFunction CopyFastaFunction::GetFunction() {
 	func.copy_to_sink = FastaCopySink;
 	func.copy_to_combine = FastaCopyCombine;
 	func.copy_to_finalize = FastaCopyFinalize;
+	func.execution_mode = SequenceCopyExecutionMode;
+	// Used to name the files DuckDB generates for PARTITION_BY / PER_THREAD_OUTPUT
+	func.extension = "fasta";
 	return func;
 }
 
@@ -5,7 +5,6 @@
 #include "duckdb/common/file_system.hpp"
 #include "duckdb/common/vector_operations/generic_executor.hpp"
 #include "duckdb/function/copy_function.hpp"
-#include <sstream>
 
 namespace duckdb {
 
@@ -23,6 +22,8 @@ struct FastqCopyBindData : public SequenceCopyBindData {
 		result->include_comment = include_comment;
 		result->compression = compression;
 		result->flush_size = flush_size;
+		result->write_index = write_index;
+		result->index_interval = index_interval;
 		result->file_path = file_path;
 		result->is_paired = is_paired;
 		result->names = names;
@@ -37,16 +38,26 @@ struct FastqCopyBindData : public SequenceCopyBindData {
 		return interleave == other.interleave && id_as_sequence_index == other.id_as_sequence_index &&
 		       include_comment == other.include_comment && qual_offset == other.qual_offset &&
 		       compression == other.compression && file_path == other.file_path && is_paired == other.is_paired &&
-		       flush_size == other.flush_size && names == other.names;
+		       flush_size == other.flush_size && write_index == other.write_index &&
+		       index_interval == other.index_interval && names == other.names;
 	}
 };
 
 //===--------------------------------------------------------------------===//
 // Helper Functions
 //===--------------------------------------------------------------------===//
-static string EncodeQuality(const uint8_t *qual_data, idx_t length, uint8_t offset) {
-	string result;
-	result.reserve(length);
+// Add the offset to a whole quality slice of the LIST(UTINYINT) child vector, writing straight into
+// the output. The loop is branch-free so it vectorizes; overflow is checked once per record.
+static void EncodeQuality(const uint8_t *qual_data, idx_t length, uint8_t offset, data_ptr_t dest) {
+	uint8_t max_q = 0;
+	for (idx_t i = 0; i < length; i++) {
+		uint8_t q = qual_data[i];
+		max_q = q > max_q ? q : max_q;
+		dest[i] = static_cast<uint8_t>(q + offset);
+	}
+	if (static_cast<uint16_t>(max_q) + offset <= 126) {
+		return;
+	}
 	for (idx_t i = 0; i < length; i++) {
 		uint8_t q = qual_data[i];
 		uint16_t encoded = static_cast<uint16_t>(q) + offset;
@@ -54,9 +65,7 @@ static string EncodeQuality(const uint8_t *qual_data, idx_t length, uint8_t offs
 			throw InvalidInputException("Quality score overflow: %d + %d = %d exceeds valid ASCII range (max 126)", q,
 			                            offset, encoded);
 		}
-		result.push_back(static_cast<char>(encoded));
 	}
-	return result;
 }
 
 //===--------------------------------------------------------------------===//
@@ -99,11 +108,14 @@ static unique_ptr<FunctionData> FastqCopyBind(ClientContext &context, CopyFuncti
 			qual_offset_param = option.second[0];
 		} else if (!StringUtil::CIEquals(option.first, "id_as_sequence_index") &&
 		           !StringUtil::CIEquals(option.first, "include_comment") &&
-		           !StringUtil::CIEquals(option.first, "compression")) {
+		           !StringUtil::CIEquals(option.first, "compression") &&
+		           !StringUtil::CIEquals(option.first, "index") &&
+		           !StringUtil::CIEquals(option.first, "index_interval")) {
 			throw BinderException("Unknown option for COPY FORMAT FASTQ: %s", option.first);
 		}
 	}
 
+	common_params.streaming = IsStreamingCopyTarget(FileSystem::GetFileSystem(context), result->file_path);
 	common_params.ParseFromOptions(input.info.options, result->file_path);
 
 	result->interleave = common_params.interleave;
@@ -111,6 +123,8 @@ static unique_ptr<FunctionData> FastqCopyBind(ClientContext &context, CopyFuncti
 	result->include_comment = common_params.include_comment;
 	result->compression = common_params.compression;
 	result->flush_size = common_params.flush_size;
+	result->write_index = common_params.write_index;
+	result->index_interval = common_params.index_interval;
 
 	// Validate paired-end parameters
 	ValidatePairedEndParameters(result->is_paired, has_interleave_param, result->interleave, result->file_path);
@@ -154,32 +168,35 @@ static unique_ptr<LocalFunctionData> FastqCopyInitializeLocal(ExecutionContext &
 //===--------------------------------------------------------------------===//
 // Sink
 //===--------------------------------------------------------------------===//
-static void WriteFastqRecordToBuffer(MemoryStream &stream, const string &id, const string &seq,
+static void WriteFastqRecordToBuffer(MemoryStream &stream, const string_t &id, const string_t &seq,
                                      const uint8_t *qual_data, idx_t qual_length, uint8_t qual_offset,
-                                     const string &comment) {
-	// Pre-calculate total size to avoid reallocations
-	idx_t size = 1 + id.size() + 1 + seq.size() + 3 + qual_length + 1; // @ + id + \n + seq + \n+\n + qual + \n
-	if (!comment.empty()) {
-		size += 1 + comment.size(); // space + comment
+                                     const string_t &comment) {
+	// Size is known up front, so the record is written in place
+	idx_t id_size = id.GetSize();
+	idx_t seq_size = seq.GetSize();
+	idx_t comment_size = comment.GetSize();
+	idx_t size = 1 + id_size + 1 + seq_size + 3 + qual_length + 1; // @ + id + \n + seq + \n+\n + qual + \n
+	if (comment_size > 0) {
+		size += 1 + comment_size; // space + comment
 	}
 
-	// Build record string with pre-reserved capacity
-	string record;
-	record.reserve(size);
-	record += '@';
-	record += id;
-	if (!comment.empty()) {
-		record += ' ';
-		record += comment;
+	auto out = ReserveStreamSpace(stream, size);
+	*out++ = '@';
+	memcpy(out, id.GetData(), id_size);
+	out += id_size;
+	if (comment_size > 0) {
+		*out++ = ' ';
+		memcpy(out, comment.GetData(), comment_size);
+		out += comment_size;
 	}
-	record += '\n';
-	record += seq;
-	record += "\n+\n";
-	record += EncodeQuality(qual_data, qual_length, qual_offset);
-	record += '\n';
-
-	// Write to stream
-	stream.WriteData(const_data_ptr_cast(record.c_str()), record.size());
+	*out++ = '\n';
+	memcpy(out, seq.GetData(), seq_size);
+	out += seq_size;
+	memcpy(out, "\n+\n", 3);
+	out += 3;
+	EncodeQuality(qual_data, qual_length, qual_offset, out);
+	out += qual_length;
+	*out = '\n';
 }
 
 static void FastqCopySink(ExecutionContext &context, FunctionData &bind_data, GlobalFunctionData &gstate_p,
@@ -210,11 +227,19 @@ static void FastqCopySink(ExecutionContext &context, FunctionData &bind_data, Gl
 	auto seq1_strings = UnifiedVectorFormat::GetData<string_t>(seq1_data);
 
 	input.data[indices.qual1_idx].ToUnifiedFormat(input.size(), qual1_data);
+	auto qual1_entries = UnifiedVectorFormat::GetData<list_entry_t>(qual1_data);
+	auto qual1_list_data = FlatVector::GetData<uint8_t>(ListVector::GetEntry(input.data[indices.qual1_idx]));
 
 	bool is_paired = fdata.is_paired;
+	const string_t *seq2_strings = nullptr;
+	const list_entry_t *qual2_entries = nullptr;
+	const uint8_t *qual2_list_data = nullptr;
 	if (is_paired) {
 		input.data[indices.sequence2_idx].ToUnifiedFormat(input.size(), seq2_data);
+		seq2_strings = UnifiedVectorFormat::GetData<string_t>(seq2_data);
 		input.data[indices.qual2_idx].ToUnifiedFormat(input.size(), qual2_data);
+		qual2_entries = UnifiedVectorFormat::GetData<list_entry_t>(qual2_data);
+		qual2_list_data = FlatVector::GetData<uint8_t>(ListVector::GetEntry(input.data[indices.qual2_idx]));
 	}
 
 	// Get references to local buffers
@@ -225,6 +250,7 @@ static void FastqCopySink(ExecutionContext &context, FunctionData &bind_data, Gl
 	}
 
 	// Build all records into local buffer(s) - NO LOCK
+	char id_buffer[SEQUENCE_INDEX_ID_BUFFER_SIZE];
 	for (idx_t row = 0; row < input.size(); row++) {
 		auto row_idx = read_id_data.sel->get_index(row);
 
@@ -233,23 +259,23 @@ static void FastqCopySink(ExecutionContext &context, FunctionData &bind_data, Gl
 			throw InvalidInputException("NULL value in read_id column (row %llu)", row);
 		}
 
-		// Get ID
-		string id;
+		// Get ID (sequence_index is formatted into a stack buffer)
+		string_t id;
 		if (fdata.id_as_sequence_index) {
 			auto seq_idx_data = UnifiedVectorFormat::GetData<int64_t>(sequence_index_data);
 			auto seq_idx_row = sequence_index_data.sel->get_index(row);
-			id = to_string(seq_idx_data[seq_idx_row]);
+			id = FormatSequenceIndexId(seq_idx_data[seq_idx_row], id_buffer);
 		} else {
-			id = read_ids[row_idx].GetString();
+			id = read_ids[row_idx];
 		}
 
 		// Get comment
-		string comment;
+		string_t comment("", 0);
 		if (fdata.include_comment && indices.comment_idx != DConstants::INVALID_INDEX) {
 			auto comment_strings = UnifiedVectorFormat::GetData<string_t>(comment_data);
 			auto comment_row = comment_data.sel->get_index(row);
 			if (comment_data.validity.RowIsValid(comment_row)) {
-				comment = comment_strings[comment_row].GetString();
+				comment = comment_strings[comment_row];
 			}
 		}
 
@@ -258,60 +284,56 @@ static void FastqCopySink(ExecutionContext &context, FunctionData &bind_data, Gl
 		if (!seq1_data.validity.RowIsValid(seq1_row)) {
 			throw InvalidInputException("NULL value in sequence1 column (row %llu)", row);
 		}
-		string seq1 = seq1_strings[seq1_row].GetString();
+		auto &seq1 = seq1_strings[seq1_row];
 
 		auto qual1_row = qual1_data.sel->get_index(row);
 		if (!qual1_data.validity.RowIsValid(qual1_row)) {
 			throw InvalidInputException("NULL value in qual1 column (row %llu)", row);
 		}
-		auto qual1_list = ListVector::GetEntry(input.data[indices.qual1_idx]);
-		auto qual1_list_data = FlatVector::GetData<uint8_t>(qual1_list);
-		auto qual1_entries = UnifiedVectorFormat::GetData<list_entry_t>(qual1_data);
 		idx_t qual1_length = qual1_entries[qual1_row].length;
 		const uint8_t *qual1_ptr = qual1_list_data + qual1_entries[qual1_row].offset;
 
 		// Validate quality score length matches sequence length
-		if (qual1_length != seq1.size()) {
+		if (qual1_length != seq1.GetSize()) {
 			throw InvalidInputException(
 			    "Quality score length (%llu) does not match sequence length (%llu) for row %llu", qual1_length,
-			    seq1.size(), row);
+			    seq1.GetSize(), row);
 		}
 
 		// Write R1 record to local buffer
+		lstate.writer_state_r1->MarkRecord();
 		WriteFastqRecordToBuffer(stream_r1, id, seq1, qual1_ptr, qual1_length, fdata.qual_offset, comment);
 		lstate.writer_state_r1->written_anything = true;
 
 		// Handle R2 for paired-end
 		if (is_paired) {
-			auto seq2_strings = UnifiedVectorFormat::GetData<string_t>(seq2_data);
 			auto seq2_row = seq2_data.sel->get_index(row);
 			if (!seq2_data.validity.RowIsValid(seq2_row)) {
 				throw InvalidInputException("NULL value in sequence2 column (row %llu)", row);
 			}
-			string seq2 = seq2_strings[seq2_row].GetString();
+			auto &seq2 = seq2_strings[seq2_row];
 
 			auto qual2_row = qual2_data.sel->get_index(row);
 			if (!qual2_data.validity.RowIsValid(qual2_row)) {
 				throw InvalidInputException("NULL value in qual2 column (row %llu)", row);
 			}
-			auto qual2_list = ListVector::GetEntry(input.data[indices.qual2_idx]);
-			auto qual2_list_data = FlatVector::GetData<uint8_t>(qual2_list);
-			auto qual2_entries = UnifiedVectorFormat::GetData<list_entry_t>(qual2_data);
 			idx_t qual2_length = qual2_entries[qual2_row].length;
 			const uint8_t *qual2_ptr = qual2_list_data + qual2_entries[qual2_row].offset;
 
 			// Validate quality score length matches sequence length
-			if (qual2_length != seq2.size()) {
+			if (qual2_length != seq2.GetSize()) {
 				throw InvalidInputException(
 				    "Quality score length (%llu) does not match sequence length (%llu) for row %llu (R2)", qual2_length,
-				    seq2.size(), row);
+				    seq2.GetSize(), row);
 			}
 
 			if (fdata.interleave) {
 				// Write R2 to same buffer
+				lstate.writer_state_r1->MarkRecord();
 				WriteFastqRecordToBuffer(stream_r1, id, seq2, qual2_ptr, qual2_length, fdata.qual_offset, comment);
 			} else {
 				// Write R2 to separate buffer
+				lstate.writer_state_r2->MarkRecord();
 				WriteFastqRecordToBuffer(*stream_r2, id, seq2, qual2_ptr, qual2_length, fdata.qual_offset, comment);
 				lstate.writer_state_r2->written_anything = true;
 			}
@@ -319,13 +341,7 @@ static void FastqCopySink(ExecutionContext &context, FunctionData &bind_data, Gl
 	}
 
 	// Check if we need to flush (buffer exceeded threshold)
-	if (lstate.writer_state_r1->stream->GetPosition() >= lstate.writer_state_r1->flush_size) {
-		FlushFormatBuffer(*lstate.writer_state_r1, *gstate.file_r1, gstate.lock);
-	}
-
-	if (stream_r2 && lstate.writer_state_r2->stream->GetPosition() >= lstate.writer_state_r2->flush_size) {
-		FlushFormatBuffer(*lstate.writer_state_r2, *gstate.file_r2, gstate.lock);
-	}
+	SequenceCopyFlushIfFull(fdata, gstate, lstate);
 }
 
 //===--------------------------------------------------------------------===//
@@ -344,7 +360,7 @@ static void FastqCopyCombine(ExecutionContext &context, FunctionData &bind_data,
 //===--------------------------------------------------------------------===//
 static void FastqCopyFinalize(ClientContext &context, FunctionData &bind_data, GlobalFunctionData &gstate_p) {
 	auto &gstate = gstate_p.Cast<FastqCopyGlobalState>();
-	SequenceCopyFinalize(gstate);
+	SequenceCopyFinalize(context, gstate);
 }
 
 //===--------------------------------------------------------------------===//
@@ -358,6 +374,9 @@ CopyFunction CopyFastqFunction::GetFunction() {
 	func.copy_to_sink = FastqCopySink;
 	func.copy_to_combine = FastqCopyCombine;
 	func.copy_to_finalize = FastqCopyFinalize;
+	func.execution_mode = SequenceCopyExecutionMode;
+	// Used to name the files DuckDB generates for PARTITION_BY / PER_THREAD_OUTPUT
+	func.extension = "fastq";
 	return func;
 }
 
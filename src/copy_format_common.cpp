@@ -1,6 +1,8 @@
 #include "copy_format_common.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/string_util.hpp"
+#include <htslib-1.22.1/htslib/bgzf.h>
+#include <charconv>
 
 namespace duckdb {
 
@@ -19,32 +21,172 @@ FormatWriterState::~FormatWriterState() {
 void FormatWriterState::Reset() {
 	stream->Rewind();
 	written_anything = false;
+	record_offsets.clear();
 }
 
 //===--------------------------------------------------------------------===//
 // Format Writer Helper Functions
 //===--------------------------------------------------------------------===//
-void FlushFormatBuffer(FormatWriterState &local_state, CopyFileHandle &file, mutex &lock) {
-	if (!local_state.written_anything) {
+// Standard BGZF end-of-file marker (an empty BGZF block)
+static constexpr uint8_t BGZF_EOF_MARKER[28] = {0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+                                                0x06, 0x00, 0x42, 0x43, 0x02, 0x00, 0x1b, 0x00, 0x03, 0x00,
+                                                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+void CompressBGZFBlocks(const_data_ptr_t data, idx_t size, MemoryStream &out, int level,
+                        vector<uint64_t> *block_sizes) {
+	uint8_t block[BGZF_MAX_BLOCK_SIZE];
+	idx_t offset = 0;
+	while (offset < size) {
+		idx_t chunk = MinValue<idx_t>(size - offset, BGZF_BLOCK_SIZE);
+		size_t block_length = sizeof(block);
+		// Level -1 selects the HTSlib default, matching what sam_open("wz") produces
+		if (bgzf_compress(block, &block_length, data + offset, chunk, level) < 0) {
+			throw IOException("Failed to compress BGZF block");
+		}
+		out.WriteData(block, block_length);
+		if (block_sizes) {
+			block_sizes->push_back(block_length);
+		}
+		offset += chunk;
+	}
+}
+
+void CompressZstdFrames(const_data_ptr_t data, idx_t size, MemoryStream &out, int level,
+                        vector<miint::ZstdFrameSize> &frames) {
+	try {
+		auto bound = miint::zstd_compress_frames_bound(size);
+		auto position = out.GetPosition();
+		auto target = char_ptr_cast(ReserveStreamSpace(out, bound));
+		auto written = miint::zstd_compress_frames(const_char_ptr_cast(data), size, target, level, frames);
+		out.SetPosition(position + written);
+	} catch (std::runtime_error &e) {
+		throw IOException("Failed to compress zstd frame: %s", e.what());
+	}
+}
+
+// Compress the thread-local buffer into BGZF blocks or zstd frames ahead of taking the lock - NO LOCK
+static void PrepareFormatBuffer(FormatWriterState &local_state, CopyFileHandle &file) {
+	if (!file.IsBlockCompressed() && !file.IsFrameCompressed()) {
+		return;
+	}
+	if (!local_state.block_stream) {
+		local_state.block_stream = make_uniq<MemoryStream>();
+	}
+	auto &blocks = *local_state.block_stream;
+	blocks.Rewind();
+	if (file.IsFrameCompressed()) {
+		local_state.frame_sizes.clear();
+		CompressZstdFrames(local_state.stream->GetData(), local_state.stream->GetPosition(), blocks,
+		                   file.CompressionLevel(), local_state.frame_sizes);
 		return;
 	}
+	local_state.block_sizes.clear();
+	CompressBGZFBlocks(local_state.stream->GetData(), local_state.stream->GetPosition(), blocks,
+	                   file.CompressionLevel(), local_state.track_records ? &local_state.block_sizes : nullptr);
+}
+
+// Append a prepared buffer; the caller holds the lock, so BytesWritten() is where the buffer lands
+static void WriteFormatBuffer(FormatWriterState &local_state, CopyFileHandle &file, miint::FastxIndex *index) {
+	if (index) {
+		index->add_block(local_state.record_offsets, local_state.stream->GetPosition(), file.BytesWritten(),
+		                 local_state.block_sizes);
+	}
+	if (file.IsBlockCompressed()) {
+		file.WriteCompressed(local_state.block_stream->GetData(), local_state.block_stream->GetPosition());
+	} else if (file.IsFrameCompressed()) {
+		file.WriteFrames(local_state.block_stream->GetData(), local_state.block_stream->GetPosition(),
+		                 local_state.frame_sizes);
+	} else {
+		file.Write(local_state.stream->GetData(), local_state.stream->GetPosition());
+	}
+}
 
-	lock_guard<mutex> glock(lock);
+void FlushFormatBuffer(FormatWriterState &local_state, CopyFileHandle &file, mutex &lock, miint::FastxIndex *index) {
+	if (!local_state.written_anything) {
+		return;
+	}
 
-	// Write accumulated buffer to file
-	file.Write(local_state.stream->GetData(), local_state.stream->GetPosition());
+	PrepareFormatBuffer(local_state, file);
+	{
+		lock_guard<mutex> glock(lock);
+		WriteFormatBuffer(local_state, file, index);
+	}
 
 	// Reset local buffer
 	local_state.Reset();
 }
 
+void FlushPairedFormatBuffers(FormatWriterState &state_r1, CopyFileHandle &file_r1, miint::FastxIndex *index_r1,
+                              FormatWriterState &state_r2, CopyFileHandle &file_r2, miint::FastxIndex *index_r2,
+                              mutex &lock) {
+	if (!state_r1.written_anything && !state_r2.written_anything) {
+		return;
+	}
+
+	PrepareFormatBuffer(state_r1, file_r1);
+	PrepareFormatBuffer(state_r2, file_r2);
+	{
+		lock_guard<mutex> glock(lock);
+		WriteFormatBuffer(state_r1, file_r1, index_r1);
+		WriteFormatBuffer(state_r2, file_r2, index_r2);
+	}
+
+	state_r1.Reset();
+	state_r2.Reset();
+}
+
+data_ptr_t ReserveStreamSpace(MemoryStream &stream, idx_t size) {
+	auto position = stream.GetPosition();
+	stream.GrowCapacity(size);
+	stream.SetPosition(position + size);
+	return stream.GetData() + position;
+}
+
+string_t FormatSequenceIndexId(int64_t value, char *buffer) {
+	auto result = std::to_chars(buffer, buffer + SEQUENCE_INDEX_ID_BUFFER_SIZE, value);
+	return string_t(buffer, UnsafeNumericCast<uint32_t>(result.ptr - buffer));
+}
+
+//===--------------------------------------------------------------------===//
+// Streaming Output
+//===--------------------------------------------------------------------===//
+bool IsStreamingCopyTarget(FileSystem &fs, const string &path) {
+	if (path == "/dev/stdout" || path == "/dev/stderr") {
+		return true;
+	}
+	return fs.IsPipe(path);
+}
+
+CopyFunctionExecutionMode SequenceCopyExecutionMode(bool preserve_insertion_order, bool) {
+	if (!preserve_insertion_order) {
+		return CopyFunctionExecutionMode::PARALLEL_COPY_TO_FILE;
+	}
+	return CopyFunctionExecutionMode::REGULAR_COPY_TO_FILE;
+}
+
 //===--------------------------------------------------------------------===//
 // CopyFileHandle Implementation
 //===--------------------------------------------------------------------===//
-CopyFileHandle::CopyFileHandle(FileSystem &fs, const string &path, FileCompressionType compression_p)
-    : compression(compression_p) {
-	auto flags =
-	    FileFlags::FILE_FLAGS_WRITE | FileFlags::FILE_FLAGS_FILE_CREATE_NEW | FileLockType::WRITE_LOCK | compression;
+CopyFileHandle::CopyFileHandle(FileSystem &fs, const string &path, FileCompressionType compression_p,
+                               int compression_level_p)
+    : compression(compression_p), compression_level(compression_level_p) {
+	// gzip output is written as concatenated BGZF blocks, which callers compress themselves.
+	// The result is still a valid multi-member gzip file, and can be decompressed in parallel.
+	block_compressed = compression == FileCompressionType::GZIP;
+	// zstd output likewise consists of independent frames, with a seek table listing them appended on Close()
+	// (the zstd seekable format), so readers can decode the frames in parallel as well
+	frame_compressed = compression == FileCompressionType::ZSTD;
+	auto file_compression = block_compressed || frame_compressed ? FileCompressionType::UNCOMPRESSED : compression;
+
+	streaming = IsStreamingCopyTarget(fs, path);
+	if (streaming) {
+		// A pipe can be neither created nor truncated nor locked, only written in order
+		stream_handle = fs.OpenFile(path, FileFlags::FILE_FLAGS_WRITE | file_compression);
+		return;
+	}
+
+	auto flags = FileFlags::FILE_FLAGS_WRITE | FileFlags::FILE_FLAGS_FILE_CREATE_NEW | FileLockType::WRITE_LOCK |
+	             file_compression;
 
 	// BufferedFileWriter handles both file opening and buffering
 	file_writer = make_uniq<BufferedFileWriter>(fs, path, flags);
@@ -54,9 +196,62 @@ CopyFileHandle::~CopyFileHandle() {
 	Close();
 }
 
-void CopyFileHandle::Write(const_data_ptr_t data, idx_t size) {
+void CopyFileHandle::WriteRaw(const_data_ptr_t data, idx_t size) {
 	if (file_writer) {
 		file_writer->WriteData(data, size);
+	} else if (stream_handle) {
+		// Writes to a pipe block while the reader is behind, and may return short
+		while (size > 0) {
+			auto written = stream_handle->Write(const_cast<data_ptr_t>(data), size);
+			if (written <= 0) {
+				throw IOException("Failed to write to \"%s\"", stream_handle->GetPath());
+			}
+			data += written;
+			size -= NumericCast<idx_t>(written);
+		}
+	}
+}
+
+void CopyFileHandle::Write(const_data_ptr_t data, idx_t size) {
+	if (!file_writer && !stream_handle) {
+		return;
+	}
+	if (block_compressed) {
+		if (!block_buffer) {
+			block_buffer = make_uniq<MemoryStream>();
+		}
+		block_buffer->Rewind();
+		CompressBGZFBlocks(data, size, *block_buffer, compression_level);
+		WriteRaw(block_buffer->GetData(), block_buffer->GetPosition());
+		bytes_written += block_buffer->GetPosition();
+	} else if (frame_compressed) {
+		if (!block_buffer) {
+			block_buffer = make_uniq<MemoryStream>();
+		}
+		block_buffer->Rewind();
+		vector<miint::ZstdFrameSize> frames;
+		CompressZstdFrames(data, size, *block_buffer, compression_level, frames);
+		WriteFrames(block_buffer->GetData(), block_buffer->GetPosition(), frames);
+	} else {
+		WriteRaw(data, size);
+		bytes_written += size;
+	}
+}
+
+void CopyFileHandle::WriteCompressed(const_data_ptr_t data, idx_t size) {
+	D_ASSERT(block_compressed);
+	if (file_writer || stream_handle) {
+		WriteRaw(data, size);
+		bytes_written += size;
+	}
+}
+
+void CopyFileHandle::WriteFrames(const_data_ptr_t data, idx_t size, const vector<miint::ZstdFrameSize> &frames) {
+	D_ASSERT(frame_compressed);
+	if (file_writer || stream_handle) {
+		WriteRaw(data, size);
+		bytes_written += size;
+		frame_sizes.insert(frame_sizes.end(), frames.begin(), frames.end());
 	}
 }
 
@@ -65,15 +260,39 @@ void CopyFileHandle::WriteString(const string &data) {
 }
 
 void CopyFileHandle::Close() {
+	if (!file_writer && !stream_handle) {
+		return;
+	}
+	if (block_compressed) {
+		WriteRaw(BGZF_EOF_MARKER, sizeof(BGZF_EOF_MARKER));
+		bytes_written += sizeof(BGZF_EOF_MARKER);
+	}
+	if (frame_compressed) {
+		miint::ZstdSeekTable table;
+		table.frames = std::move(frame_sizes);
+		auto data = table.serialize();
+		WriteRaw(const_data_ptr_cast(data.data()), data.size());
+		bytes_written += data.size();
+	}
 	if (file_writer) {
 		file_writer->Close();
 		file_writer.reset();
+	} else {
+		stream_handle->Close();
+		stream_handle.reset();
 	}
 }
 
 //===--------------------------------------------------------------------===//
 // Common Helper Functions
 //===--------------------------------------------------------------------===//
+FileCompressionType ZstdCompressionType() {
+	if (!miint::zstd_available()) {
+		throw NotImplementedException("zstd compression is not available: the extension was built without zstd");
+	}
+	return FileCompressionType::ZSTD;
+}
+
 FileCompressionType DetectCompressionType(const string &file_path, const Value &compression_param) {
 	// Explicit parameter takes precedence
 	if (!compression_param.IsNull()) {
@@ -81,14 +300,11 @@ FileCompressionType DetectCompressionType(const string &file_path, const Value &
 		if (comp_str == "gzip" || comp_str == "gz") {
 			return FileCompressionType::GZIP;
 		} else if (comp_str == "zstd" || comp_str == "zst") {
-			// TODO: zstd support temporarily disabled due to unicode encoding issues during read-back
-			throw NotImplementedException("zstd compression is temporarily disabled for FASTX/SAM formats. "
-			                              "Please use gzip compression instead. "
-			                              "zstd support will be re-enabled in a future release.");
+			return ZstdCompressionType();
 		} else if (comp_str == "none") {
 			return FileCompressionType::UNCOMPRESSED;
 		} else {
-			throw InvalidInputException("compression must be 'gzip', 'gz', or 'none' (zstd temporarily disabled)");
+			throw InvalidInputException("compression must be 'gzip', 'gz', 'zstd', 'zst', or 'none'");
 		}
 	}
 
@@ -97,11 +313,7 @@ FileCompressionType DetectCompressionType(const string &file_path, const Value &
 		return FileCompressionType::GZIP;
 	}
 	if (file_path.size() >= 4 && file_path.substr(file_path.size() - 4) == ".zst") {
-		// TODO: zstd support temporarily disabled due to unicode encoding issues during read-back
-		throw NotImplementedException(
-		    "zstd compression (.zst extension) is temporarily disabled for FASTX/SAM formats. "
-		    "Please use .gz extension or COMPRESSION='gzip' instead. "
-		    "zstd support will be re-enabled in a future release.");
+		return ZstdCompressionType();
 	}
 
 	return FileCompressionType::UNCOMPRESSED;
@@ -121,6 +333,12 @@ bool HasOrientationPlaceholder(const string &path) {
 	return path.find("{ORIENTATION}") != string::npos;
 }
 
+static bool HasFileExtension(const string &path) {
+	auto name_start = path.find_last_of("/\\");
+	auto name = name_start == string::npos ? path : path.substr(name_start + 1);
+	return name.find('.') != string::npos;
+}
+
 //===--------------------------------------------------------------------===//
 // ColumnIndices Implementation
 //===--------------------------------------------------------------------===//
@@ -153,6 +371,8 @@ void CommonCopyParameters::ParseFromOptions(const case_insensitive_map_t<vector<
 	Value id_as_sequence_index_param;
 	Value include_comment_param;
 	Value compression_param;
+	Value index_param;
+	Value index_interval_param;
 
 	for (auto &option : options) {
 		if (StringUtil::CIEquals(option.first, "interleave")) {
@@ -163,6 +383,10 @@ void CommonCopyParameters::ParseFromOptions(const case_insensitive_map_t<vector<
 			include_comment_param = option.second[0];
 		} else if (StringUtil::CIEquals(option.first, "compression")) {
 			compression_param = option.second[0];
+		} else if (StringUtil::CIEquals(option.first, "index")) {
+			index_param = option.second.empty() ? Value::BOOLEAN(true) : option.second[0];
+		} else if (StringUtil::CIEquals(option.first, "index_interval")) {
+			index_interval_param = option.second[0];
 		}
 	}
 
@@ -179,6 +403,33 @@ void CommonCopyParameters::ParseFromOptions(const case_insensitive_map_t<vector<
 	}
 
 	compression = DetectCompressionType(file_path, compression_param);
+
+	if (!index_param.IsNull()) {
+		write_index = index_param.GetValue<bool>();
+	}
+
+	if (!index_interval_param.IsNull()) {
+		if (!write_index) {
+			throw BinderException("INDEX_INTERVAL requires INDEX true");
+		}
+		int64_t interval = index_interval_param.GetValue<int64_t>();
+		if (interval <= 0) {
+			throw BinderException("INDEX_INTERVAL must be greater than 0");
+		}
+		index_interval = static_cast<idx_t>(interval);
+	}
+
+	if (write_index && compression == FileCompressionType::ZSTD) {
+		throw BinderException("INDEX is not supported with zstd compression");
+	}
+
+	if (streaming) {
+		if (write_index) {
+			throw BinderException("INDEX cannot be written when streaming to a pipe");
+		}
+		// Hand records to the reader sooner, and bound what each thread holds back
+		flush_size = STREAM_COPY_FLUSH_SIZE;
+	}
 }
 
 //===--------------------------------------------------------------------===//
@@ -199,9 +450,11 @@ void ValidatePairedEndParameters(bool is_paired, bool has_interleave_param, bool
 		throw BinderException("INTERLEAVE parameter required for paired-end data");
 	}
 
-	// Validate {ORIENTATION} usage
+	// Validate {ORIENTATION} usage. With PARTITION_BY the bound path is the output directory and the
+	// placeholder comes from FILENAME_PATTERN, which is not visible here; a path without a file
+	// extension is therefore checked again once the file names are known (SequenceCopyInitializeGlobal).
 	bool has_orientation = HasOrientationPlaceholder(file_path);
-	if (is_paired && !interleave && !has_orientation) {
+	if (is_paired && !interleave && !has_orientation && HasFileExtension(file_path)) {
 		throw BinderException("Paired-end data with INTERLEAVE=false requires {ORIENTATION} in file path");
 	}
 	if (!is_paired && has_orientation) {
@@ -228,15 +481,29 @@ unique_ptr<GlobalFunctionData> SequenceCopyInitializeGlobal(ClientContext &conte
 	gstate->interleave = fdata.interleave;
 
 	if (fdata.is_paired && !fdata.interleave) {
+		if (!HasOrientationPlaceholder(file_path)) {
+			throw BinderException("Paired-end data with INTERLEAVE=false requires {ORIENTATION} in file path");
+		}
 		// Split mode: open two files
 		string path_r1 = SubstituteOrientation(file_path, "R1");
 		string path_r2 = SubstituteOrientation(file_path, "R2");
 
 		gstate->file_r1 = make_uniq<CopyFileHandle>(fs, path_r1, fdata.compression);
 		gstate->file_r2 = make_uniq<CopyFileHandle>(fs, path_r2, fdata.compression);
+		gstate->path_r1 = path_r1;
+		gstate->path_r2 = path_r2;
 	} else {
 		// Interleaved or single-end: open one file
 		gstate->file_r1 = make_uniq<CopyFileHandle>(fs, file_path, fdata.compression);
+		gstate->path_r1 = file_path;
+	}
+
+	if (fdata.write_index) {
+		bool compressed = gstate->file_r1->IsBlockCompressed();
+		gstate->index_r1 = make_uniq<miint::FastxIndex>(fdata.index_interval, compressed);
+		if (gstate->file_r2) {
+			gstate->index_r2 = make_uniq<miint::FastxIndex>(fdata.index_interval, compressed);
+		}
 	}
 
 	return gstate;
@@ -247,25 +514,56 @@ unique_ptr<LocalFunctionData> SequenceCopyInitializeLocal(ExecutionContext &cont
 	auto lstate = make_uniq<SequenceCopyLocalState>();
 
 	lstate->writer_state_r1 = make_uniq<FormatWriterState>(context.client, fdata.flush_size);
+	lstate->writer_state_r1->track_records = fdata.write_index;
 
 	if (fdata.is_paired && !fdata.interleave) {
 		lstate->writer_state_r2 = make_uniq<FormatWriterState>(context.client, fdata.flush_size);
+		lstate->writer_state_r2->track_records = fdata.write_index;
 	}
 
 	return lstate;
 }
 
+static void SequenceCopyFlush(const SequenceCopyBindData &fdata, SequenceCopyGlobalState &gstate,
+                              SequenceCopyLocalState &lstate) {
+	if (fdata.is_paired && !fdata.interleave) {
+		// Both halves are appended together, so R1 and R2 stay record-aligned across threads
+		FlushPairedFormatBuffers(*lstate.writer_state_r1, *gstate.file_r1, gstate.index_r1.get(),
+		                         *lstate.writer_state_r2, *gstate.file_r2, gstate.index_r2.get(), gstate.lock);
+	} else {
+		FlushFormatBuffer(*lstate.writer_state_r1, *gstate.file_r1, gstate.lock, gstate.index_r1.get());
+	}
+}
+
+void SequenceCopyFlushIfFull(const SequenceCopyBindData &fdata, SequenceCopyGlobalState &gstate,
+                             SequenceCopyLocalState &lstate) {
+	auto &state_r1 = *lstate.writer_state_r1;
+	bool full = state_r1.stream->GetPosition() >= state_r1.flush_size;
+	if (lstate.writer_state_r2) {
+		auto &state_r2 = *lstate.writer_state_r2;
+		full = full || state_r2.stream->GetPosition() >= state_r2.flush_size;
+	}
+	if (full) {
+		SequenceCopyFlush(fdata, gstate, lstate);
+	}
+}
+
 void SequenceCopyCombine(const SequenceCopyBindData &fdata, SequenceCopyGlobalState &gstate,
                          SequenceCopyLocalState &lstate) {
 	// Flush any remaining data in local buffers
-	FlushFormatBuffer(*lstate.writer_state_r1, *gstate.file_r1, gstate.lock);
+	SequenceCopyFlush(fdata, gstate, lstate);
+}
 
-	if (fdata.is_paired && !fdata.interleave) {
-		FlushFormatBuffer(*lstate.writer_state_r2, *gstate.file_r2, gstate.lock);
-	}
+static void WriteFastxIndex(FileSystem &fs, const string &path, miint::FastxIndex &index, const CopyFileHandle &file) {
+	index.file_size = file.BytesWritten();
+	auto data = index.serialize();
+	auto flags = FileFlags::FILE_FLAGS_WRITE | FileFlags::FILE_FLAGS_FILE_CREATE_NEW;
+	BufferedFileWriter writer(fs, path + miint::FastxIndex::EXTENSION, flags);
+	writer.WriteData(const_data_ptr_cast(data.data()), data.size());
+	writer.Close();
 }
 
-void SequenceCopyFinalize(SequenceCopyGlobalState &gstate) {
+void SequenceCopyFinalize(ClientContext &context, SequenceCopyGlobalState &gstate) {
 	lock_guard<mutex> glock(gstate.lock);
 
 	if (gstate.file_r1) {
@@ -274,6 +572,15 @@ void SequenceCopyFinalize(SequenceCopyGlobalState &gstate) {
 	if (gstate.file_r2) {
 		gstate.file_r2->Close();
 	}
+
+	// Indexes record the final file size, so they are written once the data files are complete
+	auto &fs = FileSystem::GetFileSystem(context);
+	if (gstate.index_r1) {
+		WriteFastxIndex(fs, gstate.path_r1, *gstate.index_r1, *gstate.file_r1);
+	}
+	if (gstate.index_r2) {
+		WriteFastxIndex(fs, gstate.path_r2, *gstate.index_r2, *gstate.file_r2);
+	}
 }
 
 } // namespace duckdb
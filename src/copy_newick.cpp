@@ -6,6 +6,7 @@
 #include "duckdb/common/file_system.hpp"
 #include "duckdb/common/vector_operations/generic_executor.hpp"
 #include "duckdb/function/copy_function.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
 
 namespace duckdb {
 
@@ -341,8 +342,10 @@ static void NewickCopyFinalize(ClientContext &context, FunctionData &bind_data,
 		}
 
 		// Insert placements into tree (placements were already read at bind time)
+		auto n_threads =
+		    static_cast<size_t>(MaxValue<int32_t>(TaskScheduler::GetScheduler(context).NumberOfThreads(), 1));
 		try {
-			tree.insert_fully_resolved(gstate.placements);
+			tree.insert_fully_resolved(gstate.placements, n_threads);
 		} catch (const std::runtime_error &e) {
 			throw InvalidInputException("COPY FORMAT NEWICK: Failed to insert placements: %s", e.what());
 		}
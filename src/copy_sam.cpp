@@ -1,4 +1,6 @@
 #include "copy_sam.hpp"
+#include "copy_format_common.hpp"
+#include "bam_writer.hpp"
 #include "reference_table_reader.hpp"
 #include "duckdb/catalog/catalog.hpp"
 #include "duckdb/catalog/catalog_entry/table_catalog_entry.hpp"
@@ -9,6 +11,7 @@
 #include "duckdb/function/copy_function.hpp"
 #include <htslib-1.22.1/htslib/sam.h>
 #include <htslib-1.22.1/htslib/hts.h>
+#include <charconv>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -17,14 +20,6 @@ namespace duckdb {
 //===--------------------------------------------------------------------===//
 // HTSlib Smart Pointers
 //===--------------------------------------------------------------------===//
-struct SAMFileDeleter {
-	void operator()(samFile *fp) const {
-		if (fp) {
-			sam_close(fp);
-		}
-	}
-};
-
 struct SAMHeaderDeleter {
 	void operator()(sam_hdr_t *hdr) const {
 		if (hdr) {
@@ -41,7 +36,6 @@ struct BAMRecordDeleter {
 	}
 };
 
-using SAMFilePtr = std::unique_ptr<samFile, SAMFileDeleter>;
 using SAMHeaderPtr = std::unique_ptr<sam_hdr_t, SAMHeaderDeleter>;
 using BAMRecordPtr = std::unique_ptr<bam1_t, BAMRecordDeleter>;
 
@@ -130,9 +124,12 @@ enum class SAMOutputFormat : uint8_t { SAM = 0, BAM = 1 };
 
 struct SAMCopyBindData : public FunctionData {
 	bool include_header = true;
-	bool use_gzip = false;
+	FileCompressionType compression = FileCompressionType::UNCOMPRESSED; // SAM only; BAM is always BGZF
 	SAMOutputFormat format = SAMOutputFormat::SAM;
 	int compression_level = -1; // -1 means use HTSlib default (6 for BAM)
+	bool sort_coordinate = false; // BAM only: external merge sort on (tid, pos)
+	bool write_index = false;     // BAM only: emit .bai/.csi while writing the sorted stream
+	idx_t flush_size = DEFAULT_COPY_FLUSH_SIZE;
 	string file_path;
 	vector<string> names;
 	std::optional<string> reference_lengths_table;
@@ -141,9 +138,12 @@ struct SAMCopyBindData : public FunctionData {
 	unique_ptr<FunctionData> Copy() const override {
 		auto result = make_uniq<SAMCopyBindData>();
 		result->include_header = include_header;
-		result->use_gzip = use_gzip;
+		result->compression = compression;
 		result->format = format;
 		result->compression_level = compression_level;
+		result->sort_coordinate = sort_coordinate;
+		result->write_index = write_index;
+		result->flush_size = flush_size;
 		result->file_path = file_path;
 		result->names = names;
 		result->reference_lengths_table = reference_lengths_table;
@@ -153,8 +153,9 @@ struct SAMCopyBindData : public FunctionData {
 
 	bool Equals(const FunctionData &other_p) const override {
 		auto &other = other_p.Cast<SAMCopyBindData>();
-		return include_header == other.include_header && use_gzip == other.use_gzip && format == other.format &&
-		       compression_level == other.compression_level && file_path == other.file_path &&
+		return include_header == other.include_header && compression == other.compression && format == other.format &&
+		       compression_level == other.compression_level && sort_coordinate == other.sort_coordinate &&
+		       write_index == other.write_index && flush_size == other.flush_size && file_path == other.file_path &&
 		       reference_lengths_table == other.reference_lengths_table;
 	}
 };
@@ -241,11 +242,13 @@ static unique_ptr<FunctionData> SAMCopyBindInternal(ClientContext &context, Copy
 			compression_specified = true;
 			auto comp_value = option.second[0].ToString();
 			if (StringUtil::CIEquals(comp_value, "gzip") || StringUtil::CIEquals(comp_value, "gz")) {
-				result->use_gzip = true;
+				result->compression = FileCompressionType::GZIP;
+			} else if (StringUtil::CIEquals(comp_value, "zstd") || StringUtil::CIEquals(comp_value, "zst")) {
+				result->compression = ZstdCompressionType();
 			} else if (StringUtil::CIEquals(comp_value, "none") || StringUtil::CIEquals(comp_value, "uncompressed")) {
-				result->use_gzip = false;
+				result->compression = FileCompressionType::UNCOMPRESSED;
 			} else {
-				throw BinderException("Unknown compression type for COPY FORMAT SAM: %s (supported: gzip, none)",
+				throw BinderException("Unknown compression type for COPY FORMAT SAM: %s (supported: gzip, zstd, none)",
 				                      comp_value);
 			}
 		} else if (StringUtil::CIEquals(option.first, "compression_level")) {
@@ -253,6 +256,18 @@ static unique_ptr<FunctionData> SAMCopyBindInternal(ClientContext &context, Copy
 			if (result->compression_level < 0 || result->compression_level > 9) {
 				throw BinderException("COMPRESSION_LEVEL must be between 0 and 9, got %d", result->compression_level);
 			}
+		} else if (StringUtil::CIEquals(option.first, "sort")) {
+			auto sort_value = option.second[0].ToString();
+			if (StringUtil::CIEquals(sort_value, "coordinate")) {
+				result->sort_coordinate = true;
+			} else if (StringUtil::CIEquals(sort_value, "none")) {
+				result->sort_coordinate = false;
+			} else {
+				throw BinderException("Unknown SORT order for COPY FORMAT BAM: %s (supported: coordinate, none)",
+				                      sort_value);
+			}
+		} else if (StringUtil::CIEquals(option.first, "index")) {
+			result->write_index = option.second[0].GetValue<bool>();
 		} else if (StringUtil::CIEquals(option.first, "reference_lengths")) {
 			const auto &table_value = option.second[0];
 			if (table_value.type().id() != LogicalTypeId::VARCHAR) {
@@ -282,6 +297,22 @@ static unique_ptr<FunctionData> SAMCopyBindInternal(ClientContext &context, Copy
 		throw BinderException("COMPRESSION_LEVEL parameter only applies to BAM format");
 	}
 
+	// Sorting and indexing are implemented for BAM only
+	if (result->sort_coordinate && result->format != SAMOutputFormat::BAM) {
+		throw BinderException("SORT parameter only applies to BAM format");
+	}
+	if (result->write_index && !result->sort_coordinate) {
+		throw BinderException("INDEX=true requires FORMAT BAM with SORT 'coordinate'");
+	}
+
+	// Pipes take the records as they are produced: no sidecar index, and smaller per-thread buffers
+	if (IsStreamingCopyTarget(FileSystem::GetFileSystem(context), result->file_path)) {
+		if (result->write_index) {
+			throw BinderException("INDEX cannot be written when streaming to a pipe");
+		}
+		result->flush_size = STREAM_COPY_FLUSH_SIZE;
+	}
+
 	// BAM files must have headers (binary format requirement)
 	if (result->format == SAMOutputFormat::BAM && !result->include_header) {
 		throw BinderException("BAM format requires INCLUDE_HEADER=true (BAM is a binary format that requires headers)");
@@ -303,7 +334,9 @@ static unique_ptr<FunctionData> SAMCopyBindInternal(ClientContext &context, Copy
 	// Auto-detect compression from file extension if not specified (for SAM format)
 	if (!compression_specified && result->format == SAMOutputFormat::SAM) {
 		if (result->file_path.size() >= 3 && result->file_path.substr(result->file_path.size() - 3) == ".gz") {
-			result->use_gzip = true;
+			result->compression = FileCompressionType::GZIP;
+		} else if (result->file_path.size() >= 4 && result->file_path.substr(result->file_path.size() - 4) == ".zst") {
+			result->compression = ZstdCompressionType();
 		}
 	}
 
@@ -327,10 +360,18 @@ static unique_ptr<FunctionData> BAMCopyBind(ClientContext &context, CopyFunction
 //===--------------------------------------------------------------------===//
 struct SAMCopyGlobalState : public GlobalFunctionData {
 	mutex write_lock;
-	SAMFilePtr sam_file;
 	SAMHeaderPtr header;
-	std::atomic<bool> header_written {false};
 	bool include_header = true;
+
+	// Both SAM and BAM bypass HTSlib's writers: threads format records into local buffers (compressing
+	// them into BGZF blocks for BAM and gzipped SAM), and only append the finished output under write_lock
+	unique_ptr<CopyFileHandle> file;
+	// Read-only reference name -> TID lookup for BAM (the header is fixed before any record is written)
+	std::unordered_map<string, int32_t> reference_tids;
+
+	// SORT 'coordinate': sorted runs spilled by each thread, merged into file at finalize
+	unique_ptr<BAMCoordinateSorter> sorter;
+	string file_path;
 };
 
 static unique_ptr<GlobalFunctionData> SAMCopyInitializeGlobal(ClientContext &context, FunctionData &bind_data,
@@ -340,28 +381,6 @@ static unique_ptr<GlobalFunctionData> SAMCopyInitializeGlobal(ClientContext &con
 	auto gstate = make_uniq<SAMCopyGlobalState>();
 	gstate->include_header = fdata.include_header;
 
-	// Determine write mode based on format and compression
-	string mode;
-	if (fdata.format == SAMOutputFormat::BAM) {
-		// BAM format
-		if (fdata.compression_level >= 0) {
-			// Explicit compression level (0-9)
-			mode = "wb" + std::to_string(fdata.compression_level);
-		} else {
-			// Default BAM compression (HTSlib default level 6)
-			mode = "wb";
-		}
-	} else {
-		// SAM format
-		mode = fdata.use_gzip ? "wz" : "w";
-	}
-
-	// Open file for writing
-	gstate->sam_file = SAMFilePtr(sam_open(file_path.c_str(), mode.c_str()));
-	if (!gstate->sam_file) {
-		throw IOException("Failed to open file for writing: " + file_path);
-	}
-
 	// Create header from reference_lengths if provided, otherwise create empty header
 	gstate->header = SAMHeaderPtr(sam_hdr_init());
 	if (!gstate->header) {
@@ -379,8 +398,48 @@ static unique_ptr<GlobalFunctionData> SAMCopyInitializeGlobal(ClientContext &con
 			}
 		}
 	}
-	// If no reference_lengths provided, header remains empty
-	// References will be added dynamically as we encounter them during writing
+	// If no reference_lengths provided, header remains empty. SAM records carry reference names
+	// as text, so references outside the header are written as given.
+
+	auto &fs = FileSystem::GetFileSystem(context);
+
+	if (fdata.format == SAMOutputFormat::SAM) {
+		// Gzipped SAM is written as BGZF, matching HTSlib's "wz" mode; zstd SAM as seekable zstd frames
+		gstate->file = make_uniq<CopyFileHandle>(fs, file_path, fdata.compression);
+
+		// Header is written up front so empty results still produce it
+		if (fdata.include_header) {
+			auto header_length = sam_hdr_length(gstate->header.get());
+			if (header_length == SIZE_MAX) {
+				throw IOException("Failed to write SAM header");
+			}
+			if (header_length > 0) {
+				gstate->file->Write(const_data_ptr_cast(sam_hdr_str(gstate->header.get())), header_length);
+			}
+		}
+		return std::move(gstate);
+	}
+
+	if (fdata.sort_coordinate) {
+		if (sam_hdr_add_line(gstate->header.get(), "HD", "VN", SAM_FORMAT_VERSION, "SO", "coordinate", NULL) < 0) {
+			throw IOException("Failed to add sort order to BAM header");
+		}
+		gstate->sorter = make_uniq<BAMCoordinateSorter>(context);
+		gstate->file_path = file_path;
+	}
+
+	// BAM always has a header (required at bind), so write it up front in its own BGZF block(s)
+	gstate->file = make_uniq<CopyFileHandle>(fs, file_path, FileCompressionType::GZIP, fdata.compression_level);
+
+	int32_t n_ref = sam_hdr_nref(gstate->header.get());
+	gstate->reference_tids.reserve(n_ref);
+	for (int32_t tid = 0; tid < n_ref; tid++) {
+		gstate->reference_tids.emplace(sam_hdr_tid2name(gstate->header.get(), tid), tid);
+	}
+
+	MemoryStream header_stream;
+	SerializeBAMHeader(gstate->header.get(), header_stream);
+	gstate->file->Write(header_stream.GetData(), header_stream.GetPosition());
 
 	return std::move(gstate);
 }
@@ -392,6 +451,8 @@ struct SAMCopyLocalState : public LocalFunctionData {
 	BAMRecordPtr record;
 	std::vector<uint32_t> cigar_buffer;
 	size_t cigar_buffer_capacity = 0;
+	unique_ptr<FormatWriterState> writer_state; // Formatted SAM text or serialized BAM records
+	unique_ptr<BAMSortLocalState> sort_state;   // Records awaiting sort (BAM with SORT 'coordinate')
 
 	SAMCopyLocalState() {
 		record = BAMRecordPtr(bam_init1());
@@ -402,7 +463,14 @@ struct SAMCopyLocalState : public LocalFunctionData {
 };
 
 static unique_ptr<LocalFunctionData> SAMCopyInitializeLocal(ExecutionContext &context, FunctionData &bind_data) {
-	return make_uniq<SAMCopyLocalState>();
+	auto &fdata = bind_data.Cast<SAMCopyBindData>();
+	auto lstate = make_uniq<SAMCopyLocalState>();
+	if (fdata.sort_coordinate) {
+		lstate->sort_state = make_uniq<BAMSortLocalState>(DEFAULT_BAM_SORT_RUN_SIZE);
+	} else {
+		lstate->writer_state = make_uniq<FormatWriterState>(context.client, fdata.flush_size);
+	}
+	return std::move(lstate);
 }
 
 //===--------------------------------------------------------------------===//
@@ -439,34 +507,60 @@ static bool ParseCIGAR(const string &cigar_str, std::vector<uint32_t> &cigar_buf
 	return true;
 }
 
-// Get reference TID from header, adding it dynamically if not present
-// When writing headerless SAM files, we add references with a sentinel length
-static int32_t GetReferenceTID(sam_hdr_t *header, const string &reference) {
-	if (reference == "*") {
-		return -1;
+// Check a CIGAR string without materializing it: one or more <length><op> pairs, with lengths
+// that fit the 28 bits BAM allows. An empty string is accepted as "*", as sam_parse_cigar does.
+static bool IsValidCIGAR(const char *cigar, idx_t length) {
+	if (length == 1 && cigar[0] == '*') {
+		return true;
 	}
-	int32_t tid = sam_hdr_name2tid(header, reference.c_str());
-
-	// If reference not in header, add it with a sentinel length (2^31-1)
-	// This allows writing headerless SAM files without pre-defined reference lengths
-	if (tid < 0) {
-		constexpr const char *SENTINEL_LENGTH = "2147483647"; // 2^31-1, unknown length
-		if (sam_hdr_add_line(header, "SQ", "SN", reference.c_str(), "LN", SENTINEL_LENGTH, NULL) < 0) {
-			throw IOException("Failed to dynamically add reference to SAM header: %s", reference);
+	idx_t pos = 0;
+	while (pos < length) {
+		uint64_t op_length = 0;
+		idx_t digits_start = pos;
+		while (pos < length && cigar[pos] >= '0' && cigar[pos] <= '9') {
+			op_length = op_length * 10 + (cigar[pos] - '0');
+			if (op_length > (1ULL << (32 - BAM_CIGAR_SHIFT)) - 1) {
+				return false;
+			}
+			pos++;
 		}
-		// Get the tid after adding
-		tid = sam_hdr_name2tid(header, reference.c_str());
-		if (tid < 0) {
-			throw IOException("Failed to get TID for dynamically added reference: %s", reference);
+		if (pos == digits_start || pos == length || bam_cigar_table[static_cast<uint8_t>(cigar[pos])] < 0) {
+			return false;
 		}
+		pos++;
 	}
+	return true;
+}
 
-	return tid;
+// Get reference TID for BAM output. The header was written at initialization, so unknown
+// references cannot be added and are an error.
+static int32_t GetBAMReferenceTID(const SAMCopyGlobalState &gstate, const string &reference) {
+	if (reference == "*") {
+		return -1;
+	}
+	auto entry = gstate.reference_tids.find(reference);
+	if (entry == gstate.reference_tids.end()) {
+		throw InvalidInputException("Reference '%s' is not present in the REFERENCE_LENGTHS table", reference);
+	}
+	return entry->second;
 }
 
 //===--------------------------------------------------------------------===//
 // Tag Helpers
 //===--------------------------------------------------------------------===//
+// Optional tag columns; data is nullptr when the column is not part of the input
+struct SAMIntegerTagColumn {
+	const char *name;
+	const int64_t *data;
+	UnifiedVectorFormat format;
+};
+
+struct SAMStringTagColumn {
+	const char *name;
+	const string_t *data;
+	UnifiedVectorFormat format;
+};
+
 static inline void AppendIntegerTag(bam1_t *record, const char *tag_name, const int64_t *data_ptr,
                                     const UnifiedVectorFormat &format, idx_t row_idx, const string &read_id) {
 	if (!data_ptr) {
@@ -496,6 +590,104 @@ static inline void AppendStringTag(bam1_t *record, const char *tag_name, const s
 	}
 }
 
+//===--------------------------------------------------------------------===//
+// SAM Text Formatting
+//===--------------------------------------------------------------------===//
+static inline void AppendText(MemoryStream &out, const char *data, idx_t size) {
+	out.WriteData(const_data_ptr_cast(data), size);
+}
+
+static inline void AppendText(MemoryStream &out, const string_t &value) {
+	out.WriteData(const_data_ptr_cast(value.GetData()), value.GetSize());
+}
+
+template <class T>
+static inline void AppendNumber(MemoryStream &out, T value) {
+	char buffer[24];
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+	out.WriteData(const_data_ptr_cast(buffer), result.ptr - buffer);
+}
+
+static inline bool IsUnsetReference(const string_t &reference) {
+	return reference.GetSize() == 1 && reference.GetData()[0] == '*';
+}
+
+// Format one alignment line the way sam_format1 would print the equivalent bam1_t: SEQ and QUAL
+// are "*", RNEXT collapses to "=" when it names the read's own reference, and tags follow in
+// column order with integer tags narrowed to int32.
+static void WriteSAMRecord(MemoryStream &out, const string_t &read_id, uint16_t flags, const string_t &reference,
+                           int64_t position, uint8_t mapq, const string_t &cigar, const string_t &mate_reference,
+                           int64_t mate_position, int64_t template_length,
+                           const array<SAMIntegerTagColumn, 8> &integer_tags,
+                           const array<SAMStringTagColumn, 3> &string_tags, idx_t row) {
+	if (read_id.GetSize() == 0) {
+		AppendText(out, "*", 1);
+	} else {
+		AppendText(out, read_id);
+	}
+	AppendText(out, "\t", 1);
+	AppendNumber(out, flags);
+	AppendText(out, "\t", 1);
+
+	bool reference_unset = IsUnsetReference(reference);
+	if (reference_unset) {
+		AppendText(out, "*", 1);
+	} else {
+		AppendText(out, reference);
+	}
+	AppendText(out, "\t", 1);
+	AppendNumber(out, position);
+	AppendText(out, "\t", 1);
+	AppendNumber(out, mapq);
+	AppendText(out, "\t", 1);
+	if (cigar.GetSize() == 0) {
+		AppendText(out, "*", 1);
+	} else {
+		AppendText(out, cigar);
+	}
+	AppendText(out, "\t", 1);
+
+	bool mate_is_same = mate_reference.GetSize() == 1 && mate_reference.GetData()[0] == '=';
+	if (reference_unset && (mate_is_same || IsUnsetReference(mate_reference))) {
+		AppendText(out, "*", 1);
+	} else if (mate_is_same || mate_reference == reference) {
+		AppendText(out, "=", 1);
+	} else {
+		AppendText(out, mate_reference);
+	}
+	AppendText(out, "\t", 1);
+	AppendNumber(out, mate_position);
+	AppendText(out, "\t", 1);
+	AppendNumber(out, template_length);
+	AppendText(out, "\t*\t*", 4);
+
+	for (auto &tag : integer_tags) {
+		if (!tag.data) {
+			continue;
+		}
+		auto data_idx = tag.format.sel->get_index(row);
+		if (tag.format.validity.RowIsValid(data_idx)) {
+			AppendText(out, "\t", 1);
+			AppendText(out, tag.name, 2);
+			AppendText(out, ":i:", 3);
+			AppendNumber(out, static_cast<int32_t>(tag.data[data_idx]));
+		}
+	}
+	for (auto &tag : string_tags) {
+		if (!tag.data) {
+			continue;
+		}
+		auto data_idx = tag.format.sel->get_index(row);
+		if (tag.format.validity.RowIsValid(data_idx)) {
+			AppendText(out, "\t", 1);
+			AppendText(out, tag.name, 2);
+			AppendText(out, ":Z:", 3);
+			AppendText(out, tag.data[data_idx]);
+		}
+	}
+	AppendText(out, "\n", 1);
+}
+
 //===--------------------------------------------------------------------===//
 // Sink
 //===--------------------------------------------------------------------===//
@@ -511,9 +703,6 @@ static void SAMCopySink(ExecutionContext &context, FunctionData &bind_data, Glob
 	// Extract data from input vectors
 	UnifiedVectorFormat read_id_data, flags_data, reference_data, position_data, mapq_data;
 	UnifiedVectorFormat cigar_data, mate_reference_data, mate_position_data, template_length_data;
-	UnifiedVectorFormat tag_as_data, tag_xs_data, tag_ys_data, tag_xn_data, tag_xm_data, tag_xo_data, tag_xg_data,
-	    tag_nm_data;
-	UnifiedVectorFormat tag_yt_data, tag_md_data, tag_sa_data;
 
 	input.data[indices.read_id_idx].ToUnifiedFormat(input.size(), read_id_data);
 	input.data[indices.flags_idx].ToUnifiedFormat(input.size(), flags_data);
@@ -525,38 +714,31 @@ static void SAMCopySink(ExecutionContext &context, FunctionData &bind_data, Glob
 	input.data[indices.mate_position_idx].ToUnifiedFormat(input.size(), mate_position_data);
 	input.data[indices.template_length_idx].ToUnifiedFormat(input.size(), template_length_data);
 
-	if (indices.tag_as_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_as_idx].ToUnifiedFormat(input.size(), tag_as_data);
-	}
-	if (indices.tag_xs_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_xs_idx].ToUnifiedFormat(input.size(), tag_xs_data);
-	}
-	if (indices.tag_ys_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_ys_idx].ToUnifiedFormat(input.size(), tag_ys_data);
-	}
-	if (indices.tag_xn_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_xn_idx].ToUnifiedFormat(input.size(), tag_xn_data);
-	}
-	if (indices.tag_xm_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_xm_idx].ToUnifiedFormat(input.size(), tag_xm_data);
-	}
-	if (indices.tag_xo_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_xo_idx].ToUnifiedFormat(input.size(), tag_xo_data);
-	}
-	if (indices.tag_xg_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_xg_idx].ToUnifiedFormat(input.size(), tag_xg_data);
-	}
-	if (indices.tag_nm_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_nm_idx].ToUnifiedFormat(input.size(), tag_nm_data);
-	}
-	if (indices.tag_yt_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_yt_idx].ToUnifiedFormat(input.size(), tag_yt_data);
-	}
-	if (indices.tag_md_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_md_idx].ToUnifiedFormat(input.size(), tag_md_data);
+	// Optional tags, in the order they are emitted
+	array<SAMIntegerTagColumn, 8> integer_tags {{{"AS", nullptr, {}},
+	                                             {"XS", nullptr, {}},
+	                                             {"YS", nullptr, {}},
+	                                             {"XN", nullptr, {}},
+	                                             {"XM", nullptr, {}},
+	                                             {"XO", nullptr, {}},
+	                                             {"XG", nullptr, {}},
+	                                             {"NM", nullptr, {}}}};
+	const idx_t integer_tag_indices[] = {indices.tag_as_idx, indices.tag_xs_idx, indices.tag_ys_idx,
+	                                     indices.tag_xn_idx, indices.tag_xm_idx, indices.tag_xo_idx,
+	                                     indices.tag_xg_idx, indices.tag_nm_idx};
+	for (idx_t t = 0; t < integer_tags.size(); t++) {
+		if (integer_tag_indices[t] != DConstants::INVALID_INDEX) {
+			input.data[integer_tag_indices[t]].ToUnifiedFormat(input.size(), integer_tags[t].format);
+			integer_tags[t].data = UnifiedVectorFormat::GetData<int64_t>(integer_tags[t].format);
+		}
 	}
-	if (indices.tag_sa_idx != DConstants::INVALID_INDEX) {
-		input.data[indices.tag_sa_idx].ToUnifiedFormat(input.size(), tag_sa_data);
+	array<SAMStringTagColumn, 3> string_tags {{{"YT", nullptr, {}}, {"MD", nullptr, {}}, {"SA", nullptr, {}}}};
+	const idx_t string_tag_indices[] = {indices.tag_yt_idx, indices.tag_md_idx, indices.tag_sa_idx};
+	for (idx_t t = 0; t < string_tags.size(); t++) {
+		if (string_tag_indices[t] != DConstants::INVALID_INDEX) {
+			input.data[string_tag_indices[t]].ToUnifiedFormat(input.size(), string_tags[t].format);
+			string_tags[t].data = UnifiedVectorFormat::GetData<string_t>(string_tags[t].format);
+		}
 	}
 
 	auto read_id_ptr = UnifiedVectorFormat::GetData<string_t>(read_id_data);
@@ -569,129 +751,108 @@ static void SAMCopySink(ExecutionContext &context, FunctionData &bind_data, Glob
 	auto mate_position_ptr = UnifiedVectorFormat::GetData<int64_t>(mate_position_data);
 	auto template_length_ptr = UnifiedVectorFormat::GetData<int64_t>(template_length_data);
 
-	auto tag_as_ptr =
-	    indices.tag_as_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<int64_t>(tag_as_data) : nullptr;
-	auto tag_xs_ptr =
-	    indices.tag_xs_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<int64_t>(tag_xs_data) : nullptr;
-	auto tag_ys_ptr =
-	    indices.tag_ys_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<int64_t>(tag_ys_data) : nullptr;
-	auto tag_xn_ptr =
-	    indices.tag_xn_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<int64_t>(tag_xn_data) : nullptr;
-	auto tag_xm_ptr =
-	    indices.tag_xm_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<int64_t>(tag_xm_data) : nullptr;
-	auto tag_xo_ptr =
-	    indices.tag_xo_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<int64_t>(tag_xo_data) : nullptr;
-	auto tag_xg_ptr =
-	    indices.tag_xg_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<int64_t>(tag_xg_data) : nullptr;
-	auto tag_nm_ptr =
-	    indices.tag_nm_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<int64_t>(tag_nm_data) : nullptr;
-	auto tag_yt_ptr =
-	    indices.tag_yt_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<string_t>(tag_yt_data) : nullptr;
-	auto tag_md_ptr =
-	    indices.tag_md_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<string_t>(tag_md_data) : nullptr;
-	auto tag_sa_ptr =
-	    indices.tag_sa_idx != DConstants::INVALID_INDEX ? UnifiedVectorFormat::GetData<string_t>(tag_sa_data) : nullptr;
-
-	// Write header once (first thread to arrive)
-	if (!gstate.header_written.load()) {
-		lock_guard<mutex> glock(gstate.write_lock);
-		if (!gstate.header_written.load()) {
-			if (fdata.include_header) {
-				if (sam_hdr_write(gstate.sam_file.get(), gstate.header.get()) < 0) {
-					throw IOException("Failed to write SAM header");
-				}
-			}
-			gstate.header_written.store(true);
-		}
-	}
+	bool is_bam = fdata.format == SAMOutputFormat::BAM;
 
 	// Process each row
 	for (idx_t i = 0; i < input.size(); i++) {
-		auto read_id_idx = read_id_data.sel->get_index(i);
-		auto flags_idx = flags_data.sel->get_index(i);
-		auto reference_idx = reference_data.sel->get_index(i);
-		auto position_idx = position_data.sel->get_index(i);
-		auto mapq_idx = mapq_data.sel->get_index(i);
-		auto cigar_idx = cigar_data.sel->get_index(i);
-		auto mate_reference_idx = mate_reference_data.sel->get_index(i);
-		auto mate_position_idx = mate_position_data.sel->get_index(i);
-		auto template_length_idx = template_length_data.sel->get_index(i);
-
-		string read_id = read_id_ptr[read_id_idx].GetString();
-		uint16_t flags = flags_ptr[flags_idx];
-		string reference = reference_ptr[reference_idx].GetString();
-		int64_t position = position_ptr[position_idx];
-		uint8_t mapq = mapq_ptr[mapq_idx];
-		string cigar_str = cigar_ptr[cigar_idx].GetString();
-		string mate_reference = mate_reference_ptr[mate_reference_idx].GetString();
-		int64_t mate_position = mate_position_ptr[mate_position_idx];
-		int64_t template_length = template_length_ptr[template_length_idx];
-
-		// Parse CIGAR
-		if (!ParseCIGAR(cigar_str, lstate.cigar_buffer)) {
-			throw InvalidInputException("Failed to parse CIGAR string '%s' for read: %s", cigar_str, read_id);
-		}
+		auto &read_id = read_id_ptr[read_id_data.sel->get_index(i)];
+		uint16_t flags = flags_ptr[flags_data.sel->get_index(i)];
+		auto &reference = reference_ptr[reference_data.sel->get_index(i)];
+		int64_t position = position_ptr[position_data.sel->get_index(i)];
+		uint8_t mapq = mapq_ptr[mapq_data.sel->get_index(i)];
+		auto &cigar = cigar_ptr[cigar_data.sel->get_index(i)];
+		auto &mate_reference = mate_reference_ptr[mate_reference_data.sel->get_index(i)];
+		int64_t mate_position = mate_position_ptr[mate_position_data.sel->get_index(i)];
+		int64_t template_length = template_length_ptr[template_length_data.sel->get_index(i)];
 
 		// Validate position values before casting
 		if (position < 0) {
 			throw InvalidInputException("Invalid position value %lld for read: %s (must be non-negative)", position,
-			                            read_id);
+			                            read_id.GetString());
 		}
 		if (position > 0 && (position - 1) > HTS_POS_MAX) {
 			throw InvalidInputException("Position value %lld exceeds maximum allowed position for read: %s", position,
-			                            read_id);
+			                            read_id.GetString());
 		}
 		if (mate_position < 0) {
 			throw InvalidInputException("Invalid mate_position value %lld for read: %s (must be non-negative)",
-			                            mate_position, read_id);
+			                            mate_position, read_id.GetString());
 		}
 		if (mate_position > 0 && (mate_position - 1) > HTS_POS_MAX) {
 			throw InvalidInputException("Mate position value %lld exceeds maximum allowed position for read: %s",
-			                            mate_position, read_id);
+			                            mate_position, read_id.GetString());
+		}
+
+		if (!is_bam) {
+			// Format straight from the vectors into the thread-local buffer - NO LOCK
+			if (!IsValidCIGAR(cigar.GetData(), cigar.GetSize())) {
+				throw InvalidInputException("Failed to parse CIGAR string '%s' for read: %s", cigar.GetString(),
+				                            read_id.GetString());
+			}
+			if (read_id.GetSize() > 254) {
+				throw InvalidInputException("Read name exceeds 254 characters: %s", read_id.GetString());
+			}
+			WriteSAMRecord(*lstate.writer_state->stream, read_id, flags, reference, position, mapq, cigar,
+			               mate_reference, mate_position, template_length, integer_tags, string_tags, i);
+			lstate.writer_state->written_anything = true;
+			continue;
+		}
+
+		string read_id_str = read_id.GetString();
+		string cigar_str = cigar.GetString();
+
+		// Parse CIGAR
+		if (!ParseCIGAR(cigar_str, lstate.cigar_buffer)) {
+			throw InvalidInputException("Failed to parse CIGAR string '%s' for read: %s", cigar_str, read_id_str);
 		}
 
 		// Get reference TIDs
-		int32_t tid = GetReferenceTID(gstate.header.get(), reference);
+		int32_t tid = GetBAMReferenceTID(gstate, reference.GetString());
 
 		// Handle mate_reference: "=" means same as reference
 		int32_t mtid;
-		if (mate_reference == "=") {
+		if (mate_reference.GetSize() == 1 && mate_reference.GetData()[0] == '=') {
 			mtid = tid;
 		} else {
-			mtid = GetReferenceTID(gstate.header.get(), mate_reference);
+			mtid = GetBAMReferenceTID(gstate, mate_reference.GetString());
 		}
 
 		// Build bam1_t record
 		// Note: SEQ and QUAL are "*" (represented as NULL/0-length in bam_set1)
 		// l_qname is the length WITHOUT null terminator (bam_set1 adds it internally)
-		if (bam_set1(lstate.record.get(), read_id.length(), read_id.c_str(), flags, tid,
+		if (bam_set1(lstate.record.get(), read_id_str.length(), read_id_str.c_str(), flags, tid,
 		             static_cast<hts_pos_t>(position - 1), // Convert to 0-based
 		             mapq, lstate.cigar_buffer.size(), lstate.cigar_buffer.data(), mtid,
 		             static_cast<hts_pos_t>(mate_position - 1), // Convert to 0-based
 		             static_cast<hts_pos_t>(template_length), 0, "*", "*", 0) < 0) {
-			throw IOException("Failed to build BAM record for read: " + read_id);
+			throw IOException("Failed to build BAM record for read: " + read_id_str);
 		}
 
 		// Add optional tags
-		AppendIntegerTag(lstate.record.get(), "AS", tag_as_ptr, tag_as_data, i, read_id);
-		AppendIntegerTag(lstate.record.get(), "XS", tag_xs_ptr, tag_xs_data, i, read_id);
-		AppendIntegerTag(lstate.record.get(), "YS", tag_ys_ptr, tag_ys_data, i, read_id);
-		AppendIntegerTag(lstate.record.get(), "XN", tag_xn_ptr, tag_xn_data, i, read_id);
-		AppendIntegerTag(lstate.record.get(), "XM", tag_xm_ptr, tag_xm_data, i, read_id);
-		AppendIntegerTag(lstate.record.get(), "XO", tag_xo_ptr, tag_xo_data, i, read_id);
-		AppendIntegerTag(lstate.record.get(), "XG", tag_xg_ptr, tag_xg_data, i, read_id);
-		AppendIntegerTag(lstate.record.get(), "NM", tag_nm_ptr, tag_nm_data, i, read_id);
-		AppendStringTag(lstate.record.get(), "YT", tag_yt_ptr, tag_yt_data, i, read_id);
-		AppendStringTag(lstate.record.get(), "MD", tag_md_ptr, tag_md_data, i, read_id);
-		AppendStringTag(lstate.record.get(), "SA", tag_sa_ptr, tag_sa_data, i, read_id);
-
-		// Write record (with lock for thread safety on file I/O)
-		{
-			lock_guard<mutex> glock(gstate.write_lock);
-			if (sam_write1(gstate.sam_file.get(), gstate.header.get(), lstate.record.get()) < 0) {
-				throw IOException("Failed to write SAM record for read: " + read_id);
+		for (auto &tag : integer_tags) {
+			AppendIntegerTag(lstate.record.get(), tag.name, tag.data, tag.format, i, read_id_str);
+		}
+		for (auto &tag : string_tags) {
+			AppendStringTag(lstate.record.get(), tag.name, tag.data, tag.format, i, read_id_str);
+		}
+
+		if (lstate.sort_state) {
+			// Buffer for sorting; full buffers are sorted and spilled as a run
+			if (lstate.sort_state->Append(lstate.record.get(), read_id_str)) {
+				gstate.sorter->Spill(*lstate.sort_state);
 			}
+			continue;
 		}
+
+		// Serialize into the thread-local buffer - NO LOCK
+		SerializeBAMRecord(lstate.record.get(), *lstate.writer_state->stream, read_id_str);
+		lstate.writer_state->written_anything = true;
+	}
+
+	// Append full buffers (compressing first for BAM and gzipped SAM)
+	auto &writer_state = lstate.writer_state;
+	if (writer_state && writer_state->stream->GetPosition() >= writer_state->flush_size) {
+		FlushFormatBuffer(*writer_state, *gstate.file, gstate.write_lock);
 	}
 }
 
@@ -700,7 +861,16 @@ static void SAMCopySink(ExecutionContext &context, FunctionData &bind_data, Glob
 //===--------------------------------------------------------------------===//
 static void SAMCopyCombine(ExecutionContext &context, FunctionData &bind_data, GlobalFunctionData &gstate_p,
                            LocalFunctionData &lstate_p) {
-	// HTSlib handles buffering internally, nothing to combine
+	auto &gstate = gstate_p.Cast<SAMCopyGlobalState>();
+	auto &lstate = lstate_p.Cast<SAMCopyLocalState>();
+
+	// Flush remaining formatted records, or spill the final sorted run
+	if (lstate.writer_state) {
+		FlushFormatBuffer(*lstate.writer_state, *gstate.file, gstate.write_lock);
+	}
+	if (lstate.sort_state) {
+		gstate.sorter->Spill(*lstate.sort_state);
+	}
 }
 
 //===--------------------------------------------------------------------===//
@@ -710,14 +880,13 @@ static void SAMCopyFinalize(ClientContext &context, FunctionData &bind_data, Glo
 	auto &fdata = bind_data.Cast<SAMCopyBindData>();
 	auto &gstate = gstate_p.Cast<SAMCopyGlobalState>();
 
-	// Write header if we haven't written anything yet (empty file with header)
-	if (!gstate.header_written.load() && fdata.include_header) {
-		if (sam_hdr_write(gstate.sam_file.get(), gstate.header.get()) < 0) {
-			throw IOException("Failed to write SAM header for empty file");
-		}
+	// Sorted BAM: merge the spilled runs (building the index as blocks are written)
+	if (gstate.sorter) {
+		gstate.sorter->Merge(*gstate.file, gstate.header.get(), fdata.write_index, gstate.file_path);
 	}
 
-	// File is closed automatically by smart pointer destructor
+	// Appends the BGZF EOF block for BAM and gzipped SAM
+	gstate.file->Close();
 }
 
 //===--------------------------------------------------------------------===//
@@ -731,6 +900,7 @@ CopyFunction CopySAMFunction::GetFunction() {
 	function.copy_to_sink = SAMCopySink;
 	function.copy_to_combine = SAMCopyCombine;
 	function.copy_to_finalize = SAMCopyFinalize;
+	function.execution_mode = SequenceCopyExecutionMode;
 	function.extension = "sam";
 
 	return function;
@@ -744,6 +914,7 @@ CopyFunction CopySAMFunction::GetBAMFunction() {
 	function.copy_to_sink = SAMCopySink;
 	function.copy_to_combine = SAMCopyCombine;
 	function.copy_to_finalize = SAMCopyFinalize;
+	function.execution_mode = SequenceCopyExecutionMode;
 	function.extension = "bam";
 
 	return function;
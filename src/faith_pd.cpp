@@ -0,0 +1,153 @@
+#include "faith_pd.hpp"
+#include "tree_registry.hpp"
+#include "duckdb/common/types/vector.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/aggregate_function.hpp"
+#include <algorithm>
+
+namespace duckdb {
+
+// Distinct tips of the features added. Tips are appended as they come and the list is sorted and deduplicated
+// whenever the appended part outgrows the deduplicated one, and after every Combine, so a state never holds more
+// than about twice the tips of the tree, however many rows its group has.
+struct FaithPDState {
+	std::vector<uint32_t> *tips;
+	size_t n_unique; // tips[0, n_unique) are sorted and distinct
+
+	FaithPDState() : tips(nullptr), n_unique(0) {
+	}
+
+	// Below this many tips a state is not compacted
+	static constexpr size_t MIN_COMPACT = 64;
+
+	void Compact() {
+		std::sort(tips->begin(), tips->end());
+		tips->erase(std::unique(tips->begin(), tips->end()), tips->end());
+		n_unique = tips->size();
+	}
+
+	void Add(uint32_t tip) {
+		tips->push_back(tip);
+		if (tips->size() >= 2 * MaxValue<size_t>(n_unique, MIN_COMPACT)) {
+			Compact();
+		}
+	}
+};
+
+struct FaithPDBindData : public FunctionData {
+	std::string tree_path;
+	shared_ptr<const miint::FaithPDTree> tree;
+
+	FaithPDBindData(std::string tree_path_p, shared_ptr<const miint::FaithPDTree> tree_p)
+	    : tree_path(std::move(tree_path_p)), tree(std::move(tree_p)) {
+	}
+
+	unique_ptr<FunctionData> Copy() const override {
+		return make_uniq<FaithPDBindData>(tree_path, tree);
+	}
+
+	bool Equals(const FunctionData &other_p) const override {
+		return tree_path == other_p.Cast<FaithPDBindData>().tree_path;
+	}
+};
+
+static unique_ptr<FunctionData> FaithPDBind(ClientContext &context, AggregateFunction &function,
+                                            vector<unique_ptr<Expression>> &arguments) {
+	if (!arguments[1]->IsFoldable()) {
+		throw BinderException("faith_pd: tree must be a constant path, not a column reference");
+	}
+	auto tree_value = ExpressionExecutor::EvaluateScalar(context, *arguments[1]);
+	if (tree_value.IsNull()) {
+		throw BinderException("faith_pd: tree must not be NULL");
+	}
+	auto tree_path = tree_value.ToString();
+
+	// A tree registered by miint_load_tree is used as is; anything else is a path parsed for this query
+	auto tree = TreeRegistry::Resolve(context, tree_path, "faith_pd")->FaithPD();
+
+	// Only the feature ids are passed to the aggregate
+	Function::EraseArgument(function, arguments, 1);
+	return make_uniq<FaithPDBindData>(std::move(tree_path), std::move(tree));
+}
+
+struct FaithPDOperation {
+	template <class STATE>
+	static void Initialize(STATE &state) {
+		state.tips = new std::vector<uint32_t>();
+	}
+
+	template <class STATE>
+	static void Destroy(STATE &state, AggregateInputData &aggr_input_data) {
+		delete state.tips;
+	}
+
+	static void Operation(Vector inputs[], AggregateInputData &aggr_input_data, idx_t input_count, Vector &states,
+	                      idx_t count) {
+		auto &tree = *aggr_input_data.bind_data->Cast<FaithPDBindData>().tree;
+
+		UnifiedVectorFormat feature_data;
+		inputs[0].ToUnifiedFormat(count, feature_data);
+		auto feature_ptr = UnifiedVectorFormat::GetData<string_t>(feature_data);
+
+		UnifiedVectorFormat state_data;
+		states.ToUnifiedFormat(count, state_data);
+		auto state_ptr = UnifiedVectorFormat::GetData<FaithPDState *>(state_data);
+
+		for (idx_t i = 0; i < count; i++) {
+			auto feature_idx = feature_data.sel->get_index(i);
+			if (!feature_data.validity.RowIsValid(feature_idx)) {
+				continue;
+			}
+			auto &feature = feature_ptr[feature_idx];
+			auto tip = tree.tip(std::string_view(feature.GetData(), feature.GetSize()));
+			if (tip == miint::FaithPDTree::NOT_A_TIP) {
+				throw InvalidInputException("faith_pd: feature '%s' is not a tip of the tree", feature.GetString());
+			}
+			if (tip == miint::FaithPDTree::AMBIGUOUS_TIP) {
+				throw InvalidInputException("faith_pd: feature '%s' names more than one tip of the tree",
+				                            feature.GetString());
+			}
+			state_ptr[state_data.sel->get_index(i)]->Add(tip);
+		}
+	}
+
+	template <class STATE, class OP>
+	static void Combine(const STATE &source, STATE &target, AggregateInputData &aggr_input_data) {
+		target.tips->insert(target.tips->end(), source.tips->begin(), source.tips->end());
+		target.Compact();
+	}
+
+	static void Finalize(Vector &state_vector, AggregateInputData &aggr_input_data, Vector &result, idx_t count,
+	                     idx_t offset) {
+		auto &tree = *aggr_input_data.bind_data->Cast<FaithPDBindData>().tree;
+
+		UnifiedVectorFormat state_data;
+		state_vector.ToUnifiedFormat(count, state_data);
+		auto states = UnifiedVectorFormat::GetData<FaithPDState *>(state_data);
+		auto result_data = FlatVector::GetData<double>(result);
+
+		// One bitmap for the whole batch of states; pd leaves it cleared
+		std::vector<uint64_t> visited(tree.bitmap_words(), 0);
+		for (idx_t i = 0; i < count; i++) {
+			auto &state = *states[state_data.sel->get_index(i)];
+			result_data[i + offset] = tree.pd(*state.tips, visited);
+		}
+	}
+
+	static bool IgnoreNull() {
+		return true;
+	}
+};
+
+void FaithPDFunction::Register(ExtensionLoader &loader) {
+	auto fun = AggregateFunction(
+	    "faith_pd", {LogicalType::VARCHAR, LogicalType::VARCHAR}, LogicalType::DOUBLE,
+	    AggregateFunction::StateSize<FaithPDState>, AggregateFunction::StateInitialize<FaithPDState, FaithPDOperation>,
+	    FaithPDOperation::Operation, AggregateFunction::StateCombine<FaithPDState, FaithPDOperation>,
+	    FaithPDOperation::Finalize, nullptr, FaithPDBind,
+	    AggregateFunction::StateDestroy<FaithPDState, FaithPDOperation>);
+
+	loader.RegisterFunction(fun);
+}
+
+} // namespace duckdb
@@ -0,0 +1,209 @@
+#include "feature_table_reader.hpp"
+#include "duckdb/catalog/catalog.hpp"
+#include "duckdb/catalog/catalog_entry/table_catalog_entry.hpp"
+#include "duckdb/catalog/catalog_entry/view_catalog_entry.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/data_chunk.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/main/database.hpp"
+#include "duckdb/main/query_result.hpp"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+namespace duckdb {
+
+FeatureTableColumns ParseFeatureTableColumns(const named_parameter_map_t &named_parameters) {
+	FeatureTableColumns columns;
+	for (auto column : {&columns.sample_id, &columns.feature_id, &columns.value}) {
+		// The parameter is named after the default column name
+		auto param = named_parameters.find(*column);
+		if (param != named_parameters.end() && !param->second.IsNull()) {
+			*column = param->second.ToString();
+		}
+	}
+	return columns;
+}
+
+void ValidateFeatureTable(ClientContext &context, const std::string &table_name, const FeatureTableColumns &columns) {
+	EntryLookupInfo lookup_info(CatalogType::TABLE_ENTRY, table_name, QueryErrorContext());
+	auto entry = Catalog::GetEntry(context, INVALID_CATALOG, INVALID_SCHEMA, lookup_info, OnEntryNotFound::RETURN_NULL);
+
+	if (!entry) {
+		throw BinderException("Table or view '%s' does not exist", table_name);
+	}
+	// ReadFeatureTable goes through a separate connection, which sees neither temporary tables nor tables created by
+	// the current transaction before it commits; look the table up the same way
+	if (entry->ParentCatalog().IsTemporaryCatalog()) {
+		throw BinderException("'%s' is a temporary table or view, which cannot be read here; copy it into a regular "
+		                      "table first",
+		                      table_name);
+	}
+	Connection conn(DatabaseInstance::GetDatabase(context));
+	bool visible = false;
+	try {
+		conn.context->RunFunctionInTransaction([&]() {
+			visible = Catalog::GetEntry(*conn.context, INVALID_CATALOG, INVALID_SCHEMA, lookup_info,
+			                            OnEntryNotFound::RETURN_NULL) != nullptr;
+		});
+	} catch (const CatalogException &) {
+		visible = false;
+	}
+	if (!visible) {
+		throw BinderException("'%s' was created by a transaction that has not committed yet, which cannot be read "
+		                      "here; commit the transaction first",
+		                      table_name);
+	}
+
+	vector<string> col_names;
+	if (entry->type == CatalogType::TABLE_ENTRY) {
+		auto &table = entry->Cast<TableCatalogEntry>();
+		auto &table_columns = table.GetColumns();
+		for (idx_t i = 0; i < table_columns.LogicalColumnCount(); i++) {
+			col_names.push_back(StringUtil::Lower(table_columns.GetColumn(LogicalIndex(i)).Name()));
+		}
+	} else if (entry->type == CatalogType::VIEW_ENTRY) {
+		auto &view = entry->Cast<ViewCatalogEntry>();
+		for (const auto &name : view.names) {
+			col_names.push_back(StringUtil::Lower(name));
+		}
+	} else {
+		throw BinderException("'%s' is not a table or view", table_name);
+	}
+
+	for (const auto &column : {columns.sample_id, columns.feature_id, columns.value}) {
+		if (std::find(col_names.begin(), col_names.end(), StringUtil::Lower(column)) == col_names.end()) {
+			throw BinderException("Table '%s' missing required column '%s'", table_name, column);
+		}
+	}
+}
+
+// Index of id in ids, adding it when new
+static uint32_t InternID(std::unordered_map<std::string, uint32_t> &index, std::vector<std::string> &ids,
+                         const string_t &id) {
+	auto result = index.emplace(id.GetString(), static_cast<uint32_t>(ids.size()));
+	if (result.second) {
+		ids.push_back(result.first->first);
+	}
+	return result.first->second;
+}
+
+// Sort ids in place and return the new position of each original index
+static std::vector<uint32_t> SortIDs(std::vector<std::string> &ids) {
+	std::vector<uint32_t> order(ids.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return ids[a] < ids[b]; });
+
+	std::vector<uint32_t> rank(ids.size());
+	std::vector<std::string> sorted(ids.size());
+	for (uint32_t i = 0; i < order.size(); i++) {
+		rank[order[i]] = i;
+		sorted[i] = std::move(ids[order[i]]);
+	}
+	ids = std::move(sorted);
+	return rank;
+}
+
+FeatureTable ReadFeatureTable(ClientContext &context, const std::string &table_name,
+                              const FeatureTableColumns &columns) {
+	// Separate connection: the current context is locked while binding and initializing (see ReadReferenceTable)
+	auto &db = DatabaseInstance::GetDatabase(context);
+	Connection conn(db);
+
+	std::string query = "SELECT CAST(" + KeywordHelper::WriteOptionallyQuoted(columns.sample_id) +
+	                    " AS VARCHAR), CAST(" + KeywordHelper::WriteOptionallyQuoted(columns.feature_id) +
+	                    " AS VARCHAR), CAST(" + KeywordHelper::WriteOptionallyQuoted(columns.value) +
+	                    " AS DOUBLE) FROM " + KeywordHelper::WriteOptionallyQuoted(table_name);
+	auto query_result = conn.Query(query);
+	if (query_result->HasError()) {
+		throw InvalidInputException("Failed to read from feature table '%s': %s", table_name,
+		                            query_result->GetError());
+	}
+	auto &materialized = query_result->Cast<MaterializedQueryResult>();
+
+	FeatureTable table;
+	std::unordered_map<std::string, uint32_t> sample_index;
+	std::unordered_map<std::string, uint32_t> feature_index;
+	std::vector<uint32_t> row_samples;
+	std::vector<uint32_t> row_features;
+	std::vector<double> row_values;
+	idx_t row_number = 0;
+
+	while (auto chunk = materialized.Fetch()) {
+		if (chunk->size() == 0) {
+			break;
+		}
+		UnifiedVectorFormat sample_data, feature_data, value_data;
+		chunk->data[0].ToUnifiedFormat(chunk->size(), sample_data);
+		chunk->data[1].ToUnifiedFormat(chunk->size(), feature_data);
+		chunk->data[2].ToUnifiedFormat(chunk->size(), value_data);
+		auto sample_ptr = UnifiedVectorFormat::GetData<string_t>(sample_data);
+		auto feature_ptr = UnifiedVectorFormat::GetData<string_t>(feature_data);
+		auto value_ptr = UnifiedVectorFormat::GetData<double>(value_data);
+
+		for (idx_t i = 0; i < chunk->size(); i++) {
+			row_number++;
+			auto sample_idx = sample_data.sel->get_index(i);
+			auto feature_idx = feature_data.sel->get_index(i);
+			auto value_idx = value_data.sel->get_index(i);
+			if (!sample_data.validity.RowIsValid(sample_idx) || !feature_data.validity.RowIsValid(feature_idx) ||
+			    !value_data.validity.RowIsValid(value_idx)) {
+				throw InvalidInputException("NULL sample, feature or value at row %llu in table '%s'", row_number,
+				                            table_name);
+			}
+			if (value_ptr[value_idx] == 0) {
+				continue;
+			}
+			row_samples.push_back(InternID(sample_index, table.sample_ids, sample_ptr[sample_idx]));
+			row_features.push_back(InternID(feature_index, table.feature_ids, feature_ptr[feature_idx]));
+			row_values.push_back(value_ptr[value_idx]);
+		}
+	}
+	sample_index.clear();
+	feature_index.clear();
+
+	auto sample_rank = SortIDs(table.sample_ids);
+	auto feature_rank = SortIDs(table.feature_ids);
+
+	// Counting sort of the rows by sample
+	std::vector<uint64_t> offsets(table.sample_ids.size() + 1, 0);
+	for (auto sample : row_samples) {
+		offsets[sample_rank[sample] + 1]++;
+	}
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+	std::vector<std::pair<uint32_t, double>> entries(row_values.size());
+	{
+		auto next = offsets;
+		for (size_t r = 0; r < row_values.size(); r++) {
+			entries[next[sample_rank[row_samples[r]]]++] = {feature_rank[row_features[r]], row_values[r]};
+		}
+	}
+
+	// Sort each sample by feature, adding up repeated features
+	table.indptr.reserve(offsets.size());
+	table.indptr.push_back(0);
+	table.features.reserve(entries.size());
+	table.values.reserve(entries.size());
+	for (size_t s = 0; s + 1 < offsets.size(); s++) {
+		auto begin = entries.begin() + offsets[s];
+		auto end = entries.begin() + offsets[s + 1];
+		std::sort(begin, end, [](const std::pair<uint32_t, double> &a, const std::pair<uint32_t, double> &b) {
+			return a.first < b.first;
+		});
+		uint64_t sample_begin = table.features.size();
+		for (auto it = begin; it != end; ++it) {
+			if (table.features.size() > sample_begin && table.features.back() == it->first) {
+				table.values.back() += it->second;
+			} else {
+				table.features.push_back(it->first);
+				table.values.push_back(it->second);
+			}
+		}
+		table.indptr.push_back(table.features.size());
+	}
+
+	return table;
+}
+
+} // namespace duckdb
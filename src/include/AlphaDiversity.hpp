@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+namespace miint {
+
+// Streaming state of the alpha diversity of one sample: each call to Add is the count of one feature.
+// Every metric is derived from a few sums, so states of the same sample built on different threads are
+// combined exactly by Merge, and the counts never need to be kept.
+struct AlphaDiversity {
+	double total = 0;       // sum of counts
+	double sum_c_log_c = 0; // sum of c * ln(c)
+	double sum_c2 = 0;      // sum of c^2
+	uint64_t observed = 0;  // features with a non-zero count
+	uint64_t singletons = 0;
+	uint64_t doubletons = 0;
+
+	// Counts must be non-negative; zero counts are ignored
+	void Add(double count);
+	void Merge(const AlphaDiversity &other);
+	bool Empty() const {
+		return observed == 0;
+	}
+
+	// Shannon entropy, natural log: -sum(p * ln p) = ln(N) - sum(c * ln c) / N
+	double Shannon() const;
+	// Gini-Simpson index: 1 - sum(p^2)
+	double Simpson() const;
+	// Bias-corrected Chao1 richness estimate: S_obs + F1 * (F1 - 1) / (2 * (F2 + 1))
+	double Chao1() const;
+};
+
+} // namespace miint
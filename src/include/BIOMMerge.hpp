@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace miint {
+
+struct BIOMMergeOptions {
+	std::string id = "No Table ID";
+	std::string generated_by = "miint";
+	bool use_compression = true;
+	// Matrix entries held in memory at a time, per buffer; bounds the memory of a merge independently of the
+	// size of the inputs
+	uint64_t block_entries = 1 << 22;
+};
+
+struct BIOMMergeSummary {
+	size_t n_samples = 0;
+	size_t n_features = 0;
+	uint64_t nnz = 0;
+};
+
+// Merge BIOM files with disjoint samples into a new BIOM 2.1 file at output, which must not exist.
+//
+// The feature IDs of the output are the sorted union of the inputs' feature IDs, built with a k-way merge of
+// each input's sorted IDs; this also yields, per input, the permutation from its feature indices to the merged
+// ones. Samples keep their order, input by input, so sample/matrix is the inputs' CSC column blocks
+// concatenated, with the feature indices remapped (and re-sorted within a column where the permutation does
+// not preserve order). observation/matrix is filled a block of features at a time, so only block_entries entries
+// are held at once: each merged feature's row is the inputs' observation/matrix rows for it, concatenated in
+// input order with the input's sample offset added, so every input row is read once and needs no sorting. Inputs
+// lacking observation/matrix fall back to a scan of their sample/matrix per block. hdf5_lock() is held around the
+// HDF5 reads and writes only: decoding, the ID union, sorting and deflating the output's chunks run without it.
+// Throws std::runtime_error if a sample appears in more than one input, and removes the partially written output
+// on any failure.
+BIOMMergeSummary biom_merge(const std::vector<std::string> &inputs, const std::string &output,
+                            const BIOMMergeOptions &options = BIOMMergeOptions());
+
+} // namespace miint
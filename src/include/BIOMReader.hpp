@@ -4,6 +4,7 @@
 #include <string>
 #include <memory>
 #include "BIOMTable.hpp"
+#include "HDF5Chunks.hpp"
 #include <hdf5.h>
 
 namespace miint {
@@ -19,6 +20,32 @@ static constexpr const char *SAMPLE_INDICES = "/sample/matrix/indices";
 static constexpr const char *SAMPLE_DATA = "/sample/matrix/data";
 static constexpr const char *SAMPLE_IDS = "/sample/ids";
 
+// The two compressed forms of the matrix stored in a BIOM file: sample/matrix holds each sample's
+// features (CSC), observation/matrix holds each feature's samples (CSR)
+enum class BIOMAxis { SAMPLE, OBSERVATION };
+
+// A run of entries of one of the compressed matrices: the minor-axis index and value of each entry
+struct BIOMEntries {
+	std::vector<int32_t> indices;
+	std::vector<double> data;
+
+	size_t size() const {
+		return data.size();
+	}
+};
+
+// Entries [begin, end) of one of the matrices as stored in the file. Chunked datasets are kept as raw
+// chunks so that decoding can happen away from the HDF5 lock; anything else is read already decoded.
+struct BIOMRawEntries {
+	BIOMAxis axis = BIOMAxis::SAMPLE;
+	uint64_t begin = 0;
+	uint64_t end = 0;
+	bool direct = false;
+	HDF5RawRange indices;
+	HDF5RawRange data;
+	BIOMEntries decoded;
+};
+
 class BIOMReader {
 private:
 	hid_t file_handle;
@@ -27,11 +54,46 @@ private:
 	hid_t ds_data;
 	hid_t ds_samp_ids;
 	hid_t ds_obs_ids;
+	HDF5ChunkLayout indices_layout;
+	HDF5ChunkLayout data_layout;
+	// observation/matrix is optional: absent from some writers' files
+	hid_t ds_obs_indices = -1;
+	hid_t ds_obs_indptr = -1;
+	hid_t ds_obs_data = -1;
+	HDF5ChunkLayout obs_indices_layout;
+	HDF5ChunkLayout obs_data_layout;
+
+	struct Matrix {
+		hid_t indices;
+		hid_t indptr;
+		hid_t data;
+		const HDF5ChunkLayout &indices_layout;
+		const HDF5ChunkLayout &data_layout;
+		const char *indptr_name;
+		const char *indices_name;
+	};
+	Matrix matrix(BIOMAxis axis) const;
 
 public:
 	explicit BIOMReader(const std::string &path1);
 	~BIOMReader();
 	BIOMTable read() const;
 	static bool IsBIOM(const std::string &path);
+
+	// Streaming access to the compressed matrices. The IDs and pointers are O(samples + features); entries
+	// are read a range at a time, so memory stays bounded by the range.
+	std::vector<std::string> read_sample_ids() const;
+	std::vector<std::string> read_feature_ids() const;
+	bool has_observation_matrix() const;
+	// n_major + 1 entry offsets, validated to be non-decreasing and to end at the number of entries
+	std::vector<int32_t> read_indptr(BIOMAxis axis) const;
+	// Entries [begin, end) of a matrix, in storage order
+	void read_entries(BIOMAxis axis, uint64_t begin, uint64_t end, BIOMEntries &out) const;
+
+	// Two-step form of read_entries for concurrent scans: read_entries_raw performs all of the HDF5 I/O
+	// and must be serialized like any other HDF5 call; decode_entries only decompresses and converts, and
+	// may run on several threads at once.
+	void read_entries_raw(BIOMAxis axis, uint64_t begin, uint64_t end, BIOMRawEntries &out) const;
+	void decode_entries(BIOMRawEntries &raw, BIOMEntries &out) const;
 };
 } // namespace miint
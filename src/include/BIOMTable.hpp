@@ -1,6 +1,7 @@
 #include <vector>
 #include <hdf5.h>
 #include <string>
+#include "Parallel.hpp"
 
 namespace miint {
 
@@ -18,20 +19,28 @@ struct SparseMatrix {
 	}
 };
 
+// A BIOM table in its native sample/matrix layout: compressed sparse columns with one column per sample and
+// int32 feature indices, sorted within each column, without duplicates or zeros. That is how BIOM files store
+// it, so a file is loaded without expanding the entries, and 12 bytes per entry are kept rather than the 24 of
+// (feature, sample, value) triplets.
 class BIOMTable {
 public:
 	BIOMTable(hid_t indices, hid_t indptr, hid_t data, hid_t obs_ids, hid_t samp_ids);
 	BIOMTable(const std::vector<std::string> &feature_ids, const std::vector<std::string> &sample_ids,
 	          const std::vector<double> &values);
 	// Constructor accepting pre-computed integer indices and ordered ID lists
-	// Optimized for performance - skips string hashing that happens in string-based constructor
-	BIOMTable(const std::vector<size_t> &feature_indices, const std::vector<size_t> &sample_indices,
-	          const std::vector<double> &values, std::vector<std::string> feature_ids_ordered,
-	          std::vector<std::string> sample_ids_ordered);
+	// Optimized for performance - skips string hashing that happens in string-based constructor.
+	// The triplets are sorted with a counting sort split over n_threads threads. Index is size_t or uint32_t.
+	template <typename Index>
+	BIOMTable(std::vector<Index> feature_indices, std::vector<Index> sample_indices, std::vector<double> values,
+	          std::vector<std::string> feature_ids_ordered, std::vector<std::string> sample_ids_ordered,
+	          size_t n_threads = 1);
 	BIOMTable();
 	uint32_t nnz() const;
-	const std::vector<size_t> &COOFeatureIndices() const;
-	const std::vector<size_t> &COOSampleIndices() const;
+	// The entries as triplets, ordered by (sample, feature); the indices are expanded from the CSC arrays on
+	// each call
+	std::vector<size_t> COOFeatureIndices() const;
+	std::vector<size_t> COOSampleIndices() const;
 	const std::vector<double> &COOValues() const;
 
 	// Get ordered feature and sample IDs
@@ -50,41 +59,39 @@ public:
 		return sample_ids_ordered.size();
 	}
 
-	// Convert COO to CSR (Compressed Sparse Row) format
-	// Used for observation/matrix in BIOM (features = rows, samples = columns)
-	SparseMatrix ToCSR() const;
+	// The canonical CSC arrays, i.e. sample/matrix in BIOM (features = rows, samples = columns)
+	const SparseMatrix &CSC() const {
+		return csc;
+	}
 
-	// Convert COO to CSC (Compressed Sparse Column) format
-	// Used for sample/matrix in BIOM (features = rows, samples = columns)
-	SparseMatrix ToCSC() const;
+	// Transpose to CSR (Compressed Sparse Row) format
+	// Used for observation/matrix in BIOM (features = rows, samples = columns)
+	SparseMatrix ToCSR(size_t n_threads = 1) const;
 
 private:
-	std::vector<size_t> coo_feature_indices;
-	std::vector<size_t> coo_sample_indices;
-	std::vector<double> coo_values;
+	SparseMatrix csc;
 
 	std::vector<std::string> feature_ids_ordered;
 	std::vector<std::string> sample_ids_ordered;
 
-	void InitCOOFromCSC(const std::vector<int32_t> &indptr, const std::vector<int32_t> &indices);
-	void InitCOOFromCOO(const std::vector<std::string> &feature_ids, const std::vector<std::string> &sample_ids);
-
-	// accumulate duplicate sample / feature pairs
-	// remove zeros
-	void compress_coo();
-	std::vector<std::string> indices_to_ids(const std::vector<size_t> &indices, const std::vector<std::string> &names);
+	void InitCSCFromCOO(const std::vector<std::string> &feature_ids, const std::vector<std::string> &sample_ids,
+	                    const std::vector<double> &values);
 
-	// Helper for ToCSR/ToCSC: convert COO to compressed format
-	// by_row=true: CSR, by_row=false: CSC
-	SparseMatrix ConvertCOOToCompressed(bool by_row) const;
-
-	std::vector<std::string> load_dataset_1D_str(hid_t ds_id);
+	// Sort the triplets by (sample, feature), accumulate duplicate sample / feature pairs, remove zeros, and
+	// store the result as csc
+	template <typename Index>
+	void compress_coo(std::vector<Index> &feature_indices, std::vector<Index> &sample_indices,
+	                  std::vector<double> &values, size_t n_threads = 1);
 
 	template <typename T>
-	std::vector<T> load_dataset_1D(hid_t ds_id, hid_t exp_dtype);
+	static hid_t get_hdf5_type();
+
+public:
+	// Whole-dataset HDF5 loaders, also used by BIOMReader for the ID datasets and column pointers
+	static std::vector<std::string> load_dataset_1D_str(hid_t ds_id);
 
 	template <typename T>
-	hid_t get_hdf5_type();
+	static std::vector<T> load_dataset_1D(hid_t ds_id, hid_t exp_dtype);
 };
 
 std::vector<std::string> unique_ids_in_order(const std::vector<std::string> &ids);
@@ -92,4 +99,12 @@ std::vector<size_t> ids_to_indices(const std::vector<std::string> &ids, const st
 void sort_by_row_then_column(std::vector<size_t> &rows, std::vector<size_t> &cols, std::vector<double> &values);
 void apply_permutation(std::vector<size_t> &rows, std::vector<size_t> &cols, std::vector<double> &values,
                        const std::vector<size_t> &indices);
+
+// Stable counting sort of (keys, others, values) by keys, which must lie in [0, n_keys). Each thread
+// counts and scatters a contiguous slice of the input into its own precomputed output positions.
+// Returns the n_keys + 1 bucket boundaries, i.e. the compressed pointer array of the sorted keys.
+// Index is size_t or uint32_t.
+template <typename Index>
+std::vector<size_t> counting_sort_by_key(std::vector<Index> &keys, std::vector<Index> &others,
+                                         std::vector<double> &values, size_t n_keys, size_t n_threads = 1);
 } // namespace miint
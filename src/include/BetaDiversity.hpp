@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace miint {
+
+enum class BetaMetric { BRAY_CURTIS, JACCARD };
+
+// Parse a metric name ("braycurtis" or "jaccard"); throws std::runtime_error for anything else
+BetaMetric parse_beta_metric(const std::string &name);
+
+// Pairwise distances between the samples of a sparse sample x feature table given in compressed sparse row form,
+// with the features of each sample sorted. The arrays are referenced, not copied, and must outlive this object.
+//
+// Both metrics only depend on the features two samples share, so a row of the distance matrix is computed by
+// scattering: for each feature of sample i, walk the later samples holding that feature in a column-major copy
+// of the table and accumulate into a dense per-thread row. Samples sharing no feature cost nothing beyond
+// writing out the row, instead of the cost of intersecting every pair.
+class BetaDiversity {
+public:
+	BetaDiversity(const uint64_t *indptr, const uint32_t *features, const double *values, size_t n_samples,
+	              size_t n_features, BetaMetric metric);
+
+	size_t sample_count() const {
+		return n_samples;
+	}
+
+	// Distances from sample i to samples i + 1 ... sample_count() - 1, written to out. scratch is reused between
+	// calls and must not be shared between threads.
+	void row(size_t i, std::vector<double> &scratch, std::vector<double> &out) const;
+
+private:
+	const uint64_t *indptr;
+	const uint32_t *features;
+	const double *values;
+	size_t n_samples;
+	BetaMetric metric;
+
+	// The table in compressed sparse column form, samples sorted within each feature
+	std::vector<uint64_t> column_indptr;
+	std::vector<uint32_t> column_samples;
+	std::vector<double> column_values;
+	// Position of each row entry in the columns, so a row walks only the samples after it
+	std::vector<uint64_t> column_position;
+	// Per-sample denominator terms: total count (Bray-Curtis) or number of features (Jaccard)
+	std::vector<double> totals;
+};
+
+} // namespace miint
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "NewickTree.hpp"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace miint {
+
+// A read-only tree in struct-of-arrays form, for trees that are loaded once and queried many times. Nodes keep
+// their NewickTree indices (so read_newick's node_index applies); children are a CSR adjacency (offsets into one
+// flat child array), and the names are stored back to back in one string. Names and edge identifiers are hashed
+// to nodes.
+class CompactTree {
+public:
+	static constexpr uint32_t NO_NODE = UINT32_MAX;
+	static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+	static constexpr uint32_t AMBIGUOUS = UINT32_MAX - 1;
+
+	explicit CompactTree(const NewickTree &tree);
+	// Parse a Newick string straight into the compact form, without building a NewickTree
+	explicit CompactTree(std::string_view newick);
+	// name_index refers to names
+	CompactTree(const CompactTree &) = delete;
+	CompactTree &operator=(const CompactTree &) = delete;
+
+	size_t num_nodes() const {
+		return parent_.size();
+	}
+	size_t num_tips() const {
+		return n_tips;
+	}
+	uint32_t root() const {
+		return root_;
+	}
+
+	// NO_NODE for the root
+	uint32_t parent(uint32_t node) const {
+		return parent_[node];
+	}
+	// In order; empty for a tip
+	std::span<const uint32_t> children(uint32_t node) const {
+		return std::span<const uint32_t>(children_).subspan(child_offsets[node],
+		                                                   child_offsets[node + 1] - child_offsets[node]);
+	}
+	bool is_tip(uint32_t node) const {
+		return child_offsets[node] == child_offsets[node + 1];
+	}
+
+	std::string_view name(uint32_t node) const {
+		return std::string_view(names).substr(name_start[node], name_length[node]);
+	}
+	// NaN if not specified
+	double branch_length(uint32_t node) const {
+		return branch_length_[node];
+	}
+	std::optional<int64_t> edge_id(uint32_t node) const {
+		if (!has_edge_id[node]) {
+			return std::nullopt;
+		}
+		return edge_id_[node];
+	}
+
+	// Node named name (tip or internal), NOT_FOUND if there is none, or AMBIGUOUS if several nodes share it
+	uint32_t find_name(std::string_view name) const {
+		auto it = name_index.find(name);
+		return it == name_index.end() ? NOT_FOUND : it->second;
+	}
+	// Node with edge identifier edge_id, NOT_FOUND if there is none, or AMBIGUOUS if several nodes share it
+	uint32_t find_edge(int64_t edge_id) const {
+		auto it = edge_index.find(edge_id);
+		return it == edge_index.end() ? NOT_FOUND : it->second;
+	}
+
+	// Parents before children, children in order
+	std::vector<uint32_t> preorder() const;
+	// Children before parents, children in order
+	std::vector<uint32_t> postorder() const;
+
+	// Approximate heap memory held by the tree, in bytes
+	size_t memory_usage() const;
+
+private:
+	// Build the name and edge indexes once every array is filled
+	void build_indexes();
+
+	uint32_t root_ = NO_NODE;
+	size_t n_tips = 0;
+	std::vector<uint32_t> parent_;
+	std::vector<uint32_t> child_offsets; // children of node i are children_[child_offsets[i], child_offsets[i + 1])
+	std::vector<uint32_t> children_;
+	std::vector<double> branch_length_;
+	std::vector<int64_t> edge_id_;
+	std::vector<bool> has_edge_id;
+	std::string names; // every node name, back to back
+	std::vector<uint64_t> name_start;
+	std::vector<uint32_t> name_length;
+	std::unordered_map<std::string_view, uint32_t> name_index;
+	std::unordered_map<int64_t, uint32_t> edge_index;
+};
+
+} // namespace miint
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CompactTree.hpp"
+#include "NewickTree.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace miint {
+
+// A tree reduced to what Faith's phylogenetic diversity needs: the parent and branch length of every node, and a
+// hash from tip name to node. Built once and shared, read-only, by every sample.
+class FaithPDTree {
+public:
+	static constexpr uint32_t NOT_A_TIP = UINT32_MAX;
+	static constexpr uint32_t AMBIGUOUS_TIP = UINT32_MAX - 1;
+
+	// Branch lengths that are not specified count as 0; the root's branch is not part of any path
+	explicit FaithPDTree(const NewickTree &tree);
+	explicit FaithPDTree(const CompactTree &tree);
+	// tip_index refers to tip_names
+	FaithPDTree(const FaithPDTree &) = delete;
+	FaithPDTree &operator=(const FaithPDTree &) = delete;
+
+	// Node of the tip named name, NOT_A_TIP if there is none, or AMBIGUOUS_TIP if several tips share the name
+	uint32_t tip(std::string_view name) const {
+		auto it = tip_index.find(name);
+		return it == tip_index.end() ? NOT_A_TIP : it->second;
+	}
+
+	size_t num_nodes() const {
+		return parent.size();
+	}
+
+	// Sum of the branch lengths of the union of the paths from tips to the root. Tips may repeat. visited is
+	// scratch space of at least bitmap_words() words, all zero, and is left all zero.
+	double pd(const std::vector<uint32_t> &tips, std::vector<uint64_t> &visited) const;
+
+	size_t bitmap_words() const {
+		return (num_nodes() + 63) / 64;
+	}
+
+private:
+	template <typename Tree>
+	void init(const Tree &tree);
+
+	std::vector<uint32_t> parent; // NewickTree::NO_PARENT for the root
+	std::vector<double> length;
+	std::vector<std::string> tip_names; // owns the keys of tip_index
+	std::unordered_map<std::string_view, uint32_t> tip_index;
+};
+
+} // namespace miint
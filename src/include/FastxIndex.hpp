@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace miint {
+
+// One sampled record position. For BGZF-compressed files virtual_offset is the HTSlib virtual
+// offset of the record (compressed block start << 16 | offset within the block).
+struct FastxIndexEntry {
+	uint64_t record;         // 0-based record number
+	uint64_t offset;         // Offset of the record in the uncompressed stream
+	uint64_t virtual_offset; // BGZF virtual offset (0 for uncompressed files)
+};
+
+// Sidecar index for a FASTQ/FASTA file (written by COPY ... (INDEX true) next to the output as
+// <file>.fxi). It holds the exact record count and the position of every interval-th record, so a
+// reader can split a file between threads or start at a given record without scanning from the top.
+class FastxIndex {
+public:
+	static constexpr const char *EXTENSION = ".fxi";
+	static constexpr uint64_t DEFAULT_INTERVAL = 8192;
+	// Uncompressed bytes per BGZF block as produced by the COPY writers (BGZF_BLOCK_SIZE in HTSlib)
+	static constexpr uint64_t BGZF_BLOCK_DATA_SIZE = 0xff00;
+
+	explicit FastxIndex(uint64_t interval = DEFAULT_INTERVAL, bool compressed = false);
+
+	// Register a buffer of records appended to the file. record_offsets are the starts of the records
+	// relative to the buffer, buffer_length its uncompressed size. For compressed files the buffer was
+	// written as BGZF blocks of BGZF_BLOCK_DATA_SIZE uncompressed bytes (the last may be shorter)
+	// starting at compressed_start, with compressed sizes bgzf_block_sizes.
+	void add_block(const std::vector<uint64_t> &record_offsets, uint64_t buffer_length, uint64_t compressed_start,
+	               const std::vector<uint64_t> &bgzf_block_sizes);
+
+	// Last entry at or before record (requires a non-empty index)
+	const FastxIndexEntry &seek(uint64_t record) const;
+
+	std::string serialize() const;
+	static FastxIndex deserialize(const std::string &data);
+
+	uint64_t interval;
+	bool compressed;
+	uint64_t record_count = 0;
+	uint64_t uncompressed_size = 0;
+	uint64_t file_size = 0; // Size of the indexed file on disk, used to detect a stale index
+	std::vector<FastxIndexEntry> entries;
+};
+
+} // namespace miint
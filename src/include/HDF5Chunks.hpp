@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <hdf5.h>
+
+namespace miint {
+
+// HDF5 is not thread-safe: every HDF5 call in the process, from read_biom, biom_merge and COPY FORMAT BIOM
+// alike, is made under this lock. It is held around the HDF5 calls only, never around compression or other
+// work, and is recursive so handles closing themselves can take it while their owner already holds it.
+std::recursive_mutex &hdf5_lock();
+
+// Filter registered by h5py for LZF compression
+static constexpr H5Z_filter_t H5Z_FILTER_LZF = 32000;
+
+// Storage of a chunked 1-D numeric dataset. When direct is true every filter of its pipeline can be undone
+// here, so chunks can be fetched raw with H5Dread_chunk (under the HDF5 lock) and decoded without touching
+// the HDF5 library, i.e. on any number of threads.
+struct HDF5ChunkLayout {
+	bool direct = false;
+	uint64_t chunk_elements = 0;
+	size_t element_size = 0;
+	bool is_float = false;
+	bool is_signed = false;
+	std::vector<H5Z_filter_t> filters; // in pipeline (write) order
+
+	// Supported: deflate, shuffle and LZF filters over little-endian integers and floats
+	static HDF5ChunkLayout inspect(hid_t ds_id);
+};
+
+// The stored chunks of a 1-D dataset covering elements [begin, end)
+struct HDF5RawRange {
+	uint64_t begin = 0;
+	uint64_t end = 0;
+	uint64_t first_chunk = 0;
+	std::vector<std::vector<char>> chunks;
+	std::vector<uint32_t> filter_masks; // filters skipped when each chunk was written
+};
+
+// Fetch the chunks of ds_id covering [begin, end) without decoding them. Calls HDF5; layout.direct must be set.
+void hdf5_read_raw_range(hid_t ds_id, const HDF5ChunkLayout &layout, uint64_t begin, uint64_t end,
+                         HDF5RawRange &out);
+
+// Decode raw.end - raw.begin elements of raw into out, converting from the stored type. Does not call HDF5.
+template <typename T>
+void hdf5_decode_range(const HDF5ChunkLayout &layout, const HDF5RawRange &raw, T *out);
+
+// Decompress an LZF block (liblzf format) into out, which holds out_capacity bytes; returns the decompressed size
+size_t lzf_decompress(const char *in, size_t in_size, char *out, size_t out_capacity);
+
+} // namespace miint
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace miint {
+
+// A regular file mapped read-only into memory, so it can be parsed in place without being copied
+class MappedFile {
+public:
+	// Throws std::runtime_error if the file cannot be opened or mapped
+	explicit MappedFile(const std::string &path);
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	std::string_view view() const {
+		return std::string_view(static_cast<const char *>(data_), size_);
+	}
+
+	// Whether path is a regular file, which can be mapped (pipes and devices cannot)
+	static bool is_mappable(const std::string &path);
+
+private:
+	void *data_ = nullptr;
+	size_t size_ = 0;
+};
+
+} // namespace miint
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace miint {
+
+// A node of a Newick tree, as NewickStreamParser returns it
+struct NewickRow {
+	uint32_t node;                  // nodes are numbered in the order they are completed, as NewickTree::parse does
+	uint32_t parent;                // NewickStreamParser::NO_PARENT for the root
+	std::string_view name;          // into the input, or into the parser for quoted labels with escapes
+	double branch_length;           // NaN if not specified
+	std::optional<int64_t> edge_id; // edge identifier from {n} syntax (jplace format)
+	bool is_tip;
+};
+
+// End of each tree (just past its ';') of a text holding one or more trees, as in bootstrap or posterior sample
+// files. Quoted labels and comments are skipped, so a ';' inside them is not a boundary. Anything after the last
+// ';' other than whitespace and comments is returned as one more tree, as is a text without any tree, so that
+// parsing it reports the error.
+std::vector<size_t> newick_tree_ends(std::string_view text);
+
+// Iterative, zero-copy Newick parser that returns nodes while it parses.
+//
+// A node is returned once its parent is closed, since only then is the parent's index known: the children of a
+// node come out together, in order, followed later by the node itself. Only the children of the nodes still open
+// are held, so memory follows the widest open path rather than the size of the tree, and deep trees cannot
+// overflow the stack. Names are views into the input, which must outlive the parser.
+class NewickStreamParser {
+public:
+	static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+	explicit NewickStreamParser(std::string_view input);
+
+	// The next node whose parent is known, parsing as far as needed. False once every node has been returned.
+	// Throws std::runtime_error on malformed input.
+	bool next(NewickRow &row);
+
+	// Nodes completed so far
+	size_t num_nodes() const {
+		return n_nodes;
+	}
+
+	// Position just past the tree's ';', once every node has been returned
+	size_t position() const {
+		return pos_;
+	}
+
+private:
+	enum class State { START, START_NODE, AFTER_NODE, DONE };
+
+	std::string_view input_;
+	size_t pos_ = 0;
+	State state = State::START;
+	size_t n_nodes = 0;
+
+	// Start in pending of the children of each open node
+	std::vector<size_t> open;
+	// Completed nodes whose parent is still open
+	std::vector<NewickRow> pending;
+	// Nodes ready to be returned, from ready_head on
+	std::vector<NewickRow> ready;
+	size_t ready_head = 0;
+	// Quoted labels with escaped quotes, unescaped; a deque so the views stay valid
+	std::deque<std::string> unescaped;
+
+	void step();
+	void finish_node(size_t children_start);
+
+	char peek() const {
+		return pos_ < input_.size() ? input_[pos_] : '\0';
+	}
+	void skip_whitespace_and_comments();
+	void skip_whitespace();
+	std::string_view parse_label();
+	std::string_view parse_quoted_label(char quote_char);
+	double parse_branch_length();
+	int64_t parse_edge_id();
+};
+
+} // namespace miint
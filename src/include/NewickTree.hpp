@@ -10,10 +10,6 @@
 
 namespace miint {
 
-// Forward declarations
-class NewickTree;
-class NewickParser;
-
 // Placement data for insert_fully_resolved
 // Represents where a query sequence should be placed on a reference tree
 struct Placement {
@@ -185,10 +181,15 @@ public:
 	//    then lowest pendant_length)
 	// 2. Groups placements by edge_id
 	// 3. Sorts each group by distal_length descending
-	// 4. For each edge, creates a chain of new internal nodes with fragments
+	// 4. For each edge, creates a chain of new internal nodes with fragments,
+	//    which takes the edge's place among its parent's children
+	//
+	// Runs in time linear in the number of placements and nodes, apart from sorting each edge's group: placements
+	// are grouped with counting sorts, and the new nodes are created in a single pass. Validation, deduplication
+	// and chain building are spread over n_threads threads. Ties in distal_length keep the input order.
 	//
 	// Throws if edge_id not found or distal_length exceeds edge length
-	void insert_fully_resolved(const std::vector<Placement> &placements);
+	void insert_fully_resolved(const std::vector<Placement> &placements, size_t n_threads = 1);
 
 	// ========================================================================
 	// Modification (for insert_fully_resolved)
@@ -221,8 +222,6 @@ public:
 	}
 
 private:
-	friend class NewickParser;
-
 	std::vector<NewickNode> nodes_;
 	uint32_t root_ = NO_PARENT;
 };
@@ -0,0 +1,56 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace miint {
+
+// Run task(i) for every i in [0, n_tasks) on up to n_threads threads (the caller's thread included).
+// Calls running at the same time, e.g. from several DuckDB threads, share n_threads: a call gets n_threads divided
+// by the number of calls in progress when it starts, so concurrent callers do not each start n_threads threads.
+// The first exception thrown by a task stops further tasks and is rethrown once all threads joined.
+void run_parallel(size_t n_tasks, size_t n_threads, const std::function<void(size_t)> &task);
+
+// Threads started once and reused by every run(), for callers that would otherwise call run_parallel over and
+// over (a batch per loop iteration). Each run() counts as a run_parallel call while it runs, and uses as many of
+// the pool's threads as a run_parallel call starting then would get; an idle pool takes no share of n_threads.
+class WorkerPool {
+public:
+	explicit WorkerPool(size_t n_threads);
+	~WorkerPool();
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool &operator=(const WorkerPool &) = delete;
+
+	// Most threads taking part in a run(), the caller's included
+	size_t size() const {
+		return workers_.size() + 1;
+	}
+	// Same as run_parallel, on the pool's threads. Not to be called from several threads at once.
+	void run(size_t n_tasks, const std::function<void(size_t)> &task);
+
+private:
+	// Join the threads
+	void stop();
+	void work(size_t worker);
+	// Run tasks of the current run() until none are left; guard holds lock_ on entry and on return
+	void drain(std::unique_lock<std::mutex> &guard);
+
+	std::vector<std::thread> workers_;
+	std::mutex lock_;
+	std::condition_variable start_;
+	std::condition_variable done_;
+	const std::function<void(size_t)> *task_ = nullptr;
+	size_t n_tasks_ = 0;
+	size_t n_active_ = 0; // workers taking part in the current run()
+	size_t next_task_ = 0;
+	size_t generation_ = 0; // incremented by every run()
+	size_t finished_ = 0;   // active workers done with the current run()
+	bool stop_ = false;
+	std::exception_ptr error_;
+};
+
+} // namespace miint
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace miint {
+
+// Random source of one rarefied sample. std::mt19937_64 produces the same sequence on every platform; the
+// conversions to doubles and bounded integers are done here, since std distributions are implementation defined.
+class RarefactionRandom {
+public:
+	explicit RarefactionRandom(uint64_t seed) : engine(seed) {
+	}
+
+	// Uniform in [0, 1)
+	double next_double() {
+		return static_cast<double>(engine() >> 11) * (1.0 / 9007199254740992.0);
+	}
+	// Uniform in [0, max]
+	uint64_t next_interval(uint64_t max);
+
+private:
+	std::mt19937_64 engine;
+};
+
+// Seed of a sample: derived from the seed of the query and the sample ID, so a sample is rarefied the same way
+// regardless of which thread handles it or which other samples are in the table
+uint64_t rarefaction_seed(uint64_t seed, const std::string &sample_id);
+
+// Number of good items in a draw of sample items without replacement from good + bad items
+uint64_t random_hypergeometric(RarefactionRandom &random, uint64_t good, uint64_t bad, uint64_t sample);
+
+// Subsample depth items without replacement from counts (a multivariate hypergeometric draw), in O(counts.size()).
+// out receives the number of items drawn of each count. Throws if the counts hold fewer than depth items.
+void rarefy(const std::vector<uint64_t> &counts, uint64_t depth, RarefactionRandom &random, std::vector<uint64_t> &out);
+
+} // namespace miint
@@ -7,22 +7,46 @@
 #include "SequenceRecord.hpp"
 
 namespace miint {
+// A slice of a file (or of both files of a pair) located through a FastxIndex. Offsets are BGZF
+// virtual offsets for compressed files and plain byte offsets otherwise.
+struct SequenceReadRange {
+	uint64_t offset1 = 0;
+	uint64_t offset2 = 0;
+	bool compressed1 = false;
+	bool compressed2 = false;
+	uint64_t max_records = 0; // 0 reads to the end of the file
+};
+
+// Byte source behind a sequence stream: zlib reads plain and gzip input, ZstdReader reads zstd input
+class SequenceInput {
+public:
+	virtual ~SequenceInput() = default;
+	virtual int read(void *buffer, unsigned length) = 0;
+};
+
 class SequenceReader {
 public:
-	explicit SequenceReader(const std::string &path1, const std::optional<std::string> &path2 = std::nullopt);
+	// decode_threads is the number of threads a seekable zstd file may be decompressed with
+	explicit SequenceReader(const std::string &path1, const std::optional<std::string> &path2 = std::nullopt,
+	                        size_t decode_threads = 1);
+	// Read at most range.max_records records starting at the given offsets
+	SequenceReader(const std::string &path1, const std::optional<std::string> &path2, const SequenceReadRange &range);
 	SequenceRecordBatch read(const int n);
 
 private:
-	using SeqStreamIn = klibpp::SeqStreamIn;
+	using SeqStreamIn = klibpp::KStreamIn<SequenceInput *, int (*)(SequenceInput *, void *, unsigned)>;
 
 	std::unique_ptr<SeqStreamIn> sequence1_reader_;
 	std::optional<std::unique_ptr<SeqStreamIn>> sequence2_reader_;
 
 	bool paired_;
+	bool limited_ = false;
+	uint64_t remaining_records_ = 0;
 	bool first_read_; // Track if we need to return buffered data
 	std::vector<klibpp::KSeq> buffered_read1_;
 	std::vector<klibpp::KSeq> buffered_read2_;
 
+	void initialize(const std::string &path1, const std::optional<std::string> &path2);
 	SequenceRecordBatch read_se(const int n);
 	SequenceRecordBatch read_pe(const int n);
 };
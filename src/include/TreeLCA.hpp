@@ -0,0 +1,57 @@
+#pragma once
+
+#include "CompactTree.hpp"
+#include "NewickTree.hpp"
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace miint {
+
+// Constant-time lowest common ancestors and patristic distances of a tree, preprocessed once.
+//
+// The LCA is a range-minimum query over the Euler tour, in its DFS-order form: with nodes numbered in preorder,
+// the LCA of u != v (pre[u] < pre[v]) is the parent with the smallest preorder number among the parents of the
+// nodes numbered (pre[u], pre[v]]. A sparse table answers that with two lookups, over n rather than 2n - 1
+// entries. Distances are root_distance[a] + root_distance[b] - 2 * root_distance[lca].
+class TreeLCA {
+public:
+	static constexpr uint32_t NOT_FOUND = CompactTree::NOT_FOUND;
+	static constexpr uint32_t AMBIGUOUS = CompactTree::AMBIGUOUS;
+
+	// Branch lengths that are not specified count as 0; the root's branch is not part of any path
+	explicit TreeLCA(std::shared_ptr<const CompactTree> tree);
+	explicit TreeLCA(const NewickTree &tree) : TreeLCA(std::make_shared<const CompactTree>(tree)) {
+	}
+
+	// Node named name (tip or internal), NOT_FOUND if there is none, or AMBIGUOUS if several nodes share it
+	uint32_t node(std::string_view name) const {
+		return tree_->find_name(name);
+	}
+
+	size_t num_nodes() const {
+		return preorder_number.size();
+	}
+
+	const CompactTree &tree() const {
+		return *tree_;
+	}
+
+	uint32_t lca(uint32_t a, uint32_t b) const;
+
+	// Sum of the branch lengths on the path between a and b
+	double distance(uint32_t a, uint32_t b) const {
+		return root_distance[a] + root_distance[b] - 2 * root_distance[lca(a, b)];
+	}
+
+private:
+	std::vector<uint32_t> preorder;        // node at each preorder number
+	std::vector<uint32_t> preorder_number; // preorder number of each node
+	// levels[k][i]: smallest preorder number among the parents of the nodes numbered [i, i + 2^k)
+	std::vector<std::vector<uint32_t>> levels;
+	std::vector<double> root_distance;
+	std::shared_ptr<const CompactTree> tree_;
+};
+
+} // namespace miint
@@ -0,0 +1,67 @@
+#pragma once
+#include "CompactTree.hpp"
+#include "NewickTree.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace miint {
+
+enum class UniFracMetric { UNWEIGHTED, WEIGHTED_UNNORMALIZED, WEIGHTED_NORMALIZED };
+
+// Parse a metric name ("unweighted", "weighted_unnormalized" or "weighted_normalized"); throws std::runtime_error
+// for anything else
+UniFracMetric parse_unifrac_metric(const std::string &name);
+
+// Sparse sample x feature counts in compressed sparse row form, as referenced by UniFrac::compute
+struct SparseCounts {
+	const uint64_t *indptr;   // entries of sample i are [indptr[i], indptr[i + 1])
+	const uint32_t *features; // feature index of each entry
+	const double *values;     // count of each entry
+	size_t n_samples;
+};
+
+// UniFrac distances between all samples, computed with the Striped UniFrac algorithm (McDonald et al. 2018).
+//
+// The distance matrix is stored as stripes: stripe s holds the distances between samples i and (i + s + 1) % n
+// for every i. A single postorder sweep of the tree computes for every branch the embedding of each sample
+// (presence, or proportion of counts, below the branch), and each branch adds its length times the difference
+// of the embeddings to every stripe. Stripes are independent, so branches are applied in batches on n_threads
+// threads, each thread owning a range of stripes; the inner loop over samples is contiguous and vectorizes.
+class UniFrac {
+public:
+	// feature_ids name the features of counts and must all be tips of tree. Branch lengths that are not
+	// specified count as 0.
+	static UniFrac compute(const NewickTree &tree, const std::vector<std::string> &feature_ids,
+	                       const SparseCounts &counts, UniFracMetric metric, size_t n_threads = 1);
+	static UniFrac compute(const CompactTree &tree, const std::vector<std::string> &feature_ids,
+	                       const SparseCounts &counts, UniFracMetric metric, size_t n_threads = 1);
+
+	size_t sample_count() const {
+		return n_samples;
+	}
+	// Every pair of samples is in exactly one stripe
+	size_t stripe_count() const {
+		return n_samples / 2;
+	}
+	// Number of pairs in a stripe: the last stripe of an even number of samples would hold each pair twice,
+	// so only its first half is used
+	size_t stripe_length(size_t stripe) const {
+		return (n_samples % 2 == 0 && stripe + 1 == stripe_count()) ? n_samples / 2 : n_samples;
+	}
+	// Distance between sample i and sample (i + stripe + 1) % sample_count()
+	double distance(size_t stripe, size_t i) const {
+		return distances[stripe * n_samples + i];
+	}
+
+private:
+	template <typename Tree>
+	static UniFrac compute_tree(const Tree &tree, const std::vector<std::string> &feature_ids,
+	                            const SparseCounts &counts, UniFracMetric metric, size_t n_threads);
+
+	size_t n_samples = 0;
+	std::vector<double> distances; // stripe-major
+};
+
+} // namespace miint
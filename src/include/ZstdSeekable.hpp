@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace miint {
+
+class WorkerPool;
+
+// Sizes of one frame of a seekable zstd file
+struct ZstdFrameSize {
+	uint32_t compressed;
+	uint32_t decompressed;
+};
+
+// Seek table of the zstd seekable format (contrib/seekable_format in the zstd sources). It is stored
+// as a skippable frame at the end of the file, so decoders unaware of it still read the file as a
+// plain multi-frame zstd stream:
+//   u32 0x184D2A5E, u32 frame size, n x (u32 compressed, u32 decompressed),
+//   u32 n, u8 descriptor (bit 7: per-frame checksums, not written here), u32 0x8F92EAB1
+class ZstdSeekTable {
+public:
+	static constexpr uint32_t SKIPPABLE_MAGIC = 0x184D2A5E;
+	static constexpr uint32_t SEEKABLE_MAGIC = 0x8F92EAB1;
+	static constexpr size_t FOOTER_SIZE = 9;
+	static constexpr size_t FRAME_HEADER_SIZE = 8;
+
+	std::string serialize() const;
+	// Size of the table ending with footer (the last FOOTER_SIZE bytes of a file), 0 if footer is not
+	// the footer of a seek table
+	static size_t table_size(const std::string &footer);
+	// Parse a complete table as produced by serialize()
+	static ZstdSeekTable deserialize(const std::string &data);
+
+	uint64_t compressed_size() const;
+	uint64_t decompressed_size() const;
+
+	std::vector<ZstdFrameSize> frames;
+};
+
+// Largest amount of data compressed into a single frame. Writers split larger buffers so every frame
+// stays small enough to be decoded independently by one thread without excessive memory.
+constexpr size_t ZSTD_MAX_FRAME_SIZE = 4 << 20;
+
+// True when this build can read and write zstd
+bool zstd_available();
+
+// Upper bound of the output of zstd_compress_frames for size input bytes
+size_t zstd_compress_frames_bound(size_t size);
+
+// Compress data into independent frames of at most ZSTD_MAX_FRAME_SIZE input bytes each, appending
+// their sizes to frames. out must hold zstd_compress_frames_bound(size) bytes; returns the number of
+// bytes written. Safe to call from several threads at once.
+size_t zstd_compress_frames(const char *data, size_t size, char *out, int level, std::vector<ZstdFrameSize> &frames);
+
+// Decompressed stream of a zstd file. Files ending with a seek table are decoded a batch of frames at
+// a time, the frames of a batch in parallel on up to n_threads threads, started once per reader; other
+// zstd files (and pipes) are decoded as a single stream.
+class ZstdReader {
+public:
+	explicit ZstdReader(const std::string &path, size_t n_threads = 1);
+	~ZstdReader();
+	ZstdReader(const ZstdReader &) = delete;
+	ZstdReader &operator=(const ZstdReader &) = delete;
+
+	// Copy up to length decompressed bytes into buffer; returns 0 at the end of the file
+	size_t read(char *buffer, size_t length);
+	bool seekable() const {
+		return seekable_;
+	}
+
+	// True when the file starts with a zstd frame
+	static bool is_zstd_file(const std::string &path);
+
+private:
+	bool read_batch();
+	size_t read_stream(char *buffer, size_t length);
+
+	std::string path_;
+	int fd_ = -1;
+	size_t n_threads_;
+
+	// Seekable files
+	bool seekable_ = false;
+	std::vector<ZstdFrameSize> frames_;
+	std::unique_ptr<WorkerPool> pool_; // decodes the frames of a batch
+	size_t next_frame_ = 0;
+	uint64_t next_offset_ = 0;
+	std::vector<std::string> batch_;
+	size_t batch_frame_ = 0;
+	size_t batch_pos_ = 0;
+
+	// Everything else
+	void *dstream_ = nullptr;
+	std::vector<char> input_;
+	size_t input_pos_ = 0;
+	size_t input_size_ = 0;
+	size_t last_result_ = 0;
+	bool input_eof_ = false;
+};
+
+} // namespace miint
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "AlphaDiversity.hpp"
+#include "duckdb.hpp"
+#include "duckdb/function/aggregate_function.hpp"
+
+namespace duckdb {
+
+// alpha_shannon, alpha_simpson, alpha_chao1 and alpha_observed: aggregates over the counts of the features of a
+// sample, usually grouped by sample_id. Each keeps a fixed-size miint::AlphaDiversity state.
+class AlphaDiversityFunctions {
+public:
+	static void Register(ExtensionLoader &loader);
+};
+
+} // namespace duckdb
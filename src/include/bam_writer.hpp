@@ -0,0 +1,75 @@
+#pragma once
+
+#include "copy_format_common.hpp"
+#include <htslib-1.22.1/htslib/sam.h>
+#include <htslib-1.22.1/htslib/hts.h>
+
+namespace duckdb {
+
+//===--------------------------------------------------------------------===//
+// BAM Serialization
+//===--------------------------------------------------------------------===//
+// Serialize the BAM header (magic, SAM text, reference dictionary) as done by bam_hdr_write
+void SerializeBAMHeader(sam_hdr_t *header, MemoryStream &out);
+
+// Append a BAM record in its on-disk encoding, as done by bam_write1 (little-endian hosts).
+// CIGARs with more than 65535 operations are moved to a CG:B,I tag per the SAM specification.
+void SerializeBAMRecord(const bam1_t *record, MemoryStream &out, const string &read_id);
+
+//===--------------------------------------------------------------------===//
+// Coordinate Sort
+//===--------------------------------------------------------------------===//
+constexpr idx_t DEFAULT_BAM_SORT_RUN_SIZE = 64 * 1024 * 1024; // 64MB of serialized records per thread-local run
+constexpr idx_t BAM_SORT_MERGE_FAN_IN = 64;                     // runs open at once in one merge
+
+// Thread-local buffer of serialized records awaiting sort. Once it exceeds the run size it is
+// sorted by (tid, pos) and spilled to the temporary directory as a sorted run.
+struct BAMSortLocalState {
+	struct Entry {
+		uint32_t tid_key; // tid as unsigned, so unplaced reads (tid -1) sort last
+		uint32_t length;
+		int64_t pos;
+		int64_t end;
+		uint64_t offset; // into records, which may grow past 4GB if run_size is raised
+		bool mapped;
+	};
+
+	explicit BAMSortLocalState(idx_t run_size);
+
+	// Serialize record into the buffer; returns true once the buffer should be spilled
+	bool Append(const bam1_t *record, const string &read_id);
+	bool Empty() const {
+		return entries.empty();
+	}
+
+	idx_t run_size;
+	MemoryStream records;
+	vector<Entry> entries;
+};
+
+// Collects sorted runs from all threads and merges them into the final BGZF stream
+class BAMCoordinateSorter {
+public:
+	explicit BAMCoordinateSorter(ClientContext &context);
+	~BAMCoordinateSorter();
+
+	// Sort the local buffer and write it to a new run file (takes the lock only to register the run)
+	void Spill(BAMSortLocalState &local_state);
+
+	// K-way merge all runs into file. Beyond BAM_SORT_MERGE_FAN_IN runs, groups of runs are first merged into
+	// longer runs, in parallel, until a single merge can take them all. The final stream is BGZF-compressed
+	// on all threads. When build_index is set, a BAI (or CSI, for references longer than BAI supports) is
+	// written next to index_base_path.
+	void Merge(CopyFileHandle &file, sam_hdr_t *header, bool build_index, const string &index_base_path);
+
+private:
+	string NewRunPath();
+
+	FileSystem &fs;
+	string temp_directory;
+	idx_t n_threads;
+	mutex lock;
+	vector<string> run_paths;
+};
+
+} // namespace duckdb
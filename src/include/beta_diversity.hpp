@@ -0,0 +1,70 @@
+#pragma once
+#include "BetaDiversity.hpp"
+#include "feature_table_reader.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/typedefs.hpp"
+#include "duckdb/common/types.hpp"
+#include "duckdb/function/function.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include <string>
+#include <vector>
+
+namespace duckdb {
+
+// beta_diversity(table, metric, [sample_id], [feature_id], [value]): pairwise distances between the samples of a
+// long-form count table, one row per pair of samples (each pair once)
+class BetaDiversityTableFunction {
+public:
+	struct Data : public TableFunctionData {
+		std::string table_name;
+		FeatureTableColumns columns;
+		miint::BetaMetric metric = miint::BetaMetric::BRAY_CURTIS;
+
+		std::vector<std::string> names;
+		std::vector<LogicalType> types;
+
+		Data()
+		    : names({"sample_a", "sample_b", "distance"}),
+		      types({LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::DOUBLE}) {
+		}
+	};
+
+	struct GlobalState : public GlobalTableFunctionState {
+		mutex lock;
+		FeatureTable table;
+		unique_ptr<miint::BetaDiversity> beta; // references the arrays of table
+		size_t next_row = 0;
+		idx_t max_threads = 1;
+
+		idx_t MaxThreads() const override {
+			// Rows of the distance matrix are computed independently by whichever thread claims them
+			return max_threads;
+		}
+
+		// Claim the next row of the distance matrix; false once every row has been claimed
+		bool NextRow(size_t &row);
+	};
+
+	struct LocalState : public LocalTableFunctionState {
+		size_t row = 0;
+		std::vector<double> scratch;
+		std::vector<double> distances; // distances from row to the samples after it
+		size_t position = 0;           // next entry of distances to emit
+	};
+
+	static unique_ptr<FunctionData> Bind(ClientContext &context, TableFunctionBindInput &input,
+	                                     vector<LogicalType> &return_types, vector<std::string> &names);
+
+	static unique_ptr<GlobalTableFunctionState> InitGlobal(ClientContext &context, TableFunctionInitInput &input);
+	static unique_ptr<LocalTableFunctionState> InitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+	                                                     GlobalTableFunctionState *global_state);
+
+	static void Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output);
+
+	static TableFunction GetFunction();
+	static void Register(ExtensionLoader &loader);
+};
+
+} // namespace duckdb
@@ -0,0 +1,54 @@
+#pragma once
+#include "BIOMMerge.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/typedefs.hpp"
+#include "duckdb/common/types.hpp"
+#include "duckdb/function/function.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include <string>
+#include <vector>
+
+namespace duckdb {
+
+// biom_merge(paths, output, [id], [generated_by], [compression]): merge BIOM files with disjoint samples into a
+// new BIOM file without materializing the tables, and return a single summary row
+class BiomMergeTableFunction {
+public:
+	struct Data : public TableFunctionData {
+		std::vector<std::string> biom_paths;
+		std::string output_path;
+		miint::BIOMMergeOptions options;
+
+		std::vector<std::string> names;
+		std::vector<LogicalType> types;
+
+		Data()
+		    : names({"output_path", "num_files", "num_samples", "num_features", "nnz"}),
+		      types({LogicalType::VARCHAR, LogicalType::BIGINT, LogicalType::BIGINT, LogicalType::BIGINT,
+		             LogicalType::BIGINT}) {
+		}
+	};
+
+	struct GlobalState : public GlobalTableFunctionState {
+		miint::BIOMMergeSummary summary;
+		bool done = false;
+
+		idx_t MaxThreads() const override {
+			return 1;
+		}
+	};
+
+	static unique_ptr<FunctionData> Bind(ClientContext &context, TableFunctionBindInput &input,
+	                                     vector<LogicalType> &return_types, vector<std::string> &names);
+
+	static unique_ptr<GlobalTableFunctionState> InitGlobal(ClientContext &context, TableFunctionInitInput &input);
+
+	static void Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output);
+
+	static TableFunction GetFunction();
+	static void Register(ExtensionLoader &loader);
+};
+
+} // namespace duckdb
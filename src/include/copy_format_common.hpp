@@ -5,6 +5,8 @@
 #include "duckdb/common/serializer/buffered_file_writer.hpp"
 #include "duckdb/common/serializer/memory_stream.hpp"
 #include "duckdb/common/enums/file_compression_type.hpp"
+#include "FastxIndex.hpp"
+#include "ZstdSeekable.hpp"
 
 namespace duckdb {
 
@@ -12,22 +14,75 @@ namespace duckdb {
 // Constants
 //===--------------------------------------------------------------------===//
 constexpr idx_t DEFAULT_COPY_FLUSH_SIZE = 1024 * 1024; // 1MB default buffer size
+constexpr idx_t STREAM_COPY_FLUSH_SIZE = 128 * 1024;   // Smaller buffers when streaming to a pipe
+
+//===--------------------------------------------------------------------===//
+// Streaming Output
+//===--------------------------------------------------------------------===//
+// True when path is /dev/stdout, /dev/stderr or a named pipe. Such targets are written sequentially
+// without creating, truncating or locking the file, and cannot take sidecar files such as indexes.
+bool IsStreamingCopyTarget(FileSystem &fs, const string &path);
+
+// Execution mode shared by the FASTQ/FASTA/SAM/BAM writers. With preserve_insertion_order (the
+// default) a single thread sinks rows in query order; otherwise every thread formats and appends its
+// own buffers, so records are emitted in whatever order the threads finish them. This is the only
+// parallel path: sorted BAM output likewise builds its runs on one thread unless the setting is off.
+// Ordered output is not written through batch indexes, so the second argument of DuckDB's callback, whether
+// the plan supports them, is ignored.
+CopyFunctionExecutionMode SequenceCopyExecutionMode(bool preserve_insertion_order, bool);
 
 //===--------------------------------------------------------------------===//
 // File Handle Wrapper (handles both compressed and uncompressed)
 //===--------------------------------------------------------------------===//
 class CopyFileHandle {
 public:
-	CopyFileHandle(FileSystem &fs, const string &path, FileCompressionType compression);
+	// compression_level applies to BGZF and zstd output; -1 selects the library default
+	CopyFileHandle(FileSystem &fs, const string &path, FileCompressionType compression, int compression_level = -1);
 	~CopyFileHandle();
 
 	void Write(const_data_ptr_t data, idx_t size);
 	void WriteString(const string &data);
+	// Append data that has already been compressed into BGZF blocks (see CompressBGZFBlocks)
+	void WriteCompressed(const_data_ptr_t data, idx_t size);
+	// Append data that has already been compressed into zstd frames of the given sizes (see CompressZstdFrames)
+	void WriteFrames(const_data_ptr_t data, idx_t size, const vector<miint::ZstdFrameSize> &frames);
 	void Close();
 
+	// True when gzip output is produced as independent BGZF blocks rather than a single deflate stream
+	bool IsBlockCompressed() const {
+		return block_compressed;
+	}
+	// True when zstd output is produced as independent frames, listed in a seek table written on Close()
+	bool IsFrameCompressed() const {
+		return frame_compressed;
+	}
+	int CompressionLevel() const {
+		return compression_level;
+	}
+	// Bytes written to the underlying file so far (compressed size for BGZF output)
+	idx_t BytesWritten() const {
+		return bytes_written;
+	}
+	// True when writing to a pipe (see IsStreamingCopyTarget)
+	bool IsStreaming() const {
+		return streaming;
+	}
+
 private:
+	void WriteRaw(const_data_ptr_t data, idx_t size);
+
 	unique_ptr<BufferedFileWriter> file_writer;
+	// Streaming targets are written straight through: callers already hand over whole buffers, and a
+	// blocking write is what applies backpressure from a slow reader to the writing threads
+	unique_ptr<FileHandle> stream_handle;
+	bool streaming = false;
 	FileCompressionType compression;
+	bool block_compressed = false;
+	bool frame_compressed = false;
+	int compression_level = -1;
+	idx_t bytes_written = 0;
+	unique_ptr<MemoryStream> block_buffer;    // Scratch space for Write() on block- or frame-compressed files
+	vector<miint::ZstdFrameSize> frame_sizes; // Every zstd frame written so far, in file order
 };
 
 //===--------------------------------------------------------------------===//
@@ -39,20 +94,62 @@ struct FormatWriterState {
 
 	void Reset();
 
+	// Remember where the next record starts in the buffer (only when an index is being built)
+	void MarkRecord() {
+		if (track_records) {
+			record_offsets.push_back(stream->GetPosition());
+		}
+	}
+
 	idx_t flush_size;
 	unique_ptr<MemoryStream> stream;
+	unique_ptr<MemoryStream> block_stream; // Thread-local BGZF or zstd output, allocated on first compressed flush
 	bool written_anything = false;
+
+	bool track_records = false;
+	vector<uint64_t> record_offsets;          // Start of each record in stream
+	vector<uint64_t> block_sizes;             // Compressed size of each BGZF block in block_stream
+	vector<miint::ZstdFrameSize> frame_sizes; // Sizes of the zstd frames in block_stream
 };
 
 //===--------------------------------------------------------------------===//
 // Format Writer Helper Functions
 //===--------------------------------------------------------------------===//
-void FlushFormatBuffer(FormatWriterState &local_state, CopyFileHandle &file, mutex &lock);
+// Compress data into one or more complete BGZF blocks appended to out. When block_sizes is given,
+// the compressed size of each block is appended to it.
+void CompressBGZFBlocks(const_data_ptr_t data, idx_t size, MemoryStream &out, int level = -1,
+                        vector<uint64_t> *block_sizes = nullptr);
+
+// Compress data into independent zstd frames appended to out, appending their sizes to frames
+void CompressZstdFrames(const_data_ptr_t data, idx_t size, MemoryStream &out, int level,
+                        vector<miint::ZstdFrameSize> &frames);
+
+// Flush the thread-local buffer to file. Compression happens before the lock is taken,
+// so only the append of finished blocks is serialized across threads. When index is given,
+// the records marked in the buffer are registered with it at their final file position.
+void FlushFormatBuffer(FormatWriterState &local_state, CopyFileHandle &file, mutex &lock,
+                       miint::FastxIndex *index = nullptr);
+
+// Flush two buffers under a single lock acquisition, so files written in lockstep (R1/R2 of split
+// paired-end output) receive each thread's records at the same record positions
+void FlushPairedFormatBuffers(FormatWriterState &state_r1, CopyFileHandle &file_r1, miint::FastxIndex *index_r1,
+                              FormatWriterState &state_r2, CopyFileHandle &file_r2, miint::FastxIndex *index_r2,
+                              mutex &lock);
+
+// Extend the stream by size bytes and return a pointer to them, so a record whose size is known
+// up front can be written in place; the caller must fill all size bytes
+data_ptr_t ReserveStreamSpace(MemoryStream &stream, idx_t size);
+
+// Format a sequence_index value as a record ID into buffer, without allocating
+constexpr idx_t SEQUENCE_INDEX_ID_BUFFER_SIZE = 24;
+string_t FormatSequenceIndexId(int64_t value, char *buffer);
 
 //===--------------------------------------------------------------------===//
 // Common Helper Functions
 //===--------------------------------------------------------------------===//
 FileCompressionType DetectCompressionType(const string &file_path, const Value &compression_param);
+// FileCompressionType::ZSTD, or a NotImplementedException when the extension was built without zstd
+FileCompressionType ZstdCompressionType();
 string SubstituteOrientation(const string &path, const string &orientation);
 bool HasOrientationPlaceholder(const string &path);
 
@@ -80,6 +177,9 @@ struct CommonCopyParameters {
 	bool include_comment = false;
 	FileCompressionType compression = FileCompressionType::UNCOMPRESSED;
 	idx_t flush_size = DEFAULT_COPY_FLUSH_SIZE;
+	bool write_index = false;
+	idx_t index_interval = miint::FastxIndex::DEFAULT_INTERVAL;
+	bool streaming = false; // Set by the caller when the target is a pipe (see IsStreamingCopyTarget)
 
 	void ParseFromOptions(const case_insensitive_map_t<vector<Value>> &options, const string &file_path);
 };
@@ -102,6 +202,8 @@ struct SequenceCopyBindData : public FunctionData {
 	bool include_comment = false;
 	FileCompressionType compression = FileCompressionType::UNCOMPRESSED;
 	idx_t flush_size = DEFAULT_COPY_FLUSH_SIZE;
+	bool write_index = false; // Write a <file>.fxi sidecar index (see FastxIndex)
+	idx_t index_interval = miint::FastxIndex::DEFAULT_INTERVAL;
 	string file_path;
 	bool is_paired = false;
 	vector<string> names;
@@ -117,6 +219,12 @@ struct SequenceCopyGlobalState : public GlobalFunctionData {
 	unique_ptr<CopyFileHandle> file_r2;
 	bool is_paired = false;
 	bool interleave = false;
+
+	// Sidecar indexes, built under lock as buffers are appended (only with INDEX true)
+	unique_ptr<miint::FastxIndex> index_r1;
+	unique_ptr<miint::FastxIndex> index_r2;
+	string path_r1;
+	string path_r2;
 };
 
 // Shared local state for sequence formats (100% identical for FASTA/FASTQ)
@@ -136,11 +244,15 @@ unique_ptr<GlobalFunctionData> SequenceCopyInitializeGlobal(ClientContext &conte
 // Initialize local state for sequence formats
 unique_ptr<LocalFunctionData> SequenceCopyInitializeLocal(ExecutionContext &context, const SequenceCopyBindData &fdata);
 
+// Flush local buffers once either of them has reached the flush size (called at the end of each sink)
+void SequenceCopyFlushIfFull(const SequenceCopyBindData &fdata, SequenceCopyGlobalState &gstate,
+                             SequenceCopyLocalState &lstate);
+
 // Combine (flush) local buffers for sequence formats
 void SequenceCopyCombine(const SequenceCopyBindData &fdata, SequenceCopyGlobalState &gstate,
                          SequenceCopyLocalState &lstate);
 
-// Finalize sequence copy
-void SequenceCopyFinalize(SequenceCopyGlobalState &gstate);
+// Finalize sequence copy: close the files and write their sidecar indexes
+void SequenceCopyFinalize(ClientContext &context, SequenceCopyGlobalState &gstate);
 
 } // namespace duckdb
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "FaithPD.hpp"
+#include "duckdb.hpp"
+#include "duckdb/function/aggregate_function.hpp"
+
+namespace duckdb {
+
+// faith_pd(feature_id, tree): Faith's phylogenetic diversity of the features of a sample, usually grouped by
+// sample_id. The Newick tree at path tree is loaded once per query into a miint::FaithPDTree; a tree registered
+// with miint_load_tree is used by name and keeps its FaithPDTree across queries.
+class FaithPDFunction {
+public:
+	static void Register(ExtensionLoader &loader);
+};
+
+} // namespace duckdb
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "duckdb/common/named_parameter_map.hpp"
+#include "duckdb/main/client_context.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace duckdb {
+
+// Column names of a sample x feature table in long form: one row per (sample, feature, value).
+// The defaults match the output of read_biom.
+struct FeatureTableColumns {
+	std::string sample_id = "sample_id";
+	std::string feature_id = "feature_id";
+	std::string value = "value";
+};
+
+// A sample x feature table in compressed sparse row form. Samples and features are sorted by ID, and the
+// entries of each sample are sorted by feature.
+struct FeatureTable {
+	std::vector<std::string> sample_ids;
+	std::vector<std::string> feature_ids;
+	std::vector<uint64_t> indptr;   // entries of sample i are [indptr[i], indptr[i + 1])
+	std::vector<uint32_t> features; // feature index of each entry
+	std::vector<double> values;     // value of each entry
+
+	size_t SampleCount() const {
+		return sample_ids.size();
+	}
+};
+
+// Parse the optional sample_id/feature_id/value named parameters naming the columns of a feature table
+FeatureTableColumns ParseFeatureTableColumns(const named_parameter_map_t &named_parameters);
+
+// Check that a table or view exists, can be read by ReadFeatureTable, and has the given columns. Throws
+// BinderException otherwise, including for temporary tables and tables created by an uncommitted transaction.
+void ValidateFeatureTable(ClientContext &context, const std::string &table_name, const FeatureTableColumns &columns);
+
+// Read a table or view of (sample, feature, value) rows into a FeatureTable.
+//
+// Like ReadReferenceTable this queries through a separate Connection, so both tables and views work. That
+// connection reads the committed contents: rows changed by the caller's open transaction are not seen.
+// IDs are read as VARCHAR and values as DOUBLE. Rows with a zero value are skipped, and the values of
+// repeated (sample, feature) pairs are added.
+//
+// Throws InvalidInputException on NULL IDs or values and on failing queries.
+FeatureTable ReadFeatureTable(ClientContext &context, const std::string &table_name,
+                              const FeatureTableColumns &columns);
+
+} // namespace duckdb
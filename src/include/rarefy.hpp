@@ -0,0 +1,64 @@
+#pragma once
+#include "feature_table_reader.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/typedefs.hpp"
+#include "duckdb/common/types.hpp"
+#include "duckdb/function/function.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include <string>
+#include <vector>
+
+namespace duckdb {
+
+// rarefy(table, depth, [seed], [sample_id], [feature_id], [value]): subsample every sample of a long-form
+// count table to depth counts without replacement. Samples with fewer than depth counts are dropped.
+class RarefyTableFunction {
+public:
+	struct Data : public TableFunctionData {
+		std::string table_name;
+		FeatureTableColumns columns;
+		uint64_t depth = 0;
+		uint64_t seed = 0;
+
+		std::vector<std::string> names;
+		std::vector<LogicalType> types;
+	};
+
+	struct GlobalState : public GlobalTableFunctionState {
+		mutex lock;
+		FeatureTable table;
+		size_t next_sample = 0;
+		idx_t max_threads = 1;
+
+		idx_t MaxThreads() const override {
+			// Each sample is rarefied independently by whichever thread claims it
+			return max_threads;
+		}
+
+		// Claim the next sample; false once every sample has been claimed
+		bool NextSample(size_t &sample);
+	};
+
+	struct LocalState : public LocalTableFunctionState {
+		size_t sample = 0;
+		std::vector<uint64_t> counts;
+		std::vector<uint64_t> rarefied;
+		size_t position = 0; // next entry of rarefied to emit
+	};
+
+	static unique_ptr<FunctionData> Bind(ClientContext &context, TableFunctionBindInput &input,
+	                                     vector<LogicalType> &return_types, vector<std::string> &names);
+
+	static unique_ptr<GlobalTableFunctionState> InitGlobal(ClientContext &context, TableFunctionInitInput &input);
+	static unique_ptr<LocalTableFunctionState> InitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+	                                                     GlobalTableFunctionState *global_state);
+
+	static void Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output);
+
+	static TableFunction GetFunction();
+	static void Register(ExtensionLoader &loader);
+};
+
+} // namespace duckdb
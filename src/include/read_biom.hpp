@@ -3,11 +3,14 @@
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/typedefs.hpp"
 #include "duckdb/common/types.hpp"
+#include "duckdb/common/types/vector.hpp"
 #include "duckdb/common/vector_size.hpp"
 #include "duckdb/function/function.hpp"
 #include "duckdb/function/table_function.hpp"
 #include "duckdb/main/client_context.hpp"
 #include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include <unordered_set>
 
 namespace duckdb {
 class ReadBIOMTableFunction {
@@ -20,6 +23,13 @@ public:
 		std::vector<LogicalType> types;
 		std::vector<miint::BIOMTableField> fields;
 
+		// Samples and features the scan is restricted to, by the samples parameter and pushed-down
+		// sample_id/feature_id filters. Only the matching slices of the matrices are read.
+		bool filter_samples = false;
+		std::unordered_set<std::string> sample_filter;
+		bool filter_features = false;
+		std::unordered_set<std::string> feature_filter;
+
 		explicit Data(const std::vector<std::string> &paths, bool include_fp)
 		    : biom_paths(paths), include_filepath(include_fp), names({"sample_id", "feature_id", "value"}),
 		      types({LogicalType::VARCHAR,  // sample_id
@@ -34,58 +44,92 @@ public:
 		}
 	};
 
+	// Number of matrix entries a thread claims and reads at a time; bounds the memory of a scan independently
+	// of the size of the table, and is the unit of work that spreads one file across threads
+	static constexpr uint64_t ENTRIES_PER_READ = 1 << 20;
+
+	// A BIOM file being scanned. The open reader is shared by every thread working on the file; all HDF5
+	// calls on it, including closing it, are made under hdf5_lock.
+	struct FileState {
+		std::string path;
+		std::recursive_mutex &hdf5_lock;
+		unique_ptr<miint::BIOMReader> reader;
+		std::vector<std::string> sample_ids;
+		std::vector<std::string> feature_ids;
+		// The IDs as VARCHAR vectors, built once per file; the ID columns are emitted as dictionary vectors
+		// over them rather than copying an ID string into every row
+		unique_ptr<Vector> sample_id_vector;
+		unique_ptr<Vector> feature_id_vector;
+
+		// The matrix read: sample/matrix unless only features are selected
+		miint::BIOMAxis axis = miint::BIOMAxis::SAMPLE;
+		std::vector<int32_t> indptr;
+		// Entry ranges of the selected samples (or features) in axis order; the whole matrix without filters
+		std::vector<std::pair<uint64_t, uint64_t>> ranges;
+
+		FileState(const std::string &path, std::recursive_mutex &hdf5_lock, const Data &data);
+		~FileState();
+
+		const std::vector<std::string> &MajorIDs() const {
+			return axis == miint::BIOMAxis::SAMPLE ? sample_ids : feature_ids;
+		}
+		const std::vector<std::string> &MinorIDs() const {
+			return axis == miint::BIOMAxis::SAMPLE ? feature_ids : sample_ids;
+		}
+		const Vector &MajorIDVector() const {
+			return axis == miint::BIOMAxis::SAMPLE ? *sample_id_vector : *feature_id_vector;
+		}
+		const Vector &MinorIDVector() const {
+			return axis == miint::BIOMAxis::SAMPLE ? *feature_id_vector : *sample_id_vector;
+		}
+	};
+
+	// Entries of one file claimed by a thread: one or more ranges of its matrix
+	struct ScanRange {
+		shared_ptr<FileState> file;
+		std::vector<std::pair<uint64_t, uint64_t>> segments;
+	};
+
 	struct GlobalState : public GlobalTableFunctionState {
 		mutex lock;
-		mutex hdf5_lock; // Serialize HDF5 operations (HDF5 is not thread-safe)
+		std::recursive_mutex &hdf5_lock = miint::hdf5_lock(); // Serialize HDF5 operations (HDF5 is not thread-safe)
 		std::vector<std::string> filepaths;
 		size_t current_file_idx;
+		shared_ptr<FileState> current_file;
+		size_t next_range = 0;
+		uint64_t next_entry = 0;
+		idx_t max_threads = 1;
+		const Data &bind_data;
 
 		idx_t MaxThreads() const override {
-			// Use conservative fixed-thread approach with 4 threads
-			// Each thread processes complete files sequentially from shared queue
-			// Bounded parallelism prevents excessive memory usage
-			return 4;
+			// Files are split into ranges of entries, so any number of threads can share even a single file
+			return max_threads;
 		}
 
-		explicit GlobalState(const std::vector<std::string> &paths) : filepaths(paths), current_file_idx(0) {
+		explicit GlobalState(const Data &data)
+		    : filepaths(data.biom_paths), current_file_idx(0), bind_data(data) {
 		}
+
+		// Claim up to ENTRIES_PER_READ entries, opening the next file once the current one is fully
+		// claimed; false when every file has been claimed
+		bool NextRange(ScanRange &range);
 	};
 
+	// Reads the claimed range: the raw chunks are fetched under hdf5_lock, then decompressed and decoded
+	// without it, so threads only serialize on I/O.
 	struct LocalState : public LocalTableFunctionState {
-		std::string path;
-		miint::BIOMTable table;
-		size_t current_row = 0;
-		size_t total_rows = 0;
-		bool done = false;
-
-		bool GetNextFile(GlobalState &global_state) {
-			{
-				std::lock_guard<std::mutex> guard(global_state.lock);
-
-				if (global_state.current_file_idx >= global_state.filepaths.size()) {
-					done = true;
-					return false;
-				}
-
-				path = global_state.filepaths[global_state.current_file_idx];
-				global_state.current_file_idx++;
-			}
-
-			// Serialize HDF5 operations since HDF5 is not thread-safe
-			{
-				std::lock_guard<std::mutex> hdf5_guard(global_state.hdf5_lock);
-				{
-					auto reader = miint::BIOMReader(path);
-					table = reader.read();
-					// Explicit scope ensures reader destructor runs while holding hdf5_lock
-				}
-			}
-
-			total_rows = table.nnz();
-			current_row = 0;
-
-			return true;
-		}
+		ScanRange range;
+		miint::BIOMRawEntries raw;
+		miint::BIOMEntries segment_entries;
+		miint::BIOMEntries entries; // entries of every segment of range, in order
+		size_t entries_pos = 0;     // next entry of entries to emit
+		size_t segment_idx = 0;     // segment of the next entry
+		uint64_t entry_offset = 0;  // matrix offset of the next entry
+		size_t current_major = 0;   // sample (or feature) of the next entry
+		std::vector<size_t> row_majors; // sample (or feature) index of each row of the chunk being emitted
+
+		// Claim and decode the next range; false once every file has been claimed
+		bool ReadRange(GlobalState &global_state);
 	};
 
 	static unique_ptr<FunctionData> Bind(ClientContext &context, TableFunctionBindInput &input,
@@ -98,13 +142,15 @@ public:
 	static void Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output);
 
 	static void SetResultVector(Vector &result_vector, const miint::BIOMTableField &field,
-	                            const miint::BIOMTable &record, size_t current_row, size_t n_rows);
+	                            const LocalState &local_state, size_t n_rows);
 	static void SetResultVectorString(Vector &result_vector, const miint::BIOMTableField &field,
-	                                  const miint::BIOMTable &record, size_t current_row, size_t n_rows);
-	static void SetResultVectorDouble(Vector &result_vector, const miint::BIOMTableField &field,
-	                                  const miint::BIOMTable &record, size_t current_row, size_t n_rows);
+	                                  const LocalState &local_state, size_t n_rows);
+	static void SetResultVectorDouble(Vector &result_vector, const LocalState &local_state, size_t n_rows);
 	static void SetResultVectorFilepath(Vector &result_vector, const std::string &filepath, size_t num_records);
 
+	static void PushdownComplexFilter(ClientContext &context, LogicalGet &get, FunctionData *bind_data,
+	                                  vector<unique_ptr<Expression>> &filters);
+
 	static TableFunction GetFunction();
 	static void Register(ExtensionLoader &loader);
 };
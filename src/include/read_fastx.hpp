@@ -1,4 +1,5 @@
 #include "SequenceReader.hpp"
+#include "FastxIndex.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/typedefs.hpp"
 #include "duckdb/common/types.hpp"
@@ -8,6 +9,7 @@
 #include "SequenceRecord.hpp"
 #include "QualScore.hpp"
 #include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
 #include <atomic>
 #include <optional>
 #include <thread>
@@ -23,6 +25,14 @@ public:
 		bool uses_stdin;
 		uint8_t qual_offset;
 
+		// Sidecar indexes (<file>.fxi) per file, absent when missing, stale or disabled
+		std::vector<std::optional<miint::FastxIndex>> sequence1_indexes;
+		std::vector<std::optional<miint::FastxIndex>> sequence2_indexes;
+
+		// Bounds on sequence_index derived from the query's filters (applied per file)
+		int64_t sequence_index_min = 1;
+		int64_t sequence_index_max = NumericLimits<int64_t>::Maximum();
+
 		std::vector<std::string> names; // field names
 		std::vector<LogicalType> types; // field types
 
@@ -41,15 +51,25 @@ public:
 		};
 	};
 
+	// Records of an indexed file are split into units of about this many records
+	static constexpr uint64_t READ_UNIT_RECORDS = 131072;
+
+	// A file, or an index-delimited slice of one, read by a single thread
+	struct ReadUnit {
+		size_t file_idx;
+		uint64_t start_record; // 0-based number of the first record in the file
+		bool ranged;           // false reads the whole file
+		miint::SequenceReadRange range;
+	};
+
 	struct GlobalState : public GlobalTableFunctionState {
 		mutex lock;
-		std::vector<std::unique_ptr<miint::SequenceReader>> readers;
+		std::vector<ReadUnit> units;
 		std::vector<std::string> sequence1_filepaths;
-		std::vector<std::string> sequence2_filepaths;
-		size_t next_file_idx; // Next file available for claiming
+		std::optional<std::vector<std::string>> sequence2_filepaths;
+		size_t next_unit_idx; // Next unit available for claiming
 		bool uses_stdin;
-		std::vector<uint64_t>
-		    file_sequence_counters; // Per-file sequence counters (no atomic needed - file access is exclusive)
+		size_t decode_threads = 1; // Threads each reader may decompress a seekable zstd file with
 
 		// stdin cannot be read in parallel (no seeking/rewinding).
 		// This forces sequential execution, which may be slower than
@@ -58,35 +78,18 @@ public:
 			if (uses_stdin) {
 				return 1;
 			}
-			return std::min<idx_t>(readers.size(), std::thread::hardware_concurrency());
+			return std::max<idx_t>(1, std::min<idx_t>(units.size(), std::thread::hardware_concurrency()));
 		};
 
-		GlobalState(const std::vector<std::string> &sequence1_paths,
-		            const std::optional<std::vector<std::string>> &sequence2_paths, bool stdin_used)
-		    : next_file_idx(0), uses_stdin(stdin_used) {
-			sequence1_filepaths = sequence1_paths;
-			if (sequence2_paths.has_value()) {
-				sequence2_filepaths = sequence2_paths.value();
-			}
-
-			for (size_t i = 0; i < sequence1_paths.size(); i++) {
-				if (sequence2_paths.has_value()) {
-					readers.push_back(
-					    std::make_unique<miint::SequenceReader>(sequence1_paths[i], sequence2_paths.value()[i]));
-				} else {
-					readers.push_back(std::make_unique<miint::SequenceReader>(sequence1_paths[i]));
-				}
-				// Initialize per-file sequence counter to 1 (1-based indexing)
-				file_sequence_counters.emplace_back(1);
-			}
-		}
+		explicit GlobalState(const Data &data);
 	};
 
 	struct LocalState : public LocalTableFunctionState {
+		std::unique_ptr<miint::SequenceReader> reader; // Reader of the claimed unit, if any
 		size_t current_file_idx;
-		bool has_file;
+		uint64_t next_sequence_index;
 
-		LocalState() : current_file_idx(0), has_file(false) {
+		LocalState() : current_file_idx(0), next_sequence_index(1) {
 		}
 	};
 
@@ -100,6 +103,11 @@ public:
 
 	static void Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output);
 
+	static unique_ptr<NodeStatistics> Cardinality(ClientContext &context, const FunctionData *bind_data);
+
+	static void PushdownComplexFilter(ClientContext &context, LogicalGet &get, FunctionData *bind_data,
+	                                  vector<unique_ptr<Expression>> &filters);
+
 	static TableFunction GetFunction();
 	static void Register(ExtensionLoader &loader);
 };
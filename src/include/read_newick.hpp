@@ -1,5 +1,7 @@
 #pragma once
 
+#include "MappedFile.hpp"
+#include "NewickStream.hpp"
 #include "NewickTree.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/typedefs.hpp"
@@ -8,24 +10,44 @@
 #include "duckdb/function/table_function.hpp"
 #include "duckdb/main/client_context.hpp"
 #include "duckdb/main/extension/extension_loader.hpp"
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <thread>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace duckdb {
 
 class ReadNewickTableFunction {
 public:
-	// Row of output data for a single node
-	struct NodeRow {
-		int64_t node_index;
-		std::string name;
-		double branch_length;
-		std::optional<int64_t> edge_id;
-		std::optional<int64_t> parent_index;
-		bool is_tip;
+	// Text of a Newick file: uncompressed regular files are memory-mapped, anything else is decoded into memory
+	struct NewickText {
+		std::unique_ptr<miint::MappedFile> mapped;
+		std::string decoded;
+
+		std::string_view view() const {
+			return mapped ? mapped->view() : std::string_view(decoded);
+		}
+	};
+
+	// A file's text and where each of its trees ends, shared by the threads parsing its trees
+	struct NewickFile {
+		std::string path;
+		NewickText text;
+		std::vector<size_t> tree_ends;
+	};
+
+	// Trees [first_tree, end_tree) of a file, parsed by one thread
+	struct TreeBatch {
+		std::shared_ptr<const NewickFile> file;
+		size_t first_tree = 0;
+		size_t end_tree = 0;
 	};
 
+	// Files are split into batches of trees of about this many bytes
+	static constexpr size_t TREE_BATCH_BYTES = 1 << 20;
+
 	struct Data : public TableFunctionData {
 		std::vector<std::string> file_paths;
 		bool include_filepath;
@@ -36,9 +58,9 @@ public:
 
 		Data(const std::vector<std::string> &paths, bool include_fp, bool stdin_used)
 		    : file_paths(paths), include_filepath(include_fp), uses_stdin(stdin_used),
-		      names({"node_index", "name", "branch_length", "edge_id", "parent_index", "is_tip"}),
+		      names({"node_index", "name", "branch_length", "edge_id", "parent_index", "is_tip", "tree_index"}),
 		      types({LogicalType::BIGINT, LogicalType::VARCHAR, LogicalType::DOUBLE, LogicalType::BIGINT,
-		             LogicalType::BIGINT, LogicalType::BOOLEAN}) {
+		             LogicalType::BIGINT, LogicalType::BOOLEAN, LogicalType::BIGINT}) {
 			if (include_filepath) {
 				names.emplace_back("filepath");
 				types.emplace_back(LogicalType::VARCHAR);
@@ -50,29 +72,30 @@ public:
 		std::mutex lock;
 		std::vector<std::string> file_paths;
 		size_t next_file_idx;
-		bool uses_stdin;
+		// Batches of the files opened so far that no thread has taken yet
+		std::deque<TreeBatch> batches;
+		idx_t max_threads;
+		// Threads decoding a zstd file; files are read side by side, so each gets its share of the threads
+		idx_t decode_threads = 1;
 
+		// A file of many trees is parsed by several threads, so there can be more threads than files
 		idx_t MaxThreads() const override {
-			if (uses_stdin) {
-				return 1;
-			}
-			return std::min<idx_t>(file_paths.size(), std::thread::hardware_concurrency());
+			return max_threads;
 		}
 
-		GlobalState(const std::vector<std::string> &paths, bool stdin_used)
-		    : file_paths(paths), next_file_idx(0), uses_stdin(stdin_used) {
+		GlobalState(const std::vector<std::string> &paths, idx_t max_threads_p)
+		    : file_paths(paths), next_file_idx(0), max_threads(max_threads_p) {
 		}
+
+		// Take the next batch of trees, opening and splitting the next file when none is left. False when done.
+		bool NextBatch(TreeBatch &batch);
 	};
 
 	struct LocalState : public LocalTableFunctionState {
-		size_t current_file_idx;
-		bool has_file;
-		std::vector<NodeRow> current_rows;
-		size_t current_row_idx;
-		std::string current_filepath;
-
-		LocalState() : current_file_idx(0), has_file(false), current_row_idx(0) {
-		}
+		TreeBatch batch;
+		size_t current_tree = 0;
+		// Rows are emitted as the parser returns them; the parser reads the file's text in place
+		std::unique_ptr<miint::NewickStreamParser> parser;
 	};
 
 	static unique_ptr<FunctionData> Bind(ClientContext &context, TableFunctionBindInput &input,
@@ -85,11 +108,11 @@ public:
 
 	static void Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output);
 
-	// Helper to read and parse a newick file (handles gzip)
-	static std::string ReadNewickFile(const std::string &path);
+	// Helper to read a newick file (handles gzip and zstd, the latter decoded on up to decode_threads threads)
+	static std::string ReadNewickFile(const std::string &path, size_t decode_threads = 1);
 
-	// Convert parsed tree to row format
-	static std::vector<NodeRow> TreeToRows(const miint::NewickTree &tree);
+	// Open a newick file for parsing, mapping it when it is an uncompressed regular file
+	static NewickText OpenNewickFile(const std::string &path, size_t decode_threads = 1);
 
 	static TableFunction GetFunction();
 	static void Register(ExtensionLoader &loader);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "TreeLCA.hpp"
+#include "duckdb.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+
+namespace duckdb {
+
+// tree_lca(tree, a, b) and tree_distance(tree, a, b): lowest common ancestor (as read_newick's node_index) and
+// patristic distance of two named nodes. The Newick tree at path tree is preprocessed once per query into a
+// miint::TreeLCA, after which every row is answered in constant time. A tree registered with miint_load_tree
+// is used by name and keeps its TreeLCA across queries.
+class TreeLCAFunctions {
+public:
+	static void Register(ExtensionLoader &loader);
+};
+
+} // namespace duckdb
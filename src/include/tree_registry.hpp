@@ -0,0 +1,101 @@
+#pragma once
+
+#include "CompactTree.hpp"
+#include "FaithPD.hpp"
+#include "TreeLCA.hpp"
+#include "duckdb/common/mutex.hpp"
+#include "duckdb/common/optional_idx.hpp"
+#include "duckdb/common/typedefs.hpp"
+#include "duckdb/common/types.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/storage/object_cache.hpp"
+#include <string>
+#include <vector>
+
+namespace duckdb {
+
+// A tree held in memory: parsed once into a miint::CompactTree, with the structures tree functions derive from
+// it built on first use and kept for later queries
+class RegisteredTree : public ObjectCacheEntry {
+public:
+	RegisteredTree(std::string path_p, std::shared_ptr<const miint::CompactTree> tree_p)
+	    : path(std::move(path_p)), tree(std::move(tree_p)) {
+	}
+
+	const std::string path;
+	const std::shared_ptr<const miint::CompactTree> tree;
+
+	shared_ptr<const miint::TreeLCA> LCA();
+	shared_ptr<const miint::FaithPDTree> FaithPD();
+
+	static std::string ObjectType() {
+		return "miint_tree";
+	}
+	std::string GetObjectType() override {
+		return ObjectType();
+	}
+	// Registered trees are never evicted
+	optional_idx GetEstimatedCacheMemory() const override {
+		return optional_idx();
+	}
+
+private:
+	mutex lock;
+	shared_ptr<const miint::TreeLCA> lca;
+	shared_ptr<const miint::FaithPDTree> faith_pd;
+};
+
+// Named trees of a database, kept in its object cache
+class TreeRegistry {
+public:
+	// Parse the Newick file at path and register it as name, replacing any tree of that name
+	static shared_ptr<RegisteredTree> Load(ClientContext &context, const std::string &name, const std::string &path);
+	// Tree registered as name, or nullptr
+	static shared_ptr<RegisteredTree> Get(ClientContext &context, const std::string &name);
+	// Tree registered as tree, or else the Newick file at path tree, parsed for this caller only. Errors name
+	// function_name.
+	static shared_ptr<RegisteredTree> Resolve(ClientContext &context, const std::string &tree,
+	                                          const std::string &function_name);
+	// Parse the Newick file at path
+	static shared_ptr<RegisteredTree> Parse(const std::string &path, const std::string &function_name);
+};
+
+// miint_load_tree(name, path): parse a Newick file once and register it under name for tree functions
+class MiintLoadTreeTableFunction {
+public:
+	struct Data : public TableFunctionData {
+		std::string name;
+		std::string path;
+
+		std::vector<std::string> names;
+		std::vector<LogicalType> types;
+
+		Data()
+		    : names({"name", "path", "num_nodes", "num_tips"}),
+		      types({LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::BIGINT, LogicalType::BIGINT}) {
+		}
+	};
+
+	struct GlobalState : public GlobalTableFunctionState {
+		shared_ptr<RegisteredTree> tree;
+		bool done = false;
+
+		idx_t MaxThreads() const override {
+			return 1;
+		}
+	};
+
+	static unique_ptr<FunctionData> Bind(ClientContext &context, TableFunctionBindInput &input,
+	                                     vector<LogicalType> &return_types, vector<std::string> &names);
+
+	static unique_ptr<GlobalTableFunctionState> InitGlobal(ClientContext &context, TableFunctionInitInput &input);
+
+	static void Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output);
+
+	static TableFunction GetFunction();
+	static void Register(ExtensionLoader &loader);
+};
+
+} // namespace duckdb
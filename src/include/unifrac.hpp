@@ -0,0 +1,73 @@
+#pragma once
+#include "UniFrac.hpp"
+#include "feature_table_reader.hpp"
+#include "tree_registry.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/typedefs.hpp"
+#include "duckdb/common/types.hpp"
+#include "duckdb/function/function.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include <string>
+#include <vector>
+
+namespace duckdb {
+
+// unifrac(table, tree, metric, [sample_id], [feature_id], [value]): UniFrac distances between the samples of a
+// long-form count table over the tree registered as tree, or else the Newick file at path tree, one row per pair of
+// samples (each pair once)
+class UniFracTableFunction {
+public:
+	struct Data : public TableFunctionData {
+		std::string table_name;
+		std::string tree_path;
+		shared_ptr<RegisteredTree> tree;
+		FeatureTableColumns columns;
+		miint::UniFracMetric metric = miint::UniFracMetric::UNWEIGHTED;
+
+		std::vector<std::string> names;
+		std::vector<LogicalType> types;
+
+		Data()
+		    : names({"sample_a", "sample_b", "distance"}),
+		      types({LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::DOUBLE}) {
+		}
+	};
+
+	struct GlobalState : public GlobalTableFunctionState {
+		mutex lock;
+		FeatureTable table;
+		miint::UniFrac unifrac;
+		size_t next_stripe = 0;
+		idx_t max_threads = 1;
+
+		idx_t MaxThreads() const override {
+			// Stripes of the distance matrix are emitted by whichever thread claims them
+			return max_threads;
+		}
+
+		// Claim the next stripe of the distance matrix; false once every stripe has been claimed
+		bool NextStripe(size_t &stripe);
+	};
+
+	struct LocalState : public LocalTableFunctionState {
+		size_t stripe = 0;
+		size_t length = 0;   // pairs in stripe
+		size_t position = 0; // next pair of stripe to emit
+	};
+
+	static unique_ptr<FunctionData> Bind(ClientContext &context, TableFunctionBindInput &input,
+	                                     vector<LogicalType> &return_types, vector<std::string> &names);
+
+	static unique_ptr<GlobalTableFunctionState> InitGlobal(ClientContext &context, TableFunctionInitInput &input);
+	static unique_ptr<LocalTableFunctionState> InitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+	                                                     GlobalTableFunctionState *global_state);
+
+	static void Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output);
+
+	static TableFunction GetFunction();
+	static void Register(ExtensionLoader &loader);
+};
+
+} // namespace duckdb
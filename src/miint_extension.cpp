@@ -4,6 +4,10 @@
 #include <csignal>
 #include <alignment_flag_functions.hpp>
 #include <alignment_functions.hpp>
+#include <alpha_diversity.hpp>
+#include <faith_pd.hpp>
+#include <tree_lca.hpp>
+#include <tree_registry.hpp>
 #include <compress_intervals.hpp>
 #include <copy_biom.hpp>
 #include <copy_fasta.hpp>
@@ -17,6 +21,10 @@
 #include <read_sequences_sam.hpp>
 #include <read_sequences_sff.hpp>
 #include <read_biom.hpp>
+#include <biom_merge.hpp>
+#include <rarefy.hpp>
+#include <beta_diversity.hpp>
+#include <unifrac.hpp>
 #include <align_minimap2.hpp>
 #include <align_minimap2_sharded.hpp>
 #include <save_minimap2_index.hpp>
@@ -74,6 +82,10 @@ static void LoadInternal(ExtensionLoader &loader) {
 	ReadSequencesSamTableFunction::Register(loader);
 	ReadSequencesSFFTableFunction::Register(loader);
 	ReadBIOMTableFunction::Register(loader);
+	BiomMergeTableFunction::Register(loader);
+	RarefyTableFunction::Register(loader);
+	BetaDiversityTableFunction::Register(loader);
+	UniFracTableFunction::Register(loader);
 	ReadNewickTableFunction::Register(loader);
 	AlignMinimap2TableFunction::Register(loader);
 	AlignMinimap2ShardedTableFunction::Register(loader);
@@ -90,6 +102,10 @@ static void LoadInternal(ExtensionLoader &loader) {
 	AlignmentQueryLengthFunction::Register(loader);
 	AlignmentQueryCoverageFunction::Register(loader);
 	CompressIntervalsFunction::Register(loader);
+	AlphaDiversityFunctions::Register(loader);
+	FaithPDFunction::Register(loader);
+	TreeLCAFunctions::Register(loader);
+	MiintLoadTreeTableFunction::Register(loader);
 	SequenceFunctions::Register(loader);
 
 	AlignPairwiseScoreFunction::Register(loader);
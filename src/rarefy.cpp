@@ -0,0 +1,145 @@
+#include "rarefy.hpp"
+#include "Rarefaction.hpp"
+#include "duckdb/common/types/vector.hpp"
+#include "duckdb/common/vector_size.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include <cmath>
+
+namespace duckdb {
+
+unique_ptr<FunctionData> RarefyTableFunction::Bind(ClientContext &context, TableFunctionBindInput &input,
+                                                   vector<LogicalType> &return_types, vector<std::string> &names) {
+	auto data = make_uniq<Data>();
+
+	if (input.inputs[0].IsNull()) {
+		throw BinderException("rarefy: table must not be NULL");
+	}
+	data->table_name = input.inputs[0].ToString();
+
+	if (input.inputs[1].IsNull()) {
+		throw BinderException("rarefy: depth must not be NULL");
+	}
+	auto depth = input.inputs[1].GetValue<int64_t>();
+	if (depth <= 0) {
+		throw BinderException("rarefy: depth must be positive");
+	}
+	data->depth = static_cast<uint64_t>(depth);
+
+	auto seed = input.named_parameters.find("seed");
+	if (seed != input.named_parameters.end() && !seed->second.IsNull()) {
+		data->seed = static_cast<uint64_t>(seed->second.GetValue<int64_t>());
+	}
+
+	data->columns = ParseFeatureTableColumns(input.named_parameters);
+	ValidateFeatureTable(context, data->table_name, data->columns);
+
+	// Output columns keep the names of the input columns, so the result reads like the table it came from
+	data->names = {data->columns.sample_id, data->columns.feature_id, data->columns.value};
+	data->types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::DOUBLE};
+	names = data->names;
+	return_types = data->types;
+
+	return std::move(data);
+}
+
+bool RarefyTableFunction::GlobalState::NextSample(size_t &sample) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (next_sample >= table.SampleCount()) {
+		return false;
+	}
+	sample = next_sample++;
+	return true;
+}
+
+unique_ptr<GlobalTableFunctionState> RarefyTableFunction::InitGlobal(ClientContext &context,
+                                                                     TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<Data>();
+	auto gstate = make_uniq<GlobalState>();
+	gstate->table = ReadFeatureTable(context, bind_data.table_name, bind_data.columns);
+	gstate->max_threads =
+	    static_cast<idx_t>(MaxValue<int32_t>(TaskScheduler::GetScheduler(context).NumberOfThreads(), 1));
+	return std::move(gstate);
+}
+
+unique_ptr<LocalTableFunctionState> RarefyTableFunction::InitLocal(ExecutionContext &context,
+                                                                   TableFunctionInitInput &input,
+                                                                   GlobalTableFunctionState *global_state) {
+	return make_uniq<LocalState>();
+}
+
+// Counts of one sample, which must be whole and non-negative
+static void SampleCounts(const FeatureTable &table, size_t sample, std::vector<uint64_t> &counts) {
+	counts.clear();
+	for (uint64_t i = table.indptr[sample]; i < table.indptr[sample + 1]; i++) {
+		double value = table.values[i];
+		if (!(value >= 0) || value != std::floor(value) || value >= 9007199254740992.0) {
+			throw InvalidInputException("rarefy: value %s of feature '%s' in sample '%s' is not a count",
+			                            std::to_string(value), table.feature_ids[table.features[i]],
+			                            table.sample_ids[sample]);
+		}
+		counts.push_back(static_cast<uint64_t>(value));
+	}
+}
+
+void RarefyTableFunction::Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &bind_data = data_p.bind_data->Cast<Data>();
+	auto &global_state = data_p.global_state->Cast<GlobalState>();
+	auto &local_state = data_p.local_state->Cast<LocalState>();
+	const auto &table = global_state.table;
+
+	auto sample_data = FlatVector::GetData<string_t>(output.data[0]);
+	auto feature_data = FlatVector::GetData<string_t>(output.data[1]);
+	auto value_data = FlatVector::GetData<double>(output.data[2]);
+
+	idx_t n_rows = 0;
+	while (n_rows < STANDARD_VECTOR_SIZE) {
+		if (local_state.position >= local_state.rarefied.size()) {
+			// Claim the next sample deep enough to rarefy
+			if (!global_state.NextSample(local_state.sample)) {
+				break;
+			}
+			SampleCounts(table, local_state.sample, local_state.counts);
+			uint64_t total = 0;
+			for (auto count : local_state.counts) {
+				total += count;
+			}
+			local_state.position = 0;
+			if (total < bind_data.depth) {
+				local_state.rarefied.clear();
+				continue;
+			}
+			const auto &sample_id = table.sample_ids[local_state.sample];
+			miint::RarefactionRandom random(miint::rarefaction_seed(bind_data.seed, sample_id));
+			miint::rarefy(local_state.counts, bind_data.depth, random, local_state.rarefied);
+		}
+
+		auto entry = table.indptr[local_state.sample] + local_state.position;
+		auto count = local_state.rarefied[local_state.position++];
+		if (count == 0) {
+			continue;
+		}
+		sample_data[n_rows] = StringVector::AddString(output.data[0], table.sample_ids[local_state.sample]);
+		feature_data[n_rows] = StringVector::AddString(output.data[1], table.feature_ids[table.features[entry]]);
+		value_data[n_rows] = static_cast<double>(count);
+		n_rows++;
+	}
+
+	output.SetCardinality(n_rows);
+}
+
+TableFunction RarefyTableFunction::GetFunction() {
+	TableFunction tf("rarefy", {LogicalType::VARCHAR, LogicalType::BIGINT}, Execute, Bind, InitGlobal, InitLocal);
+
+	tf.named_parameters["seed"] = LogicalType::BIGINT;
+	tf.named_parameters["sample_id"] = LogicalType::VARCHAR;
+	tf.named_parameters["feature_id"] = LogicalType::VARCHAR;
+	tf.named_parameters["value"] = LogicalType::VARCHAR;
+
+	return tf;
+}
+
+void RarefyTableFunction::Register(ExtensionLoader &loader) {
+	loader.RegisterFunction(GetFunction());
+}
+
+} // namespace duckdb
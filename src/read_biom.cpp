@@ -6,9 +6,27 @@
 #include "duckdb/catalog/catalog_entry/table_catalog_entry.hpp"
 #include "duckdb/common/types.hpp"
 #include "duckdb/common/vector_size.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_comparison_expression.hpp"
+#include "duckdb/planner/expression/bound_conjunction_expression.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
+#include "duckdb/planner/expression/bound_operator_expression.hpp"
+#include <algorithm>
 
 namespace duckdb {
 
+// Restrict active/current to the IDs also in ids; several restrictions on one column intersect
+static void RestrictIDs(bool &active, std::unordered_set<std::string> &current, std::unordered_set<std::string> ids) {
+	if (active) {
+		for (auto it = ids.begin(); it != ids.end();) {
+			it = current.count(*it) ? std::next(it) : ids.erase(it);
+		}
+	}
+	current = std::move(ids);
+	active = true;
+}
+
 unique_ptr<FunctionData> ReadBIOMTableFunction::Bind(ClientContext &context, TableFunctionBindInput &input,
                                                      vector<LogicalType> &return_types, vector<std::string> &names) {
 	FileSystem &fs = FileSystem::GetFileSystem(context);
@@ -38,6 +56,7 @@ unique_ptr<FunctionData> ReadBIOMTableFunction::Bind(ClientContext &context, Tab
 			throw IOException("File not found: " + path);
 		}
 
+		std::lock_guard<std::recursive_mutex> hdf5_guard(miint::hdf5_lock());
 		if (!miint::BIOMReader::IsBIOM(path)) {
 			throw IOException("File is not a BIOM file: " + path);
 		}
@@ -47,6 +66,21 @@ unique_ptr<FunctionData> ReadBIOMTableFunction::Bind(ClientContext &context, Tab
 
 	auto data = duckdb::make_uniq<Data>(biom_paths, include_filepath);
 
+	auto samples = input.named_parameters.find("samples");
+	if (samples != input.named_parameters.end()) {
+		if (samples->second.IsNull()) {
+			throw InvalidInputException("read_biom: samples must be a list of sample IDs");
+		}
+		std::unordered_set<std::string> ids;
+		for (const auto &child : ListValue::GetChildren(samples->second)) {
+			if (child.IsNull()) {
+				throw InvalidInputException("read_biom: samples must not contain NULL");
+			}
+			ids.insert(child.ToString());
+		}
+		RestrictIDs(data->filter_samples, data->sample_filter, std::move(ids));
+	}
+
 	for (auto &name : data->names) {
 		names.emplace_back(name);
 	}
@@ -60,32 +94,185 @@ unique_ptr<GlobalTableFunctionState> ReadBIOMTableFunction::InitGlobal(ClientCon
                                                                        TableFunctionInitInput &input) {
 	auto &data = input.bind_data->Cast<Data>();
 
-	auto gstate = duckdb::make_uniq<GlobalState>(data.biom_paths);
+	auto gstate = duckdb::make_uniq<GlobalState>(data);
+	gstate->max_threads =
+	    static_cast<idx_t>(MaxValue<int32_t>(TaskScheduler::GetScheduler(context).NumberOfThreads(), 1));
 
 	return std::move(gstate);
 }
 
+// Indices of the IDs in filter, in file order
+static std::vector<size_t> SelectIDs(const std::vector<std::string> &ids,
+                                     const std::unordered_set<std::string> &filter) {
+	std::vector<size_t> selected;
+	for (size_t i = 0; i < ids.size(); i++) {
+		if (filter.count(ids[i])) {
+			selected.push_back(i);
+		}
+	}
+	return selected;
+}
+
+// A VARCHAR vector holding ids, the dictionary of an ID column
+static unique_ptr<Vector> MakeIDVector(const std::vector<std::string> &ids) {
+	auto vector = make_uniq<Vector>(LogicalType::VARCHAR, MaxValue<idx_t>(ids.size(), 1));
+	auto data = FlatVector::GetData<string_t>(*vector);
+	for (size_t i = 0; i < ids.size(); i++) {
+		data[i] = StringVector::AddString(*vector, ids[i]);
+	}
+	return vector;
+}
+
+// The sample (or feature) holding the entry at offset: the last one whose entries start at or before it
+static size_t FindMajor(const std::vector<int32_t> &indptr, uint64_t offset) {
+	auto major = std::upper_bound(indptr.begin(), indptr.end(), static_cast<int64_t>(offset));
+	return static_cast<size_t>(major - indptr.begin()) - 1;
+}
+
+ReadBIOMTableFunction::FileState::FileState(const std::string &path_p, std::recursive_mutex &hdf5_lock_p,
+                                            const Data &data)
+    : path(path_p), hdf5_lock(hdf5_lock_p) {
+	// Serialize HDF5 operations since HDF5 is not thread-safe
+	std::lock_guard<std::recursive_mutex> hdf5_guard(hdf5_lock);
+	try {
+		reader = make_uniq<miint::BIOMReader>(path);
+		sample_ids = reader->read_sample_ids();
+		feature_ids = reader->read_feature_ids();
+		// A feature selection without a sample selection reads the features' rows of observation/matrix;
+		// otherwise the samples' columns of sample/matrix (other filters are applied to the rows read)
+		if (!data.filter_samples && data.filter_features && reader->has_observation_matrix()) {
+			axis = miint::BIOMAxis::OBSERVATION;
+		}
+		indptr = reader->read_indptr(axis);
+	} catch (const std::runtime_error &e) {
+		reader.reset();
+		throw IOException("read_biom: failed to read " + path + ": " + e.what());
+	}
+	if (indptr.size() != MajorIDs().size() + 1) {
+		reader.reset();
+		throw IOException("read_biom: corrupt BIOM file " + path + ": " + std::to_string(MajorIDs().size()) +
+		                  " IDs but " + std::to_string(indptr.size()) + " pointers");
+	}
+	sample_id_vector = MakeIDVector(sample_ids);
+	feature_id_vector = MakeIDVector(feature_ids);
+
+	if (!data.filter_samples && axis == miint::BIOMAxis::SAMPLE) {
+		if (indptr.back() > 0) {
+			ranges.emplace_back(0, static_cast<uint64_t>(indptr.back()));
+		}
+		return;
+	}
+	const auto &filter = axis == miint::BIOMAxis::SAMPLE ? data.sample_filter : data.feature_filter;
+	for (auto major : SelectIDs(MajorIDs(), filter)) {
+		uint64_t begin = indptr[major];
+		uint64_t end = indptr[major + 1];
+		if (begin == end) {
+			continue;
+		}
+		if (!ranges.empty() && ranges.back().second == begin) {
+			ranges.back().second = end; // adjacent selections are read as one range
+		} else {
+			ranges.emplace_back(begin, end);
+		}
+	}
+}
+
+ReadBIOMTableFunction::FileState::~FileState() {
+	std::lock_guard<std::recursive_mutex> hdf5_guard(hdf5_lock);
+	reader.reset();
+}
+
+bool ReadBIOMTableFunction::GlobalState::NextRange(ScanRange &range) {
+	std::lock_guard<std::mutex> guard(lock);
+	while (!current_file || next_range >= current_file->ranges.size()) {
+		current_file.reset();
+		if (current_file_idx >= filepaths.size()) {
+			return false;
+		}
+		auto &path = filepaths[current_file_idx++];
+		current_file = make_shared_ptr<FileState>(path, hdf5_lock, bind_data);
+		next_range = 0;
+		next_entry = current_file->ranges.empty() ? 0 : current_file->ranges[0].first;
+	}
+
+	// Small selections are batched into one claim, so scattered samples do not each cost a round trip
+	range.file = current_file;
+	range.segments.clear();
+	uint64_t claimed = 0;
+	auto &ranges = current_file->ranges;
+	while (claimed < ENTRIES_PER_READ && next_range < ranges.size()) {
+		uint64_t end = std::min(ranges[next_range].second, next_entry + (ENTRIES_PER_READ - claimed));
+		range.segments.emplace_back(next_entry, end);
+		claimed += end - next_entry;
+		next_entry = end;
+		if (next_entry >= ranges[next_range].second && ++next_range < ranges.size()) {
+			next_entry = ranges[next_range].first;
+		}
+	}
+	return true;
+}
+
+bool ReadBIOMTableFunction::LocalState::ReadRange(GlobalState &global_state) {
+	// Drop the previous file first, so a file nobody else is reading is closed before the next one opens
+	range.file.reset();
+	entries_pos = 0;
+	entries.indices.clear();
+	entries.data.clear();
+	if (!global_state.NextRange(range)) {
+		return false;
+	}
+
+	auto &file = *range.file;
+	try {
+		for (auto &segment : range.segments) {
+			{
+				std::lock_guard<std::recursive_mutex> hdf5_guard(global_state.hdf5_lock);
+				file.reader->read_entries_raw(file.axis, segment.first, segment.second, raw);
+			}
+			if (range.segments.size() == 1) {
+				file.reader->decode_entries(raw, entries);
+				break;
+			}
+			file.reader->decode_entries(raw, segment_entries);
+			entries.indices.insert(entries.indices.end(), segment_entries.indices.begin(),
+			                       segment_entries.indices.end());
+			entries.data.insert(entries.data.end(), segment_entries.data.begin(), segment_entries.data.end());
+		}
+	} catch (const std::runtime_error &e) {
+		throw IOException("read_biom: failed to read " + file.path + ": " + e.what());
+	}
+
+	auto n_minor = file.MinorIDs().size();
+	for (auto index : entries.indices) {
+		if (index < 0 || static_cast<size_t>(index) >= n_minor) {
+			throw IOException("read_biom: corrupt BIOM file " + file.path + ": index " + std::to_string(index) +
+			                  " is out of range");
+		}
+	}
+
+	segment_idx = 0;
+	entry_offset = range.segments[0].first;
+	current_major = FindMajor(file.indptr, entry_offset);
+	return true;
+}
+
 unique_ptr<LocalTableFunctionState> ReadBIOMTableFunction::InitLocal(ExecutionContext &context,
                                                                      TableFunctionInitInput &input,
                                                                      GlobalTableFunctionState *global_state) {
 	auto local_state = make_uniq<LocalState>();
-	auto &gstate = global_state->Cast<GlobalState>();
-
-	// Each thread grabs its first file
-	local_state->GetNextFile(gstate);
-
-	return local_state;
+	local_state->row_majors.resize(STANDARD_VECTOR_SIZE);
+	return std::move(local_state);
 }
 
 void ReadBIOMTableFunction::SetResultVector(Vector &result_vector, const miint::BIOMTableField &field,
-                                            const miint::BIOMTable &record, size_t current_row, size_t n_rows) {
+                                            const LocalState &local_state, size_t n_rows) {
 	switch (field) {
 	case miint::BIOMTableField::SAMPLE_ID:
 	case miint::BIOMTableField::FEATURE_ID:
-		SetResultVectorString(result_vector, field, record, current_row, n_rows);
+		SetResultVectorString(result_vector, field, local_state, n_rows);
 		break;
 	case miint::BIOMTableField::VALUE:
-		SetResultVectorDouble(result_vector, field, record, current_row, n_rows);
+		SetResultVectorDouble(result_vector, local_state, n_rows);
 		break;
 	default:
 		throw NotImplementedException("field not supported");
@@ -93,26 +280,33 @@ void ReadBIOMTableFunction::SetResultVector(Vector &result_vector, const miint::
 }
 
 void ReadBIOMTableFunction::SetResultVectorString(Vector &result_vector, const miint::BIOMTableField &field,
-                                                  const miint::BIOMTable &record, size_t current_row, size_t n_rows) {
-	auto result_data = FlatVector::GetData<string_t>(result_vector);
-
-	const auto &indices =
-	    (field == miint::BIOMTableField::SAMPLE_ID) ? record.COOSampleIndices() : record.COOFeatureIndices();
-	const auto &ordered_ids = (field == miint::BIOMTableField::SAMPLE_ID) ? record.SampleIDs() : record.FeatureIDs();
-
-	for (size_t i = 0; i < n_rows; i++) {
-		auto index = indices[current_row + i];
-		result_data[i] = StringVector::AddString(result_vector, ordered_ids[index]);
+                                                  const LocalState &local_state, size_t n_rows) {
+	// Rows name their major ID through row_majors and their minor ID through the entry's index; either way the
+	// column is a selection over the file's ID vector, so no string is copied
+	auto &file = *local_state.range.file;
+	SelectionVector sel(n_rows);
+	bool is_major = (field == miint::BIOMTableField::SAMPLE_ID) == (file.axis == miint::BIOMAxis::SAMPLE);
+	if (is_major) {
+		for (size_t i = 0; i < n_rows; i++) {
+			sel.set_index(i, local_state.row_majors[i]);
+		}
+		result_vector.Slice(file.MajorIDVector(), sel, n_rows);
+	} else {
+		const auto *indices = local_state.entries.indices.data() + local_state.entries_pos;
+		for (size_t i = 0; i < n_rows; i++) {
+			sel.set_index(i, static_cast<idx_t>(indices[i]));
+		}
+		result_vector.Slice(file.MinorIDVector(), sel, n_rows);
 	}
 }
 
-void ReadBIOMTableFunction::SetResultVectorDouble(Vector &result_vector, const miint::BIOMTableField &field,
-                                                  const miint::BIOMTable &record, size_t current_row, size_t n_rows) {
+void ReadBIOMTableFunction::SetResultVectorDouble(Vector &result_vector, const LocalState &local_state,
+                                                  size_t n_rows) {
 	auto result_data = FlatVector::GetData<double>(result_vector);
-	auto &data = record.COOValues();
+	const auto *data = local_state.entries.data.data() + local_state.entries_pos;
 
 	for (size_t i = 0; i < n_rows; i++) {
-		result_data[i] = data[current_row + i];
+		result_data[i] = data[i];
 	}
 }
 
@@ -128,41 +322,159 @@ void ReadBIOMTableFunction::Execute(ClientContext &context, TableFunctionInput &
 	auto &global_state = data_p.global_state->Cast<GlobalState>();
 	auto &local_state = data_p.local_state->Cast<LocalState>();
 
-	// Check if we need to load the next file
-	while (local_state.current_row >= local_state.total_rows) {
-		// Current file is exhausted, try to get next file
-		bool got_file = local_state.GetNextFile(global_state);
-		if (!got_file) {
+	// Claim and read the next range of entries once the current one has been emitted
+	while (local_state.entries_pos >= local_state.entries.size()) {
+		if (!local_state.ReadRange(global_state)) {
 			// No more files to process
 			output.SetCardinality(0);
 			return;
 		}
-		// GetNextFile resets current_row to 0 and loads new table
 	}
 
-	// Calculate how many rows we can emit in this chunk
-	size_t n_rows =
-	    std::min(local_state.current_row + STANDARD_VECTOR_SIZE, local_state.total_rows) - local_state.current_row;
+	size_t n_rows = std::min<size_t>(STANDARD_VECTOR_SIZE, local_state.entries.size() - local_state.entries_pos);
+
+	// Walk the pointers to find the sample (or feature) of each row
+	const auto &indptr = local_state.range.file->indptr;
+	const auto &segments = local_state.range.segments;
+	for (size_t i = 0; i < n_rows; i++) {
+		if (local_state.entry_offset >= segments[local_state.segment_idx].second) {
+			local_state.segment_idx++;
+			local_state.entry_offset = segments[local_state.segment_idx].first;
+			local_state.current_major = FindMajor(indptr, local_state.entry_offset);
+		}
+		while (static_cast<uint64_t>(indptr[local_state.current_major + 1]) <= local_state.entry_offset) {
+			local_state.current_major++;
+		}
+		local_state.row_majors[i] = local_state.current_major;
+		local_state.entry_offset++;
+	}
 
 	for (size_t i = 0; i < bind_data.fields.size(); i++) {
 		auto &result_vector = output.data[i];
 		auto &field = bind_data.fields[i];
-		SetResultVector(result_vector, field, local_state.table, local_state.current_row, n_rows);
+		SetResultVector(result_vector, field, local_state, n_rows);
 	}
 
 	if (bind_data.include_filepath) {
 		auto &result_vector = output.data[bind_data.fields.size()];
-		SetResultVectorFilepath(result_vector, local_state.path, n_rows);
+		SetResultVectorFilepath(result_vector, local_state.range.file->path, n_rows);
 	}
 
 	output.SetCardinality(n_rows);
-	local_state.current_row += n_rows;
+	local_state.entries_pos += n_rows;
+}
+
+// Output column of read_biom referenced by expr, or DConstants::INVALID_INDEX
+static idx_t GetColumn(const LogicalGet &get, const Expression &expr) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF) {
+		return DConstants::INVALID_INDEX;
+	}
+	auto &colref = expr.Cast<BoundColumnRefExpression>();
+	auto &column_ids = get.GetColumnIds();
+	if (colref.binding.table_index != get.table_index || colref.binding.column_index >= column_ids.size()) {
+		return DConstants::INVALID_INDEX;
+	}
+	return column_ids[colref.binding.column_index].GetPrimaryIndex();
+}
+
+static bool GetVarcharConstant(const Expression &expr, std::string &result) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_CONSTANT) {
+		return false;
+	}
+	auto &value = expr.Cast<BoundConstantExpression>().value;
+	if (value.IsNull() || value.type().id() != LogicalTypeId::VARCHAR) {
+		return false;
+	}
+	result = StringValue::Get(value);
+	return true;
+}
+
+// True when expr only holds for rows whose column is one of ids: "column = 'x'", "column IN (...)", or an OR
+// of these over a single column
+static bool CollectIDs(const LogicalGet &get, const Expression &expr, idx_t &column,
+                       std::unordered_set<std::string> &ids) {
+	auto same_column = [&](const Expression &column_expr) {
+		auto index = GetColumn(get, column_expr);
+		if (index == DConstants::INVALID_INDEX || (column != DConstants::INVALID_INDEX && column != index)) {
+			return false;
+		}
+		column = index;
+		return true;
+	};
+
+	std::string id;
+	switch (expr.GetExpressionClass()) {
+	case ExpressionClass::BOUND_COMPARISON: {
+		auto &comparison = expr.Cast<BoundComparisonExpression>();
+		if (comparison.GetExpressionType() != ExpressionType::COMPARE_EQUAL) {
+			return false;
+		}
+		if (GetVarcharConstant(*comparison.right, id) && same_column(*comparison.left)) {
+			ids.insert(id);
+			return true;
+		}
+		if (GetVarcharConstant(*comparison.left, id) && same_column(*comparison.right)) {
+			ids.insert(id);
+			return true;
+		}
+		return false;
+	}
+	case ExpressionClass::BOUND_OPERATOR: {
+		auto &op = expr.Cast<BoundOperatorExpression>();
+		if (op.GetExpressionType() != ExpressionType::COMPARE_IN || op.children.empty() ||
+		    !same_column(*op.children[0])) {
+			return false;
+		}
+		for (size_t i = 1; i < op.children.size(); i++) {
+			if (!GetVarcharConstant(*op.children[i], id)) {
+				return false;
+			}
+			ids.insert(id);
+		}
+		return true;
+	}
+	case ExpressionClass::BOUND_CONJUNCTION: {
+		auto &conjunction = expr.Cast<BoundConjunctionExpression>();
+		if (conjunction.GetExpressionType() != ExpressionType::CONJUNCTION_OR) {
+			return false;
+		}
+		for (auto &child : conjunction.children) {
+			if (!CollectIDs(get, *child, column, ids)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+void ReadBIOMTableFunction::PushdownComplexFilter(ClientContext &context, LogicalGet &get, FunctionData *bind_data,
+                                                  vector<unique_ptr<Expression>> &filters) {
+	auto &data = bind_data->Cast<Data>();
+	for (auto &filter : filters) {
+		idx_t column = DConstants::INVALID_INDEX;
+		std::unordered_set<std::string> ids;
+		if (!CollectIDs(get, *filter, column, ids)) {
+			continue;
+		}
+		// sample_id and feature_id are the first two columns of read_biom
+		if (column == 0) {
+			RestrictIDs(data.filter_samples, data.sample_filter, std::move(ids));
+		} else if (column == 1) {
+			RestrictIDs(data.filter_features, data.feature_filter, std::move(ids));
+		}
+	}
+	// Filters are left in place: a sample selection still reads every feature of the selected samples
 }
 
 TableFunction ReadBIOMTableFunction::GetFunction() {
 	auto tf = TableFunction("read_biom", {LogicalType::ANY}, Execute, Bind, InitGlobal);
 	tf.named_parameters["include_filepath"] = LogicalType::BOOLEAN;
+	tf.named_parameters["samples"] = LogicalType::LIST(LogicalType::VARCHAR);
 	tf.init_local = InitLocal;
+	tf.pushdown_complex_filter = PushdownComplexFilter;
 	return tf;
 }
 
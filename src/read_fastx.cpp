@@ -4,10 +4,40 @@
 #include "duckdb/common/types.hpp"
 #include "duckdb/common/vector_size.hpp"
 #include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/planner/expression/bound_between_expression.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_comparison_expression.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
 #include <read_fastx.hpp>
 
 namespace duckdb {
 
+// Load <path>.fxi if it exists and still describes path (the indexed file size must match)
+static std::optional<miint::FastxIndex> LoadFastxIndex(FileSystem &fs, const std::string &path) {
+	auto index_path = path + miint::FastxIndex::EXTENSION;
+	if (!fs.FileExists(index_path)) {
+		return std::nullopt;
+	}
+
+	auto index_handle = fs.OpenFile(index_path, FileFlags::FILE_FLAGS_READ);
+	std::string serialized(index_handle->GetFileSize(), '\0');
+	index_handle->Read(&serialized[0], serialized.size());
+
+	miint::FastxIndex index;
+	try {
+		index = miint::FastxIndex::deserialize(serialized);
+	} catch (const std::exception &e) {
+		throw IOException("Invalid FASTX index %s: %s", index_path, e.what());
+	}
+
+	auto file_handle = fs.OpenFile(path, FileFlags::FILE_FLAGS_READ);
+	if (file_handle->GetFileSize() != index.file_size) {
+		return std::nullopt;
+	}
+	return index;
+}
+
 unique_ptr<FunctionData> ReadFastxTableFunction::Bind(ClientContext &context, TableFunctionBindInput &input,
                                                       vector<duckdb::LogicalType> &return_types,
                                                       vector<std::string> &names) {
@@ -144,7 +174,34 @@ unique_ptr<FunctionData> ReadFastxTableFunction::Bind(ClientContext &context, Ta
 		qual_offset = static_cast<uint8_t>(offset_value);
 	}
 
+	bool use_index = true;
+	auto use_index_param = input.named_parameters.find("use_index");
+	if (use_index_param != input.named_parameters.end() && !use_index_param->second.IsNull()) {
+		use_index = use_index_param->second.GetValue<bool>();
+	}
+
 	auto data = duckdb::make_uniq<Data>(sequence1_paths, sequence2_paths, include_filepath, uses_stdin, qual_offset);
+
+	data->sequence1_indexes.resize(sequence1_paths.size());
+	data->sequence2_indexes.resize(sequence1_paths.size());
+	if (use_index && !uses_stdin) {
+		for (size_t i = 0; i < sequence1_paths.size(); i++) {
+			auto index1 = LoadFastxIndex(fs, sequence1_paths[i]);
+			if (!index1) {
+				continue;
+			}
+			if (sequence2_paths.has_value()) {
+				// Mates are read in lockstep, so both indexes must sample the same records
+				auto index2 = LoadFastxIndex(fs, sequence2_paths.value()[i]);
+				if (!index2 || index2->record_count != index1->record_count || index2->interval != index1->interval ||
+				    index2->entries.size() != index1->entries.size()) {
+					continue;
+				}
+				data->sequence2_indexes[i] = std::move(index2);
+			}
+			data->sequence1_indexes[i] = std::move(index1);
+		}
+	}
 	for (auto &name : data->names) {
 		names.emplace_back(name);
 	}
@@ -154,12 +211,64 @@ unique_ptr<FunctionData> ReadFastxTableFunction::Bind(ClientContext &context, Ta
 	return data;
 }
 
+ReadFastxTableFunction::GlobalState::GlobalState(const Data &data)
+    : sequence1_filepaths(data.sequence1_paths), sequence2_filepaths(data.sequence2_paths), next_unit_idx(0),
+      uses_stdin(data.uses_stdin) {
+	// sequence_index is 1-based, the index counts records from 0
+	int64_t min_index = std::max<int64_t>(data.sequence_index_min, 1);
+	int64_t max_index = data.sequence_index_max;
+	if (max_index < min_index) {
+		return;
+	}
+	uint64_t first_record = static_cast<uint64_t>(min_index - 1);
+	uint64_t last_record = static_cast<uint64_t>(max_index - 1);
+
+	for (size_t i = 0; i < sequence1_filepaths.size(); i++) {
+		auto &index1 = data.sequence1_indexes[i];
+		if (!index1 || index1->entries.empty()) {
+			// No usable index: the file is read from the top by a single thread
+			units.push_back({i, 0, false, miint::SequenceReadRange()});
+			continue;
+		}
+		if (first_record >= index1->record_count) {
+			continue;
+		}
+		uint64_t file_last_record = std::min<uint64_t>(last_record, index1->record_count - 1);
+
+		// Only the index entries around [first_record, file_last_record] are read
+		auto &entries = index1->entries;
+		auto &index2 = data.sequence2_indexes[i];
+		size_t first_entry = &index1->seek(first_record) - entries.data();
+		size_t end_entry = &index1->seek(file_last_record) - entries.data() + 1;
+		size_t entries_per_unit = std::max<uint64_t>(1, READ_UNIT_RECORDS / index1->interval);
+
+		for (size_t entry = first_entry; entry < end_entry; entry += entries_per_unit) {
+			size_t next_entry = std::min(entry + entries_per_unit, end_entry);
+			uint64_t start = entries[entry].record;
+			uint64_t end = next_entry < entries.size() ? entries[next_entry].record : index1->record_count;
+
+			ReadUnit unit {i, start, true, miint::SequenceReadRange()};
+			unit.range.compressed1 = index1->compressed;
+			unit.range.offset1 = index1->compressed ? entries[entry].virtual_offset : entries[entry].offset;
+			if (index2) {
+				auto &entry2 = index2->entries[entry];
+				unit.range.compressed2 = index2->compressed;
+				unit.range.offset2 = index2->compressed ? entry2.virtual_offset : entry2.offset;
+			}
+			unit.range.max_records = end - start;
+			units.push_back(unit);
+		}
+	}
+}
+
 unique_ptr<GlobalTableFunctionState> ReadFastxTableFunction::InitGlobal(ClientContext &context,
                                                                         TableFunctionInitInput &input) {
 	auto &data = input.bind_data->Cast<Data>();
-	auto gstate = duckdb::make_uniq<GlobalState>(data.sequence1_paths, data.sequence2_paths, data.uses_stdin);
-
-	return gstate;
+	auto state = duckdb::make_uniq<GlobalState>(data);
+	// Threads not needed to read units side by side go to decompressing zstd frames within a unit
+	auto n_threads = static_cast<idx_t>(MaxValue<int32_t>(TaskScheduler::GetScheduler(context).NumberOfThreads(), 1));
+	state->decode_threads = std::max<idx_t>(1, n_threads / std::max<idx_t>(1, state->MaxThreads()));
+	return std::move(state);
 }
 
 unique_ptr<LocalTableFunctionState> ReadFastxTableFunction::InitLocal(ExecutionContext &context,
@@ -174,47 +283,58 @@ void ReadFastxTableFunction::Execute(ClientContext &context, TableFunctionInput
 	auto &local_state = data_p.local_state->Cast<LocalState>();
 
 	miint::SequenceRecordBatch batch;
-	std::string current_filepath;
-	uint64_t start_sequence_index;
 
-	// Loop until we get data or run out of files
+	// Loop until we get data or run out of units
 	while (true) {
-		// If this thread doesn't have a file, claim one
-		if (!local_state.has_file) {
-			lock_guard<mutex> read_lock(global_state.lock);
-
-			// Check if all files exhausted
-			if (global_state.next_file_idx >= global_state.readers.size()) {
-				output.SetCardinality(0);
-				return;
+		// If this thread doesn't have a unit, claim one
+		if (!local_state.reader) {
+			size_t unit_idx;
+			{
+				lock_guard<mutex> read_lock(global_state.lock);
+
+				// Check if all units exhausted
+				if (global_state.next_unit_idx >= global_state.units.size()) {
+					output.SetCardinality(0);
+					return;
+				}
+
+				// Claim next available unit
+				unit_idx = global_state.next_unit_idx++;
 			}
-
-			// Claim next available file
-			local_state.current_file_idx = global_state.next_file_idx;
-			global_state.next_file_idx++;
-			local_state.has_file = true;
+			// Lock released - open the unit without blocking other threads
+			auto &unit = global_state.units[unit_idx];
+			auto &path1 = global_state.sequence1_filepaths[unit.file_idx];
+			std::optional<std::string> path2;
+			if (global_state.sequence2_filepaths.has_value()) {
+				path2 = global_state.sequence2_filepaths.value()[unit.file_idx];
+			}
+			if (unit.ranged) {
+				local_state.reader = std::make_unique<miint::SequenceReader>(path1, path2, unit.range);
+			} else {
+				local_state.reader =
+				    std::make_unique<miint::SequenceReader>(path1, path2, global_state.decode_threads);
+			}
+			local_state.current_file_idx = unit.file_idx;
+			local_state.next_sequence_index = unit.start_record + 1;
 		}
-		// Lock released - now do I/O without blocking other threads
-		// This thread has exclusive access to its claimed file
 
-		// Read from claimed file (no lock needed)
-		batch = global_state.readers[local_state.current_file_idx]->read(STANDARD_VECTOR_SIZE);
-		current_filepath = global_state.sequence1_filepaths[local_state.current_file_idx];
+		// Read from claimed unit (no lock needed)
+		batch = local_state.reader->read(STANDARD_VECTOR_SIZE);
 
-		// If this file is exhausted, release it and try to claim another
+		// If this unit is exhausted, release it and try to claim another
 		if (batch.empty()) {
-			local_state.has_file = false;
-			continue; // Loop to claim next file
+			local_state.reader.reset();
+			continue; // Loop to claim next unit
 		}
 
 		// Got data, break out of loop
 		break;
 	}
 
-	// Get sequence indices for this chunk from the current file's counter
-	// No atomic operation needed - this thread has exclusive access to this file
-	start_sequence_index = global_state.file_sequence_counters[local_state.current_file_idx];
-	global_state.file_sequence_counters[local_state.current_file_idx] += batch.size();
+	// Units never span files, and the thread owns its unit, so sequence indices need no synchronization
+	uint64_t start_sequence_index = local_state.next_sequence_index;
+	local_state.next_sequence_index += batch.size();
+	const auto &current_filepath = global_state.sequence1_filepaths[local_state.current_file_idx];
 
 	// Set sequence_index column (first column, index 0)
 	auto &sequence_index_vector = output.data[0];
@@ -257,11 +377,110 @@ void ReadFastxTableFunction::Execute(ClientContext &context, TableFunctionInput
 	output.SetCardinality(batch.size());
 }
 
+unique_ptr<NodeStatistics> ReadFastxTableFunction::Cardinality(ClientContext &context, const FunctionData *bind_data) {
+	auto &data = bind_data->Cast<Data>();
+	idx_t total = 0;
+	for (auto &index : data.sequence1_indexes) {
+		if (!index) {
+			return make_uniq<NodeStatistics>();
+		}
+		total += index->record_count;
+	}
+	return make_uniq<NodeStatistics>(total, total);
+}
+
+static bool IsSequenceIndexColumn(const LogicalGet &get, const Expression &expr) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF) {
+		return false;
+	}
+	auto &colref = expr.Cast<BoundColumnRefExpression>();
+	auto &column_ids = get.GetColumnIds();
+	if (colref.binding.table_index != get.table_index || colref.binding.column_index >= column_ids.size()) {
+		return false;
+	}
+	// sequence_index is the first column of read_fastx
+	return column_ids[colref.binding.column_index].GetPrimaryIndex() == 0;
+}
+
+static bool GetBigIntConstant(const Expression &expr, int64_t &result) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_CONSTANT) {
+		return false;
+	}
+	auto &value = expr.Cast<BoundConstantExpression>().value;
+	if (value.IsNull() || value.type().id() != LogicalTypeId::BIGINT) {
+		return false;
+	}
+	result = value.GetValue<int64_t>();
+	return true;
+}
+
+// Narrow [min, max] by "sequence_index <comparison> value"; bounds only ever widen towards the true
+// range, as the filter itself is still applied to the scanned rows
+static void ApplySequenceIndexBound(ExpressionType comparison, int64_t value, int64_t &min, int64_t &max) {
+	switch (comparison) {
+	case ExpressionType::COMPARE_EQUAL:
+		min = MaxValue(min, value);
+		max = MinValue(max, value);
+		break;
+	case ExpressionType::COMPARE_GREATERTHAN:
+		min = MaxValue(min, value == NumericLimits<int64_t>::Maximum() ? value : value + 1);
+		break;
+	case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+		min = MaxValue(min, value);
+		break;
+	case ExpressionType::COMPARE_LESSTHAN:
+		max = MinValue(max, value == NumericLimits<int64_t>::Minimum() ? value : value - 1);
+		break;
+	case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		max = MinValue(max, value);
+		break;
+	default:
+		break;
+	}
+}
+
+void ReadFastxTableFunction::PushdownComplexFilter(ClientContext &context, LogicalGet &get, FunctionData *bind_data,
+                                                   vector<unique_ptr<Expression>> &filters) {
+	auto &data = bind_data->Cast<Data>();
+	int64_t value;
+	for (auto &filter : filters) {
+		if (filter->GetExpressionClass() == ExpressionClass::BOUND_COMPARISON) {
+			auto &comparison = filter->Cast<BoundComparisonExpression>();
+			if (IsSequenceIndexColumn(get, *comparison.left) && GetBigIntConstant(*comparison.right, value)) {
+				ApplySequenceIndexBound(comparison.GetExpressionType(), value, data.sequence_index_min,
+				                        data.sequence_index_max);
+			} else if (IsSequenceIndexColumn(get, *comparison.right) && GetBigIntConstant(*comparison.left, value)) {
+				ApplySequenceIndexBound(FlipComparisonExpression(comparison.GetExpressionType()), value,
+				                        data.sequence_index_min, data.sequence_index_max);
+			}
+		} else if (filter->GetExpressionClass() == ExpressionClass::BOUND_BETWEEN) {
+			auto &between = filter->Cast<BoundBetweenExpression>();
+			if (!IsSequenceIndexColumn(get, *between.input)) {
+				continue;
+			}
+			if (GetBigIntConstant(*between.lower, value)) {
+				ApplySequenceIndexBound(between.lower_inclusive ? ExpressionType::COMPARE_GREATERTHANOREQUALTO
+				                                                : ExpressionType::COMPARE_GREATERTHAN,
+				                        value, data.sequence_index_min, data.sequence_index_max);
+			}
+			if (GetBigIntConstant(*between.upper, value)) {
+				ApplySequenceIndexBound(between.upper_inclusive ? ExpressionType::COMPARE_LESSTHANOREQUALTO
+				                                                : ExpressionType::COMPARE_LESSTHAN,
+				                        value, data.sequence_index_min, data.sequence_index_max);
+			}
+		}
+	}
+	// Filters are left in place: units are cut at index entries, so they may hold records outside the bounds
+}
+
 TableFunction ReadFastxTableFunction::GetFunction() {
 	auto tf = TableFunction("read_fastx", {LogicalType::ANY}, Execute, Bind, InitGlobal, InitLocal);
 	tf.named_parameters["sequence2"] = LogicalType::ANY;
 	tf.named_parameters["include_filepath"] = LogicalType::BOOLEAN;
 	tf.named_parameters["qual_offset"] = LogicalType::BIGINT;
+	tf.named_parameters["use_index"] = LogicalType::BOOLEAN;
+	tf.cardinality = Cardinality;
+	tf.pushdown_complex_filter = PushdownComplexFilter;
 	return tf;
 }
 
@@ -1,8 +1,10 @@
 #include "read_newick.hpp"
 #include "table_function_common.hpp"
+#include "ZstdSeekable.hpp"
 #include "duckdb/common/types.hpp"
 #include "duckdb/common/vector_size.hpp"
 #include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
 #include <zlib.h>
 #include <fstream>
 #include <memory>
@@ -23,7 +25,7 @@ using GzFilePtr = std::unique_ptr<gzFile_s, GzFileDeleter>;
 // Buffer size for gzip decompression (16KB recommended by zlib)
 static constexpr size_t GZIP_BUFFER_SIZE = 16384;
 
-std::string ReadNewickTableFunction::ReadNewickFile(const std::string &path) {
+std::string ReadNewickTableFunction::ReadNewickFile(const std::string &path, size_t decode_threads) {
 	// Handle stdin
 	if (IsStdinPath(path)) {
 		std::stringstream buffer;
@@ -56,6 +58,18 @@ std::string ReadNewickTableFunction::ReadNewickFile(const std::string &path) {
 		return content;
 	}
 
+	// Handle zstd files; ZstdReader decodes seekable files (as written by COPY) in parallel
+	if (IsZstdCompressed(path) || miint::ZstdReader::is_zstd_file(path)) {
+		miint::ZstdReader reader(path, decode_threads);
+		std::string content;
+		char buf[GZIP_BUFFER_SIZE];
+		size_t bytes_read;
+		while ((bytes_read = reader.read(buf, sizeof(buf))) > 0) {
+			content.append(buf, bytes_read);
+		}
+		return content;
+	}
+
 	// Regular file
 	std::ifstream file(path, std::ios::binary);
 	if (!file) {
@@ -67,29 +81,20 @@ std::string ReadNewickTableFunction::ReadNewickFile(const std::string &path) {
 	return buffer.str();
 }
 
-std::vector<ReadNewickTableFunction::NodeRow> ReadNewickTableFunction::TreeToRows(const miint::NewickTree &tree) {
-	std::vector<NodeRow> rows;
-	rows.reserve(tree.num_nodes());
-
-	for (uint32_t i = 0; i < tree.num_nodes(); ++i) {
-		NodeRow row;
-		row.node_index = static_cast<int64_t>(i);
-		row.name = tree.name(i);
-		row.branch_length = tree.branch_length(i);
-		row.edge_id = tree.edge_id(i);
-
-		uint32_t parent = tree.parent(i);
-		if (parent == miint::NewickTree::NO_PARENT) {
-			row.parent_index = std::nullopt;
-		} else {
-			row.parent_index = static_cast<int64_t>(parent);
+ReadNewickTableFunction::NewickText ReadNewickTableFunction::OpenNewickFile(const std::string &path,
+                                                                           size_t decode_threads) {
+	NewickText text;
+	if (!IsStdinPath(path) && !IsGzipped(path) && !IsZstdCompressed(path) && miint::MappedFile::is_mappable(path) &&
+	    !miint::ZstdReader::is_zstd_file(path)) {
+		try {
+			text.mapped = std::make_unique<miint::MappedFile>(path);
+		} catch (const std::runtime_error &e) {
+			throw IOException(e.what());
 		}
-
-		row.is_tip = tree.is_tip(i);
-		rows.push_back(std::move(row));
+		return text;
 	}
-
-	return rows;
+	text.decoded = ReadNewickFile(path, decode_threads);
+	return text;
 }
 
 unique_ptr<FunctionData> ReadNewickTableFunction::Bind(ClientContext &context, TableFunctionBindInput &input,
@@ -156,7 +161,62 @@ unique_ptr<FunctionData> ReadNewickTableFunction::Bind(ClientContext &context, T
 unique_ptr<GlobalTableFunctionState> ReadNewickTableFunction::InitGlobal(ClientContext &context,
                                                                          TableFunctionInitInput &input) {
 	auto &data = input.bind_data->Cast<Data>();
-	return duckdb::make_uniq<GlobalState>(data.file_paths, data.uses_stdin);
+	idx_t max_threads = 1;
+	if (!data.uses_stdin) {
+		max_threads = static_cast<idx_t>(MaxValue<int32_t>(TaskScheduler::GetScheduler(context).NumberOfThreads(), 1));
+	}
+	auto state = duckdb::make_uniq<GlobalState>(data.file_paths, max_threads);
+	// Up to one file per thread is opened at once; the threads left over go to decompressing zstd frames
+	auto files_at_once = MinValue<idx_t>(max_threads, MaxValue<idx_t>(data.file_paths.size(), 1));
+	state->decode_threads = MaxValue<idx_t>(1, max_threads / files_at_once);
+	return std::move(state);
+}
+
+bool ReadNewickTableFunction::GlobalState::NextBatch(TreeBatch &batch) {
+	size_t file_idx;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!batches.empty()) {
+			batch = std::move(batches.front());
+			batches.pop_front();
+			return true;
+		}
+		if (next_file_idx >= file_paths.size()) {
+			return false;
+		}
+		file_idx = next_file_idx++;
+	}
+
+	// Files are opened and split outside the lock, so several can be read at once
+	auto file = std::make_shared<NewickFile>();
+	file->path = file_paths[file_idx];
+	try {
+		file->text = OpenNewickFile(file->path, static_cast<size_t>(decode_threads));
+		file->tree_ends = miint::newick_tree_ends(file->text.view());
+	} catch (const std::exception &e) {
+		throw IOException("Error parsing newick file '" + file->path + "': " + e.what());
+	}
+
+	// This thread takes the first batch and leaves the rest to any thread
+	std::vector<TreeBatch> split;
+	const auto &ends = file->tree_ends;
+	size_t batch_start = 0;  // first tree of the batch being formed
+	size_t batch_offset = 0; // where that tree starts in the text
+	for (size_t tree = 0; tree < ends.size(); tree++) {
+		if (ends[tree] - batch_offset >= TREE_BATCH_BYTES || tree + 1 == ends.size()) {
+			split.push_back({file, batch_start, tree + 1});
+			batch_start = tree + 1;
+			batch_offset = ends[tree];
+		}
+	}
+	batch = std::move(split[0]);
+	if (split.size() > 1) {
+		std::lock_guard<std::mutex> guard(lock);
+		for (size_t i = 1; i < split.size(); i++) {
+			batches.push_back(std::move(split[i]));
+		}
+	}
+	return true;
 }
 
 unique_ptr<LocalTableFunctionState> ReadNewickTableFunction::InitLocal(ExecutionContext &context,
@@ -170,92 +230,98 @@ void ReadNewickTableFunction::Execute(ClientContext &context, TableFunctionInput
 	auto &global_state = data_p.global_state->Cast<GlobalState>();
 	auto &local_state = data_p.local_state->Cast<LocalState>();
 
+	auto &name_vec = output.data[1];
+	auto &bl_vec = output.data[2];
+	auto &edge_vec = output.data[3];
+	auto &parent_vec = output.data[4];
+	auto node_data = FlatVector::GetData<int64_t>(output.data[0]);
+	auto name_data = FlatVector::GetData<string_t>(name_vec);
+	auto bl_data = FlatVector::GetData<double>(bl_vec);
+	auto edge_data = FlatVector::GetData<int64_t>(edge_vec);
+	auto parent_data = FlatVector::GetData<int64_t>(parent_vec);
+	auto tip_data = FlatVector::GetData<bool>(output.data[5]);
+	auto tree_data = FlatVector::GetData<int64_t>(output.data[6]);
+
 	idx_t output_idx = 0;
 
 	while (output_idx < STANDARD_VECTOR_SIZE) {
-		// If we have remaining rows from current file, output them
-		if (local_state.current_row_idx < local_state.current_rows.size()) {
-			size_t rows_to_output = std::min<size_t>(STANDARD_VECTOR_SIZE - output_idx,
-			                                         local_state.current_rows.size() - local_state.current_row_idx);
-
-			for (size_t i = 0; i < rows_to_output; ++i) {
-				const auto &row = local_state.current_rows[local_state.current_row_idx + i];
-
-				// node_index
-				FlatVector::GetData<int64_t>(output.data[0])[output_idx + i] = row.node_index;
-
-				// name (empty string if not specified, never NULL)
-				auto &name_vec = output.data[1];
-				FlatVector::GetData<string_t>(name_vec)[output_idx + i] = StringVector::AddString(name_vec, row.name);
-
-				// branch_length (nullable - NaN becomes NULL)
-				auto &bl_vec = output.data[2];
-				if (std::isnan(row.branch_length)) {
-					FlatVector::Validity(bl_vec).SetInvalid(output_idx + i);
-				} else {
-					FlatVector::GetData<double>(bl_vec)[output_idx + i] = row.branch_length;
+		auto &batch = local_state.batch;
+
+		// Emit the nodes of the current tree as the parser completes them
+		if (local_state.parser) {
+			miint::NewickRow row;
+			bool has_row;
+			try {
+				has_row = local_state.parser->next(row);
+			} catch (const std::exception &e) {
+				// Name the tree only when the file has several
+				std::string tree_label;
+				if (batch.file->tree_ends.size() > 1) {
+					tree_label = " (tree " + std::to_string(local_state.current_tree) + ")";
 				}
+				throw IOException("Error parsing newick file '" + batch.file->path + "'" + tree_label + ": " +
+				                  e.what());
+			}
+			if (!has_row) {
+				local_state.parser.reset();
+				local_state.current_tree++;
+				continue;
+			}
 
-				// edge_id (nullable)
-				auto &edge_vec = output.data[3];
-				if (row.edge_id.has_value()) {
-					FlatVector::GetData<int64_t>(edge_vec)[output_idx + i] = row.edge_id.value();
-				} else {
-					FlatVector::Validity(edge_vec).SetInvalid(output_idx + i);
-				}
+			node_data[output_idx] = static_cast<int64_t>(row.node);
 
-				// parent_index (nullable)
-				auto &parent_vec = output.data[4];
-				if (row.parent_index.has_value()) {
-					FlatVector::GetData<int64_t>(parent_vec)[output_idx + i] = row.parent_index.value();
-				} else {
-					FlatVector::Validity(parent_vec).SetInvalid(output_idx + i);
-				}
+			// name (empty string if not specified, never NULL)
+			name_data[output_idx] = StringVector::AddString(name_vec, row.name.data(), row.name.size());
 
-				// is_tip
-				FlatVector::GetData<bool>(output.data[5])[output_idx + i] = row.is_tip;
+			// branch_length (nullable - NaN becomes NULL)
+			if (std::isnan(row.branch_length)) {
+				FlatVector::Validity(bl_vec).SetInvalid(output_idx);
+			} else {
+				bl_data[output_idx] = row.branch_length;
+			}
 
-				// filepath (if included)
-				if (bind_data.include_filepath) {
-					auto &fp_vec = output.data[6];
-					FlatVector::GetData<string_t>(fp_vec)[output_idx + i] =
-					    StringVector::AddString(fp_vec, local_state.current_filepath);
-				}
+			// edge_id (nullable)
+			if (row.edge_id.has_value()) {
+				edge_data[output_idx] = row.edge_id.value();
+			} else {
+				FlatVector::Validity(edge_vec).SetInvalid(output_idx);
 			}
 
-			output_idx += rows_to_output;
-			local_state.current_row_idx += rows_to_output;
-			continue;
-		}
+			// parent_index (nullable)
+			if (row.parent == miint::NewickStreamParser::NO_PARENT) {
+				FlatVector::Validity(parent_vec).SetInvalid(output_idx);
+			} else {
+				parent_data[output_idx] = static_cast<int64_t>(row.parent);
+			}
 
-		// Need to load next file
-		if (!local_state.has_file) {
-			std::lock_guard<std::mutex> guard(global_state.lock);
+			tip_data[output_idx] = row.is_tip;
+			tree_data[output_idx] = static_cast<int64_t>(local_state.current_tree);
 
-			if (global_state.next_file_idx >= global_state.file_paths.size()) {
-				// No more files
-				break;
+			// filepath (if included)
+			if (bind_data.include_filepath) {
+				auto &fp_vec = output.data[7];
+				FlatVector::GetData<string_t>(fp_vec)[output_idx] = StringVector::AddString(fp_vec, batch.file->path);
 			}
 
-			local_state.current_file_idx = global_state.next_file_idx;
-			global_state.next_file_idx++;
-			local_state.has_file = true;
+			output_idx++;
+			continue;
 		}
 
-		// Load and parse current file
-		const std::string &path = global_state.file_paths[local_state.current_file_idx];
-		local_state.current_filepath = path;
-
-		try {
-			std::string content = ReadNewickFile(path);
-			auto tree = miint::NewickTree::parse(content);
-			local_state.current_rows = TreeToRows(tree);
-			local_state.current_row_idx = 0;
-		} catch (const std::exception &e) {
-			throw IOException("Error parsing newick file '" + path + "': " + e.what());
+		// Start the next tree of the batch; the parser reads it in place
+		if (batch.file && local_state.current_tree < batch.end_tree) {
+			const auto &ends = batch.file->tree_ends;
+			size_t begin = local_state.current_tree == 0 ? 0 : ends[local_state.current_tree - 1];
+			auto tree_text = batch.file->text.view().substr(begin, ends[local_state.current_tree] - begin);
+			local_state.parser = std::make_unique<miint::NewickStreamParser>(tree_text);
+			continue;
 		}
 
-		local_state.has_file = false; // Ready to claim next file when done
+		// Need the next batch of trees
+		batch = TreeBatch();
+		if (!global_state.NextBatch(batch)) {
+			break;
+		}
+		local_state.current_tree = batch.first_tree;
 	}
 
 	output.SetCardinality(output_idx);
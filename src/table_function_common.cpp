@@ -17,6 +17,10 @@ bool IsGzipped(const std::string &path) {
 	return path.size() >= 3 && path.substr(path.size() - 3) == ".gz";
 }
 
+bool IsZstdCompressed(const std::string &path) {
+	return path.size() >= 4 && path.substr(path.size() - 4) == ".zst";
+}
+
 // Check if any part of the pattern could match stdin paths
 static bool GlobCouldMatchStdin(const std::string &pattern) {
 	// Check for patterns that could match stdin-like paths
@@ -0,0 +1,92 @@
+#include "tree_lca.hpp"
+#include "tree_registry.hpp"
+#include "duckdb/common/types/vector.hpp"
+#include "duckdb/common/vector_operations/binary_executor.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+namespace duckdb {
+
+struct TreeLCABindData : public FunctionData {
+	std::string tree_path;
+	shared_ptr<const miint::TreeLCA> tree;
+
+	TreeLCABindData(std::string tree_path_p, shared_ptr<const miint::TreeLCA> tree_p)
+	    : tree_path(std::move(tree_path_p)), tree(std::move(tree_p)) {
+	}
+
+	unique_ptr<FunctionData> Copy() const override {
+		return make_uniq<TreeLCABindData>(tree_path, tree);
+	}
+
+	bool Equals(const FunctionData &other_p) const override {
+		return tree_path == other_p.Cast<TreeLCABindData>().tree_path;
+	}
+};
+
+static unique_ptr<FunctionData> TreeLCABind(ClientContext &context, ScalarFunction &bound_function,
+                                            vector<unique_ptr<Expression>> &arguments) {
+	auto &function_name = bound_function.name;
+	if (!arguments[0]->IsFoldable()) {
+		throw BinderException("%s: tree must be a constant path, not a column reference", function_name);
+	}
+	auto tree_value = ExpressionExecutor::EvaluateScalar(context, *arguments[0]);
+	if (tree_value.IsNull()) {
+		throw BinderException("%s: tree must not be NULL", function_name);
+	}
+	auto tree_path = tree_value.ToString();
+
+	// A tree registered by miint_load_tree is used as is; anything else is a path parsed for this query
+	auto tree = TreeRegistry::Resolve(context, tree_path, function_name)->LCA();
+	return make_uniq<TreeLCABindData>(std::move(tree_path), std::move(tree));
+}
+
+// Node of the tree named by a row's argument
+static uint32_t LookupNode(const miint::TreeLCA &tree, const string_t &name, const std::string &function_name) {
+	auto node = tree.node(std::string_view(name.GetData(), name.GetSize()));
+	if (node == miint::TreeLCA::NOT_FOUND) {
+		throw InvalidInputException("%s: '%s' does not name a node of the tree", function_name, name.GetString());
+	}
+	if (node == miint::TreeLCA::AMBIGUOUS) {
+		throw InvalidInputException("%s: '%s' names more than one node of the tree", function_name,
+		                            name.GetString());
+	}
+	return node;
+}
+
+static void TreeLCAFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &func_expr = state.expr.Cast<BoundFunctionExpression>();
+	auto &tree = *func_expr.bind_info->Cast<TreeLCABindData>().tree;
+	auto &function_name = func_expr.function.name;
+
+	// The tree argument is constant and was consumed at bind time
+	BinaryExecutor::Execute<string_t, string_t, int64_t>(
+	    args.data[1], args.data[2], result, args.size(), [&](string_t a, string_t b) {
+		    auto lca = tree.lca(LookupNode(tree, a, function_name), LookupNode(tree, b, function_name));
+		    return static_cast<int64_t>(lca);
+	    });
+}
+
+static void TreeDistanceFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &func_expr = state.expr.Cast<BoundFunctionExpression>();
+	auto &tree = *func_expr.bind_info->Cast<TreeLCABindData>().tree;
+	auto &function_name = func_expr.function.name;
+
+	BinaryExecutor::Execute<string_t, string_t, double>(
+	    args.data[1], args.data[2], result, args.size(), [&](string_t a, string_t b) {
+		    return tree.distance(LookupNode(tree, a, function_name), LookupNode(tree, b, function_name));
+	    });
+}
+
+void TreeLCAFunctions::Register(ExtensionLoader &loader) {
+	ScalarFunction tree_lca("tree_lca", {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR},
+	                        LogicalType::BIGINT, TreeLCAFunction, TreeLCABind);
+	loader.RegisterFunction(tree_lca);
+
+	ScalarFunction tree_distance("tree_distance", {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR},
+	                             LogicalType::DOUBLE, TreeDistanceFunction, TreeLCABind);
+	loader.RegisterFunction(tree_distance);
+}
+
+} // namespace duckdb
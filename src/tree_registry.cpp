@@ -0,0 +1,115 @@
+#include "tree_registry.hpp"
+#include "read_newick.hpp"
+#include "duckdb/common/exception.hpp"
+
+namespace duckdb {
+
+static const std::string TREE_KEY_PREFIX = "miint_tree:";
+
+shared_ptr<const miint::TreeLCA> RegisteredTree::LCA() {
+	lock_guard<mutex> guard(lock);
+	if (!lca) {
+		lca = make_shared_ptr<miint::TreeLCA>(tree);
+	}
+	return lca;
+}
+
+shared_ptr<const miint::FaithPDTree> RegisteredTree::FaithPD() {
+	lock_guard<mutex> guard(lock);
+	if (!faith_pd) {
+		faith_pd = make_shared_ptr<miint::FaithPDTree>(*tree);
+	}
+	return faith_pd;
+}
+
+shared_ptr<RegisteredTree> TreeRegistry::Parse(const std::string &path, const std::string &function_name) {
+	try {
+		// Parsed in place, straight into the compact form
+		auto text = ReadNewickTableFunction::OpenNewickFile(path);
+		return make_shared_ptr<RegisteredTree>(path, std::make_shared<const miint::CompactTree>(text.view()));
+	} catch (const std::exception &e) {
+		throw IOException("%s: error parsing newick file '%s': %s", function_name, path, e.what());
+	}
+}
+
+shared_ptr<RegisteredTree> TreeRegistry::Load(ClientContext &context, const std::string &name,
+                                              const std::string &path) {
+	auto tree = Parse(path, "miint_load_tree");
+	ObjectCache::GetObjectCache(context).Put(TREE_KEY_PREFIX + name, tree);
+	return tree;
+}
+
+shared_ptr<RegisteredTree> TreeRegistry::Get(ClientContext &context, const std::string &name) {
+	return ObjectCache::GetObjectCache(context).Get<RegisteredTree>(TREE_KEY_PREFIX + name);
+}
+
+shared_ptr<RegisteredTree> TreeRegistry::Resolve(ClientContext &context, const std::string &tree,
+                                                 const std::string &function_name) {
+	auto registered = Get(context, tree);
+	if (registered) {
+		return registered;
+	}
+	return Parse(tree, function_name);
+}
+
+//===--------------------------------------------------------------------===//
+// miint_load_tree
+//===--------------------------------------------------------------------===//
+unique_ptr<FunctionData> MiintLoadTreeTableFunction::Bind(ClientContext &context, TableFunctionBindInput &input,
+                                                          vector<LogicalType> &return_types,
+                                                          vector<std::string> &names) {
+	auto data = make_uniq<Data>();
+	if (input.inputs[0].IsNull() || input.inputs[0].ToString().empty()) {
+		throw BinderException("miint_load_tree: name must not be NULL or empty");
+	}
+	if (input.inputs[1].IsNull()) {
+		throw BinderException("miint_load_tree: path must not be NULL");
+	}
+	data->name = input.inputs[0].ToString();
+	data->path = input.inputs[1].ToString();
+
+	for (const auto &name : data->names) {
+		names.emplace_back(name);
+	}
+	for (const auto &type : data->types) {
+		return_types.emplace_back(type);
+	}
+	return std::move(data);
+}
+
+unique_ptr<GlobalTableFunctionState> MiintLoadTreeTableFunction::InitGlobal(ClientContext &context,
+                                                                            TableFunctionInitInput &input) {
+	auto &data = input.bind_data->Cast<Data>();
+	auto gstate = make_uniq<GlobalState>();
+	gstate->tree = TreeRegistry::Load(context, data.name, data.path);
+	return std::move(gstate);
+}
+
+void MiintLoadTreeTableFunction::Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &bind_data = data_p.bind_data->Cast<Data>();
+	auto &global_state = data_p.global_state->Cast<GlobalState>();
+
+	if (global_state.done) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	const auto &tree = *global_state.tree->tree;
+	output.data[0].SetValue(0, Value(bind_data.name));
+	output.data[1].SetValue(0, Value(bind_data.path));
+	output.data[2].SetValue(0, Value::BIGINT(static_cast<int64_t>(tree.num_nodes())));
+	output.data[3].SetValue(0, Value::BIGINT(static_cast<int64_t>(tree.num_tips())));
+
+	output.SetCardinality(1);
+	global_state.done = true;
+}
+
+TableFunction MiintLoadTreeTableFunction::GetFunction() {
+	return TableFunction("miint_load_tree", {LogicalType::VARCHAR, LogicalType::VARCHAR}, Execute, Bind, InitGlobal);
+}
+
+void MiintLoadTreeTableFunction::Register(ExtensionLoader &loader) {
+	loader.RegisterFunction(GetFunction());
+}
+
+} // namespace duckdb
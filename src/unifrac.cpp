@@ -0,0 +1,127 @@
+#include "unifrac.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/vector.hpp"
+#include "duckdb/common/vector_size.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include <stdexcept>
+
+namespace duckdb {
+
+unique_ptr<FunctionData> UniFracTableFunction::Bind(ClientContext &context, TableFunctionBindInput &input,
+                                                    vector<LogicalType> &return_types, vector<std::string> &names) {
+	auto data = make_uniq<Data>();
+
+	if (input.inputs[0].IsNull()) {
+		throw BinderException("unifrac: table must not be NULL");
+	}
+	data->table_name = input.inputs[0].ToString();
+
+	if (input.inputs[1].IsNull()) {
+		throw BinderException("unifrac: tree must not be NULL");
+	}
+	data->tree_path = input.inputs[1].ToString();
+	// A tree registered by miint_load_tree is used as is; anything else is a path parsed for this query
+	data->tree = TreeRegistry::Resolve(context, data->tree_path, "unifrac");
+
+	if (input.inputs[2].IsNull()) {
+		throw BinderException("unifrac: metric must not be NULL");
+	}
+	try {
+		data->metric = miint::parse_unifrac_metric(StringUtil::Lower(input.inputs[2].ToString()));
+	} catch (const std::runtime_error &e) {
+		throw BinderException("unifrac: %s", e.what());
+	}
+
+	data->columns = ParseFeatureTableColumns(input.named_parameters);
+	ValidateFeatureTable(context, data->table_name, data->columns);
+
+	names = data->names;
+	return_types = data->types;
+	return std::move(data);
+}
+
+bool UniFracTableFunction::GlobalState::NextStripe(size_t &stripe) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (next_stripe >= unifrac.stripe_count()) {
+		return false;
+	}
+	stripe = next_stripe++;
+	return true;
+}
+
+unique_ptr<GlobalTableFunctionState> UniFracTableFunction::InitGlobal(ClientContext &context,
+                                                                      TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<Data>();
+	auto gstate = make_uniq<GlobalState>();
+	gstate->max_threads =
+	    static_cast<idx_t>(MaxValue<int32_t>(TaskScheduler::GetScheduler(context).NumberOfThreads(), 1));
+
+	gstate->table = ReadFeatureTable(context, bind_data.table_name, bind_data.columns);
+	auto &table = gstate->table;
+	miint::SparseCounts counts {table.indptr.data(), table.features.data(), table.values.data(),
+	                            table.SampleCount()};
+	try {
+		// The whole matrix is computed up front, on every thread, since each branch touches every stripe
+		gstate->unifrac = miint::UniFrac::compute(*bind_data.tree->tree, table.feature_ids, counts, bind_data.metric,
+		                                          gstate->max_threads);
+	} catch (const std::runtime_error &e) {
+		throw InvalidInputException("unifrac: %s", e.what());
+	}
+	return std::move(gstate);
+}
+
+unique_ptr<LocalTableFunctionState> UniFracTableFunction::InitLocal(ExecutionContext &context,
+                                                                    TableFunctionInitInput &input,
+                                                                    GlobalTableFunctionState *global_state) {
+	return make_uniq<LocalState>();
+}
+
+void UniFracTableFunction::Execute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &global_state = data_p.global_state->Cast<GlobalState>();
+	auto &local_state = data_p.local_state->Cast<LocalState>();
+	const auto &sample_ids = global_state.table.sample_ids;
+	const auto &unifrac = global_state.unifrac;
+	auto n_samples = unifrac.sample_count();
+
+	auto sample_a_data = FlatVector::GetData<string_t>(output.data[0]);
+	auto sample_b_data = FlatVector::GetData<string_t>(output.data[1]);
+	auto distance_data = FlatVector::GetData<double>(output.data[2]);
+
+	idx_t n_rows = 0;
+	while (n_rows < STANDARD_VECTOR_SIZE) {
+		if (local_state.position >= local_state.length) {
+			if (!global_state.NextStripe(local_state.stripe)) {
+				break;
+			}
+			local_state.length = unifrac.stripe_length(local_state.stripe);
+			local_state.position = 0;
+		}
+
+		auto i = local_state.position++;
+		auto j = (i + local_state.stripe + 1) % n_samples;
+		// Sample ids are sorted, so the pair reads in order
+		sample_a_data[n_rows] = StringVector::AddString(output.data[0], sample_ids[MinValue(i, j)]);
+		sample_b_data[n_rows] = StringVector::AddString(output.data[1], sample_ids[MaxValue(i, j)]);
+		distance_data[n_rows] = unifrac.distance(local_state.stripe, i);
+		n_rows++;
+	}
+
+	output.SetCardinality(n_rows);
+}
+
+TableFunction UniFracTableFunction::GetFunction() {
+	TableFunction tf("unifrac", {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR}, Execute, Bind,
+	                 InitGlobal, InitLocal);
+
+	tf.named_parameters["sample_id"] = LogicalType::VARCHAR;
+	tf.named_parameters["feature_id"] = LogicalType::VARCHAR;
+	tf.named_parameters["value"] = LogicalType::VARCHAR;
+
+	return tf;
+}
+
+void UniFracTableFunction::Register(ExtensionLoader &loader) {
+	loader.RegisterFunction(GetFunction());
+}
+
+} // namespace duckdb
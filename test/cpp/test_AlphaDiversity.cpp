@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <AlphaDiversity.hpp>
+#include <vector>
+
+using namespace miint;
+using Catch::Matchers::WithinAbs;
+
+TEST_CASE("AlphaDiversity - empty state", "[alpha_diversity]") {
+	AlphaDiversity state;
+	REQUIRE(state.Empty());
+	state.Add(0);
+	REQUIRE(state.Empty());
+}
+
+TEST_CASE("AlphaDiversity - metrics", "[alpha_diversity]") {
+	AlphaDiversity state;
+	for (double count : {1, 1, 2, 3, 5, 8, 0, 1}) {
+		state.Add(count);
+	}
+	REQUIRE(state.observed == 7);
+	REQUIRE(state.singletons == 3);
+	REQUIRE(state.doubletons == 1);
+	REQUIRE_THAT(state.Shannon(), WithinAbs(1.6461960985456416, 1e-12));
+	REQUIRE_THAT(state.Simpson(), WithinAbs(0.7619047619047619, 1e-12));
+	REQUIRE_THAT(state.Chao1(), WithinAbs(8.5, 1e-12));
+}
+
+TEST_CASE("AlphaDiversity - single feature", "[alpha_diversity]") {
+	AlphaDiversity state;
+	state.Add(37);
+	REQUIRE(state.Shannon() == 0.0);
+	REQUIRE(state.Simpson() == 0.0);
+	REQUIRE(state.Chao1() == 1.0);
+}
+
+TEST_CASE("AlphaDiversity - relative abundances give the same entropy as counts", "[alpha_diversity]") {
+	AlphaDiversity counts;
+	AlphaDiversity proportions;
+	for (double count : {10, 20, 30, 40}) {
+		counts.Add(count);
+		proportions.Add(count / 100);
+	}
+	REQUIRE_THAT(proportions.Shannon(), WithinAbs(counts.Shannon(), 1e-12));
+	REQUIRE_THAT(proportions.Simpson(), WithinAbs(counts.Simpson(), 1e-12));
+}
+
+TEST_CASE("AlphaDiversity - merged states match a single pass", "[alpha_diversity]") {
+	std::vector<double> values;
+	for (int i = 0; i < 1000; i++) {
+		values.push_back((i * 37) % 11);
+	}
+	AlphaDiversity whole;
+	AlphaDiversity parts[3];
+	for (size_t i = 0; i < values.size(); i++) {
+		whole.Add(values[i]);
+		parts[i % 3].Add(values[i]);
+	}
+	parts[0].Merge(parts[1]);
+	parts[0].Merge(parts[2]);
+	REQUIRE(parts[0].observed == whole.observed);
+	REQUIRE(parts[0].singletons == whole.singletons);
+	REQUIRE(parts[0].doubletons == whole.doubletons);
+	REQUIRE_THAT(parts[0].Shannon(), WithinAbs(whole.Shannon(), 1e-9));
+	REQUIRE_THAT(parts[0].Simpson(), WithinAbs(whole.Simpson(), 1e-12));
+	REQUIRE(parts[0].Chao1() == whole.Chao1());
+}
+
+TEST_CASE("AlphaDiversity - negative counts are rejected", "[alpha_diversity]") {
+	AlphaDiversity state;
+	REQUIRE_THROWS(state.Add(-1));
+}
@@ -0,0 +1,163 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <functional>
+#include <vector>
+#include "BIOMMerge.hpp"
+#include "BIOMReader.hpp"
+
+using namespace miint;
+
+namespace {
+
+using Triplets = std::map<std::pair<std::string, std::string>, double>;
+
+// Calls fn(sample, feature, value) for every entry of one matrix of a BIOM file, checking that the minor indices
+// are sorted within each major slice
+template <typename Fn>
+void for_each_entry(const std::string &path, BIOMAxis axis, Fn fn) {
+	BIOMReader reader(path);
+	auto samples = reader.read_sample_ids();
+	auto features = reader.read_feature_ids();
+	auto indptr = reader.read_indptr(axis);
+	BIOMEntries entries;
+	reader.read_entries(axis, 0, indptr.back(), entries);
+	bool sorted = true;
+	for (size_t major = 0; major + 1 < indptr.size(); major++) {
+		for (int32_t e = indptr[major]; e < indptr[major + 1]; e++) {
+			sorted = sorted && (e == indptr[major] || entries.indices[e - 1] < entries.indices[e]);
+			auto &sample = axis == BIOMAxis::SAMPLE ? samples[major] : samples[entries.indices[e]];
+			auto &feature = axis == BIOMAxis::SAMPLE ? features[entries.indices[e]] : features[major];
+			fn(sample, feature, entries.data[e]);
+		}
+	}
+	REQUIRE(sorted);
+}
+
+std::string temp_biom(const std::string &name) {
+	auto path = (std::filesystem::temp_directory_path() / name).string();
+	std::filesystem::remove(path);
+	return path;
+}
+
+// (sample, feature) -> value of every entry of one matrix of a BIOM file
+Triplets read_triplets(const std::string &path, BIOMAxis axis) {
+	Triplets result;
+	for_each_entry(path, axis, [&](const std::string &sample, const std::string &feature, double value) {
+		result[{sample, feature}] = value;
+	});
+	return result;
+}
+
+// Order-independent checksum of the entries of one matrix, for tables too large to compare entry by entry
+uint64_t checksum(const std::string &path, BIOMAxis axis) {
+	uint64_t total = 0;
+	std::hash<std::string> hash;
+	for_each_entry(path, axis, [&](const std::string &sample, const std::string &feature, double value) {
+		total += (hash(sample) * 31 + hash(feature)) * static_cast<uint64_t>(value);
+	});
+	return total;
+}
+
+} // namespace
+
+TEST_CASE("BIOM merge of small tables", "[BIOMMerge]") {
+	std::vector<std::string> inputs = {"data/biom/test.biom", "data/biom/file1.biom", "data/biom/file2.biom"};
+	for (uint64_t block : {uint64_t(1), uint64_t(3), uint64_t(1) << 22}) {
+		auto output = temp_biom("miint_merge_small.biom");
+		BIOMMergeOptions options;
+		options.block_entries = block;
+		auto summary = biom_merge(inputs, output, options);
+		REQUIRE((summary.n_samples == 12));
+		REQUIRE((summary.n_features == 7));
+		REQUIRE((summary.nnz == 25));
+
+		Triplets expected;
+		for (auto &input : inputs) {
+			auto triplets = read_triplets(input, BIOMAxis::SAMPLE);
+			expected.insert(triplets.begin(), triplets.end());
+		}
+		REQUIRE((read_triplets(output, BIOMAxis::SAMPLE) == expected));
+		REQUIRE((read_triplets(output, BIOMAxis::OBSERVATION) == expected));
+
+		BIOMReader reader(output);
+		REQUIRE((reader.read_feature_ids() ==
+		         std::vector<std::string> {"GG_OTU_1", "GG_OTU_2", "GG_OTU_3", "GG_OTU_4", "GG_OTU_5", "O1", "O2"}));
+		REQUIRE((reader.read_sample_ids() == std::vector<std::string> {"Sample1", "Sample2", "Sample3", "Sample4",
+		                                                                "Sample5", "Sample6", "S1", "S2", "S3", "S4",
+		                                                                "S5", "S6"}));
+		REQUIRE(BIOMReader::IsBIOM(output));
+		std::filesystem::remove(output);
+	}
+}
+
+TEST_CASE("BIOM merge re-sorts columns of unsorted feature IDs", "[BIOMMerge]") {
+	// The features of large_table1.biom are O0, O1, ..., which do not sort as stored. Its observation/matrix is
+	// read once whatever the block size, so a small block does not multiply the work.
+	std::vector<std::string> inputs = {"data/biom/large_table1.biom", "data/biom/test.biom", "data/biom/empty.biom"};
+	BIOMReader large("data/biom/large_table1.biom");
+	// The tables hold integer counts
+	auto expected = checksum("data/biom/large_table1.biom", BIOMAxis::SAMPLE) +
+	                checksum("data/biom/test.biom", BIOMAxis::SAMPLE);
+	for (uint64_t block : {uint64_t(1) << 21, uint64_t(1) << 16}) {
+		auto output = temp_biom("miint_merge_large.biom");
+		BIOMMergeOptions options;
+		options.block_entries = block;
+		auto summary = biom_merge(inputs, output, options);
+
+		REQUIRE((summary.n_samples == large.read_sample_ids().size() + 6));
+		REQUIRE((summary.n_features == large.read_feature_ids().size() + 5));
+		REQUIRE((summary.nnz == static_cast<uint64_t>(large.read_indptr(BIOMAxis::SAMPLE).back()) + 15));
+		REQUIRE((checksum(output, BIOMAxis::SAMPLE) == expected));
+		REQUIRE((checksum(output, BIOMAxis::OBSERVATION) == expected));
+		std::filesystem::remove(output);
+	}
+}
+
+TEST_CASE("BIOM merge of inputs without observation/matrix", "[BIOMMerge]") {
+	// Such inputs are scanned through sample/matrix instead
+	auto stripped = temp_biom("miint_merge_no_observation.biom");
+	std::filesystem::copy_file("data/biom/file1.biom", stripped);
+	hid_t file = H5Fopen(stripped.c_str(), H5F_ACC_RDWR, H5P_DEFAULT);
+	REQUIRE(file >= 0);
+	REQUIRE(H5Ldelete(file, "/observation/matrix", H5P_DEFAULT) >= 0);
+	H5Fclose(file);
+	REQUIRE_FALSE(BIOMReader(stripped).has_observation_matrix());
+
+	std::vector<std::string> inputs = {"data/biom/test.biom", stripped, "data/biom/file2.biom"};
+	Triplets expected;
+	for (auto &input : inputs) {
+		auto triplets = read_triplets(input, BIOMAxis::SAMPLE);
+		expected.insert(triplets.begin(), triplets.end());
+	}
+	for (uint64_t block : {uint64_t(1), uint64_t(1) << 22}) {
+		auto output = temp_biom("miint_merge_mixed.biom");
+		BIOMMergeOptions options;
+		options.block_entries = block;
+		biom_merge(inputs, output, options);
+		REQUIRE((read_triplets(output, BIOMAxis::SAMPLE) == expected));
+		REQUIRE((read_triplets(output, BIOMAxis::OBSERVATION) == expected));
+		std::filesystem::remove(output);
+	}
+	std::filesystem::remove(stripped);
+}
+
+TEST_CASE("BIOM merge errors", "[BIOMMerge]") {
+	H5Eset_auto(H5E_DEFAULT, nullptr, nullptr); // Disable HDF5 error printing
+	auto output = temp_biom("miint_merge_errors.biom");
+
+	REQUIRE_THROWS_WITH(biom_merge({"data/biom/test.biom", "data/biom/test.biom"}, output),
+	                    Catch::Matchers::ContainsSubstring("Sample 'Sample1' is in both"));
+	REQUIRE_FALSE(std::filesystem::exists(output));
+
+	REQUIRE_THROWS_WITH(biom_merge({}, output), Catch::Matchers::ContainsSubstring("No BIOM files"));
+
+	biom_merge({"data/biom/test.biom"}, output);
+	REQUIRE_THROWS_WITH(biom_merge({"data/biom/file1.biom"}, output),
+	                    Catch::Matchers::ContainsSubstring("may already exist"));
+	// The existing file is left alone
+	REQUIRE((read_triplets(output, BIOMAxis::SAMPLE) == read_triplets("data/biom/test.biom", BIOMAxis::SAMPLE)));
+	std::filesystem::remove(output);
+}
@@ -80,3 +80,114 @@ TEST_CASE("BIOM file error recovery", "[BIOMReader]") {
 	auto table = reader.read();
 	REQUIRE((table.nnz() == 15));
 }
+
+TEST_CASE("BIOM streamed entries match the full table", "[BIOMReader]") {
+	miint::BIOMReader reader("data/biom/test.biom");
+	auto table = reader.read();
+	auto sample_ids = reader.read_sample_ids();
+	auto feature_ids = reader.read_feature_ids();
+	auto indptr = reader.read_indptr(miint::BIOMAxis::SAMPLE);
+
+	REQUIRE((sample_ids == table.SampleIDs()));
+	REQUIRE((feature_ids == table.FeatureIDs()));
+	REQUIRE((indptr.size() == sample_ids.size() + 1));
+	REQUIRE((static_cast<size_t>(indptr.back()) == table.nnz()));
+
+	// Ranges that do not line up with sample boundaries
+	for (uint64_t step : {1, 4, 15, 100}) {
+		std::vector<size_t> samples;
+		std::vector<size_t> features;
+		std::vector<double> values;
+		size_t sample = 0;
+		miint::BIOMEntries entries;
+		for (uint64_t begin = 0; begin < table.nnz(); begin += step) {
+			uint64_t end = std::min<uint64_t>(begin + step, table.nnz());
+			reader.read_entries(miint::BIOMAxis::SAMPLE, begin, end, entries);
+			REQUIRE((entries.size() == end - begin));
+			for (size_t i = 0; i < entries.size(); i++) {
+				while (static_cast<uint64_t>(indptr[sample + 1]) <= begin + i) {
+					sample++;
+				}
+				samples.push_back(sample);
+				features.push_back(entries.indices[i]);
+				values.push_back(entries.data[i]);
+			}
+		}
+		REQUIRE((samples == table.COOSampleIndices()));
+		REQUIRE((features == table.COOFeatureIndices()));
+		REQUIRE((values == table.COOValues()));
+	}
+
+	miint::BIOMEntries entries;
+	REQUIRE_THROWS_WITH(reader.read_entries(miint::BIOMAxis::SAMPLE, 10, 16, entries),
+	                    Catch::Matchers::ContainsSubstring("exceeds"));
+}
+
+TEST_CASE("BIOM streamed empty table", "[BIOMReader]") {
+	miint::BIOMReader reader("data/biom/empty.biom");
+	REQUIRE(reader.read_sample_ids().empty());
+	REQUIRE(reader.read_feature_ids().empty());
+	auto indptr = reader.read_indptr(miint::BIOMAxis::SAMPLE);
+	REQUIRE((indptr == std::vector<int32_t> {0}));
+
+	miint::BIOMEntries entries;
+	reader.read_entries(miint::BIOMAxis::SAMPLE, 0, 0, entries);
+	REQUIRE((entries.size() == 0));
+}
+
+TEST_CASE("BIOM raw entries decode like hyperslab reads", "[BIOMReader]") {
+	// large_table1.biom is chunked and deflated, test.biom is contiguous and read through HDF5 instead
+	for (auto path : {"data/biom/large_table1.biom", "data/biom/test.biom"}) {
+		miint::BIOMReader reader(path);
+		auto indptr = reader.read_indptr(miint::BIOMAxis::SAMPLE);
+		uint64_t nnz = indptr.back();
+		for (uint64_t begin : {uint64_t(0), nnz / 3, nnz - nnz / 7}) {
+			uint64_t end = std::min<uint64_t>(begin + 100000, nnz);
+			miint::BIOMEntries expected;
+			reader.read_entries(miint::BIOMAxis::SAMPLE, begin, end, expected);
+
+			miint::BIOMRawEntries raw;
+			miint::BIOMEntries decoded;
+			reader.read_entries_raw(miint::BIOMAxis::SAMPLE, begin, end, raw);
+			reader.decode_entries(raw, decoded);
+			REQUIRE((decoded.indices == expected.indices));
+			REQUIRE((decoded.data == expected.data));
+		}
+	}
+}
+
+TEST_CASE("BIOM observation matrix holds the same entries", "[BIOMReader]") {
+	for (auto path : {"data/biom/test.biom", "data/biom/large_table1.biom"}) {
+		miint::BIOMReader reader(path);
+		REQUIRE(reader.has_observation_matrix());
+		auto sample_indptr = reader.read_indptr(miint::BIOMAxis::SAMPLE);
+		auto obs_indptr = reader.read_indptr(miint::BIOMAxis::OBSERVATION);
+		REQUIRE((obs_indptr.size() == reader.read_feature_ids().size() + 1));
+		REQUIRE((obs_indptr.back() == sample_indptr.back()));
+
+		// Order-independent sum of value * (sample + 1) * (2 * feature + 1); the tables hold integer counts
+		auto checksum = [&](miint::BIOMAxis axis, const std::vector<int32_t> &indptr) {
+			uint64_t total = 0;
+			size_t major = 0;
+			miint::BIOMRawEntries raw;
+			miint::BIOMEntries entries;
+			uint64_t nnz = indptr.back();
+			for (uint64_t begin = 0; begin < nnz; begin += 1 << 20) {
+				uint64_t end = std::min<uint64_t>(begin + (1 << 20), nnz);
+				reader.read_entries_raw(axis, begin, end, raw);
+				reader.decode_entries(raw, entries);
+				for (size_t i = 0; i < entries.size(); i++) {
+					while (static_cast<uint64_t>(indptr[major + 1]) <= begin + i) {
+						major++;
+					}
+					auto sample = axis == miint::BIOMAxis::SAMPLE ? major : size_t(entries.indices[i]);
+					auto feature = axis == miint::BIOMAxis::SAMPLE ? size_t(entries.indices[i]) : major;
+					total += uint64_t(entries.data[i]) * (sample + 1) * (feature * 2 + 1);
+				}
+			}
+			return total;
+		};
+		REQUIRE((checksum(miint::BIOMAxis::SAMPLE, sample_indptr) ==
+		         checksum(miint::BIOMAxis::OBSERVATION, obs_indptr)));
+	}
+}
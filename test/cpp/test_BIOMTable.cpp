@@ -1,7 +1,13 @@
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_string.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 #include "BIOMTable.hpp"
 
 TEST_CASE("BIOM from COO", "[BIOMTable]") {
@@ -296,7 +302,7 @@ TEST_CASE("BIOMTable ToCSR conversion", "[BIOMTable]") {
 	}
 }
 
-TEST_CASE("BIOMTable ToCSC conversion", "[BIOMTable]") {
+TEST_CASE("BIOMTable CSC arrays", "[BIOMTable]") {
 	SECTION("Simple 2x3 matrix") {
 		// Matrix (2 features × 3 samples):
 		//         S0   S1   S2
@@ -307,7 +313,7 @@ TEST_CASE("BIOMTable ToCSC conversion", "[BIOMTable]") {
 		std::vector<double> values = {1.0, 2.0, 4.0, 3.0};
 		miint::BIOMTable table(features, samples, values);
 
-		auto csc = table.ToCSC();
+		auto csc = table.CSC();
 
 		// Expected CSC (scipy verified):
 		std::vector<double> exp_data = {1.0, 3.0, 2.0, 4.0};
@@ -325,7 +331,7 @@ TEST_CASE("BIOMTable ToCSC conversion", "[BIOMTable]") {
 		std::vector<double> values;
 		miint::BIOMTable table(features, samples, values);
 
-		auto csc = table.ToCSC();
+		auto csc = table.CSC();
 
 		REQUIRE(csc.data.empty());
 		REQUIRE(csc.indices.empty());
@@ -341,7 +347,7 @@ TEST_CASE("BIOMTable ToCSC conversion", "[BIOMTable]") {
 		std::vector<double> values = {1.0, 2.0, 3.0};
 		miint::BIOMTable table(features, samples, values);
 
-		auto csc = table.ToCSC();
+		auto csc = table.CSC();
 
 		std::vector<double> exp_data = {1.0, 2.0, 3.0};
 		std::vector<int32_t> exp_indices = {0, 0, 0};
@@ -363,7 +369,7 @@ TEST_CASE("BIOMTable ToCSC conversion", "[BIOMTable]") {
 		std::vector<double> values = {1.0, 2.0, 3.0};
 		miint::BIOMTable table(features, samples, values);
 
-		auto csc = table.ToCSC();
+		auto csc = table.CSC();
 
 		std::vector<double> exp_data = {1.0, 2.0, 3.0};
 		std::vector<int32_t> exp_indices = {0, 1, 2};
@@ -385,7 +391,7 @@ TEST_CASE("BIOMTable ToCSC conversion", "[BIOMTable]") {
 		std::vector<double> values = {1.0, 2.0, 3.0};
 		miint::BIOMTable table(features, samples, values);
 
-		auto csc = table.ToCSC();
+		auto csc = table.CSC();
 
 		std::vector<double> exp_data = {1.0, 2.0, 3.0};
 		std::vector<int32_t> exp_indices = {0, 1, 2};
@@ -402,7 +408,7 @@ TEST_CASE("BIOMTable ToCSC conversion", "[BIOMTable]") {
 		std::vector<double> values = {5.0};
 		miint::BIOMTable table(features, samples, values);
 
-		auto csc = table.ToCSC();
+		auto csc = table.CSC();
 
 		std::vector<double> exp_data = {5.0};
 		std::vector<int32_t> exp_indices = {0};
@@ -413,3 +419,264 @@ TEST_CASE("BIOMTable ToCSC conversion", "[BIOMTable]") {
 		REQUIRE((csc.indptr == exp_indptr));
 	}
 }
+
+TEST_CASE("Counting sort by key", "[BIOMTable]") {
+	SECTION("Stable with bucket boundaries") {
+		std::vector<size_t> keys = {2, 0, 2, 1, 0};
+		std::vector<size_t> others = {10, 11, 12, 13, 14};
+		std::vector<double> values = {1.0, 2.0, 3.0, 4.0, 5.0};
+
+		auto boundaries = miint::counting_sort_by_key(keys, others, values, 4);
+
+		REQUIRE((keys == std::vector<size_t> {0, 0, 1, 2, 2}));
+		REQUIRE((others == std::vector<size_t> {11, 14, 13, 10, 12}));
+		REQUIRE((values == std::vector<double> {2.0, 5.0, 4.0, 1.0, 3.0}));
+		REQUIRE((boundaries == std::vector<size_t> {0, 2, 3, 5, 5}));
+	}
+
+	SECTION("Empty") {
+		std::vector<size_t> keys, others;
+		std::vector<double> values;
+		auto boundaries = miint::counting_sort_by_key(keys, others, values, 2);
+		REQUIRE((boundaries == std::vector<size_t> {0, 0, 0}));
+	}
+
+	SECTION("Out of range key") {
+		std::vector<size_t> keys = {0, 3};
+		std::vector<size_t> others = {0, 0};
+		std::vector<double> values = {1.0, 1.0};
+		REQUIRE_THROWS_AS(miint::counting_sort_by_key(keys, others, values, 3), std::out_of_range);
+	}
+
+	SECTION("Two passes match the comparison sort for any thread count") {
+		// Large enough for the input to be split between threads
+		size_t n = 200000;
+		std::vector<size_t> rows(n), cols(n);
+		std::vector<double> values(n);
+		uint64_t state = 12345;
+		for (size_t i = 0; i < n; i++) {
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			rows[i] = (state >> 33) % 50;
+			cols[i] = (state >> 17) % 300;
+			values[i] = static_cast<double>(i);
+		}
+
+		auto exp_rows = rows;
+		auto exp_cols = cols;
+		auto exp_values = values;
+		miint::sort_by_row_then_column(exp_rows, exp_cols, exp_values);
+
+		for (size_t n_threads : {1, 2, 3, 8}) {
+			auto sorted_rows = rows;
+			auto sorted_cols = cols;
+			auto sorted_values = values;
+			miint::counting_sort_by_key(sorted_cols, sorted_rows, sorted_values, 300, n_threads);
+			miint::counting_sort_by_key(sorted_rows, sorted_cols, sorted_values, 50, n_threads);
+
+			REQUIRE((sorted_rows == exp_rows));
+			REQUIRE((sorted_cols == exp_cols));
+			// Ties keep their input order, as equal (row, col) pairs are summed in that order
+			bool stable = true;
+			for (size_t i = 1; i < n; i++) {
+				if (sorted_rows[i] == sorted_rows[i - 1] && sorted_cols[i] == sorted_cols[i - 1]) {
+					stable = stable && sorted_values[i] > sorted_values[i - 1];
+				}
+			}
+			REQUIRE(stable);
+		}
+	}
+}
+
+TEST_CASE("Run parallel", "[BIOMTable]") {
+	SECTION("Runs every task once") {
+		std::vector<int> seen(1000, 0);
+		miint::run_parallel(seen.size(), 4, [&](size_t i) { seen[i]++; });
+		REQUIRE((seen == std::vector<int>(1000, 1)));
+	}
+
+	SECTION("Rethrows task errors") {
+		REQUIRE_THROWS_WITH(miint::run_parallel(100, 4,
+		                                        [](size_t i) {
+			                                        if (i == 42) {
+				                                        throw std::runtime_error("task failed");
+			                                        }
+		                                        }),
+		                    "task failed");
+	}
+
+	SECTION("Concurrent calls share their threads") {
+		// Four callers asking for 4 threads each get 4, 2, 1 and 1 in the order they start, not 16 in total
+		std::atomic<int> running {0};
+		std::atomic<int> max_running {0};
+		auto task = [&](size_t) {
+			int now = ++running;
+			int seen = max_running.load();
+			while (now > seen && !max_running.compare_exchange_weak(seen, now)) {
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+			--running;
+		};
+		std::vector<std::thread> callers;
+		for (int i = 0; i < 4; i++) {
+			callers.emplace_back([&]() { miint::run_parallel(200, 4, task); });
+		}
+		for (auto &caller : callers) {
+			caller.join();
+		}
+		REQUIRE(max_running.load() <= 8);
+	}
+
+	SECTION("Worker pool reuses its threads") {
+		miint::WorkerPool pool(4);
+		REQUIRE(pool.size() == 4);
+		std::mutex lock;
+		std::set<std::thread::id> threads;
+		for (int run = 0; run < 50; run++) {
+			std::vector<int> seen(100, 0);
+			pool.run(seen.size(), [&](size_t i) {
+				seen[i]++;
+				std::lock_guard<std::mutex> guard(lock);
+				threads.insert(std::this_thread::get_id());
+			});
+			REQUIRE((seen == std::vector<int>(100, 1)));
+		}
+		REQUIRE(threads.size() <= 4);
+	}
+
+	SECTION("Worker pool rethrows task errors and keeps working") {
+		miint::WorkerPool pool(4);
+		REQUIRE_THROWS_WITH(pool.run(100,
+		                             [](size_t i) {
+			                             if (i == 42) {
+				                             throw std::runtime_error("task failed");
+			                             }
+		                             }),
+		                    "task failed");
+		std::atomic<size_t> done {0};
+		pool.run(100, [&](size_t) { done++; });
+		REQUIRE(done.load() == 100);
+	}
+
+	SECTION("Idle worker pools do not take a share of the threads") {
+		miint::WorkerPool idle(4);
+		std::atomic<int> running {0};
+		std::atomic<int> max_running {0};
+		miint::run_parallel(64, 4, [&](size_t) {
+			int now = ++running;
+			int seen = max_running.load();
+			while (now > seen && !max_running.compare_exchange_weak(seen, now)) {
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			--running;
+		});
+		REQUIRE(max_running.load() > 2);
+	}
+}
+
+TEST_CASE("BIOMTable from indices with threads", "[BIOMTable]") {
+	size_t n = 100000;
+	std::vector<size_t> feature_indices(n), sample_indices(n);
+	std::vector<double> values(n);
+	std::vector<std::string> feature_ids, sample_ids;
+	for (size_t i = 0; i < 400; i++) {
+		feature_ids.push_back("F" + std::to_string(i));
+	}
+	for (size_t i = 0; i < 30; i++) {
+		sample_ids.push_back("S" + std::to_string(i));
+	}
+	for (size_t i = 0; i < n; i++) {
+		feature_indices[i] = (i * 7919) % 400;
+		sample_indices[i] = (i * 104729) % 30;
+		values[i] = (i % 5 == 0) ? 0.0 : 1.0;
+	}
+
+	miint::BIOMTable serial(feature_indices, sample_indices, values, feature_ids, sample_ids);
+	miint::BIOMTable threaded(feature_indices, sample_indices, values, feature_ids, sample_ids, 4);
+
+	REQUIRE((threaded.COOFeatureIndices() == serial.COOFeatureIndices()));
+	REQUIRE((threaded.COOSampleIndices() == serial.COOSampleIndices()));
+	REQUIRE((threaded.COOValues() == serial.COOValues()));
+
+	auto csr = threaded.ToCSR(4);
+	auto exp_csr = serial.ToCSR();
+	REQUIRE((csr.data == exp_csr.data));
+	REQUIRE((csr.indices == exp_csr.indices));
+	REQUIRE((csr.indptr == exp_csr.indptr));
+	REQUIRE((csr.indptr.size() == 401));
+
+	// Within each row the columns are ascending
+	bool ascending = true;
+	for (size_t row = 0; row < 400; row++) {
+		for (auto i = csr.indptr[row] + 1; i < csr.indptr[row + 1]; i++) {
+			ascending = ascending && csr.indices[i] > csr.indices[i - 1];
+		}
+	}
+	REQUIRE(ascending);
+
+	const auto &csc = threaded.CSC();
+	REQUIRE((csc.indptr.size() == 31));
+	REQUIRE((static_cast<size_t>(csc.indptr.back()) == threaded.nnz()));
+}
+
+TEST_CASE("BIOMTable keeps canonical CSC arrays", "[BIOMTable]") {
+	// Matrix (3 features x 3 samples), given unsorted, with a duplicate and a zero:
+	//         S0   S1   S2
+	//   F0    1.0  0.0  2.0
+	//   F1    0.0  0.0  5.0
+	//   F2    4.0  0.0  0.0
+	std::vector<uint32_t> feature_indices = {2, 0, 1, 0, 1, 0};
+	std::vector<uint32_t> sample_indices = {0, 2, 2, 0, 2, 1};
+	std::vector<double> values = {4.0, 2.0, 3.0, 1.0, 2.0, 0.0};
+	miint::BIOMTable table(feature_indices, sample_indices, values, {"F0", "F1", "F2"}, {"S0", "S1", "S2"}, 2);
+
+	const auto &csc = table.CSC();
+	REQUIRE((csc.indptr == std::vector<int32_t> {0, 2, 2, 4}));
+	REQUIRE((csc.indices == std::vector<int32_t> {0, 2, 0, 1}));
+	REQUIRE((csc.data == std::vector<double> {1.0, 4.0, 2.0, 5.0}));
+	REQUIRE((table.nnz() == 4));
+
+	// The triplet view is expanded from the same arrays
+	REQUIRE((table.COOSampleIndices() == std::vector<size_t> {0, 0, 2, 2}));
+	REQUIRE((table.COOFeatureIndices() == std::vector<size_t> {0, 2, 0, 1}));
+
+	auto csr = table.ToCSR();
+	REQUIRE((csr.indptr == std::vector<int32_t> {0, 2, 3, 4}));
+	REQUIRE((csr.indices == std::vector<int32_t> {0, 2, 2, 0}));
+	REQUIRE((csr.data == std::vector<double> {1.0, 2.0, 5.0, 4.0}));
+}
+
+TEST_CASE("BIOMTable transposes large tables on threads", "[BIOMTable]") {
+	size_t n = 300000;
+	std::vector<uint32_t> feature_indices(n), sample_indices(n);
+	std::vector<double> values(n);
+	std::vector<std::string> feature_ids, sample_ids;
+	for (size_t i = 0; i < 50; i++) {
+		feature_ids.push_back("F" + std::to_string(i));
+	}
+	for (size_t i = 0; i < 2000; i++) {
+		sample_ids.push_back("S" + std::to_string(i));
+	}
+	for (size_t i = 0; i < n; i++) {
+		feature_indices[i] = (i * 7919) % 50;
+		sample_indices[i] = (i * 104729) % 2000;
+		values[i] = 1.0;
+	}
+	miint::BIOMTable table(feature_indices, sample_indices, values, feature_ids, sample_ids, 4);
+
+	auto serial = table.ToCSR(1);
+	for (size_t n_threads : {2, 3, 8}) {
+		auto csr = table.ToCSR(n_threads);
+		REQUIRE((csr.indptr == serial.indptr));
+		REQUIRE((csr.indices == serial.indices));
+		REQUIRE((csr.data == serial.data));
+	}
+	// Within each row the samples are ascending
+	bool ascending = true;
+	for (size_t row = 0; row < 50; row++) {
+		for (auto i = serial.indptr[row] + 1; i < serial.indptr[row + 1]; i++) {
+			ascending = ascending && serial.indices[i] > serial.indices[i - 1];
+		}
+	}
+	REQUIRE(ascending);
+	REQUIRE((static_cast<size_t>(serial.indptr.back()) == table.nnz()));
+}
@@ -0,0 +1,102 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <algorithm>
+#include <vector>
+#include "BetaDiversity.hpp"
+
+using namespace miint;
+using Catch::Matchers::WithinAbs;
+
+namespace {
+
+// A sparse table and its dense copy
+struct Table {
+	std::vector<uint64_t> indptr = {0};
+	std::vector<uint32_t> features;
+	std::vector<double> values;
+	std::vector<std::vector<double>> dense;
+
+	Table(size_t n_samples, size_t n_features, uint64_t seed) {
+		dense.assign(n_samples, std::vector<double>(n_features, 0));
+		uint64_t state = seed;
+		for (size_t i = 0; i < n_samples; i++) {
+			for (uint32_t k = 0; k < n_features; k++) {
+				state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+				if ((state >> 33) % 4 == 0) {
+					dense[i][k] = static_cast<double>((state >> 40) % 20 + 1);
+					features.push_back(k);
+					values.push_back(dense[i][k]);
+				}
+			}
+			indptr.push_back(features.size());
+		}
+	}
+};
+
+double brute_force(const std::vector<double> &a, const std::vector<double> &b, BetaMetric metric) {
+	double shared = 0, total = 0;
+	for (size_t k = 0; k < a.size(); k++) {
+		if (metric == BetaMetric::BRAY_CURTIS) {
+			shared += std::min(a[k], b[k]);
+			total += a[k] + b[k];
+		} else {
+			shared += (a[k] > 0 && b[k] > 0) ? 1 : 0;
+			total += (a[k] > 0 || b[k] > 0) ? 1 : 0;
+		}
+	}
+	if (total == 0) {
+		return 0;
+	}
+	return metric == BetaMetric::BRAY_CURTIS ? 1 - 2 * shared / total : 1 - shared / total;
+}
+
+} // namespace
+
+TEST_CASE("BetaDiversity - matches dense computation", "[BetaDiversity]") {
+	Table table(60, 40, 11);
+	for (auto metric : {BetaMetric::BRAY_CURTIS, BetaMetric::JACCARD}) {
+		BetaDiversity beta(table.indptr.data(), table.features.data(), table.values.data(), 60, 40, metric);
+		REQUIRE(beta.sample_count() == 60);
+		std::vector<double> scratch, out;
+		for (size_t i = 0; i < 60; i++) {
+			beta.row(i, scratch, out);
+			REQUIRE(out.size() == 60 - i - 1);
+			for (size_t j = i + 1; j < 60; j++) {
+				CHECK_THAT(out[j - i - 1], WithinAbs(brute_force(table.dense[i], table.dense[j], metric), 1e-12));
+			}
+		}
+	}
+}
+
+TEST_CASE("BetaDiversity - known values", "[BetaDiversity]") {
+	// a = {f0: 6, f1: 7, f2: 4}, b = {f1: 10, f3: 2}, c = {}
+	std::vector<uint64_t> indptr = {0, 3, 5, 5};
+	std::vector<uint32_t> features = {0, 1, 2, 1, 3};
+	std::vector<double> values = {6, 7, 4, 10, 2};
+	std::vector<double> scratch, out;
+
+	BetaDiversity bray(indptr.data(), features.data(), values.data(), 3, 4, BetaMetric::BRAY_CURTIS);
+	bray.row(0, scratch, out);
+	CHECK_THAT(out[0], WithinAbs(1 - 2.0 * 7 / 29, 1e-12));
+	CHECK(out[1] == 1.0);
+	bray.row(2, scratch, out);
+	CHECK(out.empty());
+
+	BetaDiversity jaccard(indptr.data(), features.data(), values.data(), 3, 4, BetaMetric::JACCARD);
+	jaccard.row(0, scratch, out);
+	CHECK_THAT(out[0], WithinAbs(0.75, 1e-12));
+	jaccard.row(1, scratch, out);
+	CHECK(out[0] == 1.0);
+}
+
+TEST_CASE("BetaDiversity - metric names and invalid values", "[BetaDiversity]") {
+	CHECK(parse_beta_metric("braycurtis") == BetaMetric::BRAY_CURTIS);
+	CHECK(parse_beta_metric("jaccard") == BetaMetric::JACCARD);
+	CHECK_THROWS_WITH(parse_beta_metric("euclid"), Catch::Matchers::ContainsSubstring("Unknown beta diversity"));
+
+	std::vector<uint64_t> indptr = {0, 1};
+	std::vector<uint32_t> features = {0};
+	std::vector<double> values = {-1};
+	CHECK_THROWS(BetaDiversity(indptr.data(), features.data(), values.data(), 1, 1, BetaMetric::BRAY_CURTIS));
+}
@@ -0,0 +1,127 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <CompactTree.hpp>
+#include <FaithPD.hpp>
+#include <TreeLCA.hpp>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace miint;
+using Catch::Matchers::WithinAbs;
+
+TEST_CASE("CompactTree - same topology as NewickTree", "[CompactTree]") {
+	auto newick = NewickTree::parse("((A:1.0,B:2.0)AB:0.5,(C:1.0,(D:2.0,E)DE:0.25,F:3)CDE:0.5)root;");
+	CompactTree tree(newick);
+	REQUIRE(tree.num_nodes() == newick.num_nodes());
+	REQUIRE(tree.num_tips() == newick.tips().size());
+	REQUIRE(tree.root() == newick.root());
+	REQUIRE(tree.parent(tree.root()) == CompactTree::NO_NODE);
+	REQUIRE(tree.preorder() == newick.preorder());
+	REQUIRE(tree.postorder() == newick.postorder());
+
+	for (uint32_t node = 0; node < newick.num_nodes(); node++) {
+		REQUIRE(tree.name(node) == newick.name(node));
+		REQUIRE(tree.is_tip(node) == newick.is_tip(node));
+		if (node != tree.root()) {
+			REQUIRE(tree.parent(node) == newick.parent(node));
+		}
+		auto children = tree.children(node);
+		REQUIRE(std::vector<uint32_t>(children.begin(), children.end()) == newick.children(node));
+		if (std::isnan(newick.branch_length(node))) {
+			REQUIRE(std::isnan(tree.branch_length(node)));
+		} else {
+			REQUIRE(tree.branch_length(node) == newick.branch_length(node));
+		}
+	}
+}
+
+TEST_CASE("CompactTree - parsed directly matches built from NewickTree", "[CompactTree]") {
+	for (const char *text : {"((A:1.0,B:2.0)AB:0.5,(C:1.0,(D:2.0,E)DE:0.25,F:3)CDE:0.5)root;",
+	                         "((A:0.1{0},'B ''x''':0.2{1})AB:0.3{2},(C:0.4{3},,D):0.6);", "A;", ";"}) {
+		auto newick = NewickTree::parse(text);
+		CompactTree built(newick);
+		CompactTree parsed {std::string_view(text)};
+		REQUIRE(parsed.num_nodes() == built.num_nodes());
+		REQUIRE(parsed.num_tips() == built.num_tips());
+		REQUIRE(parsed.root() == built.root());
+		REQUIRE(parsed.preorder() == built.preorder());
+		for (uint32_t node = 0; node < built.num_nodes(); node++) {
+			REQUIRE(parsed.parent(node) == built.parent(node));
+			REQUIRE(parsed.name(node) == built.name(node));
+			REQUIRE(parsed.edge_id(node) == built.edge_id(node));
+			REQUIRE(parsed.find_name(parsed.name(node)) == built.find_name(built.name(node)));
+			auto a = parsed.children(node);
+			auto b = built.children(node);
+			REQUIRE(std::vector<uint32_t>(a.begin(), a.end()) == std::vector<uint32_t>(b.begin(), b.end()));
+		}
+	}
+	REQUIRE_THROWS_AS(CompactTree(std::string_view("(A,B")), std::runtime_error);
+}
+
+TEST_CASE("CompactTree - name and edge indexes", "[CompactTree]") {
+	auto newick = NewickTree::parse("((A:0.1{0},B:0.2{1})AB:0.3{2},(C:0.4{3},C:0.5{3}):0.6)root;");
+	CompactTree tree(newick);
+
+	REQUIRE(tree.find_name("A") == *newick.find_node_by_name("A"));
+	REQUIRE(tree.find_name("AB") == *newick.find_node_by_name("AB"));
+	REQUIRE(tree.find_name("root") == tree.root());
+	REQUIRE(tree.find_name("C") == CompactTree::AMBIGUOUS);
+	REQUIRE(tree.find_name("D") == CompactTree::NOT_FOUND);
+	// Unnamed internal nodes are not indexed
+	REQUIRE(tree.find_name("") == CompactTree::NOT_FOUND);
+
+	REQUIRE(tree.find_edge(0) == tree.find_name("A"));
+	REQUIRE(tree.find_edge(2) == tree.find_name("AB"));
+	REQUIRE(tree.find_edge(3) == CompactTree::AMBIGUOUS);
+	REQUIRE(tree.find_edge(4) == CompactTree::NOT_FOUND);
+	REQUIRE(tree.edge_id(tree.find_name("B")) == 1);
+	REQUIRE_FALSE(tree.edge_id(tree.root()).has_value());
+	REQUIRE(tree.memory_usage() > 0);
+}
+
+TEST_CASE("CompactTree - single node and deep trees", "[CompactTree]") {
+	CompactTree single(NewickTree::parse("A;"));
+	REQUIRE(single.num_nodes() == 1);
+	REQUIRE(single.num_tips() == 1);
+	REQUIRE(single.preorder() == std::vector<uint32_t> {single.root()});
+
+	// Preorder is iterative, so a caterpillar tree does not overflow the stack
+	std::string newick = "A";
+	for (int i = 0; i < 5000; i++) {
+		newick = "(" + newick + ",T" + std::to_string(i) + ":1)";
+	}
+	auto parsed = NewickTree::parse(newick + ";");
+	CompactTree deep(parsed);
+	REQUIRE(deep.preorder() == parsed.preorder());
+	CompactTree deep_parsed {std::string_view(newick + ";")};
+	REQUIRE(deep_parsed.preorder() == parsed.preorder());
+}
+
+TEST_CASE("CompactTree - shared by TreeLCA and FaithPDTree", "[CompactTree]") {
+	auto newick = NewickTree::parse("((A:1.0,B:2.0)AB:0.5,(C:1.0,(D:2.0,E)DE:0.25)CDE:0.5)root;");
+	auto compact = std::make_shared<const CompactTree>(newick);
+
+	TreeLCA from_compact(compact);
+	TreeLCA from_newick(newick);
+	REQUIRE(&from_compact.tree() == compact.get());
+	for (uint32_t x = 0; x < newick.num_nodes(); x++) {
+		for (uint32_t y = 0; y < newick.num_nodes(); y++) {
+			REQUIRE(from_compact.lca(x, y) == from_newick.lca(x, y));
+			REQUIRE_THAT(from_compact.distance(x, y), WithinAbs(from_newick.distance(x, y), 1e-12));
+		}
+	}
+
+	FaithPDTree pd_compact(*compact);
+	FaithPDTree pd_newick(newick);
+	std::vector<uint64_t> visited(pd_compact.bitmap_words(), 0);
+	std::vector<uint32_t> tips;
+	for (const char *name : {"A", "D", "E"}) {
+		REQUIRE(pd_compact.tip(name) == pd_newick.tip(name));
+		tips.push_back(pd_compact.tip(name));
+	}
+	REQUIRE(pd_compact.tip("AB") == FaithPDTree::NOT_A_TIP);
+	REQUIRE_THAT(pd_compact.pd(tips, visited), WithinAbs(pd_newick.pd(tips, visited), 1e-12));
+}
@@ -0,0 +1,81 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <FaithPD.hpp>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace miint;
+using Catch::Matchers::WithinAbs;
+
+TEST_CASE("FaithPD - tip lookup", "[faith_pd]") {
+	auto newick = NewickTree::parse("((A:0.1,B:0.2)AB:0.3,(C:0.4,C:0.5):0.6);");
+	FaithPDTree tree(newick);
+	REQUIRE(tree.num_nodes() == newick.num_nodes());
+	REQUIRE(tree.tip("A") == *newick.find_node_by_name("A"));
+	REQUIRE(tree.tip("AB") == FaithPDTree::NOT_A_TIP);
+	REQUIRE(tree.tip("D") == FaithPDTree::NOT_A_TIP);
+	REQUIRE(tree.tip("C") == FaithPDTree::AMBIGUOUS_TIP);
+}
+
+TEST_CASE("FaithPD - union of root paths", "[faith_pd]") {
+	FaithPDTree tree(NewickTree::parse("((A:0.1,B:0.2):0.3,C:0.4,D)root:5;"));
+	std::vector<uint64_t> visited(tree.bitmap_words(), 0);
+	auto pd = [&](const std::vector<std::string> &names) {
+		std::vector<uint32_t> tips;
+		for (const auto &name : names) {
+			tips.push_back(tree.tip(name));
+		}
+		return tree.pd(tips, visited);
+	};
+
+	REQUIRE_THAT(pd({}), WithinAbs(0.0, 1e-12));
+	REQUIRE_THAT(pd({"A"}), WithinAbs(0.4, 1e-12));
+	REQUIRE_THAT(pd({"A", "B"}), WithinAbs(0.6, 1e-12));
+	REQUIRE_THAT(pd({"B", "A", "A", "B"}), WithinAbs(0.6, 1e-12));
+	REQUIRE_THAT(pd({"A", "C"}), WithinAbs(0.8, 1e-12));
+	// D has no branch length; the root's branch is never counted
+	REQUIRE_THAT(pd({"A", "B", "C", "D"}), WithinAbs(1.0, 1e-12));
+	for (auto word : visited) {
+		REQUIRE(word == 0);
+	}
+}
+
+TEST_CASE("FaithPD - matches per-tip root walks", "[faith_pd]") {
+	// Random binary tree of 300 tips
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<double> length(0.01, 1.0);
+	std::vector<std::string> subtrees;
+	for (int i = 0; i < 300; i++) {
+		subtrees.push_back("T" + std::to_string(i) + ":" + std::to_string(length(rng)));
+	}
+	while (subtrees.size() > 1) {
+		size_t a = rng() % subtrees.size();
+		std::swap(subtrees[a], subtrees.back());
+		auto left = subtrees.back();
+		subtrees.pop_back();
+		size_t b = rng() % subtrees.size();
+		subtrees[b] = "(" + left + "," + subtrees[b] + "):" + std::to_string(length(rng));
+	}
+	auto newick = NewickTree::parse(subtrees[0] + ";");
+	FaithPDTree tree(newick);
+	std::vector<uint64_t> visited(tree.bitmap_words(), 0);
+
+	for (int sample = 0; sample < 50; sample++) {
+		std::vector<uint32_t> tips;
+		std::set<uint32_t> nodes;
+		for (int k = 0; k < 1 + sample * 3; k++) {
+			auto tip = tree.tip("T" + std::to_string(rng() % 300));
+			tips.push_back(tip);
+			for (auto node = tip; node != newick.root(); node = newick.parent(node)) {
+				nodes.insert(node);
+			}
+		}
+		double expected = 0;
+		for (auto node : nodes) {
+			expected += newick.branch_length(node);
+		}
+		REQUIRE_THAT(tree.pd(tips, visited), WithinAbs(expected, 1e-9));
+	}
+}
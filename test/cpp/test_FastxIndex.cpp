@@ -0,0 +1,195 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "htslib-1.22.1/htslib/bgzf.h"
+#include "FastxIndex.hpp"
+#include "SequenceReader.hpp"
+
+using namespace miint;
+
+namespace {
+
+std::string fastq_record(size_t i) {
+	std::string seq(20 + i % 37, "ACGT"[i % 4]);
+	return "@read_" + std::to_string(i) + "\n" + seq + "\n+\n" + std::string(seq.size(), 'I') + "\n";
+}
+
+// Build records the way COPY does: a buffer of records plus the offset of each record in it
+std::string build_buffer(size_t first, size_t count, std::vector<uint64_t> &offsets) {
+	std::string buffer;
+	offsets.clear();
+	for (size_t i = first; i < first + count; i++) {
+		offsets.push_back(buffer.size());
+		buffer += fastq_record(i);
+	}
+	return buffer;
+}
+
+// Compress buffer into BGZF blocks of BGZF_BLOCK_DATA_SIZE bytes, recording each block's size
+std::string compress_blocks(const std::string &buffer, std::vector<uint64_t> &block_sizes) {
+	std::string out;
+	block_sizes.clear();
+	std::vector<uint8_t> block(BGZF_MAX_BLOCK_SIZE);
+	for (size_t offset = 0; offset < buffer.size(); offset += FastxIndex::BGZF_BLOCK_DATA_SIZE) {
+		size_t chunk = std::min<size_t>(buffer.size() - offset, FastxIndex::BGZF_BLOCK_DATA_SIZE);
+		size_t block_length = block.size();
+		REQUIRE(bgzf_compress(block.data(), &block_length, buffer.data() + offset, chunk, -1) == 0);
+		out.append(reinterpret_cast<const char *>(block.data()), block_length);
+		block_sizes.push_back(block_length);
+	}
+	return out;
+}
+
+class TempFile {
+public:
+	explicit TempFile(const std::string &name)
+	    : path((std::filesystem::temp_directory_path() / name).string()) {
+	}
+	~TempFile() {
+		std::filesystem::remove(path);
+	}
+	void write(const std::string &data) const {
+		std::ofstream out(path, std::ios::binary);
+		out << data;
+	}
+	std::string path;
+};
+
+} // namespace
+
+TEST_CASE("FastxIndex - samples every interval-th record", "[FastxIndex]") {
+	FastxIndex index(4);
+	std::vector<uint64_t> offsets;
+	auto buffer1 = build_buffer(0, 6, offsets);
+	index.add_block(offsets, buffer1.size(), 0, {});
+	auto offsets1 = offsets;
+	auto buffer2 = build_buffer(6, 5, offsets);
+	index.add_block(offsets, buffer2.size(), buffer1.size(), {});
+
+	REQUIRE(index.record_count == 11);
+	REQUIRE(index.uncompressed_size == buffer1.size() + buffer2.size());
+	REQUIRE(index.entries.size() == 3);
+	CHECK(index.entries[0].record == 0);
+	CHECK(index.entries[0].offset == 0);
+	CHECK(index.entries[1].record == 4);
+	CHECK(index.entries[1].offset == offsets1[4]);
+	CHECK(index.entries[2].record == 8);
+	CHECK(index.entries[2].offset == buffer1.size() + offsets[2]);
+	CHECK(index.entries[2].virtual_offset == 0);
+}
+
+TEST_CASE("FastxIndex - seek finds the entry at or before a record", "[FastxIndex]") {
+	FastxIndex index(10);
+	std::vector<uint64_t> offsets;
+	auto buffer = build_buffer(0, 35, offsets);
+	index.add_block(offsets, buffer.size(), 0, {});
+
+	CHECK(index.seek(0).record == 0);
+	CHECK(index.seek(9).record == 0);
+	CHECK(index.seek(10).record == 10);
+	CHECK(index.seek(34).record == 30);
+	CHECK(index.seek(1000).record == 30);
+}
+
+TEST_CASE("FastxIndex - serialize round trip", "[FastxIndex]") {
+	FastxIndex index(3, true);
+	std::vector<uint64_t> offsets, block_sizes;
+	auto buffer = build_buffer(0, 10, offsets);
+	compress_blocks(buffer, block_sizes);
+	index.add_block(offsets, buffer.size(), 100, block_sizes);
+	index.file_size = 12345;
+
+	auto restored = FastxIndex::deserialize(index.serialize());
+	CHECK(restored.interval == 3);
+	CHECK(restored.compressed);
+	CHECK(restored.record_count == 10);
+	CHECK(restored.uncompressed_size == buffer.size());
+	CHECK(restored.file_size == 12345);
+	REQUIRE(restored.entries.size() == index.entries.size());
+	for (size_t i = 0; i < index.entries.size(); i++) {
+		CHECK(restored.entries[i].record == index.entries[i].record);
+		CHECK(restored.entries[i].offset == index.entries[i].offset);
+		CHECK(restored.entries[i].virtual_offset == index.entries[i].virtual_offset);
+	}
+}
+
+TEST_CASE("FastxIndex - rejects corrupt data", "[FastxIndex]") {
+	CHECK_THROWS_WITH(FastxIndex::deserialize("not an index"), Catch::Matchers::ContainsSubstring("Not a FASTX index"));
+
+	FastxIndex index(2);
+	std::vector<uint64_t> offsets;
+	auto buffer = build_buffer(0, 8, offsets);
+	index.add_block(offsets, buffer.size(), 0, {});
+	auto data = index.serialize();
+	CHECK_THROWS_WITH(FastxIndex::deserialize(data.substr(0, data.size() - 5)),
+	                  Catch::Matchers::ContainsSubstring("Truncated"));
+	CHECK_THROWS(FastxIndex(0));
+}
+
+TEST_CASE("FastxIndex - ranged reads of a plain file", "[FastxIndex]") {
+	FastxIndex index(100);
+	std::vector<uint64_t> offsets;
+	std::string file;
+	for (size_t first = 0; first < 1000; first += 250) {
+		auto buffer = build_buffer(first, 250, offsets);
+		index.add_block(offsets, buffer.size(), file.size(), {});
+		file += buffer;
+	}
+	TempFile temp("fastx_index_plain.fastq");
+	temp.write(file);
+
+	for (const auto &entry : index.entries) {
+		SequenceReadRange range;
+		range.offset1 = entry.offset;
+		range.max_records = 100;
+		SequenceReader reader(temp.path, std::nullopt, range);
+		auto batch = reader.read(1000);
+		REQUIRE(batch.size() == 100);
+		CHECK(batch.read_ids.front() == "read_" + std::to_string(entry.record));
+		CHECK(batch.read_ids.back() == "read_" + std::to_string(entry.record + 99));
+		CHECK(reader.read(1000).empty());
+	}
+}
+
+TEST_CASE("FastxIndex - ranged reads of a BGZF file", "[FastxIndex]") {
+	// Large enough that records straddle block boundaries and flushes cover several blocks
+	FastxIndex index(1000, true);
+	std::vector<uint64_t> offsets, block_sizes;
+	std::string file;
+	for (size_t first = 0; first < 20000; first += 5000) {
+		auto buffer = build_buffer(first, 5000, offsets);
+		auto blocks = compress_blocks(buffer, block_sizes);
+		index.add_block(offsets, buffer.size(), file.size(), block_sizes);
+		file += blocks;
+	}
+	TempFile temp("fastx_index_bgzf.fastq.gz");
+	temp.write(file);
+
+	REQUIRE(index.entries.size() == 20);
+	for (const auto &entry : index.entries) {
+		SequenceReadRange range;
+		range.offset1 = entry.virtual_offset;
+		range.compressed1 = true;
+		range.max_records = 1000;
+		SequenceReader reader(temp.path, std::nullopt, range);
+		size_t total = 0;
+		std::string first_id, last_id;
+		while (true) {
+			auto batch = reader.read(300);
+			if (batch.empty()) {
+				break;
+			}
+			if (first_id.empty()) {
+				first_id = batch.read_ids.front();
+			}
+			last_id = batch.read_ids.back();
+			total += batch.size();
+		}
+		CHECK(total == 1000);
+		CHECK(first_id == "read_" + std::to_string(entry.record));
+		CHECK(last_id == "read_" + std::to_string(entry.record + 999));
+	}
+}
@@ -0,0 +1,127 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "HDF5Chunks.hpp"
+
+using namespace miint;
+
+namespace {
+
+// A 1-D dataset in a temporary HDF5 file, written through the regular (filtered) HDF5 path
+class TempDataset {
+public:
+	TempDataset(const std::string &name, hid_t file_type, hid_t mem_type, const void *values, hsize_t n,
+	            hsize_t chunk, const std::vector<H5Z_filter_t> &filters)
+	    : path((std::filesystem::temp_directory_path() / name).string()) {
+		file = H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+		hid_t space = H5Screate_simple(1, &n, nullptr);
+		hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+		H5Pset_chunk(dcpl, 1, &chunk);
+		for (auto filter : filters) {
+			if (filter == H5Z_FILTER_DEFLATE) {
+				H5Pset_deflate(dcpl, 6);
+			} else if (filter == H5Z_FILTER_SHUFFLE) {
+				H5Pset_shuffle(dcpl);
+			}
+		}
+		dataset = H5Dcreate2(file, "values", file_type, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+		H5Dwrite(dataset, mem_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, values);
+		H5Pclose(dcpl);
+		H5Sclose(space);
+	}
+	~TempDataset() {
+		H5Dclose(dataset);
+		H5Fclose(file);
+		std::filesystem::remove(path);
+	}
+
+	std::string path;
+	hid_t file;
+	hid_t dataset;
+};
+
+template <typename T>
+std::vector<T> decode(hid_t dataset, const HDF5ChunkLayout &layout, uint64_t begin, uint64_t end) {
+	HDF5RawRange raw;
+	hdf5_read_raw_range(dataset, layout, begin, end, raw);
+	std::vector<T> out(end - begin);
+	hdf5_decode_range(layout, raw, out.data());
+	return out;
+}
+
+} // namespace
+
+TEST_CASE("HDF5Chunks - deflate and shuffle chunks decode outside HDF5", "[HDF5Chunks]") {
+	std::vector<int32_t> values(10007);
+	for (size_t i = 0; i < values.size(); i++) {
+		values[i] = static_cast<int32_t>(i * 7919 % 100003) - 50000;
+	}
+	TempDataset temp("hdf5_chunks_int.h5", H5T_STD_I32LE, H5T_NATIVE_INT32, values.data(), values.size(), 1000,
+	                 {H5Z_FILTER_SHUFFLE, H5Z_FILTER_DEFLATE});
+
+	auto layout = HDF5ChunkLayout::inspect(temp.dataset);
+	REQUIRE(layout.direct);
+	CHECK(layout.chunk_elements == 1000);
+	CHECK(layout.element_size == 4);
+	CHECK(layout.filters == std::vector<H5Z_filter_t> {H5Z_FILTER_SHUFFLE, H5Z_FILTER_DEFLATE});
+
+	// Whole dataset, a range inside one chunk, and ranges straddling chunk and dataset ends
+	for (auto range : std::vector<std::pair<uint64_t, uint64_t>> {{0, 10007}, {10, 20}, {999, 3001}, {9500, 10007}}) {
+		auto decoded = decode<int32_t>(temp.dataset, layout, range.first, range.second);
+		CHECK(decoded == std::vector<int32_t>(values.begin() + range.first, values.begin() + range.second));
+	}
+	CHECK(decode<int32_t>(temp.dataset, layout, 5, 5).empty());
+	CHECK_THROWS(decode<int32_t>(temp.dataset, layout, 10000, 11000));
+}
+
+TEST_CASE("HDF5Chunks - stored types are converted", "[HDF5Chunks]") {
+	std::vector<float> values = {0.5f, 1.0f, 2.25f, -3.0f, 1e6f};
+	TempDataset temp("hdf5_chunks_float.h5", H5T_IEEE_F32LE, H5T_NATIVE_FLOAT, values.data(), values.size(), 2,
+	                 {H5Z_FILTER_DEFLATE});
+	auto layout = HDF5ChunkLayout::inspect(temp.dataset);
+	REQUIRE(layout.direct);
+	CHECK(decode<double>(temp.dataset, layout, 0, 5) == std::vector<double> {0.5, 1.0, 2.25, -3.0, 1e6});
+
+	std::vector<int64_t> wide = {1, 2, 3, 4, 5, 6};
+	TempDataset temp64("hdf5_chunks_int64.h5", H5T_STD_I64LE, H5T_NATIVE_INT64, wide.data(), wide.size(), 4, {});
+	auto layout64 = HDF5ChunkLayout::inspect(temp64.dataset);
+	REQUIRE(layout64.direct);
+	CHECK(decode<int32_t>(temp64.dataset, layout64, 1, 6) == std::vector<int32_t> {2, 3, 4, 5, 6});
+}
+
+TEST_CASE("HDF5Chunks - unsupported layouts are not read directly", "[HDF5Chunks]") {
+	std::vector<int32_t> values = {1, 2, 3};
+	hsize_t n = values.size();
+	TempDataset temp("hdf5_chunks_contiguous.h5", H5T_STD_I32BE, H5T_NATIVE_INT32, values.data(), n, 2, {});
+	// Big-endian storage
+	CHECK_FALSE(HDF5ChunkLayout::inspect(temp.dataset).direct);
+
+	// Contiguous storage
+	hid_t space = H5Screate_simple(1, &n, nullptr);
+	hid_t contiguous = H5Dcreate2(temp.file, "contiguous", H5T_STD_I32LE, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	auto layout = HDF5ChunkLayout::inspect(contiguous);
+	CHECK_FALSE(layout.direct);
+	HDF5RawRange raw;
+	CHECK_THROWS(hdf5_read_raw_range(contiguous, layout, 0, 3, raw));
+	H5Dclose(contiguous);
+	H5Sclose(space);
+}
+
+TEST_CASE("HDF5Chunks - LZF", "[HDF5Chunks]") {
+	// Literal "abc" followed by a 9-byte back reference at distance 3, which overlaps its own output
+	const char compressed[] = {0x02, 'a', 'b', 'c', static_cast<char>(0xE0), 0x00, 0x02};
+	char out[16];
+	CHECK(lzf_decompress(compressed, sizeof(compressed), out, sizeof(out)) == 12);
+	CHECK(std::string(out, 12) == "abcabcabcabc");
+
+	// Short back reference: length 3 + 2 at distance 1
+	const char repeated[] = {0x00, 'x', 0x60, 0x00};
+	CHECK(lzf_decompress(repeated, sizeof(repeated), out, sizeof(out)) == 6);
+	CHECK(std::string(out, 6) == "xxxxxx");
+
+	CHECK_THROWS_WITH(lzf_decompress(compressed, sizeof(compressed), out, 8), Catch::Matchers::ContainsSubstring("LZF"));
+	const char bad_distance[] = {0x00, 'x', 0x20, 0x05};
+	CHECK_THROWS(lzf_decompress(bad_distance, sizeof(bad_distance), out, sizeof(out)));
+}
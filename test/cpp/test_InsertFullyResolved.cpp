@@ -580,3 +580,101 @@ TEST_CASE("insert_fully_resolved at distal_length = edge_length", "[insert][edge
 	uint32_t internal = tree.parent(f);
 	REQUIRE(tree.branch_length(internal) == Approx(0.0));
 }
+
+// ============================================================================
+// Ordering and parallel insertion
+// ============================================================================
+
+TEST_CASE("insert_fully_resolved keeps sibling order", "[insert][order]") {
+	auto tree = miint::NewickTree::parse("((A:1.0{0},B:2.0{1}):0.5{2},C:3.0{3}):0.0{4};");
+
+	std::vector<miint::Placement> placements = {
+	    {.fragment_id = "F1", .edge_id = 0, .distal_length = 0.3, .pendant_length = 0.1, .like_weight_ratio = 1.0},
+	    {.fragment_id = "F2", .edge_id = 0, .distal_length = 0.3, .pendant_length = 0.2, .like_weight_ratio = 1.0}};
+
+	tree.insert_fully_resolved(placements);
+
+	// The chain takes A's place before B; placements at the same distal_length keep their input order
+	auto ab = tree.parent(tree.find_node_by_name("B").value());
+	REQUIRE(tree.children(ab).size() == 2);
+	REQUIRE(tree.children(ab)[1] == tree.find_node_by_name("B").value());
+	auto f1 = tree.find_node_by_name("F1").value();
+	REQUIRE(tree.children(ab)[0] == tree.parent(f1));
+	auto f2 = tree.find_node_by_name("F2").value();
+	REQUIRE(tree.parent(tree.parent(f2)) == tree.parent(f1));
+}
+
+TEST_CASE("insert_fully_resolved gives the same tree on several threads", "[insert][parallel]") {
+	// Enough placements for several chunks, with duplicated fragments and ties in distal_length
+	const std::string newick = "((A:1000.0{0},B:1000.0{1}):500.0{2},(C:1000.0{3},D:1000.0{4}):500.0{5}):0.0{6};";
+	std::vector<miint::Placement> placements;
+	for (int i = 0; i < 200000; ++i) {
+		placements.push_back({.fragment_id = "F" + std::to_string(i % 150000),
+		                      .edge_id = i % 6,
+		                      .distal_length = static_cast<double>(i % 401),
+		                      .pendant_length = 0.01 * (i % 5),
+		                      .like_weight_ratio = (i % 3) * 0.25});
+	}
+
+	auto serial = miint::NewickTree::parse(newick);
+	serial.insert_fully_resolved(placements, 1);
+	auto parallel = miint::NewickTree::parse(newick);
+	parallel.insert_fully_resolved(placements, 8);
+
+	REQUIRE(serial.num_tips() == 4 + 150000);
+	REQUIRE(serial.num_nodes() == 7 + 2 * 150000);
+	REQUIRE(parallel.to_newick() == serial.to_newick());
+	auto a = serial.find_node_by_name("A").value();
+	auto b = serial.find_node_by_name("B").value();
+	REQUIRE(serial.pairwise_distance(a, b) == Approx(2000.0));
+}
+
+TEST_CASE("insert_fully_resolved reports the first invalid placement", "[insert][error]") {
+	auto tree = miint::NewickTree::parse("((A:1.0{0},B:2.0{1}):0.5{2},C:3.0{3}):0.0{4};");
+
+	std::vector<miint::Placement> placements;
+	for (int i = 0; i < 300000; ++i) {
+		placements.push_back({.fragment_id = "F" + std::to_string(i),
+		                      .edge_id = 0,
+		                      .distal_length = 0.5,
+		                      .pendant_length = 0.1,
+		                      .like_weight_ratio = 1.0});
+	}
+	placements[250000].edge_id = 99;
+	placements[100000].pendant_length = -1.0;
+
+	REQUIRE_THROWS_WITH(tree.insert_fully_resolved(placements, 4), ContainsSubstring("'F100000'"));
+	// Nothing was inserted
+	REQUIRE(tree.num_nodes() == 5);
+}
+
+TEST_CASE("insert_fully_resolved on many children of one node", "[insert][scale]") {
+	// A star whose every tip edge gets a placement: each chain replaces its tip among the root's children, in order
+	std::string newick = "(";
+	for (int i = 0; i < 50000; ++i) {
+		newick += (i ? ",T" : "T") + std::to_string(i) + ":1.0{" + std::to_string(i) + "}";
+	}
+	newick += ");";
+	auto tree = miint::NewickTree::parse(newick);
+
+	std::vector<miint::Placement> placements;
+	for (int i = 0; i < 50000; i += 2) {
+		placements.push_back({.fragment_id = "F" + std::to_string(i),
+		                      .edge_id = i,
+		                      .distal_length = 0.5,
+		                      .pendant_length = 0.1,
+		                      .like_weight_ratio = 1.0});
+	}
+	tree.insert_fully_resolved(placements, 4);
+
+	REQUIRE(tree.num_tips() == 75000);
+	const auto &children = tree.children(tree.root());
+	REQUIRE(children.size() == 50000);
+	bool in_order = true;
+	for (int i = 0; i < 50000; ++i) {
+		// Below a new internal node, the tip follows the fragment
+		uint32_t tip = i % 2 == 0 ? tree.children(children[i])[1] : children[i];
+		in_order &= tree.name(tip) == "T" + std::to_string(i);
+	}
+	REQUIRE(in_order);
+}
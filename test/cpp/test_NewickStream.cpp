@@ -0,0 +1,182 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <MappedFile.hpp>
+#include <NewickStream.hpp>
+#include <NewickTree.hpp>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace miint;
+using Catch::Matchers::ContainsSubstring;
+
+static std::vector<NewickRow> all_rows(NewickStreamParser &parser) {
+	std::vector<NewickRow> rows;
+	NewickRow row;
+	while (parser.next(row)) {
+		rows.push_back(row);
+	}
+	return rows;
+}
+
+TEST_CASE("NewickStreamParser - rows as parents close", "[NewickStream]") {
+	std::string text = "((A:0.1,B:0.2)AB:0.3,C:0.4{7});";
+	NewickStreamParser parser(text);
+	auto rows = all_rows(parser);
+	REQUIRE(parser.num_nodes() == 5);
+	REQUIRE(parser.position() == text.size());
+
+	// A and B come out when AB closes, then AB and C when the root closes, then the root
+	REQUIRE(rows.size() == 5);
+	std::vector<std::string> names;
+	for (const auto &row : rows) {
+		names.emplace_back(row.name);
+	}
+	REQUIRE(names == std::vector<std::string> {"A", "B", "AB", "C", ""});
+	REQUIRE(rows[0].node == 0);
+	REQUIRE(rows[0].parent == 2);
+	REQUIRE(rows[0].is_tip);
+	REQUIRE(rows[2].node == 2);
+	REQUIRE(rows[2].parent == 4);
+	REQUIRE_FALSE(rows[2].is_tip);
+	REQUIRE(rows[3].edge_id == 7);
+	REQUIRE(rows[4].parent == NewickStreamParser::NO_PARENT);
+	REQUIRE(std::isnan(rows[4].branch_length));
+
+	// Unquoted names are views into the input
+	REQUIRE(rows[0].name.data() == text.data() + 2);
+}
+
+TEST_CASE("NewickStreamParser - matches NewickTree::parse", "[NewickStream]") {
+	std::string text = "(('A ''quoted'' name':1,\"B\":2[comment])[x]AB:0.5{1},(C,,D)CD,E:1e-3)root:0;";
+	auto tree = NewickTree::parse(text);
+	NewickStreamParser parser(text);
+	auto rows = all_rows(parser);
+	REQUIRE(rows.size() == tree.num_nodes());
+	for (const auto &row : rows) {
+		REQUIRE(row.name == tree.name(row.node));
+		REQUIRE(row.parent == tree.parent(row.node));
+		REQUIRE(row.is_tip == tree.is_tip(row.node));
+		REQUIRE(row.edge_id == tree.edge_id(row.node));
+		if (std::isnan(tree.branch_length(row.node))) {
+			REQUIRE(std::isnan(row.branch_length));
+		} else {
+			REQUIRE(row.branch_length == tree.branch_length(row.node));
+		}
+	}
+	REQUIRE(tree.name(*tree.find_node_by_name("A 'quoted' name")) == "A 'quoted' name");
+}
+
+TEST_CASE("NewickStreamParser - deep and wide trees", "[NewickStream]") {
+	// A caterpillar of a million tips, which a recursive parser could not handle
+	const int depth = 1000000;
+	std::string text(depth, '(');
+	text += "T";
+	for (int i = 0; i < depth; i++) {
+		text += ",T" + std::to_string(i) + ")";
+	}
+	text += ";";
+	NewickStreamParser parser(text);
+	NewickRow row;
+	size_t count = 0;
+	size_t tips = 0;
+	while (parser.next(row)) {
+		count++;
+		tips += row.is_tip;
+	}
+	REQUIRE(count == 2 * size_t(depth) + 1);
+	REQUIRE(tips == size_t(depth) + 1);
+	REQUIRE(NewickTree::parse(text).num_tips() == size_t(depth) + 1);
+
+	// A star: every tip waits for the root
+	std::string star = "(";
+	for (int i = 0; i < 10000; i++) {
+		star += (i ? ",S" : "S") + std::to_string(i);
+	}
+	star += ");";
+	NewickStreamParser star_parser(star);
+	auto rows = all_rows(star_parser);
+	REQUIRE(rows.size() == 10001);
+	REQUIRE(rows[9999].parent == 10000);
+	REQUIRE(rows[10000].parent == NewickStreamParser::NO_PARENT);
+}
+
+TEST_CASE("NewickStreamParser - errors", "[NewickStream]") {
+	auto parse_all = [](const std::string &text) {
+		NewickStreamParser parser(text);
+		all_rows(parser);
+	};
+	REQUIRE_THROWS_WITH(parse_all(""), ContainsSubstring("empty"));
+	REQUIRE_THROWS_WITH(parse_all("(A,B)"), ContainsSubstring("semicolon"));
+	REQUIRE_THROWS_WITH(parse_all("(A,B;"), ContainsSubstring("parenthes"));
+	REQUIRE_THROWS_WITH(parse_all("('A,B);"), ContainsSubstring("quote"));
+	REQUIRE_THROWS_WITH(parse_all("(A:x,B);"), ContainsSubstring("branch length"));
+	REQUIRE_THROWS_WITH(parse_all("(A{1,B);"), ContainsSubstring("brace"));
+
+	// Nodes before the error are returned first
+	NewickStreamParser parser("((A,B)C,D;");
+	NewickRow row;
+	REQUIRE(parser.next(row));
+	REQUIRE(row.name == "A");
+	REQUIRE(parser.next(row));
+	REQUIRE(row.name == "B");
+	REQUIRE_THROWS_WITH(parser.next(row), ContainsSubstring("parenthes"));
+}
+
+TEST_CASE("newick_tree_ends - tree boundaries", "[NewickStream]") {
+	using ends = std::vector<size_t>;
+	REQUIRE(newick_tree_ends("(A,B);") == ends {6});
+	REQUIRE(newick_tree_ends("(A,B);\n") == ends {6});
+	REQUIRE(newick_tree_ends("(A,B);\n(C,D);\n[trailing comment]\n") == ends {6, 13});
+	// ';' inside comments and quoted labels, including doubled quotes, is not a boundary
+	REQUIRE(newick_tree_ends("[a;b](A,B);('C;''D''',E);") == ends {11, 25});
+	REQUIRE(newick_tree_ends("(A,\"B;\")[x[;]y];") == ends {16});
+	// Text that is not a terminated tree is returned so that parsing it fails
+	REQUIRE(newick_tree_ends("(A,B);(C,D)") == ends {6, 11});
+	REQUIRE(newick_tree_ends("") == ends {0});
+	REQUIRE(newick_tree_ends("  \n") == ends {3});
+	REQUIRE(newick_tree_ends("(A,'B);") == ends {7});
+
+	// Each tree parses on its own
+	std::string text = "((A,B)AB,C);\n(D,(E,F));\n;\n";
+	auto tree_ends = newick_tree_ends(text);
+	REQUIRE(tree_ends.size() == 3);
+	std::vector<size_t> sizes;
+	size_t begin = 0;
+	for (auto end : tree_ends) {
+		NewickStreamParser parser(std::string_view(text).substr(begin, end - begin));
+		sizes.push_back(all_rows(parser).size());
+		begin = end;
+	}
+	REQUIRE(sizes == std::vector<size_t> {5, 5, 1});
+}
+
+TEST_CASE("MappedFile - maps regular files", "[MappedFile]") {
+	auto path = (std::filesystem::temp_directory_path() / "test_mapped_file.nwk").string();
+	{
+		std::ofstream out(path, std::ios::binary);
+		out << "(A:1,B:2);\n";
+	}
+	{
+		MappedFile file(path);
+		REQUIRE(file.view() == "(A:1,B:2);\n");
+		REQUIRE(MappedFile::is_mappable(path));
+	}
+
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	}
+	{
+		MappedFile empty(path);
+		REQUIRE(empty.view().empty());
+	}
+	std::remove(path.c_str());
+
+	REQUIRE_FALSE(MappedFile::is_mappable(path));
+	REQUIRE_THROWS_WITH(MappedFile(path), ContainsSubstring("Failed to open"));
+	REQUIRE_FALSE(MappedFile::is_mappable("/dev/null"));
+	REQUIRE_THROWS_WITH(MappedFile("/dev/null"), ContainsSubstring("Not a regular file"));
+}
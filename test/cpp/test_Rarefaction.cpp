@@ -0,0 +1,70 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <cmath>
+#include <vector>
+#include "Rarefaction.hpp"
+
+using namespace miint;
+
+TEST_CASE("Rarefaction - draws exactly depth items within the counts", "[Rarefaction]") {
+	std::vector<uint64_t> counts = {0, 5, 1000, 3, 250000, 1, 0, 77, 12};
+	RarefactionRandom random(7);
+	std::vector<uint64_t> out;
+	for (uint64_t depth : {0, 1, 9, 10, 1000, 200000, 251098}) {
+		rarefy(counts, depth, random, out);
+		REQUIRE(out.size() == counts.size());
+		uint64_t total = 0;
+		for (size_t i = 0; i < counts.size(); i++) {
+			CHECK(out[i] <= counts[i]);
+			total += out[i];
+		}
+		CHECK(total == depth);
+	}
+	// Drawing everything returns the counts
+	CHECK(out == counts);
+
+	CHECK_THROWS_WITH(rarefy(counts, 251099, random, out), Catch::Matchers::ContainsSubstring("depth of 251099"));
+}
+
+TEST_CASE("Rarefaction - deterministic for a seed", "[Rarefaction]") {
+	std::vector<uint64_t> counts(500);
+	for (size_t i = 0; i < counts.size(); i++) {
+		counts[i] = (i * 7919) % 1013;
+	}
+	std::vector<uint64_t> first, second, other;
+	RarefactionRandom a(rarefaction_seed(42, "sample1"));
+	RarefactionRandom b(rarefaction_seed(42, "sample1"));
+	RarefactionRandom c(rarefaction_seed(42, "sample2"));
+	rarefy(counts, 10000, a, first);
+	rarefy(counts, 10000, b, second);
+	rarefy(counts, 10000, c, other);
+	CHECK(first == second);
+	CHECK(first != other);
+	CHECK(rarefaction_seed(42, "sample1") != rarefaction_seed(43, "sample1"));
+}
+
+TEST_CASE("Rarefaction - hypergeometric moments", "[Rarefaction]") {
+	// Small samples use the urn, larger ones the ratio-of-uniforms sampler
+	struct Case {
+		uint64_t good, bad, sample;
+	};
+	for (auto test : {Case {30, 70, 5}, Case {30, 70, 95}, Case {400, 600, 100}, Case {5000000, 20000000, 1000000},
+	                  Case {3, 1000000, 500000}}) {
+		RarefactionRandom random(test.good + test.sample);
+		const int n = 20000;
+		double sum = 0, sum_sq = 0;
+		for (int i = 0; i < n; i++) {
+			auto k = random_hypergeometric(random, test.good, test.bad, test.sample);
+			REQUIRE(k <= std::min(test.good, test.sample));
+			sum += k;
+			sum_sq += static_cast<double>(k) * k;
+		}
+		double total = static_cast<double>(test.good + test.bad);
+		double mean = test.sample * test.good / total;
+		double var = mean * (test.bad / total) * (total - test.sample) / (total - 1);
+		double observed_mean = sum / n;
+		double observed_var = sum_sq / n - observed_mean * observed_mean;
+		CHECK(std::abs(observed_mean - mean) < 5 * std::sqrt(var / n) + 1e-9);
+		CHECK(std::abs(observed_var - var) < 0.1 * var + 1e-9);
+	}
+}
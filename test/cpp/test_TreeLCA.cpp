@@ -0,0 +1,80 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#include "TreeLCA.hpp"
+
+using Catch::Approx;
+using namespace miint;
+
+TEST_CASE("TreeLCA answers like NewickTree", "[TreeLCA]") {
+	auto tree = NewickTree::parse("((A:1.0,B:2.0)AB:0.5,(C:1.0,(D:2.0,E)DE:0.25)CDE:0.5)root;");
+	TreeLCA index(tree);
+	REQUIRE(index.num_nodes() == tree.num_nodes());
+
+	auto a = index.node("A");
+	auto b = index.node("B");
+	auto d = index.node("D");
+	auto e = index.node("E");
+	REQUIRE(index.lca(a, b) == index.node("AB"));
+	REQUIRE(index.lca(b, a) == index.node("AB"));
+	REQUIRE(index.lca(a, d) == tree.root());
+	REQUIRE(index.lca(d, e) == index.node("DE"));
+	REQUIRE(index.lca(a, a) == a);
+	REQUIRE(index.lca(a, index.node("AB")) == index.node("AB"));
+	REQUIRE(index.lca(tree.root(), e) == tree.root());
+
+	REQUIRE(index.distance(a, b) == Approx(3.0));
+	REQUIRE(index.distance(a, d) == Approx(1.0 + 0.5 + 0.5 + 0.25 + 2.0));
+	// E has no branch length, which counts as 0
+	REQUIRE(index.distance(d, e) == Approx(2.0));
+	REQUIRE(index.distance(a, a) == Approx(0.0));
+
+	for (uint32_t x = 0; x < tree.num_nodes(); x++) {
+		for (uint32_t y = 0; y < tree.num_nodes(); y++) {
+			REQUIRE(index.lca(x, y) == tree.find_lca(x, y));
+			REQUIRE(index.distance(x, y) == Approx(tree.pairwise_distance(x, y)));
+		}
+	}
+}
+
+TEST_CASE("TreeLCA on random trees", "[TreeLCA]") {
+	std::mt19937 rng(11);
+	for (size_t n_nodes : {1, 2, 3, 17, 64, 65, 1000}) {
+		// Random parents give trees of every shape, from paths to stars
+		std::vector<NodeInput> nodes;
+		std::uniform_real_distribution<double> length(0.0, 1.0);
+		for (size_t i = 0; i < n_nodes; i++) {
+			std::optional<int64_t> parent;
+			if (i > 0) {
+				parent = static_cast<int64_t>(std::uniform_int_distribution<size_t>(0, i - 1)(rng));
+			}
+			nodes.push_back({static_cast<int64_t>(i), parent, "n" + std::to_string(i), length(rng), std::nullopt});
+		}
+		auto tree = NewickTree::build(nodes);
+		TreeLCA index(tree);
+
+		std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(n_nodes - 1));
+		for (size_t q = 0; q < 2000; q++) {
+			auto x = pick(rng);
+			auto y = pick(rng);
+			REQUIRE(index.lca(x, y) == tree.find_lca(x, y));
+			REQUIRE(index.distance(x, y) == Approx(tree.pairwise_distance(x, y)).margin(1e-9));
+		}
+		for (uint32_t node = 0; node < n_nodes; node++) {
+			REQUIRE(index.node(tree.name(node)) == node);
+		}
+	}
+}
+
+TEST_CASE("TreeLCA name lookup", "[TreeLCA]") {
+	auto tree = NewickTree::parse("((A:1,A:1)X:1,(B:1,C:1):1);");
+	TreeLCA index(tree);
+	REQUIRE(index.node("A") == TreeLCA::AMBIGUOUS);
+	REQUIRE(index.node("missing") == TreeLCA::NOT_FOUND);
+	// Unnamed internal nodes cannot be looked up
+	REQUIRE(index.node("") == TreeLCA::NOT_FOUND);
+	REQUIRE(tree.name(index.node("X")) == "X");
+	REQUIRE(index.lca(index.node("B"), index.node("C")) == tree.parent(index.node("B")));
+}
@@ -0,0 +1,165 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "UniFrac.hpp"
+
+using namespace miint;
+using Catch::Matchers::WithinAbs;
+
+namespace {
+
+struct Counts {
+	std::vector<std::string> feature_ids;
+	std::vector<uint64_t> indptr = {0};
+	std::vector<uint32_t> features;
+	std::vector<double> values;
+	std::vector<std::vector<double>> dense; // sample x feature
+
+	SparseCounts sparse() const {
+		return {indptr.data(), features.data(), values.data(), dense.size()};
+	}
+};
+
+Counts random_counts(const std::vector<std::string> &feature_ids, size_t n_samples, uint64_t seed) {
+	Counts counts;
+	counts.feature_ids = feature_ids;
+	uint64_t state = seed;
+	for (size_t i = 0; i < n_samples; i++) {
+		counts.dense.emplace_back(feature_ids.size(), 0.0);
+		for (uint32_t k = 0; k < feature_ids.size(); k++) {
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			if ((state >> 33) % 3 == 0) {
+				counts.dense[i][k] = static_cast<double>((state >> 40) % 9 + 1);
+				counts.features.push_back(k);
+				counts.values.push_back(counts.dense[i][k]);
+			}
+		}
+		counts.indptr.push_back(counts.features.size());
+	}
+	return counts;
+}
+
+// UniFrac by its definition: every branch, with the samples' presence or proportion below it
+double brute_force(const NewickTree &tree, const Counts &counts, size_t a, size_t b, UniFracMetric metric) {
+	double total_a = 0, total_b = 0;
+	for (size_t k = 0; k < counts.feature_ids.size(); k++) {
+		total_a += counts.dense[a][k];
+		total_b += counts.dense[b][k];
+	}
+	double num = 0, den = 0;
+	for (uint32_t node = 0; node < tree.num_nodes(); node++) {
+		double length = tree.branch_length(node);
+		if (node == tree.root() || std::isnan(length)) {
+			continue;
+		}
+		double ea = 0, eb = 0;
+		for (size_t k = 0; k < counts.feature_ids.size(); k++) {
+			auto tip = *tree.find_node_by_name(counts.feature_ids[k]);
+			bool below = false;
+			for (auto n = tip; n != NewickTree::NO_PARENT; n = tree.parent(n)) {
+				below = below || n == node;
+			}
+			if (below) {
+				ea += counts.dense[a][k];
+				eb += counts.dense[b][k];
+			}
+		}
+		if (metric == UniFracMetric::UNWEIGHTED) {
+			bool pa = ea > 0, pb = eb > 0;
+			num += length * (pa != pb);
+			den += length * (pa || pb);
+		} else {
+			double pa = total_a > 0 ? ea / total_a : 0, pb = total_b > 0 ? eb / total_b : 0;
+			num += length * std::abs(pa - pb);
+			den += length * (pa + pb);
+		}
+	}
+	if (metric == UniFracMetric::WEIGHTED_UNNORMALIZED) {
+		return num;
+	}
+	return den > 0 ? num / den : 0;
+}
+
+} // namespace
+
+TEST_CASE("UniFrac - matches the definition", "[UniFrac]") {
+	auto tree = NewickTree::parse("((A:1,B:2):0.5,(C:1,(D:0.3,E:0.7,G:0.1):0.2):1.5,F:2,H);");
+	CompactTree compact(tree);
+	std::vector<std::string> feature_ids = {"A", "B", "C", "D", "E", "F", "G", "H"};
+	for (size_t n_samples : {2, 3, 8, 9, 40}) {
+		auto counts = random_counts(feature_ids, n_samples, n_samples);
+		for (auto metric :
+		     {UniFracMetric::UNWEIGHTED, UniFracMetric::WEIGHTED_UNNORMALIZED, UniFracMetric::WEIGHTED_NORMALIZED}) {
+			for (size_t threads : {1, 3}) {
+				auto unifrac = UniFrac::compute(tree, feature_ids, counts.sparse(), metric, threads);
+				auto from_compact = UniFrac::compute(compact, feature_ids, counts.sparse(), metric, threads);
+				REQUIRE(unifrac.sample_count() == n_samples);
+				REQUIRE(unifrac.stripe_count() == n_samples / 2);
+
+				// Every pair appears exactly once
+				std::vector<int> seen(n_samples * n_samples, 0);
+				for (size_t s = 0; s < unifrac.stripe_count(); s++) {
+					for (size_t i = 0; i < unifrac.stripe_length(s); i++) {
+						size_t j = (i + s + 1) % n_samples;
+						seen[std::min(i, j) * n_samples + std::max(i, j)]++;
+						CHECK_THAT(unifrac.distance(s, i), WithinAbs(brute_force(tree, counts, i, j, metric), 1e-12));
+						CHECK_THAT(from_compact.distance(s, i), WithinAbs(unifrac.distance(s, i), 1e-12));
+					}
+				}
+				for (size_t i = 0; i < n_samples; i++) {
+					for (size_t j = i + 1; j < n_samples; j++) {
+						CHECK(seen[i * n_samples + j] == 1);
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("UniFrac - known values", "[UniFrac]") {
+	auto tree = NewickTree::parse("((A:0.1,B:0.2):0.3,C:0.4);");
+	Counts counts;
+	counts.feature_ids = {"A", "B", "C"};
+	// s0 = {A: 1}, s1 = {B: 1}, s2 = {A: 1, C: 1}
+	counts.indptr = {0, 1, 2, 4};
+	counts.features = {0, 1, 0, 2};
+	counts.values = {1, 1, 1, 1};
+	counts.dense = {{1, 0, 0}, {0, 1, 0}, {1, 0, 1}};
+
+	auto unweighted = UniFrac::compute(tree, counts.feature_ids, counts.sparse(), UniFracMetric::UNWEIGHTED);
+	// s0 vs s1: unique branches A and B (0.3) over A, B and their parent (0.6)
+	CHECK_THAT(unweighted.distance(0, 0), WithinAbs(0.5, 1e-12));
+	// s2 vs s0: unique branch C (0.4) over A, C and A's parent (0.8)
+	CHECK_THAT(unweighted.distance(0, 2), WithinAbs(0.5, 1e-12));
+
+	auto weighted = UniFrac::compute(tree, counts.feature_ids, counts.sparse(), UniFracMetric::WEIGHTED_UNNORMALIZED);
+	CHECK_THAT(weighted.distance(0, 0), WithinAbs(0.3, 1e-12));
+}
+
+TEST_CASE("UniFrac - errors and degenerate input", "[UniFrac]") {
+	auto tree = NewickTree::parse("((A:1,A:2):0.5,C:1);");
+	std::vector<std::string> feature_ids = {"C", "X"};
+	std::vector<uint64_t> indptr = {0, 1, 2};
+	std::vector<uint32_t> features = {1, 1};
+	std::vector<double> values = {1, 1};
+	SparseCounts counts {indptr.data(), features.data(), values.data(), 2};
+	CHECK_THROWS_WITH(UniFrac::compute(tree, feature_ids, counts, UniFracMetric::UNWEIGHTED),
+	                  Catch::Matchers::ContainsSubstring("'X' is not a tip"));
+	feature_ids = {"A"};
+	features = {0, 0};
+	CHECK_THROWS_WITH(UniFrac::compute(tree, feature_ids, counts, UniFracMetric::UNWEIGHTED),
+	                  Catch::Matchers::ContainsSubstring("more than one tip"));
+
+	CHECK(UniFrac::compute(tree, {}, {indptr.data(), features.data(), values.data(), 1}, UniFracMetric::UNWEIGHTED)
+	          .stripe_count() == 0);
+	// Sample counts whose distances cannot fit are rejected before anything is read
+	CHECK_THROWS_WITH(
+	    UniFrac::compute(tree, {}, {nullptr, nullptr, nullptr, size_t(1) << 33}, UniFracMetric::UNWEIGHTED),
+	    Catch::Matchers::ContainsSubstring("8589934592 samples needs more memory"));
+	CHECK(parse_unifrac_metric("weighted_normalized") == UniFracMetric::WEIGHTED_NORMALIZED);
+	CHECK_THROWS(parse_unifrac_metric("generalized"));
+}
@@ -0,0 +1,192 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "SequenceReader.hpp"
+#include "ZstdSeekable.hpp"
+
+using namespace miint;
+
+#ifdef HAVE_LIBZSTD
+
+namespace {
+
+std::string fastq_records(size_t first, size_t count) {
+	std::string out;
+	for (size_t i = first; i < first + count; i++) {
+		std::string seq(20 + i % 37, "ACGT"[i % 4]);
+		out += "@read_" + std::to_string(i) + "\n" + seq + "\n+\n" + std::string(seq.size(), 'I') + "\n";
+	}
+	return out;
+}
+
+// Compress buffers the way COPY does: each buffer into its own frames, followed by the seek table
+std::string compress_seekable(const std::vector<std::string> &buffers, bool with_table = true) {
+	std::string out;
+	ZstdSeekTable table;
+	for (const auto &buffer : buffers) {
+		std::vector<char> compressed(zstd_compress_frames_bound(buffer.size()));
+		auto size = zstd_compress_frames(buffer.data(), buffer.size(), compressed.data(), 3, table.frames);
+		out.append(compressed.data(), size);
+	}
+	if (with_table) {
+		out += table.serialize();
+	}
+	return out;
+}
+
+std::string read_all(ZstdReader &reader, size_t chunk) {
+	std::string out;
+	std::vector<char> buffer(chunk);
+	size_t n;
+	while ((n = reader.read(buffer.data(), buffer.size())) > 0) {
+		out.append(buffer.data(), n);
+	}
+	return out;
+}
+
+class TempFile {
+public:
+	explicit TempFile(const std::string &name) : path((std::filesystem::temp_directory_path() / name).string()) {
+	}
+	~TempFile() {
+		std::filesystem::remove(path);
+	}
+	void write(const std::string &data) const {
+		std::ofstream out(path, std::ios::binary);
+		out << data;
+	}
+	std::string path;
+};
+
+} // namespace
+
+TEST_CASE("ZstdSeekTable - serialize round trip", "[ZstdSeekable]") {
+	ZstdSeekTable table;
+	table.frames = {{100, 4096}, {250, 1 << 20}, {7, 1}};
+	auto data = table.serialize();
+	REQUIRE(data.size() == ZstdSeekTable::FRAME_HEADER_SIZE + 3 * 8 + ZstdSeekTable::FOOTER_SIZE);
+	CHECK(ZstdSeekTable::table_size(data.substr(data.size() - ZstdSeekTable::FOOTER_SIZE)) == data.size());
+
+	auto restored = ZstdSeekTable::deserialize(data);
+	REQUIRE(restored.frames.size() == 3);
+	CHECK(restored.frames[1].compressed == 250);
+	CHECK(restored.frames[1].decompressed == (1u << 20));
+	CHECK(restored.compressed_size() == 357);
+	CHECK(restored.decompressed_size() == 4096 + (1 << 20) + 1);
+}
+
+TEST_CASE("ZstdSeekTable - rejects other data", "[ZstdSeekable]") {
+	CHECK(ZstdSeekTable::table_size("not a footer") == 0);
+	CHECK(ZstdSeekTable::table_size(std::string(ZstdSeekTable::FOOTER_SIZE, '\0')) == 0);
+	CHECK_THROWS_WITH(ZstdSeekTable::deserialize(std::string(40, 'x')),
+	                  Catch::Matchers::ContainsSubstring("Not a zstd seek table"));
+
+	ZstdSeekTable table;
+	table.frames = {{1, 2}};
+	auto data = table.serialize();
+	CHECK_THROWS(ZstdSeekTable::deserialize(data.substr(0, data.size() - 1)));
+}
+
+TEST_CASE("ZstdSeekable - large buffers are split into several frames", "[ZstdSeekable]") {
+	std::string buffer = fastq_records(0, 200000);
+	REQUIRE(buffer.size() > 2 * ZSTD_MAX_FRAME_SIZE);
+	std::vector<ZstdFrameSize> frames;
+	std::vector<char> compressed(zstd_compress_frames_bound(buffer.size()));
+	zstd_compress_frames(buffer.data(), buffer.size(), compressed.data(), 0, frames);
+	REQUIRE(frames.size() == (buffer.size() + ZSTD_MAX_FRAME_SIZE - 1) / ZSTD_MAX_FRAME_SIZE);
+	CHECK(frames.front().decompressed == ZSTD_MAX_FRAME_SIZE);
+
+	std::vector<ZstdFrameSize> empty;
+	CHECK(zstd_compress_frames(buffer.data(), 0, compressed.data(), 0, empty) == 0);
+	CHECK(empty.empty());
+}
+
+TEST_CASE("ZstdReader - seekable files decode in parallel", "[ZstdSeekable]") {
+	std::vector<std::string> buffers;
+	std::string expected;
+	for (size_t first = 0; first < 60000; first += 3000) {
+		buffers.push_back(fastq_records(first, 3000));
+		expected += buffers.back();
+	}
+	TempFile temp("zstd_seekable.fastq.zst");
+	temp.write(compress_seekable(buffers));
+
+	for (size_t threads : {1, 4}) {
+		ZstdReader reader(temp.path, threads);
+		CHECK(reader.seekable());
+		// Odd chunk sizes make reads straddle frame and batch boundaries
+		CHECK(read_all(reader, 16384) == expected);
+	}
+	ZstdReader reader(temp.path, 3);
+	CHECK(read_all(reader, 777) == expected);
+}
+
+TEST_CASE("ZstdReader - files without a seek table are streamed", "[ZstdSeekable]") {
+	std::vector<std::string> buffers = {fastq_records(0, 5000), fastq_records(5000, 5000)};
+	TempFile temp("zstd_plain.fastq.zst");
+	temp.write(compress_seekable(buffers, false));
+
+	ZstdReader reader(temp.path, 4);
+	CHECK_FALSE(reader.seekable());
+	CHECK(read_all(reader, 4096) == buffers[0] + buffers[1]);
+}
+
+TEST_CASE("ZstdReader - truncated and corrupt files", "[ZstdSeekable]") {
+	std::vector<std::string> buffers = {fastq_records(0, 5000)};
+	auto data = compress_seekable(buffers, false);
+	TempFile temp("zstd_truncated.fastq.zst");
+	temp.write(data.substr(0, data.size() / 2));
+	ZstdReader truncated(temp.path);
+	CHECK_THROWS_WITH(read_all(truncated, 4096), Catch::Matchers::ContainsSubstring("Truncated"));
+
+	// A seek table whose frames do not add up to the file is ignored rather than trusted
+	ZstdSeekTable table;
+	table.frames = {{10, 10}};
+	TempFile stale("zstd_stale_table.fastq.zst");
+	stale.write(data + table.serialize());
+	ZstdReader reader(stale.path);
+	CHECK_FALSE(reader.seekable());
+	CHECK(read_all(reader, 4096) == buffers[0]);
+
+	CHECK_THROWS(ZstdReader("/nonexistent/file.zst"));
+}
+
+TEST_CASE("ZstdReader - detects zstd content", "[ZstdSeekable]") {
+	TempFile zstd("zstd_detect.fq");
+	zstd.write(compress_seekable({fastq_records(0, 10)}));
+	TempFile plain("zstd_detect_plain.fq");
+	plain.write(fastq_records(0, 10));
+	CHECK(ZstdReader::is_zstd_file(zstd.path));
+	CHECK_FALSE(ZstdReader::is_zstd_file(plain.path));
+	CHECK_FALSE(ZstdReader::is_zstd_file("/nonexistent/file"));
+}
+
+TEST_CASE("SequenceReader - reads zstd FASTQ", "[ZstdSeekable]") {
+	std::vector<std::string> buffers;
+	for (size_t first = 0; first < 20000; first += 4000) {
+		buffers.push_back(fastq_records(first, 4000));
+	}
+	TempFile temp("zstd_reader.fastq.zst");
+	temp.write(compress_seekable(buffers));
+
+	SequenceReader reader(temp.path, std::nullopt, 4);
+	size_t total = 0;
+	bool in_order = true;
+	while (true) {
+		auto batch = reader.read(1024);
+		if (batch.empty()) {
+			break;
+		}
+		for (size_t i = 0; i < batch.size(); i++) {
+			in_order = in_order && batch.read_ids[i] == "read_" + std::to_string(total + i);
+		}
+		total += batch.size();
+	}
+	CHECK(total == 20000);
+	CHECK(in_order);
+}
+
+#endif
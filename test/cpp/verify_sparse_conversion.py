@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 """
 Verify expected CSR/CSC conversion results using scipy.
-Used to generate test expectations for BIOMTable::ToCSR() and ToCSC().
+Used to generate test expectations for BIOMTable::ToCSR() and CSC().
 """
 
 import numpy as np
@@ -0,0 +1,73 @@
+#!/bin/bash
+# Tests for COPY FASTQ/FASTA/SAM streaming to stdout and named pipes
+
+set -e
+
+DUCKDB="./build/release/duckdb"
+FAILED=0
+
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+FIFO="$TMP_DIR/reads.pipe"
+mkfifo "$FIFO"
+
+# 100000 reads of 100bp, enough to fill many 128KB writer buffers
+READS="SELECT 'r_' || i AS read_id, repeat('ACGT', 25) AS sequence1, list_transform(range(100), x -> 30::UTINYINT) AS qual1 FROM range(100000) t(i)"
+ALIGNMENTS="SELECT 'r_' || i AS read_id, 0::USMALLINT AS flags, 'ref_1' AS reference, (i + 1)::BIGINT AS position, 60::UTINYINT AS mapq, '50M' AS cigar, '*' AS mate_reference, 0::BIGINT AS mate_position, 0::BIGINT AS template_length FROM range(100000) t(i)"
+PARALLEL="SET threads=4; SET preserve_insertion_order=false;"
+
+# Helper function to run a test
+run_test() {
+    local test_name="$1"
+    local expected="$2"
+    shift 2
+    local cmd="$@"
+
+    echo "Running: $test_name"
+
+    result=$(eval "$cmd" 2>&1 || true)
+
+    if echo "$result" | grep -q "$expected"; then
+        echo "  ✓ PASS"
+    else
+        echo "  ✗ FAIL"
+        echo "  Expected substring: $expected"
+        echo "  Got: $result"
+        FAILED=1
+    fi
+}
+
+# Test 1: FASTQ to stdout, in query order
+run_test "FASTQ to /dev/stdout in query order" \
+    "^400000 r_0 r_99999$" \
+    "$DUCKDB -c \"COPY ($READS) TO '/dev/stdout' (FORMAT FASTQ);\" | awk 'NR % 4 == 1 { if (NR == 1) first = \$0; last = \$0 } END { print NR, substr(first, 2), substr(last, 2) }'"
+
+# Test 2: FASTQ to stdout from several threads, read back through a pipe
+run_test "Parallel FASTQ to /dev/stdout read back from /dev/stdin" \
+    "true" \
+    "$DUCKDB -c \"$PARALLEL COPY ($READS) TO '/dev/stdout' (FORMAT FASTQ);\" | $DUCKDB -c \"SELECT COUNT(*) = 100000 AND COUNT(DISTINCT read_id) = 100000 AND bool_and(length(sequence1) = 100) AS ok FROM read_fastx('/dev/stdin');\""
+
+# Test 3: FASTA to a named pipe
+run_test "FASTA to a named pipe" \
+    "^200000$" \
+    "$DUCKDB -c \"COPY (SELECT read_id, sequence1 FROM ($READS)) TO '$FIFO' (FORMAT FASTA);\" > /dev/null & wc -l < '$FIFO' | tr -d ' '"
+
+# Test 4: gzip-compressed FASTQ from several threads to a named pipe
+run_test "Parallel BGZF FASTQ to a named pipe" \
+    "^400000$" \
+    "$DUCKDB -c \"$PARALLEL COPY ($READS) TO '$FIFO' (FORMAT FASTQ, COMPRESSION gzip);\" > /dev/null & gzip -dc < '$FIFO' | wc -l | tr -d ' '"
+
+# Test 5: Headerless SAM from several threads to stdout
+run_test "Parallel SAM to /dev/stdout" \
+    "^100000 100000$" \
+    "$DUCKDB -c \"$PARALLEL COPY ($ALIGNMENTS) TO '/dev/stdout' (FORMAT SAM, INCLUDE_HEADER false);\" | awk '{ ids[\$1] = 1 } END { print NR, length(ids) }'"
+
+# Summary
+echo ""
+if [ $FAILED -eq 0 ]; then
+    echo "All tests passed!"
+    exit 0
+else
+    echo "Some tests failed!"
+    exit 1
+fi